@@ -13,23 +13,47 @@
 
 #include "rmutil/alloc.h"
 
+static inline size_t chunkCapacity(const Chunk *chunk) {
+    return chunk->size / SAMPLE_SIZE;
+}
+
+static void allocColumns(Chunk *chunk) {
+    chunk->timestamps = (timestamp_t *)malloc(chunkCapacity(chunk) * sizeof(timestamp_t));
+    chunk->values = (double *)malloc(chunkCapacity(chunk) * sizeof(double));
+#ifdef DEBUG
+    memset(chunk->timestamps, 0, chunkCapacity(chunk) * sizeof(timestamp_t));
+    memset(chunk->values, 0, chunkCapacity(chunk) * sizeof(double));
+#endif
+}
+
+static void reallocColumns(Chunk *chunk) {
+    chunk->timestamps =
+        (timestamp_t *)realloc(chunk->timestamps, chunkCapacity(chunk) * sizeof(timestamp_t));
+    chunk->values = (double *)realloc(chunk->values, chunkCapacity(chunk) * sizeof(double));
+}
+
 Chunk_t *Uncompressed_NewChunk(size_t size) {
     Chunk *newChunk = (Chunk *)malloc(sizeof(Chunk));
     newChunk->base_timestamp = 0;
     newChunk->num_samples = 0;
     newChunk->size = size;
-    newChunk->samples = (Sample *)malloc(size);
-#ifdef DEBUG
-    memset(newChunk->samples, 0, size);
-#endif
+    allocColumns(newChunk);
+    ChunkSummary_Reset(&newChunk->summary);
 
     return newChunk;
 }
 
-void Uncompressed_FreeChunk(Chunk_t *chunk) {
-    if (((Chunk *)chunk)->samples) {
-        free(((Chunk *)chunk)->samples);
+static void rebuildSummary(Chunk *chunk) {
+    ChunkSummary_Reset(&chunk->summary);
+    for (size_t i = 0; i < chunk->num_samples; ++i) {
+        Sample sample = { .timestamp = chunk->timestamps[i], .value = chunk->values[i] };
+        ChunkSummary_Add(&chunk->summary, &sample);
     }
+}
+
+void Uncompressed_FreeChunk(Chunk_t *chunk) {
+    free(((Chunk *)chunk)->timestamps);
+    free(((Chunk *)chunk)->values);
     free(chunk);
 }
 
@@ -45,15 +69,21 @@ Chunk_t *Uncompressed_SplitChunk(Chunk_t *chunk) {
 
     // create chunk and copy samples
     Chunk *newChunk = Uncompressed_NewChunk(split * SAMPLE_SIZE);
-    for (size_t i = 0; i < split; ++i) {
-        Sample *sample = &curChunk->samples[curNumSamples + i];
-        Uncompressed_AddSample(newChunk, sample);
+    if (split > 0) {
+        memcpy(newChunk->timestamps,
+               curChunk->timestamps + curNumSamples,
+               split * sizeof(timestamp_t));
+        memcpy(newChunk->values, curChunk->values + curNumSamples, split * sizeof(double));
+        newChunk->num_samples = split;
+        newChunk->base_timestamp = newChunk->timestamps[0];
+        rebuildSummary(newChunk);
     }
 
     // update current chunk
     curChunk->num_samples = curNumSamples;
     curChunk->size = curNumSamples * SAMPLE_SIZE;
-    curChunk->samples = realloc(curChunk->samples, curChunk->size);
+    reallocColumns(curChunk);
+    rebuildSummary(curChunk);
 
     return newChunk;
 }
@@ -67,8 +97,9 @@ Chunk_t *Uncompressed_CloneChunk(const Chunk_t *src) {
     const Chunk *_src = src;
     Chunk *dst = (Chunk *)malloc(sizeof(Chunk));
     memcpy(dst, _src, sizeof(Chunk));
-    dst->samples = (Sample *)malloc(dst->size);
-    memcpy(dst->samples, _src->samples, dst->size);
+    allocColumns(dst);
+    memcpy(dst->timestamps, _src->timestamps, dst->num_samples * sizeof(timestamp_t));
+    memcpy(dst->values, _src->values, dst->num_samples * sizeof(double));
     return dst;
 }
 
@@ -79,21 +110,32 @@ int Uncompressed_DefragChunk(RedisModuleDefragCtx *ctx,
                              void **newptr) {
     Chunk *chunk = (Chunk *)data;
     chunk = defragPtr(ctx, chunk);
-    chunk->samples = defragPtr(ctx, chunk->samples);
+    chunk->timestamps = defragPtr(ctx, chunk->timestamps);
+    chunk->values = defragPtr(ctx, chunk->values);
     *newptr = (void *)chunk;
     return DefragStatus_Finished;
 }
 
 static int IsChunkFull(Chunk *chunk) {
-    return chunk->num_samples == chunk->size / SAMPLE_SIZE;
+    return chunk->num_samples == chunkCapacity(chunk);
 }
 
 uint64_t Uncompressed_NumOfSample(Chunk_t *chunk) {
     return ((Chunk *)chunk)->num_samples;
 }
 
-static Sample *ChunkGetSample(Chunk *chunk, int index) {
-    return &chunk->samples[index];
+// Returns the index of the first sample with a timestamp >= ts, num_samples if there is none
+static size_t lowerBound(const Chunk *chunk, timestamp_t ts) {
+    size_t lo = 0, hi = chunk->num_samples;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (chunk->timestamps[mid] < ts) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
 }
 
 timestamp_t Uncompressed_GetLastTimestamp(Chunk_t *chunk) {
@@ -101,7 +143,7 @@ timestamp_t Uncompressed_GetLastTimestamp(Chunk_t *chunk) {
         RedisModule_Log(mr_staticCtx, "error", "Trying to get the last timestamp of empty chunk");
         return 0;
     }
-    return ChunkGetSample(chunk, ((Chunk *)chunk)->num_samples - 1)->timestamp;
+    return ((Chunk *)chunk)->timestamps[((Chunk *)chunk)->num_samples - 1];
 }
 
 double Uncompressed_GetLastValue(Chunk_t *chunk) {
@@ -109,7 +151,7 @@ double Uncompressed_GetLastValue(Chunk_t *chunk) {
         RedisModule_Log(mr_staticCtx, "error", "Trying to get the last value of empty chunk");
         return 0;
     }
-    return ChunkGetSample(chunk, ((Chunk *)chunk)->num_samples - 1)->value;
+    return ((Chunk *)chunk)->values[((Chunk *)chunk)->num_samples - 1];
 }
 
 timestamp_t Uncompressed_GetFirstTimestamp(Chunk_t *chunk) {
@@ -118,7 +160,7 @@ timestamp_t Uncompressed_GetFirstTimestamp(Chunk_t *chunk) {
         // Only the first chunk can be empty since we delete empty chunks
         return 0;
     }
-    return ChunkGetSample(chunk, 0)->timestamp;
+    return ((Chunk *)chunk)->timestamps[0];
 }
 
 ChunkResult Uncompressed_AddSample(Chunk_t *chunk, Sample *sample) {
@@ -132,8 +174,10 @@ ChunkResult Uncompressed_AddSample(Chunk_t *chunk, Sample *sample) {
         regChunk->base_timestamp = sample->timestamp;
     }
 
-    regChunk->samples[regChunk->num_samples] = *sample;
+    regChunk->timestamps[regChunk->num_samples] = sample->timestamp;
+    regChunk->values[regChunk->num_samples] = sample->value;
     regChunk->num_samples++;
+    ChunkSummary_Add(&regChunk->summary, sample);
 
     return CR_OK;
 }
@@ -145,16 +189,20 @@ ChunkResult Uncompressed_AddSample(Chunk_t *chunk, Sample *sample) {
  * @param sample
  */
 static void upsertChunk(Chunk *chunk, size_t idx, Sample *sample) {
-    if (chunk->num_samples == chunk->size / SAMPLE_SIZE) {
-        chunk->size += sizeof(Sample);
-        chunk->samples = realloc(chunk->samples, chunk->size);
+    if (chunk->num_samples == chunkCapacity(chunk)) {
+        chunk->size += SAMPLE_SIZE;
+        reallocColumns(chunk);
     }
     if (idx < chunk->num_samples) { // sample is not last
-        memmove(&chunk->samples[idx + 1],
-                &chunk->samples[idx],
-                (chunk->num_samples - idx) * sizeof(Sample));
+        memmove(&chunk->timestamps[idx + 1],
+                &chunk->timestamps[idx],
+                (chunk->num_samples - idx) * sizeof(timestamp_t));
+        memmove(&chunk->values[idx + 1],
+                &chunk->values[idx],
+                (chunk->num_samples - idx) * sizeof(double));
     }
-    chunk->samples[idx] = *sample;
+    chunk->timestamps[idx] = sample->timestamp;
+    chunk->values[idx] = sample->value;
     chunk->num_samples++;
 }
 
@@ -168,23 +216,21 @@ ChunkResult Uncompressed_UpsertSample(UpsertCtx *uCtx, int *size, DuplicatePolic
     *size = 0;
     Chunk *regChunk = (Chunk *)uCtx->inChunk;
     timestamp_t ts = uCtx->sample.timestamp;
-    short numSamples = regChunk->num_samples;
     // find sample location
-    size_t i = 0;
-    Sample *sample = NULL;
-    for (; i < numSamples; ++i) {
-        sample = ChunkGetSample(regChunk, i);
-        if (ts <= sample->timestamp) {
-            break;
-        }
-    }
+    size_t i = lowerBound(regChunk, ts);
     // update value in case timestamp exists
-    if (sample != NULL && ts == sample->timestamp) {
-        ChunkResult cr = handleDuplicateSample(duplicatePolicy, *sample, &uCtx->sample);
+    if (i < regChunk->num_samples && ts == regChunk->timestamps[i]) {
+        Sample sample = { .timestamp = ts, .value = regChunk->values[i] };
+        ChunkResult cr = handleDuplicateSample(duplicatePolicy, sample, &uCtx->sample);
         if (cr != CR_OK) {
             return CR_ERR;
         }
-        regChunk->samples[i].value = uCtx->sample.value;
+        uCtx->overridden = true;
+        uCtx->overriddenValue = sample.value;
+        regChunk->values[i] = uCtx->sample.value;
+        if (sample.value != uCtx->sample.value) {
+            regChunk->summary.stale = true;
+        }
         return CR_OK;
     }
 
@@ -193,26 +239,26 @@ ChunkResult Uncompressed_UpsertSample(UpsertCtx *uCtx, int *size, DuplicatePolic
     }
 
     upsertChunk(regChunk, i, &uCtx->sample);
+    ChunkSummary_Add(&regChunk->summary, &uCtx->sample);
     *size = 1;
     return CR_OK;
 }
 
 size_t Uncompressed_DelRange(Chunk_t *chunk, timestamp_t startTs, timestamp_t endTs) {
     Chunk *regChunk = (Chunk *)chunk;
-    Sample *newSamples = (Sample *)malloc(regChunk->size);
-    size_t i = 0;
-    size_t new_count = 0;
-    for (; i < regChunk->num_samples; ++i) {
-        if (regChunk->samples[i].timestamp >= startTs && regChunk->samples[i].timestamp <= endTs) {
-            continue;
-        }
-        newSamples[new_count++] = regChunk->samples[i];
+    // samples are sorted, the deleted ones are a single run which is closed in place
+    const size_t si = lowerBound(regChunk, startTs);
+    const size_t ei = endTs == UINT64_MAX ? regChunk->num_samples : lowerBound(regChunk, endTs + 1);
+    if (si >= ei) {
+        return 0;
     }
-    size_t deleted_count = regChunk->num_samples - new_count;
-    free(regChunk->samples);
-    regChunk->samples = newSamples;
-    regChunk->num_samples = new_count;
-    regChunk->base_timestamp = newSamples[0].timestamp;
+    const size_t deleted_count = ei - si;
+    const size_t tail = regChunk->num_samples - ei;
+    memmove(&regChunk->timestamps[si], &regChunk->timestamps[ei], tail * sizeof(timestamp_t));
+    memmove(&regChunk->values[si], &regChunk->values[ei], tail * sizeof(double));
+    regChunk->num_samples -= deleted_count;
+    regChunk->base_timestamp = regChunk->timestamps[0];
+    regChunk->summary.stale = true;
     return deleted_count;
 }
 
@@ -233,7 +279,6 @@ void reverseEnrichedChunk(EnrichedChunk *enrichedChunk) {
     enrichedChunk->rev = true;
 }
 
-// TODO: can be optimized further using binary search
 void Uncompressed_ProcessChunk(const Chunk_t *chunk,
                                uint64_t start,
                                uint64_t end,
@@ -243,65 +288,64 @@ void Uncompressed_ProcessChunk(const Chunk_t *chunk,
     ResetEnrichedChunk(enrichedChunk);
     if (unlikely(!_chunk || _chunk->num_samples == 0 || end < start ||
                  _chunk->base_timestamp > end ||
-                 _chunk->samples[_chunk->num_samples - 1].timestamp < start)) {
+                 _chunk->timestamps[_chunk->num_samples - 1] < start)) {
         return;
     }
 
-    size_t si = _chunk->num_samples, ei = _chunk->num_samples - 1, i = 0;
-
-    // find start index
-    for (; i < _chunk->num_samples; i++) {
-        if (_chunk->samples[i].timestamp >= start) {
-            si = i;
-            break;
-        }
-    }
-
-    if (si == _chunk->num_samples) { // all TS are smaller than start
-        return;
-    }
-
-    // find end index
-    for (; i < _chunk->num_samples; i++) {
-        if (_chunk->samples[i].timestamp > end) {
-            ei = i - 1;
-            break;
-        }
-    }
-
-    enrichedChunk->samples.num_samples = ei - si + 1;
-    if (enrichedChunk->samples.num_samples == 0) {
+    const size_t si = lowerBound(_chunk, start);
+    const size_t ei = end == UINT64_MAX ? _chunk->num_samples : lowerBound(_chunk, end + 1);
+    if (si >= ei) {
         return;
     }
+    enrichedChunk->samples.num_samples = ei - si;
 
     if (unlikely(reverse)) {
-        for (i = 0; i < enrichedChunk->samples.num_samples; ++i) {
-            enrichedChunk->samples.timestamps[i] = _chunk->samples[ei - i].timestamp;
-            enrichedChunk->samples.values[i] = _chunk->samples[ei - i].value;
+        for (size_t i = 0; i < enrichedChunk->samples.num_samples; ++i) {
+            enrichedChunk->samples.timestamps[i] = _chunk->timestamps[ei - 1 - i];
+            enrichedChunk->samples.values[i] = _chunk->values[ei - 1 - i];
         }
         enrichedChunk->rev = true;
     } else {
-        for (i = 0; i < enrichedChunk->samples.num_samples;
-             ++i) { // use memcpy once chunk becomes columned
-            enrichedChunk->samples.timestamps[i] = _chunk->samples[i + si].timestamp;
-            enrichedChunk->samples.values[i] = _chunk->samples[i + si].value;
-        }
+        // the columns are already laid out as the enriched chunk, a forward read borrows them
+        enrichedChunk->samples.timestamps = (timestamp_t *)&_chunk->timestamps[si];
+        enrichedChunk->samples.values = (double *)&_chunk->values[si];
+        enrichedChunk->borrowed = true;
         enrichedChunk->rev = false;
     }
-    return;
 }
 
 size_t Uncompressed_GetChunkSize(const Chunk_t *chunk, bool includeStruct) {
     const Chunk *uncompChunk = chunk;
     size_t size = includeStruct ? RedisModule_MallocSize((void *)uncompChunk) +
-                                      RedisModule_MallocSize(uncompChunk->samples)
+                                      RedisModule_MallocSize(uncompChunk->timestamps) +
+                                      RedisModule_MallocSize(uncompChunk->values)
                                 : uncompChunk->size;
     return size;
 }
 
+// Overrides and deletions mark the summary stale, it's rebuilt once by the next read which uses it
+const ChunkSummary *Uncompressed_GetSummary(const Chunk_t *chunk) {
+    Chunk *regChunk = (Chunk *)chunk;
+    if (regChunk->summary.stale) {
+        rebuildSummary(regChunk);
+    }
+    return ChunkSummary_Get(&regChunk->summary);
+}
+
+// Uncompressed chunks are already laid out for reads
+void Uncompressed_SealChunk(__unused Chunk_t *chunk) {
+}
+
+// Uncompressed chunks are random access, no checkpoints are needed
+size_t Uncompressed_GetCheckpointsSize(__unused const Chunk_t *chunk) {
+    return 0;
+}
+
 typedef void (*SaveUnsignedFunc)(void *, uint64_t);
 typedef void (*SaveStringBufferFunc)(void *, const char *str, size_t len);
 
+// The serialized format keeps the original array of samples (size bytes), so the columns are
+// interleaved on save and split again on load
 static void Uncompressed_GenericSerialize(Chunk_t *chunk,
                                           void *ctx,
                                           SaveUnsignedFunc saveUnsigned,
@@ -312,7 +356,25 @@ static void Uncompressed_GenericSerialize(Chunk_t *chunk,
     saveUnsigned(ctx, uncompchunk->num_samples);
     saveUnsigned(ctx, uncompchunk->size);
 
-    saveStringBuffer(ctx, (char *)uncompchunk->samples, uncompchunk->size);
+    Sample *samples = (Sample *)calloc(1, uncompchunk->size);
+    for (size_t i = 0; i < uncompchunk->num_samples; ++i) {
+        samples[i].timestamp = uncompchunk->timestamps[i];
+        samples[i].value = uncompchunk->values[i];
+    }
+    saveStringBuffer(ctx, (char *)samples, uncompchunk->size);
+    free(samples);
+}
+
+static void loadSamples(Chunk *chunk, const Sample *samples, size_t len) {
+    allocColumns(chunk);
+    chunk->num_samples = min(chunk->num_samples, min(chunkCapacity(chunk), len / SAMPLE_SIZE));
+    for (size_t i = 0; i < chunk->num_samples; ++i) {
+        Sample sample;
+        memcpy(&sample, &samples[i], sizeof(sample)); // remote buffers aren't aligned
+        chunk->timestamps[i] = sample.timestamp;
+        chunk->values[i] = sample.value;
+    }
+    rebuildSummary(chunk);
 }
 
 void Uncompressed_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io) {
@@ -333,8 +395,10 @@ int Uncompressed_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
     uncompchunk->num_samples = LoadUnsigned_IOError(io, err, TSDB_ERROR);
     uncompchunk->size = LoadUnsigned_IOError(io, err, TSDB_ERROR);
     size_t string_buffer_size;
-    uncompchunk->samples =
+    Sample *samples =
         (Sample *)LoadStringBuffer_IOError(io, &string_buffer_size, err, TSDB_ERROR);
+    loadSamples(uncompchunk, samples, string_buffer_size);
+    free(samples);
     *chunk = (Chunk_t *)uncompchunk;
 
     return TSDB_OK;
@@ -353,8 +417,11 @@ int Uncompressed_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx) {
     uncompchunk->base_timestamp = MR_SerializationCtxReadLongLongWrapper(sctx);
     uncompchunk->num_samples = MR_SerializationCtxReadLongLongWrapper(sctx);
     uncompchunk->size = MR_SerializationCtxReadLongLongWrapper(sctx);
-    size_t string_buffer_size;
-    uncompchunk->samples = (Sample *)MR_ownedBufferFrom(sctx, &string_buffer_size);
+    MRError *err;
+    size_t string_buffer_size = 0;
+    const Sample *samples =
+        (const Sample *)MR_SerializationCtxReadBuffer(sctx, &string_buffer_size, &err);
+    loadSamples(uncompchunk, samples, string_buffer_size);
     *chunk = (Chunk_t *)uncompchunk;
     return TSDB_OK;
 }
@@ -14,12 +14,16 @@
 
 #include <stdint.h>
 
+// Samples are stored as separate timestamp and value columns, matching the layout of EnrichedChunk
+// so ranges are copied out with a memcpy per column
 typedef struct Chunk
 {
     timestamp_t base_timestamp;
-    Sample *samples;
+    timestamp_t *timestamps;
+    double *values;
     unsigned int num_samples;
-    size_t size;
+    size_t size; // capacity in bytes, SAMPLE_SIZE per sample
+    ChunkSummary summary;
 } Chunk;
 
 Chunk_t *Uncompressed_NewChunk(size_t size);
@@ -38,6 +42,7 @@ int Uncompressed_DefragChunk(RedisModuleDefragCtx *ctx,
                              size_t keylen,
                              void **newptr);
 size_t Uncompressed_GetChunkSize(const Chunk_t *chunk, bool includeStruct);
+size_t Uncompressed_GetCheckpointsSize(const Chunk_t *chunk);
 
 /**
  * TODO: describe me
@@ -56,11 +61,13 @@ ChunkResult Uncompressed_AddSample(Chunk_t *chunk, Sample *sample);
  */
 ChunkResult Uncompressed_UpsertSample(UpsertCtx *uCtx, int *size, DuplicatePolicy duplicatePolicy);
 size_t Uncompressed_DelRange(Chunk_t *chunk, timestamp_t startTs, timestamp_t endTs);
+void Uncompressed_SealChunk(Chunk_t *chunk);
 
 uint64_t Uncompressed_NumOfSample(Chunk_t *chunk);
 timestamp_t Uncompressed_GetLastTimestamp(Chunk_t *chunk);
 double Uncompressed_GetLastValue(Chunk_t *chunk);
 timestamp_t Uncompressed_GetFirstTimestamp(Chunk_t *chunk);
+const ChunkSummary *Uncompressed_GetSummary(const Chunk_t *chunk);
 
 void reverseEnrichedChunk(EnrichedChunk *enrichedChunk);
 void Uncompressed_ProcessChunk(const Chunk_t *chunk,
@@ -1,8 +1,12 @@
 #include "common.h"
 #include "tsdb.h"
 #include "indexer.h"
+#include "ingest_batch.h"
 
 int NotifyCallback(RedisModuleCtx *ctx, int type, const char *event, RedisModuleString *key) {
+    // the batched samples are propagated before the command which changed the key
+    IngestBatch_Flush(ctx);
+
     if (strcasecmp(event, "del") ==
             0 || // unlink also notifies with del with freeseries called before
         strcasecmp(event, "set") == 0 ||
@@ -28,6 +32,11 @@ int NotifyCallback(RedisModuleCtx *ctx, int type, const char *event, RedisModule
         return REDISMODULE_OK;
     }
 
+    if (strcasecmp(event, "move_to") == 0 || strcasecmp(event, "copy_to") == 0) {
+        SeriesMovedTo(ctx, key);
+        return REDISMODULE_OK;
+    }
+
     // Will be called in replicaof or on load rdb on load time
     if (strcasecmp(event, "loaded") == 0) {
         IndexMetricFromName(ctx, key);
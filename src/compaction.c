@@ -33,18 +33,6 @@ typedef struct FirstValueContext
     char isResetted;
 } FirstValueContext;
 
-typedef struct SingleValueContext
-{
-    double value;
-} SingleValueContext;
-
-typedef struct AvgContext
-{
-    double val;
-    double cnt;
-    bool isOverflow;
-} AvgContext;
-
 typedef struct TwaContext
 {
     double res;
@@ -59,13 +47,6 @@ typedef struct TwaContext
     int64_t iteration;
 } TwaContext;
 
-typedef struct StdContext
-{
-    double sum;
-    double sum_2; // sum of (values^2)
-    uint64_t cnt;
-} StdContext;
-
 void finalize_empty_with_NAN(__unused void *contextPtr, double *value) {
     *value = NAN;
 }
@@ -221,6 +202,70 @@ void AvgAddValue(void *contextPtr, double value, __attribute__((unused)) timesta
     }
 }
 
+// Like AvgAddValue with all the values of the summary at once
+void AvgAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    AvgContext *context = (AvgContext *)contextPtr;
+    const double prevCnt = context->cnt;
+    context->cnt += summary->count;
+
+    if (unlikely(((context->val < 0.0) == (summary->sum < 0.0) &&
+                  (fabs(context->val) > (DBL_MAX - fabs(summary->sum)))) ||
+                 context->isOverflow)) {
+        // calculating: avg(t+n) = t*avg(t)/(t+n) + sum/(t+n)
+        long double ld_val = context->val;
+        if (context->isOverflow) {
+            ld_val *= ((long double)prevCnt / context->cnt);
+        } else {
+            ld_val /= context->cnt;
+        }
+        ld_val += ((long double)summary->sum / context->cnt);
+        context->val = ld_val;
+        context->isOverflow = true;
+    } else { // No Overflow
+        context->val += summary->sum;
+    }
+}
+
+// Appends the values of [si, ei] whose sum is sum. The values are appended one by one when the
+// context is, or may get, out of the double range.
+static void AvgAppendValuesSum(AvgContext *__restrict__ context,
+                               double *__restrict__ values,
+                               size_t si,
+                               size_t ei,
+                               double sum) {
+    if (unlikely(context->isOverflow || !isfinite(sum) ||
+                 ((context->val < 0.0) == (sum < 0.0) &&
+                  (fabs(context->val) > (DBL_MAX - fabs(sum)))))) {
+        for (size_t i = si; i <= ei; ++i) {
+            AvgAddValue(context, values[i], 0);
+        }
+        return;
+    }
+    context->cnt += ei - si + 1;
+    context->val += sum;
+}
+
+void AvgAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei) {
+    double sum = 0;
+    for (size_t i = si; i <= ei; ++i) {
+        sum += values[i];
+    }
+    AvgAppendValuesSum(context, values, si, ei, sum);
+}
+
+bool AvgRetractValue(void *contextPtr, double value) {
+    AvgContext *context = (AvgContext *)contextPtr;
+    if (unlikely(context->isOverflow || context->cnt == 0 || !isfinite(value))) {
+        return false;
+    }
+    context->cnt--;
+    context->val -= value;
+    return true;
+}
+
 int AvgFinalize(void *contextPtr, double *value) {
     AvgContext *context = (AvgContext *)contextPtr;
     if (unlikely(context->cnt == 0)) {
@@ -439,6 +484,36 @@ void StdAddValue(void *contextPtr, double value, __attribute__((unused)) timesta
     context->sum_2 += value * value;
 }
 
+void StdAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    StdContext *context = (StdContext *)contextPtr;
+    context->cnt += summary->count;
+    context->sum += summary->sum;
+    context->sum_2 += summary->sum_2;
+}
+
+void StdAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei) {
+    StdContext *stdContext = (StdContext *)context;
+    for (size_t i = si; i <= ei; ++i) {
+        stdContext->sum += values[i];
+        stdContext->sum_2 += values[i] * values[i];
+    }
+    stdContext->cnt += ei - si + 1;
+}
+
+bool StdRetractValue(void *contextPtr, double value) {
+    StdContext *context = (StdContext *)contextPtr;
+    if (unlikely(context->cnt == 0 || !isfinite(value))) {
+        return false;
+    }
+    --context->cnt;
+    context->sum -= value;
+    context->sum_2 -= value * value;
+    return true;
+}
+
 static inline double variance(double sum, double sum_2, double count) {
     if (count == 0) {
         return 0;
@@ -532,6 +607,9 @@ static AggregationClass aggWAvg = {
     .getLastSample = TwaGetLastSample,
     .resetContext = TwaReset,
     .cloneContext = TwaCloneContext,
+    .retractValue = NULL,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggAvg = {
@@ -539,6 +617,7 @@ static AggregationClass aggAvg = {
     .createContext = AvgCreateContext,
     .appendValue = AvgAddValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = AvgAppendSummary,
     .freeContext = rm_free,
     .finalize = AvgFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -550,6 +629,9 @@ static AggregationClass aggAvg = {
     .getLastSample = NULL,
     .resetContext = AvgReset,
     .cloneContext = AvgCloneContext,
+    .retractValue = AvgRetractValue,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggStdP = {
@@ -557,6 +639,7 @@ static AggregationClass aggStdP = {
     .createContext = StdCreateContext,
     .appendValue = StdAddValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = StdAppendSummary,
     .freeContext = rm_free,
     .finalize = StdPopulationFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -568,6 +651,9 @@ static AggregationClass aggStdP = {
     .getLastSample = NULL,
     .resetContext = StdReset,
     .cloneContext = StdCloneContext,
+    .retractValue = StdRetractValue,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggStdS = {
@@ -575,6 +661,7 @@ static AggregationClass aggStdS = {
     .createContext = StdCreateContext,
     .appendValue = StdAddValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = StdAppendSummary,
     .freeContext = rm_free,
     .finalize = StdSamplesFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -586,6 +673,9 @@ static AggregationClass aggStdS = {
     .getLastSample = NULL,
     .resetContext = StdReset,
     .cloneContext = StdCloneContext,
+    .retractValue = StdRetractValue,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggVarP = {
@@ -593,6 +683,7 @@ static AggregationClass aggVarP = {
     .createContext = StdCreateContext,
     .appendValue = StdAddValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = StdAppendSummary,
     .freeContext = rm_free,
     .finalize = VarPopulationFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -604,6 +695,9 @@ static AggregationClass aggVarP = {
     .getLastSample = NULL,
     .resetContext = StdReset,
     .cloneContext = StdCloneContext,
+    .retractValue = StdRetractValue,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggVarS = {
@@ -611,6 +705,7 @@ static AggregationClass aggVarS = {
     .createContext = StdCreateContext,
     .appendValue = StdAddValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = StdAppendSummary,
     .freeContext = rm_free,
     .finalize = VarSamplesFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -622,6 +717,9 @@ static AggregationClass aggVarS = {
     .getLastSample = NULL,
     .resetContext = StdReset,
     .cloneContext = StdCloneContext,
+    .retractValue = StdRetractValue,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 void *MaxMinCreateContext(__unused bool reverse) {
@@ -657,6 +755,15 @@ void MinAppendValue(void *contextPtr, double value, __attribute__((unused)) time
     }
 }
 
+void MinAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei) {
+    for (size_t i = si; i <= ei; ++i) {
+        _AssignIfLess(&((MaxMinContext *)context)->minValue, &values[i]);
+    }
+}
+
 void MaxMinAppendValue(void *contextPtr, double value, __attribute__((unused)) timestamp_t ts) {
     MaxMinContext *context = (MaxMinContext *)contextPtr;
     if (value > context->maxValue) {
@@ -667,6 +774,72 @@ void MaxMinAppendValue(void *contextPtr, double value, __attribute__((unused)) t
     }
 }
 
+void MaxMinAppendValuesVec(void *__restrict__ context,
+                           double *__restrict__ values,
+                           size_t si,
+                           size_t ei) {
+    MaxMinContext *maxMinContext = (MaxMinContext *)context;
+    for (size_t i = si; i <= ei; ++i) {
+        _AssignIfGreater(&maxMinContext->maxValue, &values[i]);
+        _AssignIfLess(&maxMinContext->minValue, &values[i]);
+    }
+}
+
+void MaxAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    MaxMinContext *context = (MaxMinContext *)contextPtr;
+    if (summary->max > context->maxValue) {
+        context->maxValue = summary->max;
+    }
+}
+
+void MinAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    MaxMinContext *context = (MaxMinContext *)contextPtr;
+    if (summary->min < context->minValue) {
+        context->minValue = summary->min;
+    }
+}
+
+void MaxMinAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    MaxAppendSummary(contextPtr, summary);
+    MinAppendSummary(contextPtr, summary);
+}
+
+// A value above the minimum (below the maximum) doesn't affect it, removing the extreme itself
+// needs the rest of the bucket
+bool MaxRetractValue(void *contextPtr, double value) {
+    return value < ((MaxMinContext *)contextPtr)->maxValue;
+}
+
+bool MinRetractValue(void *contextPtr, double value) {
+    return value > ((MaxMinContext *)contextPtr)->minValue;
+}
+
+bool MaxMinRetractValue(void *contextPtr, double value) {
+    return MaxRetractValue(contextPtr, value) && MinRetractValue(contextPtr, value);
+}
+
+bool MaxMergeFinalized(double *finalized, double value) {
+    if (value > *finalized) {
+        *finalized = value;
+    }
+    return true;
+}
+
+bool MinMergeFinalized(double *finalized, double value) {
+    if (value < *finalized) {
+        *finalized = value;
+    }
+    return true;
+}
+
+bool MaxRetractFinalized(double *finalized, double value) {
+    return value < *finalized;
+}
+
+bool MinRetractFinalized(double *finalized, double value) {
+    return value > *finalized;
+}
+
 int MaxFinalize(void *contextPtr, double *value) {
     MaxMinContext *context = (MaxMinContext *)contextPtr;
     *value = context->maxValue;
@@ -715,11 +888,75 @@ void SumAppendValue(void *contextPtr, double value, __attribute__((unused)) time
     context->value += value;
 }
 
+void SumAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    SingleValueContext *context = (SingleValueContext *)contextPtr;
+    context->value += summary->sum;
+}
+
+void SumAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei) {
+    SingleValueContext *sumContext = (SingleValueContext *)context;
+    for (size_t i = si; i <= ei; ++i) {
+        sumContext->value += values[i];
+    }
+}
+
 void CountAppendValue(void *contextPtr, double value, __attribute__((unused)) timestamp_t ts) {
     FirstValueContext *context = (FirstValueContext *)contextPtr;
     context->value++;
 }
 
+void CountAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    SingleValueContext *context = (SingleValueContext *)contextPtr;
+    context->value += summary->count;
+}
+
+void CountAppendValuesVec(void *__restrict__ context,
+                          __unused double *__restrict__ values,
+                          size_t si,
+                          size_t ei) {
+    ((SingleValueContext *)context)->value += ei - si + 1;
+}
+
+// a non finite value can't be subtracted back out of the sum
+bool SumRetractValue(void *contextPtr, double value) {
+    if (!isfinite(value)) {
+        return false;
+    }
+    ((SingleValueContext *)contextPtr)->value -= value;
+    return true;
+}
+
+bool CountRetractValue(void *contextPtr, __unused double value) {
+    ((SingleValueContext *)contextPtr)->value--;
+    return true;
+}
+
+bool SumMergeFinalized(double *finalized, double value) {
+    *finalized += value;
+    return true;
+}
+
+bool SumRetractFinalized(double *finalized, double value) {
+    if (!isfinite(value)) {
+        return false;
+    }
+    *finalized -= value;
+    return true;
+}
+
+bool CountMergeFinalized(double *finalized, __unused double value) {
+    (*finalized)++;
+    return true;
+}
+
+bool CountRetractFinalized(double *finalized, __unused double value) {
+    (*finalized)--;
+    return true;
+}
+
 int CountFinalize(void *contextPtr, double *val) {
     FirstValueContext *context = (FirstValueContext *)contextPtr;
     *val = context->value;
@@ -734,16 +971,39 @@ void FirstAppendValue(void *contextPtr, double value, __attribute__((unused)) ti
     }
 }
 
+void FirstAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    FirstAppendValue(contextPtr, summary->first.value, summary->first.timestamp);
+}
+
+void FirstAppendValuesVec(void *__restrict__ context,
+                          double *__restrict__ values,
+                          size_t si,
+                          __unused size_t ei) {
+    FirstAppendValue(context, values[si], 0);
+}
+
 void LastAppendValue(void *contextPtr, double value, __attribute__((unused)) timestamp_t ts) {
     SingleValueContext *context = (SingleValueContext *)contextPtr;
     context->value = value;
 }
 
+void LastAppendSummary(void *contextPtr, const ChunkSummary *summary) {
+    LastAppendValue(contextPtr, summary->last.value, summary->last.timestamp);
+}
+
+void LastAppendValuesVec(void *__restrict__ context,
+                         double *__restrict__ values,
+                         __unused size_t si,
+                         size_t ei) {
+    ((SingleValueContext *)context)->value = values[ei];
+}
+
 static AggregationClass aggMax = {
     .type = TS_AGG_MAX,
     .createContext = MaxMinCreateContext,
     .appendValue = MaxAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = MaxAppendSummary,
     .freeContext = rm_free,
     .finalize = MaxFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -755,6 +1015,9 @@ static AggregationClass aggMax = {
     .getLastSample = NULL,
     .resetContext = MaxMinReset,
     .cloneContext = MaxMinCloneContext,
+    .retractValue = MaxRetractValue,
+    .mergeFinalized = MaxMergeFinalized,
+    .retractFinalized = MaxRetractFinalized,
 };
 
 static AggregationClass aggMin = {
@@ -762,6 +1025,7 @@ static AggregationClass aggMin = {
     .createContext = MaxMinCreateContext,
     .appendValue = MinAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = MinAppendSummary,
     .freeContext = rm_free,
     .finalize = MinFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -773,6 +1037,9 @@ static AggregationClass aggMin = {
     .getLastSample = NULL,
     .resetContext = MaxMinReset,
     .cloneContext = MaxMinCloneContext,
+    .retractValue = MinRetractValue,
+    .mergeFinalized = MinMergeFinalized,
+    .retractFinalized = MinRetractFinalized,
 };
 
 static AggregationClass aggSum = {
@@ -780,6 +1047,7 @@ static AggregationClass aggSum = {
     .createContext = SingleValueCreateContext,
     .appendValue = SumAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = SumAppendSummary,
     .freeContext = rm_free,
     .finalize = SingleValueFinalize,
     .finalizeEmpty = finalize_empty_with_ZERO,
@@ -791,6 +1059,9 @@ static AggregationClass aggSum = {
     .getLastSample = NULL,
     .resetContext = SingleValueReset,
     .cloneContext = SingleValueCloneContext,
+    .retractValue = SumRetractValue,
+    .mergeFinalized = SumMergeFinalized,
+    .retractFinalized = SumRetractFinalized,
 };
 
 static AggregationClass aggCount = {
@@ -798,6 +1069,7 @@ static AggregationClass aggCount = {
     .createContext = SingleValueCreateContext,
     .appendValue = CountAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = CountAppendSummary,
     .freeContext = rm_free,
     .finalize = CountFinalize,
     .finalizeEmpty = finalize_empty_with_ZERO,
@@ -809,6 +1081,9 @@ static AggregationClass aggCount = {
     .getLastSample = NULL,
     .resetContext = SingleValueReset,
     .cloneContext = SingleValueCloneContext,
+    .retractValue = CountRetractValue,
+    .mergeFinalized = CountMergeFinalized,
+    .retractFinalized = CountRetractFinalized,
 };
 
 static AggregationClass aggFirst = {
@@ -816,6 +1091,7 @@ static AggregationClass aggFirst = {
     .createContext = FirstValueCreateContext,
     .appendValue = FirstAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = FirstAppendSummary,
     .freeContext = rm_free,
     .finalize = FirstValueFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -827,6 +1103,9 @@ static AggregationClass aggFirst = {
     .getLastSample = NULL,
     .resetContext = FirstValueReset,
     .cloneContext = FirstValueCloneContext,
+    .retractValue = NULL,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggLast = {
@@ -834,6 +1113,7 @@ static AggregationClass aggLast = {
     .createContext = SingleValueCreateContext,
     .appendValue = LastAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = LastAppendSummary,
     .freeContext = rm_free,
     .finalize = SingleValueFinalize,
     .finalizeEmpty = finalize_empty_last_value,
@@ -845,6 +1125,9 @@ static AggregationClass aggLast = {
     .getLastSample = NULL,
     .resetContext = LastValueReset,
     .cloneContext = SingleValueCloneContext,
+    .retractValue = NULL,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
 static AggregationClass aggRange = {
@@ -852,6 +1135,7 @@ static AggregationClass aggRange = {
     .createContext = MaxMinCreateContext,
     .appendValue = MaxMinAppendValue,
     .appendValueVec = NULL, /* determined on run time */
+    .appendSummary = MaxMinAppendSummary,
     .freeContext = rm_free,
     .finalize = RangeFinalize,
     .finalizeEmpty = finalize_empty_with_NAN,
@@ -863,22 +1147,59 @@ static AggregationClass aggRange = {
     .getLastSample = NULL,
     .resetContext = MaxMinReset,
     .cloneContext = MaxMinCloneContext,
+    .retractValue = MaxMinRetractValue,
+    .mergeFinalized = NULL,
+    .retractFinalized = NULL,
 };
 
+// TWA weighs each value by the time around it, it's appended sample by sample
+static void initPortableAppendValuesVec(void) {
+    aggMax.appendValueVec = MaxAppendValuesVec;
+    aggMin.appendValueVec = MinAppendValuesVec;
+    aggRange.appendValueVec = MaxMinAppendValuesVec;
+    aggSum.appendValueVec = SumAppendValuesVec;
+    aggCount.appendValueVec = CountAppendValuesVec;
+    aggAvg.appendValueVec = AvgAppendValuesVec;
+    aggStdP.appendValueVec = StdAppendValuesVec;
+    aggStdS.appendValueVec = StdAppendValuesVec;
+    aggVarP.appendValueVec = StdAppendValuesVec;
+    aggVarS.appendValueVec = StdAppendValuesVec;
+    aggFirst.appendValueVec = FirstAppendValuesVec;
+    aggLast.appendValueVec = LastAppendValuesVec;
+}
+
+#if defined(__x86_64__)
+// COUNT, FIRST and LAST don't read the values inside the range, they keep the portable kernels.
+// So do SUM, AVG and VAR/STD: vector lanes would add the values in another order than the portable
+// kernels, and the results would then depend on the CPU.
+// AVX512F is measured by the kernels microbenchmark but isn't dispatched yet.
+static __unused void initAVX512FAppendValuesVec(void) {
+    aggMax.appendValueVec = MaxAppendValuesAVX512F;
+    aggMin.appendValueVec = MinAppendValuesAVX512F;
+    aggRange.appendValueVec = MaxMinAppendValuesAVX512F;
+}
+
+static void initAVX2AppendValuesVec(void) {
+    aggMax.appendValueVec = MaxAppendValuesAVX2;
+    aggMin.appendValueVec = MinAppendValuesAVX2;
+    aggRange.appendValueVec = MaxMinAppendValuesAVX2;
+}
+#endif // __x86_64__
+
 void initGlobalCompactionFunctions() {
     const X86Features *features = getArchitectureOptimization();
-    aggMax.appendValueVec = MaxAppendValuesVec;
+    initPortableAppendValuesVec();
 
 #if defined(__x86_64__)
     if (!features) {
         return;
         /* remove this comment to enable avx512
      } else if (features->avx512f) {
-            aggMax.appendValueVec = MaxAppendValuesAVX512F;
+            initAVX512FAppendValuesVec();
             return;
         }*/
     } else if (features->avx2) {
-        aggMax.appendValueVec = MaxAppendValuesAVX2;
+        initAVX2AppendValuesVec();
         return;
     }
 #endif // __x86_64__
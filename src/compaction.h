@@ -28,6 +28,8 @@ typedef struct AggregationClass
                            double *__restrict__ values,
                            size_t si,
                            size_t ei);
+    // folds all the samples of a chunk at once, NULL when the aggregation needs each sample
+    void (*appendSummary)(void *context, const ChunkSummary *summary);
     void (*resetContext)(void *context);
     void (*writeContext)(void *context, RedisModuleIO *io);
     int (*readContext)(void *context, RedisModuleIO *io, int encver);
@@ -44,6 +46,13 @@ typedef struct AggregationClass
     int (*finalize)(void *context, double *value);
     void (*finalizeEmpty)(void *contextPtr, double *value); // assigns empty value to value
     void *(*cloneContext)(void *contextPtr);                // return cloned context
+    // Incremental maintenance of a bucket when a sample of it is upserted, NULL when unsupported.
+    // retractValue removes a value which was appended to the context, it returns false (leaving
+    // the context untouched) when the context can't tell the result without the other values.
+    bool (*retractValue)(void *contextPtr, double value);
+    // mergeFinalized and retractFinalized do the same on a finalized bucket value.
+    bool (*mergeFinalized)(double *finalized, double value);
+    bool (*retractFinalized)(double *finalized, double value);
 } AggregationClass;
 
 AggregationClass *GetAggClass(TS_AGG_TYPES_T aggType);
@@ -1,6 +1,12 @@
 #include "compaction_common.h"
 #include <immintrin.h>
 
+// The kernels only cover min/max, whose result doesn't depend on the order of the values. SUM, AVG
+// and VAR/STD keep the portable kernels, which add the values in sample order, so their results
+// are the same on every CPU.
+// A NaN value is passed as the first operand of min/max, which then returns the partial result:
+// it's skipped like the scalar comparison skips it.
+
 void MaxAppendValuesAVX2(void *__restrict__ context,
                          double *__restrict__ values,
                          size_t si,
@@ -11,41 +17,78 @@ void MaxAppendValuesAVX2(void *__restrict__ context,
     }
 
     double *res = &((MaxMinContext *)context)->maxValue;
+    __m256d res_avx = _mm256_set1_pd(*res);
+    for (; si + VECTOR_SIZE_AVX2 <= ei + 1; si += VECTOR_SIZE_AVX2) {
+        res_avx = _mm256_max_pd(_mm256_loadu_pd(&values[si]), res_avx);
+    }
+
+    // find max in the vector
+    double vec[VECTOR_SIZE_AVX2];
+    _mm256_storeu_pd(vec, res_avx);
+    for (int i = 0; i < VECTOR_SIZE_AVX2; ++i) {
+        _AssignIfGreater(res, &vec[i]);
+    }
 
-    // search in beginning
-    while (si <= ei && !is_aligned(&values[si], ALIGN_SIZE_AVX2)) {
+    // search in the remainder
+    for (; si <= ei; ++si) {
         _AssignIfGreater(res, &values[si]);
-        ++si;
     }
+}
 
-    if (si > ei) {
+void MinAppendValuesAVX2(void *__restrict__ context,
+                         double *__restrict__ values,
+                         size_t si,
+                         size_t ei) {
+    if ((ei - si + 1) < VECTOR_SIZE_AVX2 * 2) {
+        MinAppendValuesVec(context, values, si, ei);
         return;
     }
 
-    if (ei - si + 1 >= VECTOR_SIZE_AVX2 * 2) {
-        double vec[VECTOR_SIZE_AVX2] __attribute__((aligned(ALIGN_SIZE_AVX2)));
-        __m256d values_avx = _mm256_load_pd(&values[si]);
-        _mm256_store_pd(vec, values_avx);
-        __m256d res_avx = _mm256_load_pd(vec);
-
-        size_t vec_ei = (ei - ((ei - si) % VECTOR_SIZE_AVX2));
-        si += VECTOR_SIZE_AVX2;
-        for (; si < vec_ei; si += VECTOR_SIZE_AVX2) {
-            values_avx = _mm256_load_pd(&values[si]);
-            res_avx = _mm256_max_pd(res_avx, values_avx);
-        }
+    double *res = &((MaxMinContext *)context)->minValue;
+    __m256d res_avx = _mm256_set1_pd(*res);
+    for (; si + VECTOR_SIZE_AVX2 <= ei + 1; si += VECTOR_SIZE_AVX2) {
+        res_avx = _mm256_min_pd(_mm256_loadu_pd(&values[si]), res_avx);
+    }
 
-        // find max in the vector
-        _mm256_store_pd(vec, res_avx);
-        for (int i = 0; i < VECTOR_SIZE_AVX2; ++i) {
-            _AssignIfGreater(res, &vec[i]);
-        }
+    double vec[VECTOR_SIZE_AVX2];
+    _mm256_storeu_pd(vec, res_avx);
+    for (int i = 0; i < VECTOR_SIZE_AVX2; ++i) {
+        _AssignIfLess(res, &vec[i]);
     }
 
-    // search in the remainder
     for (; si <= ei; ++si) {
-        _AssignIfGreater(res, &values[si]);
+        _AssignIfLess(res, &values[si]);
+    }
+}
+
+void MaxMinAppendValuesAVX2(void *__restrict__ context,
+                            double *__restrict__ values,
+                            size_t si,
+                            size_t ei) {
+    if ((ei - si + 1) < VECTOR_SIZE_AVX2 * 2) {
+        MaxMinAppendValuesVec(context, values, si, ei);
+        return;
     }
 
-    return;
+    MaxMinContext *maxMinContext = (MaxMinContext *)context;
+    __m256d max_avx = _mm256_set1_pd(maxMinContext->maxValue);
+    __m256d min_avx = _mm256_set1_pd(maxMinContext->minValue);
+    for (; si + VECTOR_SIZE_AVX2 <= ei + 1; si += VECTOR_SIZE_AVX2) {
+        const __m256d values_avx = _mm256_loadu_pd(&values[si]);
+        max_avx = _mm256_max_pd(values_avx, max_avx);
+        min_avx = _mm256_min_pd(values_avx, min_avx);
+    }
+
+    double max_vec[VECTOR_SIZE_AVX2], min_vec[VECTOR_SIZE_AVX2];
+    _mm256_storeu_pd(max_vec, max_avx);
+    _mm256_storeu_pd(min_vec, min_avx);
+    for (int i = 0; i < VECTOR_SIZE_AVX2; ++i) {
+        _AssignIfGreater(&maxMinContext->maxValue, &max_vec[i]);
+        _AssignIfLess(&maxMinContext->minValue, &min_vec[i]);
+    }
+
+    for (; si <= ei; ++si) {
+        _AssignIfGreater(&maxMinContext->maxValue, &values[si]);
+        _AssignIfLess(&maxMinContext->minValue, &values[si]);
+    }
 }
@@ -1,51 +1,94 @@
 #include "compaction_common.h"
 #include <immintrin.h>
 
+// The kernels only cover min/max, whose result doesn't depend on the order of the values. SUM, AVG
+// and VAR/STD keep the portable kernels, which add the values in sample order, so their results
+// are the same on every CPU.
+// A NaN value is passed as the first operand of min/max, which then returns the partial result:
+// it's skipped like the scalar comparison skips it.
+
 void MaxAppendValuesAVX512F(void *__restrict__ context,
-                            double *__restrict__ values,
-                            size_t si,
-                            size_t ei) {
+                         double *__restrict__ values,
+                         size_t si,
+                         size_t ei) {
     if ((ei - si + 1) < VECTOR_SIZE * 2) {
         MaxAppendValuesVec(context, values, si, ei);
         return;
     }
 
     double *res = &((MaxMinContext *)context)->maxValue;
+    __m512d res_avx = _mm512_set1_pd(*res);
+    for (; si + VECTOR_SIZE <= ei + 1; si += VECTOR_SIZE) {
+        res_avx = _mm512_max_pd(_mm512_loadu_pd(&values[si]), res_avx);
+    }
+
+    // find max in the vector
+    double vec[VECTOR_SIZE];
+    _mm512_storeu_pd(vec, res_avx);
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        _AssignIfGreater(res, &vec[i]);
+    }
 
-    // search in beginning
-    while (si <= ei && !is_aligned(&values[si], CACHE_LINE_SIZE)) {
+    // search in the remainder
+    for (; si <= ei; ++si) {
         _AssignIfGreater(res, &values[si]);
-        ++si;
     }
+}
 
-    if (si > ei) {
+void MinAppendValuesAVX512F(void *__restrict__ context,
+                         double *__restrict__ values,
+                         size_t si,
+                         size_t ei) {
+    if ((ei - si + 1) < VECTOR_SIZE * 2) {
+        MinAppendValuesVec(context, values, si, ei);
         return;
     }
 
-    if (ei - si + 1 >= VECTOR_SIZE * 2) {
-        double vec[VECTOR_SIZE] __attribute__((aligned(CACHE_LINE_SIZE)));
-        __m512d values_avx = _mm512_load_pd(&values[si]);
-        _mm512_store_pd(vec, values_avx);
-        __m512d res_avx = _mm512_load_pd(vec);
-
-        size_t vec_ei = (ei - ((ei - si) % VECTOR_SIZE));
-        si += VECTOR_SIZE;
-        for (; si < vec_ei; si += VECTOR_SIZE) {
-            values_avx = _mm512_load_pd(&values[si]);
-            res_avx = _mm512_max_pd(res_avx, values_avx);
-        }
+    double *res = &((MaxMinContext *)context)->minValue;
+    __m512d res_avx = _mm512_set1_pd(*res);
+    for (; si + VECTOR_SIZE <= ei + 1; si += VECTOR_SIZE) {
+        res_avx = _mm512_min_pd(_mm512_loadu_pd(&values[si]), res_avx);
+    }
 
-        // find max in the vector
-        _mm512_store_pd(vec, res_avx);
-        for (int i = 0; i < VECTOR_SIZE; ++i) {
-            _AssignIfGreater(res, &vec[i]);
-        }
+    double vec[VECTOR_SIZE];
+    _mm512_storeu_pd(vec, res_avx);
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        _AssignIfLess(res, &vec[i]);
     }
 
-    // search in the remainder
     for (; si <= ei; ++si) {
-        _AssignIfGreater(res, &values[si]);
+        _AssignIfLess(res, &values[si]);
+    }
+}
+
+void MaxMinAppendValuesAVX512F(void *__restrict__ context,
+                            double *__restrict__ values,
+                            size_t si,
+                            size_t ei) {
+    if ((ei - si + 1) < VECTOR_SIZE * 2) {
+        MaxMinAppendValuesVec(context, values, si, ei);
+        return;
+    }
+
+    MaxMinContext *maxMinContext = (MaxMinContext *)context;
+    __m512d max_avx = _mm512_set1_pd(maxMinContext->maxValue);
+    __m512d min_avx = _mm512_set1_pd(maxMinContext->minValue);
+    for (; si + VECTOR_SIZE <= ei + 1; si += VECTOR_SIZE) {
+        const __m512d values_avx = _mm512_loadu_pd(&values[si]);
+        max_avx = _mm512_max_pd(values_avx, max_avx);
+        min_avx = _mm512_min_pd(values_avx, min_avx);
     }
 
-    return;
+    double max_vec[VECTOR_SIZE], min_vec[VECTOR_SIZE];
+    _mm512_storeu_pd(max_vec, max_avx);
+    _mm512_storeu_pd(min_vec, min_avx);
+    for (int i = 0; i < VECTOR_SIZE; ++i) {
+        _AssignIfGreater(&maxMinContext->maxValue, &max_vec[i]);
+        _AssignIfLess(&maxMinContext->minValue, &min_vec[i]);
+    }
+
+    for (; si <= ei; ++si) {
+        _AssignIfGreater(&maxMinContext->maxValue, &values[si]);
+        _AssignIfLess(&maxMinContext->minValue, &values[si]);
+    }
 }
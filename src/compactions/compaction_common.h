@@ -29,6 +29,25 @@ typedef struct MaxMinContext
     double maxValue;
 } MaxMinContext;
 
+typedef struct SingleValueContext
+{
+    double value;
+} SingleValueContext;
+
+typedef struct AvgContext
+{
+    double val;
+    double cnt;
+    bool isOverflow;
+} AvgContext;
+
+typedef struct StdContext
+{
+    double sum;
+    double sum_2; // sum of (values^2)
+    uint64_t cnt;
+} StdContext;
+
 static really_inline void _AssignIfGreater(double *__restrict__ value, double *__restrict__ newValues)
 {
     if(*newValues > *value) {
@@ -36,10 +55,52 @@ static really_inline void _AssignIfGreater(double *__restrict__ value, double *_
     }
 }
 
+static really_inline void _AssignIfLess(double *__restrict__ value, double *__restrict__ newValues)
+{
+    if(*newValues < *value) {
+        *value = *newValues;
+    }
+}
+
+// The portable kernels which append the values of [si, ei] to the context of an aggregation, as
+// appending them one by one would. The kernels of an instruction set fall back to them for short
+// ranges.
 void MaxAppendValuesVec(void *__restrict__ context,
                         double *__restrict__ values,
                         size_t si,
                         size_t ei);
+void MinAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei);
+void MaxMinAppendValuesVec(void *__restrict__ context,
+                           double *__restrict__ values,
+                           size_t si,
+                           size_t ei);
+void SumAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei);
+void CountAppendValuesVec(void *__restrict__ context,
+                          double *__restrict__ values,
+                          size_t si,
+                          size_t ei);
+void AvgAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei);
+void StdAppendValuesVec(void *__restrict__ context,
+                        double *__restrict__ values,
+                        size_t si,
+                        size_t ei);
+void FirstAppendValuesVec(void *__restrict__ context,
+                          double *__restrict__ values,
+                          size_t si,
+                          size_t ei);
+void LastAppendValuesVec(void *__restrict__ context,
+                         double *__restrict__ values,
+                         size_t si,
+                         size_t ei);
 
 static really_inline bool is_aligned(void *p, int N)
 {
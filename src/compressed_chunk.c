@@ -12,10 +12,14 @@
 
 #include "LibMR/src/mr.h"
 #include "chunk.h"
+#include "config.h"
+#include "frozen_chunk.h"
 #include "generic_chunk.h"
+#include "rdb.h"
 
 #include <assert.h> // assert
 #include <limits.h>
+#include <math.h>
 #include <stdarg.h>
 #include <stdio.h>  // printf
 #include <stdlib.h> // malloc
@@ -23,6 +27,9 @@
 
 #define BIT 8
 #define CHUNK_RESIZE_STEP 32
+#define DECOMPRESS_BLOCK_SIZE 64
+// out of order samples are encoded into the chunk once the buffer reaches this size
+#define OOO_BUFFER_MAX_SAMPLES 256
 
 /*********************
  *  Chunk functions  *
@@ -38,24 +45,90 @@ Chunk_t *Compressed_NewChunk(size_t size) {
     chunk->prevLeading = 32;
     chunk->prevTrailing = 32;
     chunk->prevTimestamp = 0;
+    chunk->checkpointInterval = TSGlobalConfig.chunkCheckpointInterval;
     return chunk;
 }
 
+Chunk_t *Decimal_NewChunk(size_t size) {
+    CompressedChunk *chunk = Compressed_NewChunk(size);
+    chunk->valueEncoding = VALUE_ENCODING_DECIMAL;
+    return chunk;
+}
+
+Chunk_t *Chimp_NewChunk(size_t size) {
+    CompressedChunk *chunk = Compressed_NewChunk(size);
+    chunk->valueEncoding = VALUE_ENCODING_CHIMP;
+    return chunk;
+}
+
+// A new chunk with the same value encoding, a decimal chunk detects its scale again
+static CompressedChunk *newChunkLike(const CompressedChunk *chunk, size_t size) {
+    switch (chunk->valueEncoding) {
+        case VALUE_ENCODING_DECIMAL:
+        case VALUE_ENCODING_DECIMAL_FALLBACK:
+            return Decimal_NewChunk(size);
+        case VALUE_ENCODING_CHIMP:
+            return Chimp_NewChunk(size);
+        default:
+            return Compressed_NewChunk(size);
+    }
+}
+
 void Compressed_FreeChunk(Chunk_t *chunk) {
     CompressedChunk *cmpChunk = chunk;
     if (cmpChunk->data) {
         free(cmpChunk->data);
     }
     cmpChunk->data = NULL;
+    if (cmpChunk->checkpoints) {
+        free(cmpChunk->checkpoints);
+    }
+    cmpChunk->checkpoints = NULL;
+    if (cmpChunk->oooSamples) {
+        free(cmpChunk->oooSamples);
+    }
+    cmpChunk->oooSamples = NULL;
+    if (cmpChunk->frozen) {
+        free(cmpChunk->frozen);
+    }
+    cmpChunk->frozen = NULL;
     free(chunk);
 }
 
+// The checkpoints and the out of order samples arrays grow in powers of 2, their capacity is
+// derived from the count
+static inline size_t arrayCapacity(uint32_t count) {
+    size_t capacity = 1;
+    while (capacity < count) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
 Chunk_t *Compressed_CloneChunk(const Chunk_t *chunk) {
     const CompressedChunk *oldChunk = chunk;
     CompressedChunk *newChunk = malloc(sizeof(CompressedChunk));
     memcpy(newChunk, oldChunk, sizeof(CompressedChunk));
-    newChunk->data = malloc(newChunk->size);
-    memcpy(newChunk->data, oldChunk->data, oldChunk->size);
+    if (oldChunk->data) {
+        newChunk->data = malloc(newChunk->size);
+        memcpy(newChunk->data, oldChunk->data, oldChunk->size);
+    }
+    if (oldChunk->checkpoints) {
+        newChunk->checkpoints =
+            malloc(arrayCapacity(oldChunk->numCheckpoints) * sizeof(CompressedCheckpoint));
+        memcpy(newChunk->checkpoints,
+               oldChunk->checkpoints,
+               oldChunk->numCheckpoints * sizeof(CompressedCheckpoint));
+    }
+    if (oldChunk->oooSamples) {
+        newChunk->oooSamples = malloc(arrayCapacity(oldChunk->numOOOSamples) * sizeof(Sample));
+        memcpy(newChunk->oooSamples,
+               oldChunk->oooSamples,
+               oldChunk->numOOOSamples * sizeof(Sample));
+    }
+    if (oldChunk->frozen) {
+        newChunk->frozen = Frozen_Clone(oldChunk->frozen);
+    }
     return newChunk;
 }
 
@@ -67,6 +140,9 @@ int Compressed_DefragChunk(RedisModuleDefragCtx *ctx,
     CompressedChunk *chunk = data;
     chunk = defragPtr(ctx, chunk);
     chunk->data = defragPtr(ctx, chunk->data);
+    chunk->checkpoints = defragPtr(ctx, chunk->checkpoints);
+    chunk->oooSamples = defragPtr(ctx, chunk->oooSamples);
+    chunk->frozen = defragPtr(ctx, chunk->frozen);
     *newptr = (void *)chunk;
     return DefragStatus_Finished;
 }
@@ -112,93 +188,498 @@ static void trimChunk(CompressedChunk *chunk) {
     }
 }
 
+// Iterates over the encoded samples of a chunk merged with its out of order samples. The encoded
+// samples of a frozen chunk are decoded a block at a time.
+typedef struct MergedIterator
+{
+    Compressed_Iterator iter;
+    const CompressedChunk *chunk;
+    size_t oooIdx;
+    Sample encoded;
+    bool hasEncoded;
+
+    uint32_t frozenBlock;
+    size_t blockIdx;
+    size_t blockLen;
+    timestamp_t blockTimestamps[FROZEN_BLOCK_SAMPLES];
+    double blockValues[FROZEN_BLOCK_SAMPLES];
+} MergedIterator;
+
+static bool MergedIterator_NextEncoded(MergedIterator *mIter) {
+    const FrozenChunk *frozen = mIter->chunk->frozen;
+    if (likely(!frozen)) {
+        return Compressed_ChunkIteratorGetNext(&mIter->iter, &mIter->encoded) == CR_OK;
+    }
+    if (mIter->blockIdx == mIter->blockLen) {
+        if (mIter->frozenBlock == frozen->numBlocks) {
+            return false;
+        }
+        mIter->blockLen = Frozen_DecodeBlock(
+            frozen, mIter->frozenBlock++, mIter->blockTimestamps, mIter->blockValues);
+        mIter->blockIdx = 0;
+    }
+    mIter->encoded.timestamp = mIter->blockTimestamps[mIter->blockIdx];
+    mIter->encoded.value = mIter->blockValues[mIter->blockIdx];
+    mIter->blockIdx++;
+    return true;
+}
+
+static void MergedIterator_Init(MergedIterator *mIter, const CompressedChunk *chunk) {
+    mIter->chunk = chunk;
+    mIter->oooIdx = 0;
+    mIter->frozenBlock = 0;
+    mIter->blockIdx = mIter->blockLen = 0;
+    if (!chunk->frozen) {
+        Compressed_ResetChunkIterator(&mIter->iter, chunk);
+    }
+    mIter->hasEncoded = MergedIterator_NextEncoded(mIter);
+}
+
+// An out of order sample overrides the encoded sample with the same timestamp
+static bool MergedIterator_GetNext(MergedIterator *mIter, Sample *sample) {
+    const bool hasOOO = mIter->oooIdx < mIter->chunk->numOOOSamples;
+    if (hasOOO && (!mIter->hasEncoded || mIter->chunk->oooSamples[mIter->oooIdx].timestamp <=
+                                             mIter->encoded.timestamp)) {
+        *sample = mIter->chunk->oooSamples[mIter->oooIdx++];
+        if (!mIter->hasEncoded || sample->timestamp != mIter->encoded.timestamp) {
+            return true;
+        }
+    } else if (mIter->hasEncoded) {
+        *sample = mIter->encoded;
+    } else {
+        return false;
+    }
+    mIter->hasEncoded = MergedIterator_NextEncoded(mIter);
+    return true;
+}
+
+// Encodes the samples of a chunk together with its out of order samples into a new chunk
+static CompressedChunk *encodeMergedChunk(const CompressedChunk *chunk) {
+    CompressedChunk *newChunk = newChunkLike(chunk, chunk->size);
+    MergedIterator mIter;
+    MergedIterator_Init(&mIter, chunk);
+    Sample sample;
+    while (MergedIterator_GetNext(&mIter, &sample)) {
+        ensureAddSample(newChunk, &sample);
+    }
+    return newChunk;
+}
+
+// Replaces the chunk with a mutable one holding the same samples, a sealed chunk is sealed again
+// by the caller once it's done
+static void reencodeChunk(CompressedChunk *chunk) {
+    CompressedChunk *newChunk = encodeMergedChunk(chunk);
+    swapChunks(newChunk, chunk);
+    Compressed_FreeChunk(newChunk);
+}
+
+// Encodes the out of order samples into the chunk
+static void foldOOOSamples(CompressedChunk *chunk) {
+    if (likely(chunk->numOOOSamples == 0)) {
+        return;
+    }
+    const bool sealed = chunk->sealed;
+    reencodeChunk(chunk);
+    if (sealed) {
+        Compressed_SealChunk(chunk);
+    }
+}
+
+// The number of samples of the chunk, the pending out of order samples are looked up by merging
+static size_t countMergedSamples(const CompressedChunk *chunk) {
+    if (likely(chunk->numOOOPending == 0)) {
+        return Compressed_ChunkNumOfSample((Chunk_t *)chunk);
+    }
+    MergedIterator mIter;
+    MergedIterator_Init(&mIter, chunk);
+    Sample sample;
+    size_t count = 0;
+    while (MergedIterator_GetNext(&mIter, &sample)) {
+        ++count;
+    }
+    return count;
+}
+
 Chunk_t *Compressed_SplitChunk(Chunk_t *chunk) {
     CompressedChunk *curChunk = chunk;
-    size_t split = curChunk->count / 2;
-    size_t curNumSamples = curChunk->count - split;
+    const size_t count = countMergedSamples(curChunk);
+    size_t split = count / 2;
+    size_t curNumSamples = count - split;
 
     // add samples in new chunks
     size_t i = 0;
     Sample sample;
-    ChunkIter_t *iter = Compressed_NewChunkIterator(curChunk);
-    CompressedChunk *newChunk1 = Compressed_NewChunk(curChunk->size);
-    CompressedChunk *newChunk2 = Compressed_NewChunk(curChunk->size);
+    MergedIterator mIter;
+    MergedIterator_Init(&mIter, curChunk);
+    CompressedChunk *newChunk1 = newChunkLike(curChunk, curChunk->size);
+    CompressedChunk *newChunk2 = newChunkLike(curChunk, curChunk->size);
     for (; i < curNumSamples; ++i) {
-        Compressed_ChunkIteratorGetNext(iter, &sample);
+        MergedIterator_GetNext(&mIter, &sample);
         ensureAddSample(newChunk1, &sample);
     }
-    for (; i < curChunk->count; ++i) {
-        Compressed_ChunkIteratorGetNext(iter, &sample);
+    for (; i < count; ++i) {
+        MergedIterator_GetNext(&mIter, &sample);
         ensureAddSample(newChunk2, &sample);
     }
 
     trimChunk(newChunk1);
     trimChunk(newChunk2);
+    const bool sealed = curChunk->sealed;
     swapChunks(curChunk, newChunk1);
-
-    Compressed_FreeChunkIterator(iter);
     Compressed_FreeChunk(newChunk1);
+    if (sealed) {
+        Compressed_SealChunk(curChunk);
+        Compressed_SealChunk(newChunk2);
+    }
 
     return newChunk2;
 }
 
+// returns the index of the first sample which timestamp is >= ts, or n if there is none
+static inline size_t lowerBoundSample(const Sample *samples, size_t n, timestamp_t ts) {
+    size_t l = 0, h = n;
+    while (l < h) {
+        const size_t m = l + (h - l) / 2;
+        if (samples[m].timestamp < ts) {
+            l = m + 1;
+        } else {
+            h = m;
+        }
+    }
+    return l;
+}
+
+static bool findEncodedSample(const CompressedChunk *chunk, timestamp_t ts, Sample *sample);
+static bool encodedTimestampKnown(const CompressedChunk *chunk, timestamp_t ts, bool *found);
+
+// A late sample is inserted into the sorted out of order buffer instead of re-encoding the chunk,
+// the buffer is encoded into the chunk once it's full. A sealed chunk takes every sample into the
+// buffer so it stays sealed.
+// The encoded sample with the same timestamp is only decoded when the duplicate policy needs its
+// value. Otherwise the sample is buffered without a lookup and the merge tells whether it replaced
+// one, `size` is the change of the chunk sample count.
 ChunkResult Compressed_UpsertSample(UpsertCtx *uCtx, int *size, DuplicatePolicy duplicatePolicy) {
     *size = 0;
-    ChunkResult rv = CR_OK;
-    ChunkResult nextRes = CR_OK;
-    CompressedChunk *oldChunk = (CompressedChunk *)uCtx->inChunk;
+    CompressedChunk *chunk = (CompressedChunk *)uCtx->inChunk;
+    const timestamp_t ts = uCtx->sample.timestamp;
+
+    if (chunk->count == 0 || (!chunk->sealed && ts > Compressed_GetLastTimestamp(chunk))) {
+        // nothing to merge with, append to the chunk
+        ensureAddSample(chunk, &uCtx->sample);
+        *size = 1;
+        return CR_OK;
+    }
 
-    size_t newSize = oldChunk->size;
+    const size_t pos = lowerBoundSample(chunk->oooSamples, chunk->numOOOSamples, ts);
+    if (pos < chunk->numOOOSamples && chunk->oooSamples[pos].timestamp == ts) {
+        if (handleDuplicateSample(duplicatePolicy, chunk->oooSamples[pos], &uCtx->sample) !=
+            CR_OK) {
+            return CR_ERR;
+        }
+        uCtx->overridden = true;
+        uCtx->overriddenValue = chunk->oooSamples[pos].value;
+        if (chunk->oooSamples[pos].value != uCtx->sample.value) {
+            chunk->summary.stale = true;
+        }
+        chunk->oooSamples[pos] = uCtx->sample;
+        return CR_OK;
+    }
 
-    CompressedChunk *newChunk = Compressed_NewChunk(newSize);
-    Compressed_Iterator *iter = Compressed_NewChunkIterator(oldChunk);
-    timestamp_t ts = uCtx->sample.timestamp;
-    int numSamples = oldChunk->count;
+    // a NaN doesn't replace a value, whatever the policy
+    const bool needsValue = duplicatePolicy != DP_LAST || isnan(uCtx->sample.value);
+    Sample encoded = { .timestamp = ts, .value = chunk->prevValue.d };
+    bool override = false;
+    bool valueKnown = true;
+    bool pending = false;
+    if (ts == chunk->prevTimestamp) {
+        override = true;
+    } else if (needsValue) {
+        override = ts >= chunk->baseTimestamp && ts <= chunk->prevTimestamp &&
+                   findEncodedSample(chunk, ts, &encoded);
+    } else {
+        pending = !encodedTimestampKnown(chunk, ts, &override);
+        valueKnown = !override;
+    }
+    if (override && valueKnown &&
+        handleDuplicateSample(duplicatePolicy, encoded, &uCtx->sample) != CR_OK) {
+        return CR_ERR;
+    }
+    uCtx->overridden = override && valueKnown;
+    uCtx->overriddenValue = uCtx->overridden ? encoded.value : 0;
+    uCtx->overriddenUnknown = pending || !valueKnown;
+
+    const uint64_t numSamples = Compressed_ChunkNumOfSample(chunk);
+    const uint32_t n = chunk->numOOOSamples;
+    if ((n & (n - 1)) == 0) { // full, n is a power of 2 (or 0)
+        chunk->oooSamples = realloc(chunk->oooSamples, (n ? n * 2 : 1) * sizeof(Sample));
+    }
+    memmove(&chunk->oooSamples[pos + 1], &chunk->oooSamples[pos], (n - pos) * sizeof(Sample));
+    chunk->oooSamples[pos] = uCtx->sample;
+    chunk->numOOOSamples++;
+    chunk->numOOOOverrides += override;
+    chunk->numOOOPending += pending;
+    if (!override && !pending) {
+        ChunkSummary_Add(&chunk->summary, &uCtx->sample);
+    } else if (!uCtx->overridden || encoded.value != uCtx->sample.value) {
+        chunk->summary.stale = true;
+    }
 
-    size_t i = 0;
-    Sample iterSample;
-    for (; i < numSamples; ++i) {
-        nextRes = Compressed_ChunkIteratorGetNext(iter, &iterSample);
-        if (iterSample.timestamp >= ts) {
-            break;
-        }
-        ensureAddSample(newChunk, &iterSample);
+    if (chunk->numOOOSamples >= OOO_BUFFER_MAX_SAMPLES) {
+        foldOOOSamples(chunk);
     }
+    *size = (int)((int64_t)Compressed_ChunkNumOfSample(chunk) - (int64_t)numSamples);
+    return CR_OK;
+}
 
-    if (ts == iterSample.timestamp) {
-        ChunkResult cr = handleDuplicateSample(duplicatePolicy, iterSample, &uCtx->sample);
-        if (cr != CR_OK) {
-            Compressed_FreeChunkIterator(iter);
-            Compressed_FreeChunk(newChunk);
-            return CR_ERR;
-        }
-        nextRes = Compressed_ChunkIteratorGetNext(iter, &iterSample);
-        *size = -1; // we skipped a sample
+static void addCheckpoint(CompressedChunk *chunk, const CompressedCheckpoint *checkpoint) {
+    const uint32_t n = chunk->numCheckpoints;
+    if ((n & (n - 1)) == 0) { // full, n is a power of 2 (or 0)
+        chunk->checkpoints =
+            realloc(chunk->checkpoints, (n ? n * 2 : 1) * sizeof(CompressedCheckpoint));
     }
-    // upsert the sample
-    ensureAddSample(newChunk, &uCtx->sample);
-    *size += 1;
+    chunk->checkpoints[n] = *checkpoint;
+    chunk->numCheckpoints++;
+}
 
-    if (i < numSamples) {
-        while (nextRes == CR_OK) {
-            ensureAddSample(newChunk, &iterSample);
-            nextRes = Compressed_ChunkIteratorGetNext(iter, &iterSample);
+// Picks the scale of a decimal chunk from its first sample. Once the chunk has samples, a value
+// which needs a larger scale re-encodes the chunk with that scale, and a value which doesn't fit
+// any scale re-encodes it with Gorilla.
+static void adaptDecimalScale(CompressedChunk *chunk, double value) {
+    const int scale = Decimal_ScaleOf(value);
+    if (chunk->count == 0) {
+        if (scale < 0) {
+            chunk->valueEncoding = VALUE_ENCODING_DECIMAL_FALLBACK;
+        } else {
+            chunk->decimalScale = scale;
         }
+        return;
     }
 
-    swapChunks(newChunk, oldChunk);
+    CompressedChunk *newChunk = Compressed_NewChunk(chunk->size);
+    newChunk->checkpointInterval = chunk->checkpointInterval;
+    const uint8_t newScale = max(scale, (int)chunk->decimalScale);
+    if (scale < 0 || !Decimal_Fits(value, newScale)) {
+        newChunk->valueEncoding = VALUE_ENCODING_DECIMAL_FALLBACK;
+    } else {
+        newChunk->valueEncoding = VALUE_ENCODING_DECIMAL;
+        newChunk->decimalScale = newScale;
+    }
+
+    Compressed_Iterator iter;
+    Compressed_ResetChunkIterator(&iter, chunk);
+    Sample sample;
+    while (Compressed_ChunkIteratorGetNext(&iter, &sample) == CR_OK) {
+        ensureAddSample(newChunk, &sample);
+    }
+    // the out of order samples aren't encoded, they are moved as is
+    newChunk->oooSamples = chunk->oooSamples;
+    newChunk->numOOOSamples = chunk->numOOOSamples;
+    newChunk->numOOOOverrides = chunk->numOOOOverrides;
+    newChunk->numOOOPending = chunk->numOOOPending;
+    newChunk->summary = chunk->summary;
+    chunk->oooSamples = NULL;
+    swapChunks(newChunk, chunk);
+    Compressed_FreeChunk(newChunk);
+}
 
-    Compressed_FreeChunkIterator(iter);
+// Decodes the frozen samples of a chunk which takes appends again, the out of order samples are
+// moved as is
+static void thawChunk(CompressedChunk *chunk) {
+    CompressedChunk *newChunk = newChunkLike(chunk, chunk->size);
+    const FrozenChunk *frozen = chunk->frozen;
+    timestamp_t timestamps[FROZEN_BLOCK_SAMPLES];
+    double values[FROZEN_BLOCK_SAMPLES];
+    for (uint32_t block = 0; block < frozen->numBlocks; ++block) {
+        const size_t n = Frozen_DecodeBlock(frozen, block, timestamps, values);
+        for (size_t i = 0; i < n; ++i) {
+            Sample sample = { .timestamp = timestamps[i], .value = values[i] };
+            ensureAddSample(newChunk, &sample);
+        }
+    }
+    newChunk->oooSamples = chunk->oooSamples;
+    newChunk->numOOOSamples = chunk->numOOOSamples;
+    newChunk->numOOOOverrides = chunk->numOOOOverrides;
+    newChunk->numOOOPending = chunk->numOOOPending;
+    newChunk->summary = chunk->summary;
+    chunk->oooSamples = NULL;
+    swapChunks(newChunk, chunk);
     Compressed_FreeChunk(newChunk);
-    return rv;
 }
 
 ChunkResult Compressed_AddSample(Chunk_t *chunk, Sample *sample) {
-    return Compressed_Append((CompressedChunk *)chunk, sample->timestamp, sample->value);
+    CompressedChunk *cmpChunk = chunk;
+    if (unlikely(cmpChunk->sealed)) {
+        // the last chunk of the series was removed and this one became the last
+        if (cmpChunk->frozen) {
+            thawChunk(cmpChunk);
+        }
+        cmpChunk->sealed = false;
+    }
+    if (cmpChunk->valueEncoding == VALUE_ENCODING_DECIMAL &&
+        unlikely(!Decimal_Fits(sample->value, cmpChunk->decimalScale))) {
+        adaptDecimalScale(cmpChunk, sample->value);
+    }
+
+    const bool takeCheckpoint = cmpChunk->checkpointInterval != 0 && cmpChunk->count != 0 &&
+                                cmpChunk->count % cmpChunk->checkpointInterval == 0;
+    CompressedCheckpoint checkpoint;
+    if (unlikely(takeCheckpoint)) {
+        checkpoint = (CompressedCheckpoint){
+            .prevTS = cmpChunk->prevTimestamp,
+            .prevDelta = cmpChunk->prevTimestampDelta,
+            .prevValue = cmpChunk->prevValue,
+            .prevScaledDelta = cmpChunk->prevScaledDelta,
+            .idx = cmpChunk->idx,
+            .leading = cmpChunk->prevLeading,
+            .trailing = cmpChunk->prevTrailing,
+        };
+    }
+
+    ChunkResult res = Compressed_Append(cmpChunk, sample->timestamp, sample->value);
+    if (res == CR_OK) {
+        ChunkSummary_Add(&cmpChunk->summary, sample);
+    }
+    if (unlikely(takeCheckpoint) && res == CR_OK) {
+        addCheckpoint(cmpChunk, &checkpoint);
+    }
+    return res;
+}
+
+// Closes the chunk for appends and re-encodes its samples into the frozen layout, which decodes
+// faster. The chunk keeps the Gorilla layout if the frozen one is larger.
+void Compressed_SealChunk(Chunk_t *chunk) {
+    CompressedChunk *cmpChunk = chunk;
+    if (cmpChunk->sealed) {
+        return;
+    }
+    cmpChunk->sealed = true;
+    size_t count = Compressed_ChunkNumOfSample(cmpChunk);
+    if (count == 0) {
+        return;
+    }
+
+    timestamp_t *timestamps = malloc(count * sizeof(timestamp_t));
+    double *values = malloc(count * sizeof(double));
+    if (likely(cmpChunk->numOOOSamples == 0)) {
+        Compressed_Iterator iter;
+        Compressed_ResetChunkIterator(&iter, cmpChunk);
+        Compressed_ChunkIteratorGetNextBlock(&iter, timestamps, values, count);
+    } else {
+        // the merge finds which of the pending out of order samples replaced encoded ones
+        MergedIterator mIter;
+        MergedIterator_Init(&mIter, cmpChunk);
+        Sample sample;
+        for (count = 0; MergedIterator_GetNext(&mIter, &sample); ++count) {
+            timestamps[count] = sample.timestamp;
+            values[count] = sample.value;
+        }
+        cmpChunk->numOOOOverrides = cmpChunk->count + cmpChunk->numOOOSamples - count;
+        cmpChunk->numOOOPending = 0;
+    }
+
+    FrozenChunk *frozen = Frozen_Encode(timestamps, values, count);
+    const size_t encodedSize = cmpChunk->size +
+                               cmpChunk->numCheckpoints * sizeof(CompressedCheckpoint) +
+                               cmpChunk->numOOOSamples * sizeof(Sample);
+    if (Frozen_Size(frozen) > encodedSize) {
+        free(frozen);
+    } else {
+        free(cmpChunk->data);
+        free(cmpChunk->checkpoints);
+        free(cmpChunk->oooSamples);
+        cmpChunk->data = NULL;
+        cmpChunk->checkpoints = NULL;
+        cmpChunk->numCheckpoints = 0;
+        cmpChunk->oooSamples = NULL;
+        cmpChunk->numOOOSamples = 0;
+        cmpChunk->numOOOOverrides = 0;
+        cmpChunk->idx = 0;
+        cmpChunk->intervalCount = 0;
+        cmpChunk->count = count;
+        cmpChunk->baseTimestamp = timestamps[0];
+        cmpChunk->baseValue.d = values[0];
+        cmpChunk->prevTimestamp = timestamps[count - 1];
+        cmpChunk->prevValue.d = values[count - 1];
+        cmpChunk->frozen = frozen;
+    }
+    free(timestamps);
+    free(values);
+}
+
+// Rebuilds the checkpoints of a chunk by decoding it, used when loading a chunk
+void Compressed_RebuildCheckpoints(Chunk_t *cmpChunk, uint32_t interval) {
+    CompressedChunk *chunk = cmpChunk;
+    free(chunk->checkpoints);
+    chunk->checkpoints = NULL;
+    chunk->numCheckpoints = 0;
+    chunk->checkpointInterval = interval;
+    // a frozen chunk is indexed by its blocks
+    if (interval == 0 || chunk->count <= interval || chunk->frozen) {
+        return;
+    }
+
+    timestamp_t timestamps[DECOMPRESS_BLOCK_SIZE];
+    double values[DECOMPRESS_BLOCK_SIZE];
+    Compressed_Iterator iter;
+    Compressed_ResetChunkIterator(&iter, chunk);
+    // the last sample doesn't need a checkpoint, nothing is left to decode after it
+    while (iter.count + interval < chunk->count) {
+        const uint64_t next = iter.count + interval;
+        while (iter.count < next) {
+            Compressed_ChunkIteratorGetNextBlock(
+                &iter, timestamps, values, min(next - iter.count, DECOMPRESS_BLOCK_SIZE));
+        }
+        const CompressedCheckpoint checkpoint = {
+            .prevTS = iter.prevTS,
+            .prevDelta = iter.prevDelta,
+            .prevValue = iter.prevValue,
+            .prevScaledDelta = iter.prevScaledDelta,
+            .idx = iter.idx,
+            .leading = iter.leading,
+            .trailing = iter.trailing,
+        };
+        addCheckpoint(chunk, &checkpoint);
+    }
+}
+
+// Rebuilds the summary of a chunk by decoding it, used when loading a chunk
+static void rebuildSummary(CompressedChunk *chunk) {
+    ChunkSummary_Reset(&chunk->summary);
+    if (chunk->frozen || chunk->numOOOSamples > 0) {
+        MergedIterator mIter;
+        MergedIterator_Init(&mIter, chunk);
+        Sample sample;
+        while (MergedIterator_GetNext(&mIter, &sample)) {
+            ChunkSummary_Add(&chunk->summary, &sample);
+        }
+        return;
+    }
+    timestamp_t timestamps[DECOMPRESS_BLOCK_SIZE];
+    double values[DECOMPRESS_BLOCK_SIZE];
+    Compressed_Iterator iter;
+    Compressed_ResetChunkIterator(&iter, chunk);
+    size_t n;
+    while ((n = Compressed_ChunkIteratorGetNextBlock(
+                &iter, timestamps, values, DECOMPRESS_BLOCK_SIZE)) > 0) {
+        for (size_t i = 0; i < n; ++i) {
+            const Sample sample = { .timestamp = timestamps[i], .value = values[i] };
+            ChunkSummary_Add(&chunk->summary, &sample);
+        }
+    }
+}
+
+const ChunkSummary *Compressed_GetSummary(const Chunk_t *chunk) {
+    return ChunkSummary_Get(&((const CompressedChunk *)chunk)->summary);
+}
+
+size_t Compressed_GetCheckpointsSize(const Chunk_t *chunk) {
+    const CompressedChunk *cmpChunk = chunk;
+    return cmpChunk->checkpoints ? RedisModule_MallocSize(cmpChunk->checkpoints) : 0;
 }
 
 uint64_t Compressed_ChunkNumOfSample(Chunk_t *chunk) {
-    return ((CompressedChunk *)chunk)->count;
+    const CompressedChunk *cmpChunk = chunk;
+    return cmpChunk->count + cmpChunk->numOOOSamples - cmpChunk->numOOOOverrides;
 }
 
 timestamp_t Compressed_GetFirstTimestamp(Chunk_t *chunk) {
@@ -206,42 +687,60 @@ timestamp_t Compressed_GetFirstTimestamp(Chunk_t *chunk) {
         0) { // When the chunk is empty it first TS is used for the chunk dict key
         return 0;
     }
-    return ((CompressedChunk *)chunk)->baseTimestamp;
+    const CompressedChunk *cmpChunk = chunk;
+    if (cmpChunk->numOOOSamples > 0) {
+        return min(cmpChunk->baseTimestamp, cmpChunk->oooSamples[0].timestamp);
+    }
+    return cmpChunk->baseTimestamp;
 }
 
 timestamp_t Compressed_GetLastTimestamp(Chunk_t *chunk) {
     if (unlikely(((CompressedChunk *)chunk)->count == 0)) { // empty chunks are being removed
         RedisModule_Log(mr_staticCtx, "error", "Trying to get the last timestamp of empty chunk");
     }
-    return ((CompressedChunk *)chunk)->prevTimestamp;
+    const CompressedChunk *cmpChunk = chunk;
+    if (cmpChunk->numOOOSamples > 0) {
+        return max(cmpChunk->prevTimestamp,
+                   cmpChunk->oooSamples[cmpChunk->numOOOSamples - 1].timestamp);
+    }
+    return cmpChunk->prevTimestamp;
 }
 
 double Compressed_GetLastValue(Chunk_t *chunk) {
     if (unlikely(((CompressedChunk *)chunk)->count == 0)) { // empty chunks are being removed
         RedisModule_Log(mr_staticCtx, "error", "Trying to get the last value of empty chunk");
     }
-    return ((CompressedChunk *)chunk)->prevValue.d;
+    const CompressedChunk *cmpChunk = chunk;
+    if (cmpChunk->numOOOSamples > 0) {
+        const Sample *last = &cmpChunk->oooSamples[cmpChunk->numOOOSamples - 1];
+        if (last->timestamp >= cmpChunk->prevTimestamp) {
+            return last->value;
+        }
+    }
+    return cmpChunk->prevValue.d;
 }
 
 size_t Compressed_GetChunkSize(const Chunk_t *chunk, bool includeStruct) {
     const CompressedChunk *cmpChunk = chunk;
-    size_t size = includeStruct ? RedisModule_MallocSize((void *)cmpChunk) +
-                                      RedisModule_MallocSize(cmpChunk->data)
-                                : cmpChunk->size;
-    return size;
+    if (!includeStruct) {
+        return cmpChunk->frozen ? Frozen_Size(cmpChunk->frozen) : cmpChunk->size;
+    }
+    return RedisModule_MallocSize((void *)cmpChunk) +
+           (cmpChunk->data ? RedisModule_MallocSize(cmpChunk->data) : 0) +
+           (cmpChunk->frozen ? RedisModule_MallocSize(cmpChunk->frozen) : 0) +
+           Compressed_GetCheckpointsSize(cmpChunk) +
+           (cmpChunk->oooSamples ? RedisModule_MallocSize(cmpChunk->oooSamples) : 0);
 }
 
 size_t Compressed_DelRange(Chunk_t *chunk, timestamp_t startTs, timestamp_t endTs) {
     CompressedChunk *oldChunk = (CompressedChunk *)chunk;
     size_t newSize = oldChunk->size; // mem size
-    CompressedChunk *newChunk = Compressed_NewChunk(newSize);
-    Compressed_Iterator *iter = Compressed_NewChunkIterator(oldChunk);
-    size_t i = 0;
+    CompressedChunk *newChunk = newChunkLike(oldChunk, newSize);
+    MergedIterator mIter;
+    MergedIterator_Init(&mIter, oldChunk);
     size_t deleted_count = 0;
     Sample iterSample;
-    int numSamples = oldChunk->count; // sample size
-    for (; i < numSamples; ++i) {
-        Compressed_ChunkIteratorGetNext(iter, &iterSample);
+    while (MergedIterator_GetNext(&mIter, &iterSample)) {
         if (iterSample.timestamp >= startTs && iterSample.timestamp <= endTs) {
             // in delete range, skip adding to the new chunk
             deleted_count++;
@@ -249,180 +748,309 @@ size_t Compressed_DelRange(Chunk_t *chunk, timestamp_t startTs, timestamp_t endT
         }
         ensureAddSample(newChunk, &iterSample);
     }
+    const bool sealed = oldChunk->sealed;
     swapChunks(newChunk, oldChunk);
-    Compressed_FreeChunkIterator(iter);
     Compressed_FreeChunk(newChunk);
+    if (sealed) {
+        Compressed_SealChunk(oldChunk);
+    }
     return deleted_count;
 }
 
-// TODO: convert to template and unify with decompressChunk when moving to RUST
-// decompress chunk reverse
-static inline void decompressChunkReverse(const CompressedChunk *compressedChunk,
-                                          uint64_t start,
-                                          uint64_t end,
-                                          EnrichedChunk *enrichedChunk) {
-    uint64_t numSamples = compressedChunk->count;
-    uint64_t lastTS = compressedChunk->prevTimestamp;
-    Sample sample;
-    ResetEnrichedChunk(enrichedChunk);
-    if (unlikely(numSamples == 0 || end < start || compressedChunk->baseTimestamp > end ||
-                 lastTS < start)) {
-        return;
+// returns the index of the first timestamp which is >= ts, or n if there is none
+static inline size_t lowerBoundTS(const timestamp_t *timestamps, size_t n, timestamp_t ts) {
+    size_t l = 0, h = n;
+    while (l < h) {
+        const size_t m = l + (h - l) / 2;
+        if (timestamps[m] < ts) {
+            l = m + 1;
+        } else {
+            h = m;
+        }
     }
+    return l;
+}
 
-    Compressed_Iterator *iter = Compressed_NewChunkIterator(compressedChunk);
-    timestamp_t *timestamps_ptr = enrichedChunk->samples.timestamps + numSamples - 1;
-    double *values_ptr = enrichedChunk->samples.values + numSamples - 1;
-
-    // find the first sample which is greater than start
-    Compressed_ChunkIteratorGetNext(iter, &sample);
-    while (sample.timestamp < start && iter->count < numSamples) {
-        Compressed_ChunkIteratorGetNext(iter, &sample);
+// returns the index of the first timestamp which is > ts, or n if there is none
+static inline size_t upperBoundTS(const timestamp_t *timestamps, size_t n, timestamp_t ts) {
+    size_t l = 0, h = n;
+    while (l < h) {
+        const size_t m = l + (h - l) / 2;
+        if (timestamps[m] <= ts) {
+            l = m + 1;
+        } else {
+            h = m;
+        }
     }
+    return l;
+}
 
-    if (unlikely(sample.timestamp > end)) {
-        // occurs when the are TS smaller than start and larger than end but nothing in the range.
-        Compressed_FreeChunkIterator(iter);
+// Moves the iterator to the last checkpoint which precedes `start`, all the samples before the
+// checkpoint are known to be smaller than `start`.
+static inline void seekToCheckpoint(const CompressedChunk *chunk,
+                                    timestamp_t start,
+                                    Compressed_Iterator *iter) {
+    const CompressedCheckpoint *checkpoints = chunk->checkpoints;
+    size_t l = 0, h = chunk->numCheckpoints;
+    while (l < h) {
+        const size_t m = l + (h - l) / 2;
+        if (checkpoints[m].prevTS < start) {
+            l = m + 1;
+        } else {
+            h = m;
+        }
+    }
+    if (l == 0) {
         return;
     }
-    *timestamps_ptr-- = sample.timestamp;
-    *values_ptr-- = sample.value;
-
-    if (lastTS > end) { // the range not include the whole chunk
-        // 4 samples per iteration
-        const size_t n = numSamples >= 4 ? numSamples - 4 : 0;
-        while (iter->count < n) {
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr-- = sample.timestamp;
-            *values_ptr-- = sample.value;
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr-- = sample.timestamp;
-            *values_ptr-- = sample.value;
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr-- = sample.timestamp;
-            *values_ptr-- = sample.value;
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr-- = sample.timestamp;
-            *values_ptr-- = sample.value;
-            if (unlikely(*(timestamps_ptr + 1) > end)) {
-                while (*(timestamps_ptr + 1) > end) {
-                    ++timestamps_ptr;
-                    ++values_ptr;
-                }
-                goto _done;
-            }
-        }
 
-        // left-overs
-        while (iter->count < numSamples) {
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            if (sample.timestamp > end) {
-                goto _done;
-            }
-            *timestamps_ptr-- = sample.timestamp;
-            *values_ptr-- = sample.value;
-        }
-    } else {
-        while (iter->count < numSamples) {
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr-- = sample.timestamp;
-            *values_ptr-- = sample.value;
-        }
+    Compressed_ChunkIteratorSeek(iter, &checkpoints[l - 1], l * chunk->checkpointInterval);
+}
+
+// The timestamp of the last sample on the interval, the chunk must have one
+static inline timestamp_t lastIntervalTimestamp(const CompressedChunk *chunk) {
+    return chunk->baseTimestamp + (chunk->intervalCount - 1) * chunk->interval;
+}
+
+// Index of the first sample on the interval which timestamp is >= ts, ts must not be after
+// lastIntervalTimestamp
+static inline uint64_t intervalLowerBound(const CompressedChunk *chunk, timestamp_t ts) {
+    if (ts <= chunk->baseTimestamp) {
+        return 0;
     }
+    return (ts - chunk->baseTimestamp + chunk->interval - 1) / chunk->interval;
+}
 
-_done:
-    enrichedChunk->samples.timestamps = timestamps_ptr + 1;
-    enrichedChunk->samples.values = values_ptr + 1;
-    enrichedChunk->samples.num_samples =
-        enrichedChunk->samples.og_timestamps + numSamples - enrichedChunk->samples.timestamps;
-    enrichedChunk->rev = true;
+// Index of the first sample on the interval which timestamp is > ts, ts must be between the base
+// timestamp and lastIntervalTimestamp
+static inline uint64_t intervalUpperBound(const CompressedChunk *chunk, timestamp_t ts) {
+    if (chunk->intervalCount == 1) {
+        return 1;
+    }
+    return (ts - chunk->baseTimestamp) / chunk->interval + 1;
+}
 
-    Compressed_FreeChunkIterator(iter);
+// Moves the iterator to the last checkpoint which precedes the sample at `index`
+static inline void seekToIndex(const CompressedChunk *chunk,
+                               uint64_t index,
+                               Compressed_Iterator *iter) {
+    if (chunk->checkpointInterval == 0) {
+        return;
+    }
+    const uint64_t l = min(index / chunk->checkpointInterval, chunk->numCheckpoints);
+    if (l == 0) {
+        return;
+    }
+    Compressed_ChunkIteratorSeek(iter, &chunk->checkpoints[l - 1], l * chunk->checkpointInterval);
+}
 
-    return;
+// Decodes the frozen blocks which may hold samples in [start, end], the first one is found with a
+// binary search over the block headers
+static inline size_t decodeFrozenBlocks(const CompressedChunk *compressedChunk,
+                                        uint64_t start,
+                                        uint64_t end,
+                                        timestamp_t *timestamps,
+                                        double *values) {
+    const FrozenChunk *frozen = compressedChunk->frozen;
+    uint32_t block = start > compressedChunk->baseTimestamp ? Frozen_SeekBlock(frozen, start) : 0;
+    size_t decoded = 0;
+    for (; block < frozen->numBlocks && frozen->blocks[block].baseTimestamp <= end; ++block) {
+        decoded += Frozen_DecodeBlock(frozen, block, timestamps + decoded, values + decoded);
+    }
+    return decoded;
 }
 
 // decompress chunk
+// Decoding starts from the nearest checkpoint before `start` (or from the chunk base) and the
+// samples are decoded in blocks straight into the enriched chunk buffers, we stop decoding as
+// soon as a block passes `end`. The range bounds are then found with a binary search over the
+// decoded timestamps and the enriched chunk points into the decoded buffers.
+// When the range ends on the chunk interval, the bounds are computed from the interval and only
+// the samples in the range (and from the checkpoint before it) are decoded.
 static inline void decompressChunk(const CompressedChunk *compressedChunk,
                                    uint64_t start,
                                    uint64_t end,
                                    EnrichedChunk *enrichedChunk) {
     uint64_t numSamples = compressedChunk->count;
     uint64_t lastTS = compressedChunk->prevTimestamp;
-    Sample sample;
-    ChunkResult res;
     ResetEnrichedChunk(enrichedChunk);
     if (unlikely(numSamples == 0 || end < start || compressedChunk->baseTimestamp > end ||
                  lastTS < start)) {
         return;
     }
 
-    Compressed_Iterator *iter = Compressed_NewChunkIterator(compressedChunk);
-    timestamp_t *timestamps_ptr = enrichedChunk->samples.timestamps;
-    double *values_ptr = enrichedChunk->samples.values;
-
-    // find the first sample which is greater than start
-    res = Compressed_ChunkIteratorGetNext(iter, &sample);
-    while (sample.timestamp < start && res == CR_OK) {
-        res = Compressed_ChunkIteratorGetNext(iter, &sample);
+    timestamp_t *timestamps = enrichedChunk->samples.timestamps;
+    double *values = enrichedChunk->samples.values;
+    size_t decoded = 0;
+    if (compressedChunk->frozen) {
+        decoded = decodeFrozenBlocks(compressedChunk, start, end, timestamps, values);
+    } else if (compressedChunk->intervalCount > 0 &&
+               end <= lastIntervalTimestamp(compressedChunk)) {
+        const uint64_t si = intervalLowerBound(compressedChunk, start);
+        const uint64_t ei = intervalUpperBound(compressedChunk, end);
+        if (unlikely(si >= ei)) {
+            return;
+        }
+        Compressed_Iterator iter;
+        Compressed_ResetChunkIterator(&iter, compressedChunk);
+        seekToIndex(compressedChunk, si, &iter);
+        const uint64_t first = iter.count;
+        Compressed_ChunkIteratorGetNextBlock(&iter, timestamps, values, ei - first);
+        enrichedChunk->samples.timestamps = timestamps + (si - first);
+        enrichedChunk->samples.values = values + (si - first);
+        enrichedChunk->samples.num_samples = ei - si;
+        return;
+    } else {
+        Compressed_Iterator iter;
+        Compressed_ResetChunkIterator(&iter, compressedChunk);
+        if (start > compressedChunk->baseTimestamp) {
+            seekToCheckpoint(compressedChunk, start, &iter);
+        }
+        numSamples -= iter.count;
+
+        if (lastTS > end) { // the range not include the whole chunk
+            while (decoded < numSamples) {
+                decoded += Compressed_ChunkIteratorGetNextBlock(
+                    &iter, timestamps + decoded, values + decoded, DECOMPRESS_BLOCK_SIZE);
+                if (timestamps[decoded - 1] > end) {
+                    break;
+                }
+            }
+        } else {
+            decoded = Compressed_ChunkIteratorGetNextBlock(&iter, timestamps, values, numSamples);
+        }
     }
 
-    if (unlikely(sample.timestamp > end)) {
+    const size_t si = lowerBoundTS(timestamps, decoded, start);
+    const size_t ei = upperBoundTS(timestamps, decoded, end);
+    if (unlikely(si >= ei)) {
         // occurs when the are TS smaller than start and larger than end but nothing in the range.
-        Compressed_FreeChunkIterator(iter);
         return;
     }
-    *timestamps_ptr++ = sample.timestamp;
-    *values_ptr++ = sample.value;
-
-    if (lastTS > end) { // the range not include the whole chunk
-        // 4 samples per iteration
-        const size_t n = numSamples >= 4 ? numSamples - 4 : 0;
-        while (iter->count < n) {
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr++ = sample.timestamp;
-            *values_ptr++ = sample.value;
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr++ = sample.timestamp;
-            *values_ptr++ = sample.value;
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr++ = sample.timestamp;
-            *values_ptr++ = sample.value;
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr++ = sample.timestamp;
-            *values_ptr++ = sample.value;
-            if (unlikely(*(timestamps_ptr - 1) > end)) {
-                while (*(timestamps_ptr - 1) > end) {
-                    --timestamps_ptr;
-                    --values_ptr;
-                }
-                goto _done;
-            }
-        }
 
-        // left-overs
-        while (iter->count < numSamples) {
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            if (sample.timestamp > end) {
-                goto _done;
-            }
-            *timestamps_ptr++ = sample.timestamp;
-            *values_ptr++ = sample.value;
+    enrichedChunk->samples.timestamps = timestamps + si;
+    enrichedChunk->samples.values = values + si;
+    enrichedChunk->samples.num_samples = ei - si;
+}
+
+// Looks for the encoded sample with the given timestamp in the frozen block which may hold it
+static bool findFrozenSample(const FrozenChunk *frozen, timestamp_t ts, Sample *sample) {
+    timestamp_t timestamps[FROZEN_BLOCK_SAMPLES];
+    double values[FROZEN_BLOCK_SAMPLES];
+    const size_t n =
+        Frozen_DecodeBlock(frozen, Frozen_SeekBlock(frozen, ts), timestamps, values);
+    const size_t i = lowerBoundTS(timestamps, n, ts);
+    if (i == n || timestamps[i] != ts) {
+        return false;
+    }
+    sample->timestamp = ts;
+    sample->value = values[i];
+    return true;
+}
+
+// Looks for the encoded sample with the given timestamp, decoding from the nearest checkpoint.
+// The index of a sample on the chunk interval is computed, only its value is decoded.
+static bool findEncodedSample(const CompressedChunk *chunk, timestamp_t ts, Sample *sample) {
+    if (chunk->frozen) {
+        return findFrozenSample(chunk->frozen, ts, sample);
+    }
+    timestamp_t timestamps[DECOMPRESS_BLOCK_SIZE];
+    double values[DECOMPRESS_BLOCK_SIZE];
+    Compressed_Iterator iter;
+    Compressed_ResetChunkIterator(&iter, chunk);
+    if (chunk->intervalCount > 0 && ts <= lastIntervalTimestamp(chunk)) {
+        const uint64_t i = intervalLowerBound(chunk, ts);
+        if (ts < chunk->baseTimestamp || chunk->baseTimestamp + i * chunk->interval != ts) {
+            return false;
         }
-    } else {
-        while (iter->count < numSamples) {
-            Compressed_ChunkIteratorGetNext(iter, &sample);
-            *timestamps_ptr++ = sample.timestamp;
-            *values_ptr++ = sample.value;
+        seekToIndex(chunk, i, &iter);
+        size_t n = 0;
+        while (iter.count <= i) {
+            n = Compressed_ChunkIteratorGetNextBlock(
+                &iter, timestamps, values, min(i + 1 - iter.count, DECOMPRESS_BLOCK_SIZE));
+        }
+        sample->timestamp = ts;
+        sample->value = values[n - 1];
+        return true;
+    }
+    seekToCheckpoint(chunk, ts, &iter);
+    size_t n;
+    while ((n = Compressed_ChunkIteratorGetNextBlock(
+                &iter, timestamps, values, DECOMPRESS_BLOCK_SIZE)) > 0) {
+        if (timestamps[n - 1] < ts) {
+            continue;
         }
+        const size_t i = lowerBoundTS(timestamps, n, ts);
+        if (timestamps[i] != ts) {
+            return false;
+        }
+        sample->timestamp = ts;
+        sample->value = values[i];
+        return true;
+    }
+    return false;
+}
+
+// Tells whether the encoded samples hold the timestamp, returns false when that isn't known
+// without decoding them
+static bool encodedTimestampKnown(const CompressedChunk *chunk, timestamp_t ts, bool *found) {
+    if (ts < chunk->baseTimestamp || ts > chunk->prevTimestamp) {
+        *found = false;
+    } else if (ts == chunk->baseTimestamp || ts == chunk->prevTimestamp) {
+        *found = true;
+    } else if (!chunk->frozen && chunk->intervalCount > 0 && ts <= lastIntervalTimestamp(chunk)) {
+        *found = (ts - chunk->baseTimestamp) % chunk->interval == 0;
+    } else {
+        return false;
     }
+    return true;
+}
 
-_done:
-    enrichedChunk->samples.num_samples = timestamps_ptr - enrichedChunk->samples.timestamps;
+// Merges the out of order samples in [start, end] into the decoded samples of the enriched chunk.
+// The merge is done in place from the end, the enriched chunk has room for all the samples of the
+// chunk and the decoded samples never start after the index of their position in the chunk.
+static void mergeOOOSamples(const CompressedChunk *chunk,
+                            uint64_t start,
+                            uint64_t end,
+                            EnrichedChunk *enrichedChunk) {
+    const Sample *ooo = chunk->oooSamples;
+    const size_t oi = lowerBoundSample(ooo, chunk->numOOOSamples, start);
+    size_t oe = oi;
+    while (oe < chunk->numOOOSamples && ooo[oe].timestamp <= end) {
+        ++oe;
+    }
+    if (oi == oe) {
+        return;
+    }
 
-    Compressed_FreeChunkIterator(iter);
+    timestamp_t *timestamps = enrichedChunk->samples.timestamps;
+    double *values = enrichedChunk->samples.values;
+    const size_t n = enrichedChunk->samples.num_samples;
+    size_t overrides = 0;
+    for (size_t i = oi; i < oe; ++i) {
+        const size_t j = lowerBoundTS(timestamps, n, ooo[i].timestamp);
+        overrides += j < n && timestamps[j] == ooo[i].timestamp;
+    }
 
-    return;
+    const size_t total = n + (oe - oi) - overrides;
+    size_t r = n, w = total;
+    while (oe > oi) {
+        const Sample *sample = &ooo[oe - 1];
+        --w;
+        if (r > 0 && timestamps[r - 1] > sample->timestamp) {
+            --r;
+            timestamps[w] = timestamps[r];
+            values[w] = values[r];
+        } else {
+            if (r > 0 && timestamps[r - 1] == sample->timestamp) {
+                --r; // overridden
+            }
+            timestamps[w] = sample->timestamp;
+            values[w] = sample->value;
+            --oe;
+        }
+    }
+    enrichedChunk->samples.num_samples = total;
 }
 
 /************************
@@ -447,6 +1075,11 @@ void Compressed_ResetChunkIterator(ChunkIter_t *iterator, const Chunk_t *chunk)
     iter->leading = 32;
     iter->trailing = 32;
     iter->blocksize = 0;
+    iter->prevScaledValue = compressedChunk->valueEncoding == VALUE_ENCODING_DECIMAL
+                                ? Decimal_ToScaled(compressedChunk->baseValue.d,
+                                                   compressedChunk->decimalScale)
+                                : 0;
+    iter->prevScaledDelta = 0;
     iterator = (ChunkIter_t *)iter;
 }
 
@@ -471,10 +1104,12 @@ void Compressed_ProcessChunk(const Chunk_t *chunk,
     }
     const CompressedChunk *compressedChunk = chunk;
 
-    if (unlikely(reverse)) {
-        decompressChunkReverse(compressedChunk, start, end, enrichedChunk);
-    } else {
-        decompressChunk(compressedChunk, start, end, enrichedChunk);
+    decompressChunk(compressedChunk, start, end, enrichedChunk);
+    if (unlikely(compressedChunk->numOOOSamples > 0)) {
+        mergeOOOSamples(compressedChunk, start, end, enrichedChunk);
+    }
+    if (unlikely(reverse && enrichedChunk->samples.num_samples > 0)) {
+        reverseEnrichedChunk(enrichedChunk);
     }
 
     return;
@@ -485,12 +1120,21 @@ typedef void (*SaveStringBufferFunc)(void *, const char *str, size_t len);
 typedef uint64_t (*ReadUnsignedFunc)(void *);
 typedef char *(*ReadStringBufferFunc)(void *, size_t *);
 
+// Decimal and Chimp chunks are saved with their value encoding state ahead of the compressed chunk
+// fields. The chunk is saved as it is in memory: the interval timestamps, the out of order samples
+// and the frozen samples follow the encoded data, which is empty for a frozen chunk.
 static void Compressed_Serialize(Chunk_t *chunk,
                                  void *ctx,
                                  SaveUnsignedFunc saveUnsigned,
-                                 SaveStringBufferFunc saveStringBuffer) {
+                                 SaveStringBufferFunc saveStringBuffer,
+                                 bool valueEncoding) {
     CompressedChunk *compchunk = chunk;
-
+    if (valueEncoding) {
+        saveUnsigned(ctx, compchunk->valueEncoding);
+        saveUnsigned(ctx, compchunk->decimalScale);
+        saveUnsigned(ctx, compchunk->prevScaledValue);
+        saveUnsigned(ctx, compchunk->prevScaledDelta);
+    }
     saveUnsigned(ctx, compchunk->size);
     saveUnsigned(ctx, compchunk->count);
     saveUnsigned(ctx, compchunk->idx);
@@ -501,17 +1145,77 @@ static void Compressed_Serialize(Chunk_t *chunk,
     saveUnsigned(ctx, compchunk->prevValue.u);
     saveUnsigned(ctx, compchunk->prevLeading);
     saveUnsigned(ctx, compchunk->prevTrailing);
-    saveStringBuffer(ctx, (char *)compchunk->data, compchunk->size);
+    if (compchunk->data) {
+        saveStringBuffer(ctx, (char *)compchunk->data, compchunk->size);
+    } else {
+        saveStringBuffer(ctx, "", 0);
+    }
+
+    saveUnsigned(ctx, compchunk->timestampEncoding);
+    saveUnsigned(ctx, compchunk->interval);
+    saveUnsigned(ctx, compchunk->intervalCount);
+    saveUnsigned(ctx, compchunk->numOOOOverrides);
+    saveUnsigned(ctx, compchunk->numOOOPending);
+    if (compchunk->numOOOSamples > 0) {
+        saveStringBuffer(
+            ctx, (char *)compchunk->oooSamples, compchunk->numOOOSamples * sizeof(Sample));
+    } else {
+        saveStringBuffer(ctx, "", 0);
+    }
+    saveUnsigned(ctx, compchunk->sealed);
+    if (compchunk->frozen) {
+        saveStringBuffer(ctx, (char *)compchunk->frozen, Frozen_Size(compchunk->frozen));
+    } else {
+        saveStringBuffer(ctx, "", 0);
+    }
+}
+
+// Takes the saved out of order samples and frozen samples, returns false if they're invalid
+static bool restoreSavedLayout(CompressedChunk *compchunk,
+                               char *oooSamples,
+                               size_t oooLen,
+                               char *frozen,
+                               size_t frozenLen) {
+    compchunk->numOOOSamples = oooLen / sizeof(Sample);
+    if (compchunk->numOOOSamples > 0) {
+        // the array grows in powers of 2
+        compchunk->oooSamples =
+            realloc(oooSamples, arrayCapacity(compchunk->numOOOSamples) * sizeof(Sample));
+    } else {
+        free(oooSamples);
+    }
+    if (frozenLen > 0) {
+        compchunk->frozen = (FrozenChunk *)frozen;
+        free(compchunk->data);
+        compchunk->data = NULL;
+    } else {
+        free(frozen);
+    }
+    return oooLen % sizeof(Sample) == 0 &&
+           (uint64_t)compchunk->numOOOOverrides + compchunk->numOOOPending <=
+               compchunk->numOOOSamples &&
+           compchunk->timestampEncoding <= TIMESTAMP_ENCODING_DELTA &&
+           (frozenLen == 0 ||
+            (frozenLen >= sizeof(FrozenChunk) && Frozen_Size(compchunk->frozen) == frozenLen));
 }
 
 void Compressed_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io) {
     Compressed_Serialize(chunk,
                          io,
                          (SaveUnsignedFunc)RedisModule_SaveUnsigned,
-                         (SaveStringBufferFunc)RedisModule_SaveStringBuffer);
+                         (SaveStringBufferFunc)RedisModule_SaveStringBuffer,
+                         false);
 }
 
-int Compressed_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
+void Decimal_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io) {
+    Compressed_Serialize(chunk,
+                         io,
+                         (SaveUnsignedFunc)RedisModule_SaveUnsigned,
+                         (SaveStringBufferFunc)RedisModule_SaveStringBuffer,
+                         true);
+}
+
+static int loadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io, bool valueEncoding) {
     bool err = false;
     errdefer(err, *chunk = NULL);
 
@@ -519,6 +1223,37 @@ int Compressed_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
     errdefer(err, Compressed_FreeChunk(compchunk));
 
     compchunk->data = NULL;
+    compchunk->checkpoints = NULL;
+    compchunk->numCheckpoints = 0;
+    compchunk->checkpointInterval = 0;
+    compchunk->oooSamples = NULL;
+    compchunk->numOOOSamples = 0;
+    compchunk->numOOOOverrides = 0;
+    compchunk->numOOOPending = 0;
+    compchunk->valueEncoding = VALUE_ENCODING_GORILLA;
+    compchunk->decimalScale = 0;
+    compchunk->prevScaledValue = 0;
+    compchunk->prevScaledDelta = 0;
+    compchunk->sealed = false;
+    compchunk->frozen = NULL;
+    // the timestamps saved before the interval encoding are all delta of deltas, a loaded empty
+    // chunk starts on an interval
+    compchunk->timestampEncoding = TIMESTAMP_ENCODING_INTERVAL;
+    compchunk->interval = 0;
+    compchunk->intervalCount = 0;
+    ChunkSummary_Reset(&compchunk->summary);
+    if (valueEncoding) {
+        compchunk->valueEncoding = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->decimalScale = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->prevScaledValue = (int64_t)LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->prevScaledDelta = (int64_t)LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        if (compchunk->valueEncoding > VALUE_ENCODING_CHIMP ||
+            compchunk->decimalScale > DECIMAL_MAX_SCALE) {
+            RedisModule_LogIOError(io, "error", "invalid value encoding");
+            err = true;
+            return TSDB_ERROR;
+        }
+    }
     compchunk->size = LoadUnsigned_IOError(io, err, TSDB_ERROR);
     compchunk->count = LoadUnsigned_IOError(io, err, TSDB_ERROR);
     compchunk->idx = LoadUnsigned_IOError(io, err, TSDB_ERROR);
@@ -532,22 +1267,99 @@ int Compressed_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
 
     size_t len;
     compchunk->data = (uint64_t *)LoadStringBuffer_IOError(io, &len, err, TSDB_ERROR);
+    if (last_rdb_load_version >= TS_NATIVE_CHUNKS_VER) {
+        compchunk->timestampEncoding = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->interval = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->intervalCount = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->numOOOOverrides = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        compchunk->numOOOPending = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        size_t oooLen;
+        char *oooSamples = LoadStringBuffer_IOError(io, &oooLen, err, TSDB_ERROR);
+        compchunk->sealed = LoadUnsigned_IOError(io, err, TSDB_ERROR);
+        size_t frozenLen;
+        char *frozen = LoadStringBuffer_IOError(io, &frozenLen, err, TSDB_ERROR);
+        if (!restoreSavedLayout(compchunk, oooSamples, oooLen, frozen, frozenLen)) {
+            RedisModule_LogIOError(io, "error", "invalid chunk layout");
+            err = true;
+            return TSDB_ERROR;
+        }
+    }
+    // checkpoints and the summary aren't persisted, they are rebuilt according to the current
+    // configuration
+    Compressed_RebuildCheckpoints(compchunk, TSGlobalConfig.chunkCheckpointInterval);
+    rebuildSummary(compchunk);
     *chunk = (Chunk_t *)compchunk;
 
     return TSDB_OK;
 }
 
+int Compressed_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
+    return loadFromRDB(chunk, io, false);
+}
+
+int Decimal_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
+    return loadFromRDB(chunk, io, true);
+}
+
+void Chimp_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io) {
+    Compressed_Serialize(chunk,
+                         io,
+                         (SaveUnsignedFunc)RedisModule_SaveUnsigned,
+                         (SaveStringBufferFunc)RedisModule_SaveStringBuffer,
+                         true);
+}
+
+int Chimp_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io) {
+    return loadFromRDB(chunk, io, true);
+}
+
 void Compressed_MRSerialize(Chunk_t *chunk, WriteSerializationCtx *sctx) {
     Compressed_Serialize(chunk,
                          sctx,
                          (SaveUnsignedFunc)MR_SerializationCtxWriteLongLongWrapper,
-                         (SaveStringBufferFunc)MR_SerializationCtxWriteBufferWrapper);
+                         (SaveStringBufferFunc)MR_SerializationCtxWriteBufferWrapper,
+                         false);
 }
 
-int Compressed_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx) {
+void Decimal_MRSerialize(Chunk_t *chunk, WriteSerializationCtx *sctx) {
+    Compressed_Serialize(chunk,
+                         sctx,
+                         (SaveUnsignedFunc)MR_SerializationCtxWriteLongLongWrapper,
+                         (SaveStringBufferFunc)MR_SerializationCtxWriteBufferWrapper,
+                         true);
+}
+
+static int mrDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx, bool valueEncoding) {
     CompressedChunk *compchunk = (CompressedChunk *)malloc(sizeof(*compchunk));
 
     compchunk->data = NULL;
+    compchunk->checkpoints = NULL;
+    compchunk->numCheckpoints = 0;
+    compchunk->checkpointInterval = 0;
+    compchunk->oooSamples = NULL;
+    compchunk->numOOOSamples = 0;
+    compchunk->numOOOOverrides = 0;
+    compchunk->numOOOPending = 0;
+    compchunk->valueEncoding = VALUE_ENCODING_GORILLA;
+    compchunk->decimalScale = 0;
+    compchunk->prevScaledValue = 0;
+    compchunk->prevScaledDelta = 0;
+    compchunk->sealed = false;
+    compchunk->frozen = NULL;
+    // the timestamps saved before the interval encoding are all delta of deltas, a loaded empty
+    // chunk starts on an interval
+    compchunk->timestampEncoding = TIMESTAMP_ENCODING_INTERVAL;
+    compchunk->interval = 0;
+    compchunk->intervalCount = 0;
+    // a chunk read by a remote query is decoded once, rebuilding its summary costs the same
+    ChunkSummary_Reset(&compchunk->summary);
+    compchunk->summary.stale = true;
+    if (valueEncoding) {
+        compchunk->valueEncoding = MR_SerializationCtxReadLongLongWrapper(sctx);
+        compchunk->decimalScale = MR_SerializationCtxReadLongLongWrapper(sctx);
+        compchunk->prevScaledValue = (int64_t)MR_SerializationCtxReadLongLongWrapper(sctx);
+        compchunk->prevScaledDelta = (int64_t)MR_SerializationCtxReadLongLongWrapper(sctx);
+    }
     compchunk->size = MR_SerializationCtxReadLongLongWrapper(sctx);
     compchunk->count = MR_SerializationCtxReadLongLongWrapper(sctx);
     compchunk->idx = MR_SerializationCtxReadLongLongWrapper(sctx);
@@ -561,6 +1373,37 @@ int Compressed_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx) {
 
     size_t len;
     compchunk->data = (uint64_t *)MR_ownedBufferFrom(sctx, &len);
+    compchunk->timestampEncoding = MR_SerializationCtxReadLongLongWrapper(sctx);
+    compchunk->interval = MR_SerializationCtxReadLongLongWrapper(sctx);
+    compchunk->intervalCount = MR_SerializationCtxReadLongLongWrapper(sctx);
+    compchunk->numOOOOverrides = MR_SerializationCtxReadLongLongWrapper(sctx);
+    compchunk->numOOOPending = MR_SerializationCtxReadLongLongWrapper(sctx);
+    size_t oooLen;
+    char *oooSamples = MR_ownedBufferFrom(sctx, &oooLen);
+    compchunk->sealed = MR_SerializationCtxReadLongLongWrapper(sctx);
+    size_t frozenLen;
+    char *frozen = MR_ownedBufferFrom(sctx, &frozenLen);
+    restoreSavedLayout(compchunk, oooSamples, oooLen, frozen, frozenLen);
     *chunk = (Chunk_t *)compchunk;
     return TSDB_OK;
 }
+
+int Compressed_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx) {
+    return mrDeserialize(chunk, sctx, false);
+}
+
+int Decimal_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx) {
+    return mrDeserialize(chunk, sctx, true);
+}
+
+void Chimp_MRSerialize(Chunk_t *chunk, WriteSerializationCtx *sctx) {
+    Compressed_Serialize(chunk,
+                         sctx,
+                         (SaveUnsignedFunc)MR_SerializationCtxWriteLongLongWrapper,
+                         (SaveStringBufferFunc)MR_SerializationCtxWriteBufferWrapper,
+                         true);
+}
+
+int Chimp_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx) {
+    return mrDeserialize(chunk, sctx, true);
+}
@@ -31,6 +31,8 @@ int Compressed_DefragChunk(RedisModuleDefragCtx *ctx,
 ChunkResult Compressed_AddSample(Chunk_t *chunk, Sample *sample);
 ChunkResult Compressed_UpsertSample(UpsertCtx *uCtx, int *size, DuplicatePolicy duplicatePolicy);
 size_t Compressed_DelRange(Chunk_t *chunk, timestamp_t startTs, timestamp_t endTs);
+// Closes a full chunk, see frozen_chunk.h
+void Compressed_SealChunk(Chunk_t *chunk);
 
 void Compressed_ProcessChunk(const Chunk_t *chunk,
                              uint64_t start,
@@ -38,17 +40,20 @@ void Compressed_ProcessChunk(const Chunk_t *chunk,
                              EnrichedChunk *enrichedChunk,
                              bool reverse);
 
-// Read from compressed chunk using an iterator
+// Read from compressed chunk using an iterator, a frozen chunk can't be read with it
 ChunkIter_t *Compressed_NewChunkIterator(const Chunk_t *chunk);
 void Compressed_ResetChunkIterator(ChunkIter_t *iterator, const Chunk_t *chunk);
 void Compressed_FreeChunkIterator(ChunkIter_t *iter);
 
 // Miscellaneous
 size_t Compressed_GetChunkSize(const Chunk_t *chunk, bool includeStruct);
+size_t Compressed_GetCheckpointsSize(const Chunk_t *chunk);
+void Compressed_RebuildCheckpoints(Chunk_t *chunk, uint32_t interval);
 uint64_t Compressed_ChunkNumOfSample(Chunk_t *chunk);
 timestamp_t Compressed_GetFirstTimestamp(Chunk_t *chunk);
 timestamp_t Compressed_GetLastTimestamp(Chunk_t *chunk);
 double Compressed_GetLastValue(Chunk_t *chunk);
+const ChunkSummary *Compressed_GetSummary(const Chunk_t *chunk);
 
 // RDB
 void Compressed_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io);
@@ -58,6 +63,21 @@ int Compressed_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io);
 void Compressed_MRSerialize(Chunk_t *chunk, WriteSerializationCtx *sctx);
 int Compressed_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx);
 
+// Decimal chunk, a compressed chunk which values are encoded as scaled integers. Besides creation
+// and serialization it shares the compressed chunk functions.
+Chunk_t *Decimal_NewChunk(size_t size);
+void Decimal_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io);
+int Decimal_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io);
+void Decimal_MRSerialize(Chunk_t *chunk, WriteSerializationCtx *sctx);
+int Decimal_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx);
+
+// Chimp chunk, a compressed chunk which values are encoded with Chimp instead of Gorilla
+Chunk_t *Chimp_NewChunk(size_t size);
+void Chimp_SaveToRDB(Chunk_t *chunk, struct RedisModuleIO *io);
+int Chimp_LoadFromRDB(Chunk_t **chunk, struct RedisModuleIO *io);
+void Chimp_MRSerialize(Chunk_t *chunk, WriteSerializationCtx *sctx);
+int Chimp_MRDeserialize(Chunk_t **chunk, ReaderSerializationCtx *sctx);
+
 /* Used in tests */
 uint64_t getIterIdx(ChunkIter_t *iter);
 
@@ -46,6 +46,11 @@ static RedisModuleString *getConfigStringCache = NULL;
 void InitConfig(void) {
     TSGlobalConfig.options = SERIES_OPT_DEFAULT_COMPRESSION;
     TSGlobalConfig.password = NULL;
+    TSGlobalConfig.chunkCheckpointInterval = DEFAULT_CHUNK_CHECKPOINT_INTERVAL;
+    TSGlobalConfig.chunkSealing = CHUNK_SEALING_INLINE;
+    TSGlobalConfig.compactionRecomputeInterval = 0;
+    TSGlobalConfig.ingestBatching = false;
+    TSGlobalConfig.fusedRange = true;
 
     if (getConfigStringCache) {
         RedisModule_FreeString(rts_staticCtx, getConfigStringCache);
@@ -111,6 +116,24 @@ const char *ChunkTypeToString(int options) {
     if (options & SERIES_OPT_COMPRESSED_GORILLA) {
         return COMPRESSED_GORILLA_ARG_STR;
     }
+    if (options & SERIES_OPT_COMPRESSED_DECIMAL) {
+        return COMPRESSED_DECIMAL_ARG_STR;
+    }
+    if (options & SERIES_OPT_COMPRESSED_CHIMP) {
+        return COMPRESSED_CHIMP_ARG_STR;
+    }
+    return "invalid";
+}
+
+const char *ChunkSealingToString(ChunkSealing sealing) {
+    switch (sealing) {
+        case CHUNK_SEALING_INLINE:
+            return "inline";
+        case CHUNK_SEALING_DEFERRED:
+            return "deferred";
+        case CHUNK_SEALING_NONE:
+            return "none";
+    }
     return "invalid";
 }
 
@@ -160,6 +183,16 @@ static RedisModuleString *getModernStringConfigValue(const char *name, void *pri
 
         getConfigStringCache = RedisModule_CreateString(rts_staticCtx, value, strlen(value));
 
+        return getConfigStringCache;
+    } else if (!strcasecmp("ts-chunk-sealing", name)) {
+        const char *value = ChunkSealingToString(TSGlobalConfig.chunkSealing);
+
+        if (getConfigStringCache) {
+            RedisModule_FreeString(rts_staticCtx, getConfigStringCache);
+        }
+
+        getConfigStringCache = RedisModule_CreateString(rts_staticCtx, value, strlen(value));
+
         return getConfigStringCache;
     } else if (!strcasecmp("ts-ignore-max-val-diff", name)) {
         if (getConfigStringCache) {
@@ -286,11 +319,17 @@ static bool Config_SetEncodingFromRedisString(RedisModuleString *value, RedisMod
     const char *encoding = RedisModule_StringPtrLen(value, &len);
 
     if (!strcasecmp(encoding, UNCOMPRESSED_ARG_STR)) {
-        TSGlobalConfig.options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+        TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
         TSGlobalConfig.options |= SERIES_OPT_UNCOMPRESSED;
     } else if (!strcasecmp(encoding, COMPRESSED_GORILLA_ARG_STR)) {
-        TSGlobalConfig.options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+        TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
         TSGlobalConfig.options |= SERIES_OPT_COMPRESSED_GORILLA;
+    } else if (!strcasecmp(encoding, COMPRESSED_DECIMAL_ARG_STR)) {
+        TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
+        TSGlobalConfig.options |= SERIES_OPT_COMPRESSED_DECIMAL;
+    } else if (!strcasecmp(encoding, COMPRESSED_CHIMP_ARG_STR)) {
+        TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
+        TSGlobalConfig.options |= SERIES_OPT_COMPRESSED_CHIMP;
     } else {
         *err = RedisModule_CreateStringPrintf(NULL, "Invalid encoding: %s", encoding);
         return false;
@@ -299,6 +338,22 @@ static bool Config_SetEncodingFromRedisString(RedisModuleString *value, RedisMod
     return true;
 }
 
+static bool Config_SetChunkSealingFromRedisString(RedisModuleString *value,
+                                                  RedisModuleString **err) {
+    size_t len = 0;
+    const char *sealing = RedisModule_StringPtrLen(value, &len);
+
+    for (ChunkSealing s = CHUNK_SEALING_INLINE; s <= CHUNK_SEALING_NONE; ++s) {
+        if (!strcasecmp(sealing, ChunkSealingToString(s))) {
+            TSGlobalConfig.chunkSealing = s;
+            return true;
+        }
+    }
+
+    *err = RedisModule_CreateStringPrintf(NULL, "Invalid chunk sealing: %s", sealing);
+    return false;
+}
+
 static int setModernStringConfigValue(const char *name,
                                       RedisModuleString *value,
                                       void *data,
@@ -317,6 +372,9 @@ static int setModernStringConfigValue(const char *name,
                                                                      : REDISMODULE_ERR;
     } else if (!strcasecmp("ts-encoding", name)) {
         return Config_SetEncodingFromRedisString(value, err) ? REDISMODULE_OK : REDISMODULE_ERR;
+    } else if (!strcasecmp("ts-chunk-sealing", name)) {
+        return Config_SetChunkSealingFromRedisString(value, err) ? REDISMODULE_OK
+                                                                 : REDISMODULE_ERR;
     }
 
     return REDISMODULE_ERR;
@@ -331,6 +389,10 @@ static long long getModernIntegerConfigValue(const char *name, void *privdata) {
         return TSGlobalConfig.chunkSizeBytes;
     } else if (!strcasecmp("ts-ignore-max-time-diff", name)) {
         return TSGlobalConfig.ignoreMaxTimeDiff;
+    } else if (!strcasecmp("ts-chunk-checkpoint-interval", name)) {
+        return TSGlobalConfig.chunkCheckpointInterval;
+    } else if (!strcasecmp("ts-compaction-recompute-interval", name)) {
+        return TSGlobalConfig.compactionRecomputeInterval;
     }
 
     return 0;
@@ -365,6 +427,42 @@ static int setModernIntegerConfigValue(const char *name,
 
         TSGlobalConfig.ignoreMaxTimeDiff = value;
 
+        return REDISMODULE_OK;
+    } else if (!strcasecmp("ts-chunk-checkpoint-interval", name)) {
+        TSGlobalConfig.chunkCheckpointInterval = value;
+
+        return REDISMODULE_OK;
+    } else if (!strcasecmp("ts-compaction-recompute-interval", name)) {
+        TSGlobalConfig.compactionRecomputeInterval = value;
+        RescheduleDirtyCompactions();
+
+        return REDISMODULE_OK;
+    }
+
+    return REDISMODULE_ERR;
+}
+
+static int getModernBoolConfigValue(const char *name, void *privdata) {
+    if (!strcasecmp("ts-ingest-batching", name)) {
+        return TSGlobalConfig.ingestBatching;
+    } else if (!strcasecmp("ts-fused-range", name)) {
+        return TSGlobalConfig.fusedRange;
+    }
+
+    return 0;
+}
+
+static int setModernBoolConfigValue(const char *name,
+                                    int value,
+                                    void *data,
+                                    RedisModuleString **err) {
+    if (!strcasecmp("ts-ingest-batching", name)) {
+        TSGlobalConfig.ingestBatching = value;
+
+        return REDISMODULE_OK;
+    } else if (!strcasecmp("ts-fused-range", name)) {
+        TSGlobalConfig.fusedRange = value;
+
         return REDISMODULE_OK;
     }
 
@@ -516,6 +614,105 @@ bool RegisterModernConfigurationOptions(RedisModuleCtx *ctx) {
                     12,
                     TSGlobalConfig.ignoreMaxTimeDiff);
 
+    if (RedisModule_RegisterNumericConfig(ctx,
+                                          "ts-chunk-checkpoint-interval",
+                                          TSGlobalConfig.chunkCheckpointInterval,
+                                          REDISMODULE_CONFIG_UNPREFIXED,
+                                          CHUNK_CHECKPOINT_INTERVAL_MIN,
+                                          CHUNK_CHECKPOINT_INTERVAL_MAX,
+                                          getModernIntegerConfigValue,
+                                          setModernIntegerConfigValue,
+                                          NULL,
+                                          NULL)) {
+        return false;
+    }
+
+    RedisModule_Log(ctx,
+                    "notice",
+                    "\t{ %-*s: %*lld }",
+                    23,
+                    "ts-chunk-checkpoint-interval",
+                    12,
+                    TSGlobalConfig.chunkCheckpointInterval);
+
+    if (RedisModule_RegisterNumericConfig(ctx,
+                                          "ts-compaction-recompute-interval",
+                                          TSGlobalConfig.compactionRecomputeInterval,
+                                          REDISMODULE_CONFIG_UNPREFIXED,
+                                          COMPACTION_RECOMPUTE_INTERVAL_MIN,
+                                          COMPACTION_RECOMPUTE_INTERVAL_MAX,
+                                          getModernIntegerConfigValue,
+                                          setModernIntegerConfigValue,
+                                          NULL,
+                                          NULL)) {
+        return false;
+    }
+
+    RedisModule_Log(ctx,
+                    "notice",
+                    "\t{ %-*s: %*lld }",
+                    23,
+                    "ts-compaction-recompute-interval",
+                    12,
+                    TSGlobalConfig.compactionRecomputeInterval);
+
+    if (RedisModule_RegisterBoolConfig(ctx,
+                                       "ts-ingest-batching",
+                                       TSGlobalConfig.ingestBatching,
+                                       REDISMODULE_CONFIG_UNPREFIXED,
+                                       getModernBoolConfigValue,
+                                       setModernBoolConfigValue,
+                                       NULL,
+                                       NULL)) {
+        return false;
+    }
+
+    RedisModule_Log(ctx,
+                    "notice",
+                    "\t{ %-*s: %*s }",
+                    23,
+                    "ts-ingest-batching",
+                    12,
+                    TSGlobalConfig.ingestBatching ? "yes" : "no");
+
+    if (RedisModule_RegisterBoolConfig(ctx,
+                                       "ts-fused-range",
+                                       TSGlobalConfig.fusedRange,
+                                       REDISMODULE_CONFIG_UNPREFIXED,
+                                       getModernBoolConfigValue,
+                                       setModernBoolConfigValue,
+                                       NULL,
+                                       NULL)) {
+        return false;
+    }
+
+    RedisModule_Log(ctx,
+                    "notice",
+                    "\t{ %-*s: %*s }",
+                    23,
+                    "ts-fused-range",
+                    12,
+                    TSGlobalConfig.fusedRange ? "yes" : "no");
+
+    if (RedisModule_RegisterStringConfig(ctx,
+                                         "ts-chunk-sealing",
+                                         ChunkSealingToString(TSGlobalConfig.chunkSealing),
+                                         REDISMODULE_CONFIG_UNPREFIXED,
+                                         getModernStringConfigValue,
+                                         setModernStringConfigValue,
+                                         NULL,
+                                         NULL)) {
+        return false;
+    }
+
+    RedisModule_Log(ctx,
+                    "notice",
+                    "\t{ %-*s: %*s }",
+                    23,
+                    "ts-chunk-sealing",
+                    12,
+                    ChunkSealingToString(TSGlobalConfig.chunkSealing));
+
     {
         char oldValue[32] = { 0 };
         snprintf(oldValue, sizeof(oldValue), "%lf", TSGlobalConfig.ignoreMaxValDiff);
@@ -692,11 +889,17 @@ int ReadDeprecatedLoadTimeConfig(RedisModuleCtx *ctx,
         chunk_type_cstr = RedisModule_StringPtrLen(chunk_type, &len);
 
         if (strncmp(chunk_type_cstr, COMPRESSED_GORILLA_ARG_STR, len) == 0) {
-            TSGlobalConfig.options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+            TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
             TSGlobalConfig.options |= SERIES_OPT_COMPRESSED_GORILLA;
         } else if (strncmp(chunk_type_cstr, UNCOMPRESSED_ARG_STR, len) == 0) {
-            TSGlobalConfig.options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+            TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
             TSGlobalConfig.options |= SERIES_OPT_UNCOMPRESSED;
+        } else if (strncmp(chunk_type_cstr, COMPRESSED_DECIMAL_ARG_STR, len) == 0) {
+            TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
+            TSGlobalConfig.options |= SERIES_OPT_COMPRESSED_DECIMAL;
+        } else if (strncmp(chunk_type_cstr, COMPRESSED_CHIMP_ARG_STR, len) == 0) {
+            TSGlobalConfig.options &= ~SERIES_OPT_ENCODING_MASK;
+            TSGlobalConfig.options |= SERIES_OPT_COMPRESSED_CHIMP;
         } else {
             RedisModule_Log(ctx, "warning", "unknown series ENCODING type: %s\n", chunk_type_cstr);
             return TSDB_ERROR;
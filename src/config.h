@@ -25,6 +25,18 @@
 #define IGNORE_MAX_TIME_DIFF_MAX LLONG_MAX
 #define IGNORE_MAX_VAL_DIFF_MIN 0.0
 #define IGNORE_MAX_VAL_DIFF_MAX DBL_MAX
+#define DEFAULT_CHUNK_CHECKPOINT_INTERVAL 1024
+#define CHUNK_CHECKPOINT_INTERVAL_MIN 0
+#define CHUNK_CHECKPOINT_INTERVAL_MAX 1048576
+#define COMPACTION_RECOMPUTE_INTERVAL_MIN 0
+#define COMPACTION_RECOMPUTE_INTERVAL_MAX 3600000
+
+typedef enum ChunkSealing
+{
+    CHUNK_SEALING_INLINE = 0, // a full chunk is sealed when the next chunk is created
+    CHUNK_SEALING_DEFERRED,   // a full chunk is sealed by a timer after the command which filled it
+    CHUNK_SEALING_NONE,
+} ChunkSealing;
 
 typedef struct
 {
@@ -40,6 +52,16 @@ typedef struct
     bool dontAssertOnFailure;    // Internal debug configuration param
     long long ignoreMaxTimeDiff; // Insert filter max time diff with the last sample
     double ignoreMaxValDiff;     // Insert filter max value diff with the last sample
+    // Number of samples between the seek checkpoints of a compressed chunk, 0 disables them
+    long long chunkCheckpointInterval;
+    ChunkSealing chunkSealing; // when full compressed chunks are re-encoded for reads
+    // Milliseconds the compaction buckets invalidated by upserts may wait before they are
+    // recomputed, reads see the old buckets meanwhile. 0 recomputes them at the end of the command
+    long long compactionRecomputeInterval;
+    // Replicate consecutive TS.ADD commands as a single TS.MADD and notify their keys once
+    bool ingestBatching;
+    // Run the common range query shapes in a single fused loop instead of the iterator chain
+    bool fusedRange;
 } TSConfig;
 
 extern TSConfig TSGlobalConfig;
@@ -53,6 +75,7 @@ int ReadDeprecatedLoadTimeConfig(RedisModuleCtx *ctx,
                                  int argc,
                                  const bool showDeprecationWarning);
 const char *ChunkTypeToString(int options);
+const char *ChunkSealingToString(ChunkSealing sealing);
 typedef struct RTS_RedisVersion
 {
     int redisMajorVersion;
@@ -111,8 +111,16 @@ static inline __attribute__((always_inline)) const char *DuplicatePolicyToString
 
 #define SERIES_OPT_COMPRESSED_GORILLA 0x2
 
+#define SERIES_OPT_COMPRESSED_DECIMAL 0x4
+
+#define SERIES_OPT_COMPRESSED_CHIMP 0x8
+
 #define SERIES_OPT_DEFAULT_COMPRESSION SERIES_OPT_COMPRESSED_GORILLA
 
+#define SERIES_OPT_ENCODING_MASK                                                                   \
+    (SERIES_OPT_UNCOMPRESSED | SERIES_OPT_COMPRESSED_GORILLA | SERIES_OPT_COMPRESSED_DECIMAL |     \
+     SERIES_OPT_COMPRESSED_CHIMP)
+
 /* Chunk enum */
 typedef enum
 {
@@ -127,6 +135,10 @@ typedef enum
 #define TS_ADD_DUPLICATE_POLICY_ARG "ON_DUPLICATE"
 #define UNCOMPRESSED_ARG_STR "uncompressed"
 #define COMPRESSED_GORILLA_ARG_STR "compressed"
+#define COMPRESSED_DECIMAL_ARG_STR "decimal"
+#define COMPRESSED_CHIMP_ARG_STR "chimp"
+#define PACKED_ARG_STR "packed"
+#define PACKED_DELTA_ARG_STR "packed_delta"
 
 // DC - Don't Care (Arbitrary value)
 #define DC 0
@@ -10,8 +10,12 @@
 #include "enriched_chunk.h"
 #include "rmutil/alloc.h"
 
+#include <string.h>
+
 void ResetEnrichedChunk(EnrichedChunk *chunk) {
     chunk->rev = false;
+    chunk->borrowed = false;
+    chunk->summary = NULL;
     chunk->samples.num_samples = 0;
     chunk->samples.timestamps = chunk->samples.og_timestamps;
     chunk->samples.values = chunk->samples.og_values;
@@ -20,6 +24,8 @@ void ResetEnrichedChunk(EnrichedChunk *chunk) {
 EnrichedChunk *NewEnrichedChunk() {
     EnrichedChunk *chunk = (EnrichedChunk *)malloc(sizeof(EnrichedChunk));
     chunk->rev = false;
+    chunk->borrowed = false;
+    chunk->summary = NULL;
     chunk->samples.num_samples = 0;
     chunk->samples.size = 0;
     chunk->samples.og_timestamps = NULL;
@@ -36,6 +42,24 @@ void ReallocSamplesArray(Samples *samples, size_t n_samples) {
     samples->values = samples->og_values;
 }
 
+// Copies a borrowed view into the own buffers of the enriched chunk
+void MakeEnrichedChunkWritable(EnrichedChunk *chunk) {
+    if (likely(!chunk->borrowed)) {
+        return;
+    }
+    Samples *samples = &chunk->samples;
+    const timestamp_t *timestamps = samples->timestamps;
+    const double *values = samples->values;
+    if (samples->size < samples->num_samples) {
+        ReallocSamplesArray(samples, samples->num_samples);
+    }
+    memcpy(samples->og_timestamps, timestamps, samples->num_samples * sizeof(timestamp_t));
+    memcpy(samples->og_values, values, samples->num_samples * sizeof(double));
+    samples->timestamps = samples->og_timestamps;
+    samples->values = samples->og_values;
+    chunk->borrowed = false;
+}
+
 void FreeEnrichedChunk(EnrichedChunk *chunk) {
     free(chunk->samples.og_timestamps);
     free(chunk->samples.og_values);
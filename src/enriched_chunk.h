@@ -22,15 +22,23 @@ typedef struct Samples
     size_t size;                // num of maximal samples which can be contained
 } Samples;
 
+struct ChunkSummary;
+
 typedef struct EnrichedChunk
 {
     Samples samples;
     bool rev;
+    // the samples point into the memory of a chunk and are read only, a stage which modifies them
+    // in place calls MakeEnrichedChunkWritable first
+    bool borrowed;
+    // set when a whole chunk is passed as its summary, the samples then hold only its first sample
+    const struct ChunkSummary *summary;
 } EnrichedChunk;
 
 EnrichedChunk *NewEnrichedChunk();
 void ResetEnrichedChunk(EnrichedChunk *chunk);
 void FreeEnrichedChunk(EnrichedChunk *chunk);
 void ReallocSamplesArray(Samples *samples, size_t n_samples);
+void MakeEnrichedChunkWritable(EnrichedChunk *chunk);
 
 #endif // ENRICHED_CHUNK_H
@@ -10,159 +10,69 @@
 
 #include "abstract_iterator.h"
 #include "series_iterator.h"
-#include "utils/arr.h"
+#include "filters/filter_ts.h"
+#include "filters/filter_value.h"
 #include <assert.h>
-#include <math.h> /* ceil */
 
-static inline bool check_sample_value(double value, FilterByValueArgs *byValueArgs) {
-    if (value >= byValueArgs->min && value <= byValueArgs->max) {
-        return true;
-    } else {
-        return false;
-    }
-}
-
-typedef struct dfs_stack_val
-{
-    size_t si;
-    size_t ei;
-    size_t filter_si;
-    size_t filter_ei;
-} dfs_stack_val;
-
-#define dfs_stack_val_init(_val, _si, _ei, _filter_si, _filter_ei)                                 \
-    do {                                                                                           \
-        (_val).si = (_si);                                                                         \
-        (_val).ei = (_ei);                                                                         \
-        (_val).filter_si = (_filter_si);                                                           \
-        (_val).filter_ei = (_filter_ei);                                                           \
-    } while (0)
-
-static inline timestamp_t calc_bucket_ts(BucketTimestamp bucketTS,
-                                         timestamp_t ts,
-                                         int64_t TimeDelta) {
-    switch (bucketTS) {
-        case BucketStartTimestamp:
-            return ts;
-        case BucketMidTimestamp:
-            return ts + TimeDelta / 2;
-        case BucketEndTimestamp:
-            return ts + TimeDelta;
-        default:
-            assert(false);
-    }
-}
-
-// returns the number of matches
-static size_t filterSamples(Samples *samples,
-                            const timestamp_t *filter,
-                            size_t filter_si,
-                            size_t filter_ei) {
-    size_t count = 0;
-    size_t num_samples = samples->num_samples;
-    dfs_stack_val *dfs_stack =
-        array_new(dfs_stack_val, ceil(log(num_samples)) + 1); // + 1 is for one left child
-    dfs_stack_val first_frame = {
-        .si = 0, .ei = num_samples - 1, .filter_si = filter_si, .filter_ei = filter_ei
-    };
-    dfs_stack_val left_frame, right_frame;
-    array_append(dfs_stack, first_frame);
-    dfs_stack_val cur_frame;
-    bool found_left, found_right;
-    while (array_len(dfs_stack) > 0) {
-        cur_frame = array_pop(dfs_stack);
-        if (cur_frame.si == cur_frame.ei) {
-            assert((num_samples <= 1) || cur_frame.filter_ei == cur_frame.filter_si);
-            for (size_t i = cur_frame.filter_si; i <= cur_frame.filter_ei; ++i) {
-                const timestamp_t sample_ts = samples->timestamps[cur_frame.si];
-                if (sample_ts == filter[i]) {
-                    double value = samples->values[cur_frame.si];
-                    samples->timestamps[count] = sample_ts;
-                    samples->values[count] = value;
-                    ++(count);
-                    break;
-                }
-            }
-            continue;
-        }
-
-        const size_t mid = (cur_frame.si + cur_frame.ei) / 2;
-
-        // find filter values that fit into left bucket
-        found_left = false;
-        size_t _filter_si = cur_frame.filter_si, _filter_ei;
-
-        while (_filter_si <= cur_frame.filter_ei &&
-               filter[_filter_si] < samples->timestamps[cur_frame.si]) {
-            ++_filter_si;
-        }
-
-        _filter_ei = _filter_si;
-        while (_filter_ei <= cur_frame.filter_ei &&
-               filter[_filter_ei] <= samples->timestamps[mid]) {
-            found_left = true;
-            ++_filter_ei;
-        }
-
-        if (found_left) {
-            dfs_stack_val_init(left_frame, cur_frame.si, mid, _filter_si, _filter_ei - 1);
-        }
-
-        // find filter that fit into right bucket
-        found_right = false;
-        _filter_si = _filter_ei;
-        while (_filter_si <= cur_frame.filter_ei &&
-               filter[_filter_si] < samples->timestamps[mid + 1]) {
-            ++_filter_si;
-        }
-
-        _filter_ei = _filter_si;
-        while (_filter_ei <= cur_frame.filter_ei &&
-               filter[_filter_ei] <= samples->timestamps[cur_frame.ei]) {
-            found_right = true;
-            ++_filter_ei;
-        }
-
-        if (found_right) {
-            dfs_stack_val_init(right_frame, mid + 1, cur_frame.ei, _filter_si, _filter_ei - 1);
-        }
-
-        if (found_right) {
-            array_append(dfs_stack, right_frame);
-        }
-
-        if (found_left) {
-            array_append(dfs_stack, left_frame);
+// Lets a filter write the matching samples of the chunk to its own buffers. The samples of a
+// borrowed view are read from the view, so no copy of the whole view is needed.
+static void prepareFilterOutput(EnrichedChunk *enrichedChunk) {
+    Samples *samples = &enrichedChunk->samples;
+    if (enrichedChunk->borrowed) {
+        if (samples->size < samples->num_samples) {
+            ReallocSamplesArray(samples, samples->num_samples);
         }
+        samples->timestamps = samples->og_timestamps;
+        samples->values = samples->og_values;
+        enrichedChunk->borrowed = false;
     }
-
-    array_free(dfs_stack);
-    return count;
 }
 
 EnrichedChunk *SeriesFilterTSIterator_GetNextChunk(struct AbstractIterator *base) {
     SeriesFilterTSIterator *self = (SeriesFilterTSIterator *)base;
+    const timestamp_t *filter = self->ByTsArgs.values;
     EnrichedChunk *enrichedChunk;
     size_t count = 0;
     assert(self->ByTsArgs.hasValue);
 
-    if (self->tsFilterIndex == self->ByTsArgs.count) {
-        return NULL;
-    }
-    while ((enrichedChunk = self->base.input->GetNext(self->base.input)) &&
+    while (self->filterStart < self->filterEnd &&
+           (enrichedChunk = self->base.input->GetNext(self->base.input)) &&
            enrichedChunk->samples.num_samples > 0) {
         assert(!enrichedChunk->rev); // the impl assumes that the chunk isn't reversed
-        count = filterSamples(&enrichedChunk->samples,
-                              self->ByTsArgs.values,
-                              self->tsFilterIndex,
-                              self->ByTsArgs.count - 1);
+        Samples *samples = &enrichedChunk->samples;
+        const timestamp_t *timestamps = samples->timestamps;
+        const double *values = samples->values;
+        const size_t num_samples = samples->num_samples;
+        prepareFilterOutput(enrichedChunk);
+        if (!self->reverse) {
+            count = FilterByTimestamps(samples->timestamps,
+                                       samples->values,
+                                       timestamps,
+                                       values,
+                                       num_samples,
+                                       filter,
+                                       &self->filterStart,
+                                       self->filterEnd);
+        } else {
+            // the chunks come from the last one, the filter timestamps before the first sample
+            // are left for the next chunks
+            size_t filterIndex = GallopLowerBoundReverse(
+                filter, self->filterStart, self->filterEnd, timestamps[0]);
+            const size_t filterEnd = filterIndex;
+            count = FilterByTimestamps(samples->timestamps,
+                                       samples->values,
+                                       timestamps,
+                                       values,
+                                       num_samples,
+                                       filter,
+                                       &filterIndex,
+                                       self->filterEnd);
+            self->filterEnd = filterEnd;
+        }
         if (count > 0) {
             enrichedChunk->samples.num_samples = count;
             if (unlikely(self->reverse)) {
                 reverseEnrichedChunk(enrichedChunk);
-                self->ByTsArgs.count -= count;
-            } else {
-                self->tsFilterIndex += count; // at least count samples consumed
             }
             return enrichedChunk;
         }
@@ -179,7 +89,8 @@ SeriesFilterTSIterator *SeriesFilterTSIterator_New(AbstractIterator *input,
     newIter->base.GetNext = SeriesFilterTSIterator_GetNextChunk;
     newIter->base.Close = SeriesFilterIterator_Close;
     newIter->ByTsArgs = ByTsArgs;
-    newIter->tsFilterIndex = 0;
+    newIter->filterStart = 0;
+    newIter->filterEnd = ByTsArgs.count;
     newIter->reverse = rev;
     return newIter;
 }
@@ -192,19 +103,23 @@ void SeriesFilterIterator_Close(struct AbstractIterator *iterator) {
 EnrichedChunk *SeriesFilterValIterator_GetNextChunk(struct AbstractIterator *base) {
     SeriesFilterValIterator *self = (SeriesFilterValIterator *)base;
     EnrichedChunk *enrichedChunk;
-    size_t i, count = 0;
+    size_t count = 0;
     assert(self->byValueArgs.hasValue);
 
     while ((enrichedChunk = self->base.input->GetNext(self->base.input))) {
         // currently if the query reversed the chunk will be already reversed here
         // assert(self->reverse == enrichedChunk->rev);
-        for (i = 0; i < enrichedChunk->samples.num_samples; ++i) {
-            if (check_sample_value(enrichedChunk->samples.values[i], &self->byValueArgs)) {
-                enrichedChunk->samples.timestamps[count] = enrichedChunk->samples.timestamps[i];
-                enrichedChunk->samples.values[count] = enrichedChunk->samples.values[i];
-                ++count;
-            }
-        }
+        Samples *samples = &enrichedChunk->samples;
+        const timestamp_t *timestamps = samples->timestamps;
+        const double *values = samples->values;
+        prepareFilterOutput(enrichedChunk);
+        count = FilterByValue(samples->timestamps,
+                              samples->values,
+                              timestamps,
+                              values,
+                              samples->num_samples,
+                              self->byValueArgs.min,
+                              self->byValueArgs.max);
         if (count > 0) {
             enrichedChunk->samples.num_samples = count;
             return enrichedChunk;
@@ -267,32 +182,25 @@ static inline void finalizeBucket(Samples *samples, size_t index, const Aggregat
     self->aggregation->resetContext(self->aggregationContext);
 }
 
-// assumes num of samples > si + 1, returns -1 when no such an index
-static int64_t findLastIndexbeforeTS(const EnrichedChunk *chunk,
-                                     timestamp_t timestamp,
-                                     int64_t si) {
-    timestamp_t *timestamps = chunk->samples.timestamps;
-    int64_t h = chunk->samples.num_samples - 1;
-    if (unlikely(timestamps[si] >= timestamp)) {
-        // the first sample of the current range finalize prev chunk bucket
-        return -1;
-    }
-    if (timestamps[h] < timestamp) { // range of size 1 will be handled here
-        return h;
-    }
-
-    int64_t m, l = si;
-    assert(h > l);      // from here h > l
-    while (l < h - 1) { // if l == h-1 it means l has the result
-        m = (l + h) / 2;
-        if (timestamps[m] < timestamp) {
-            l = m;
-        } else {
-            h = m;
-        }
-    }
+static inline bool inBucket(timestamp_t ts,
+                            timestamp_t bucketStart,
+                            timestamp_t bucketEnd,
+                            bool reversed) {
+    return reversed ? ts >= bucketStart : ts < bucketEnd;
+}
 
-    return l;
+int64_t findLastIndexInBucket(const EnrichedChunk *chunk,
+                              timestamp_t bucketStart,
+                              timestamp_t bucketEnd,
+                              int64_t si,
+                              bool reversed) {
+    const size_t end = FindBucketEnd(chunk->samples.timestamps,
+                                     si,
+                                     chunk->samples.num_samples,
+                                     reversed ? bucketStart : bucketEnd,
+                                     reversed);
+    // the first sample of the current range finalizes the bucket of the previous chunk
+    return end == (size_t)si ? -1 : (int64_t)end - 1;
 }
 
 static void fillEmptyBucketWithValueIncIter(size_t *write_index,
@@ -572,6 +480,53 @@ static void fillEmptyBuckets(Samples *samples,
     return;
 }
 
+// Finalizes the current bucket into the output and makes the bucket of ts, the timestamp of the
+// sample at si, the current one. The empty buckets between them are filled when requested.
+static void advanceBucket(AggregationIterator *self,
+                          EnrichedChunk *enrichedChunk,
+                          size_t *agg_n_samples,
+                          timestamp_t ts,
+                          uint64_t *contextScope,
+                          int64_t *si) {
+    const uint64_t aggregationTimeDelta = self->aggregationTimeDelta;
+    const bool is_reversed = self->reverse;
+    MakeEnrichedChunkWritable(enrichedChunk); // the buckets are written in place
+    finalizeBucket(&enrichedChunk->samples, (*agg_n_samples)++, self);
+    self->aggregationLastTimestamp =
+        CalcBucketStart(ts, aggregationTimeDelta, self->timestampAlignment);
+    if (self->empty) {
+        bool has_empty_buckets = true;
+        timestamp_t first_bucket, last_bucket;
+        if (is_reversed) {
+            first_bucket =
+                max(0, (int64_t)((int64_t)*contextScope - (int64_t)(2 * aggregationTimeDelta)));
+            last_bucket = self->aggregationLastTimestamp + aggregationTimeDelta;
+            if (*contextScope < last_bucket + (2 * aggregationTimeDelta)) {
+                has_empty_buckets = false;
+            }
+        } else {
+            first_bucket = *contextScope;
+            if (first_bucket >= self->aggregationLastTimestamp) {
+                has_empty_buckets = false;
+            }
+            last_bucket = max(0,
+                              (int64_t)((int64_t)self->aggregationLastTimestamp -
+                                        (int64_t)aggregationTimeDelta));
+        }
+        if (has_empty_buckets) {
+            fillEmptyBuckets(&enrichedChunk->samples,
+                             agg_n_samples,
+                             first_bucket,
+                             last_bucket,
+                             self,
+                             is_reversed,
+                             si);
+        }
+    }
+    *contextScope = self->aggregationLastTimestamp + aggregationTimeDelta;
+    self->aggregationLastTimestamp = BucketStartNormalize(self->aggregationLastTimestamp);
+}
+
 #define TWA_EMPTY_RANGE(iter) (((iter)->empty) && ((iter)->aggregation->type == TS_AGG_TWA))
 
 EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
@@ -677,6 +632,7 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
         }
         if (has_empty_buckets) {
             si = -1;
+            MakeEnrichedChunkWritable(enrichedChunk);
             fillEmptyBuckets(&enrichedChunk->samples,
                              &agg_n_samples,
                              first_bucket,
@@ -735,10 +691,15 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
         // currently if the query reversed the chunk will be already revered here
         assert(self->reverse == enrichedChunk->rev || enrichedChunk->samples.num_samples == 0);
         Samples *samples = &enrichedChunk->samples;
-        if (self->aggregation->type == TS_AGG_MAX &&
-            !is_reversed) { // Currently only implemented vectorization for specific case
+        // a chunk summary comes with the first sample of the chunk, it's appended instead of it
+        const ChunkSummary *summary = enrichedChunk->summary;
+        if (aggregation->appendValueVec && !summary) {
             while (si < samples->num_samples) {
-                ei = findLastIndexbeforeTS(enrichedChunk, contextScope, si);
+                ei = findLastIndexInBucket(enrichedChunk,
+                                           self->aggregationLastTimestamp,
+                                           contextScope,
+                                           si,
+                                           is_reversed);
                 if (likely(ei >= 0)) {
                     aggregation->appendValueVec(
                         aggregationContext, enrichedChunk->samples.values, si, ei);
@@ -751,43 +712,12 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
                             .timestamps[si]; // store sample cause we aggregate in place
                     sample.value = enrichedChunk->samples
                                        .values[si]; // store sample cause we aggregate in place
-                    assert(enrichedChunk->samples.timestamps[si] >= contextScope);
-                    finalizeBucket(&enrichedChunk->samples, agg_n_samples++, self);
-                    self->aggregationLastTimestamp = CalcBucketStart(
-                        sample.timestamp, aggregationTimeDelta, self->timestampAlignment);
-                    if (self->empty) {
-                        bool has_empty_buckets = true;
-                        timestamp_t first_bucket, last_bucket;
-                        if (is_reversed) {
-                            first_bucket = max(0,
-                                               (int64_t)((int64_t)contextScope -
-                                                         (int64_t)(2 * aggregationTimeDelta)));
-                            last_bucket = self->aggregationLastTimestamp + aggregationTimeDelta;
-                            if (contextScope > last_bucket + (2 * aggregationTimeDelta)) {
-                                has_empty_buckets = false;
-                            }
-                        } else {
-                            first_bucket = contextScope;
-                            if (first_bucket >= self->aggregationLastTimestamp) {
-                                has_empty_buckets = false;
-                            }
-                            last_bucket = max(0,
-                                              (int64_t)((int64_t)self->aggregationLastTimestamp -
-                                                        (int64_t)aggregationTimeDelta));
-                        }
-                        if (has_empty_buckets) {
-                            fillEmptyBuckets(&enrichedChunk->samples,
-                                             &agg_n_samples,
-                                             first_bucket,
-                                             last_bucket,
-                                             self,
-                                             is_reversed,
-                                             &si);
-                        }
-                    }
-                    contextScope = self->aggregationLastTimestamp + aggregationTimeDelta;
-                    self->aggregationLastTimestamp =
-                        BucketStartNormalize(self->aggregationLastTimestamp);
+                    assert(!inBucket(sample.timestamp,
+                                     self->aggregationLastTimestamp,
+                                     contextScope,
+                                     is_reversed));
+                    advanceBucket(
+                        self, enrichedChunk, &agg_n_samples, sample.timestamp, &contextScope, &si);
 
                     // append sample and inc si cause we aggregate in place
                     appendValue(aggregationContext, sample.value, sample.timestamp);
@@ -806,8 +736,10 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
                 // - mod where 0 <= mod from (1)+(2) contextScope > chunk->samples.timestamps[0]
                 // from (3) chunk->samples.timestamps[0] >= self->aggregationLastTimestamp so the
                 // following condition should always be false on the first iteration
-                if ((!is_reversed && sample.timestamp >= contextScope) ||
-                    (is_reversed && sample.timestamp < self->aggregationLastTimestamp)) {
+                if (!inBucket(sample.timestamp,
+                              self->aggregationLastTimestamp,
+                              contextScope,
+                              is_reversed)) {
                     if (aggregation->type == TS_AGG_TWA) {
                         aggregation->addNextBucketFirstSample(
                             aggregationContext, sample.value, sample.timestamp);
@@ -817,42 +749,8 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
                     if (aggregation->type == TS_AGG_TWA) {
                         aggregation->getLastSample(aggregationContext, &last_sample);
                     }
-                    finalizeBucket(&enrichedChunk->samples, agg_n_samples++, self);
-                    self->aggregationLastTimestamp = CalcBucketStart(
-                        sample.timestamp, aggregationTimeDelta, self->timestampAlignment);
-                    if (self->empty) {
-                        bool has_empty_buckets = true;
-                        timestamp_t first_bucket, last_bucket;
-                        if (is_reversed) {
-                            first_bucket = max(0,
-                                               (int64_t)((int64_t)contextScope -
-                                                         (int64_t)(2 * aggregationTimeDelta)));
-                            last_bucket = self->aggregationLastTimestamp + aggregationTimeDelta;
-                            if (contextScope < last_bucket + (2 * aggregationTimeDelta)) {
-                                has_empty_buckets = false;
-                            }
-                        } else {
-                            first_bucket = contextScope;
-                            if (first_bucket >= self->aggregationLastTimestamp) {
-                                has_empty_buckets = false;
-                            }
-                            last_bucket = max(0,
-                                              (int64_t)((int64_t)self->aggregationLastTimestamp -
-                                                        (int64_t)aggregationTimeDelta));
-                        }
-                        if (has_empty_buckets) {
-                            fillEmptyBuckets(&enrichedChunk->samples,
-                                             &agg_n_samples,
-                                             first_bucket,
-                                             last_bucket,
-                                             self,
-                                             is_reversed,
-                                             &si);
-                        }
-                    }
-                    contextScope = self->aggregationLastTimestamp + aggregationTimeDelta;
-                    self->aggregationLastTimestamp =
-                        BucketStartNormalize(self->aggregationLastTimestamp);
+                    advanceBucket(
+                        self, enrichedChunk, &agg_n_samples, sample.timestamp, &contextScope, &si);
                     if (aggregation->type == TS_AGG_TWA) {
                         aggregation->addPrevBucketLastSample(
                             aggregationContext, last_sample.value, last_sample.timestamp);
@@ -871,7 +769,11 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
                     }
                 }
 
-                appendValue(aggregationContext, sample.value, sample.timestamp);
+                if (unlikely(summary)) {
+                    aggregation->appendSummary(aggregationContext, summary);
+                } else {
+                    appendValue(aggregationContext, sample.value, sample.timestamp);
+                }
                 si++;
             }
         }
@@ -879,6 +781,7 @@ EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter) {
         if (agg_n_samples > 0) {
             self->prev_ts = enrichedChunk->samples.timestamps[agg_n_samples - 1];
             enrichedChunk->samples.num_samples = agg_n_samples;
+            enrichedChunk->summary = NULL;
             return enrichedChunk;
         }
         enrichedChunk = input->GetNext(input);
@@ -13,11 +13,15 @@
 #ifndef FILTER_ITERATOR_H
 #define FILTER_ITERATOR_H
 
+#include <assert.h>
+
 typedef struct SeriesFilterTSIterator
 {
     AbstractIterator base;
     FilterByTSArgs ByTsArgs;
-    size_t tsFilterIndex; // the index in the TS filter array in ByTsArgs
+    // the filter timestamps in [filterStart, filterEnd) weren't passed yet by the chunks
+    size_t filterStart;
+    size_t filterEnd;
     bool reverse;
 } SeriesFilterTSIterator;
 
@@ -75,4 +79,28 @@ AggregationIterator *AggregationIterator_New(struct AbstractIterator *input,
 EnrichedChunk *AggregationIterator_GetNextChunk(struct AbstractIterator *iter);
 void AggregationIterator_Close(struct AbstractIterator *iterator);
 
+// The timestamp which is reported for the bucket which starts at ts
+static inline timestamp_t calc_bucket_ts(BucketTimestamp bucketTS,
+                                         timestamp_t ts,
+                                         int64_t TimeDelta) {
+    switch (bucketTS) {
+        case BucketStartTimestamp:
+            return ts;
+        case BucketMidTimestamp:
+            return ts + TimeDelta / 2;
+        case BucketEndTimestamp:
+            return ts + TimeDelta;
+        default:
+            assert(false);
+    }
+}
+
+// Returns the last index from si whose sample is in the current bucket [bucketStart, bucketEnd),
+// -1 when the sample at si already isn't. The samples are ascending, or descending when reversed.
+int64_t findLastIndexInBucket(const EnrichedChunk *chunk,
+                              timestamp_t bucketStart,
+                              timestamp_t bucketEnd,
+                              int64_t si,
+                              bool reversed);
+
 #endif // FILTER_ITERATOR_H
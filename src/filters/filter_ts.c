@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filter_ts.h"
+
+#include "filter_ts_avx2.h"
+#include "filter_ts_avx512f.h"
+#include "../utils/arch_features.h"
+
+static size_t (*countBelow)(const timestamp_t *timestamps, timestamp_t bound) = CountBelowVec;
+
+// Returns the first index in [lo, hi] which is >= value, timestamps[hi] must be >= value or hi
+// must be the end of the array
+static inline size_t lowerBound(const timestamp_t *timestamps,
+                                size_t lo,
+                                size_t hi,
+                                timestamp_t value) {
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (timestamps[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+size_t GallopLowerBound(const timestamp_t *timestamps, size_t lo, size_t hi, timestamp_t value) {
+    if (lo >= hi || timestamps[lo] >= value) {
+        return lo;
+    }
+    // timestamps[below] < value, probe at distances of 1, 2, 4... from it
+    size_t below = lo;
+    size_t step = 1;
+    size_t probe = lo + 1;
+    while (probe < hi && timestamps[probe] < value) {
+        below = probe;
+        step *= 2;
+        probe = below + step;
+    }
+    return lowerBound(timestamps, below + 1, probe < hi ? probe : hi, value);
+}
+
+size_t GallopLowerBoundReverse(const timestamp_t *timestamps,
+                               size_t lo,
+                               size_t hi,
+                               timestamp_t value) {
+    if (lo >= hi || timestamps[hi - 1] < value) {
+        return hi;
+    }
+    // timestamps[atLeast] >= value, probe at distances of 1, 2, 4... from it
+    size_t atLeast = hi - 1;
+    size_t step = 1;
+    while (atLeast >= lo + step && timestamps[atLeast - step] >= value) {
+        atLeast -= step;
+        step *= 2;
+    }
+    return lowerBound(timestamps, atLeast >= lo + step ? atLeast - step + 1 : lo, atLeast, value);
+}
+
+size_t FilterByTimestamps(timestamp_t *dstTimestamps,
+                          double *dstValues,
+                          const timestamp_t *timestamps,
+                          const double *values,
+                          size_t n,
+                          const timestamp_t *filter,
+                          size_t *filterIndex,
+                          size_t filterEnd) {
+    size_t count = 0;
+    size_t i = 0;
+    size_t j = *filterIndex;
+    while (i < n && j < filterEnd) {
+        if (timestamps[i] < filter[j]) {
+            i = GallopLowerBound(timestamps, i + 1, n, filter[j]);
+        } else if (timestamps[i] > filter[j]) {
+            j = GallopLowerBound(filter, j + 1, filterEnd, timestamps[i]);
+        } else {
+            // the destination never passes i, so the samples can be moved in place
+            dstTimestamps[count] = timestamps[i];
+            dstValues[count] = values[i];
+            ++count;
+            ++i;
+            ++j;
+        }
+    }
+    // when the samples ran out, filter[j] is past the last sample
+    *filterIndex = j;
+    return count;
+}
+
+size_t CountBelowVec(const timestamp_t *timestamps, timestamp_t bound) {
+    size_t count = 0;
+    for (size_t i = 0; i < BUCKET_SCAN_WINDOW; ++i) {
+        count += timestamps[i] < bound;
+    }
+    return count;
+}
+
+static inline bool bucketContains(timestamp_t timestamp, timestamp_t bound, bool descending) {
+    return descending ? timestamp >= bound : timestamp < bound;
+}
+
+size_t FindBucketEnd(const timestamp_t *timestamps,
+                     size_t si,
+                     size_t n,
+                     timestamp_t bound,
+                     bool descending) {
+    if (si >= n || bucketContains(timestamps[n - 1], bound, descending)) {
+        // a bucket which is longer than the chunk
+        return n;
+    }
+    if (n - si < BUCKET_SCAN_WINDOW) {
+        while (bucketContains(timestamps[si], bound, descending)) {
+            ++si;
+        }
+        return si;
+    }
+    const size_t below = countBelow(&timestamps[si], bound);
+    const size_t inBucket = descending ? BUCKET_SCAN_WINDOW - below : below;
+    if (inBucket < BUCKET_SCAN_WINDOW) {
+        return si + inBucket;
+    }
+
+    // timestamps[inside] is in the bucket, probe at distances of 1, 2, 4... from it. The last
+    // timestamp isn't, so the probes stop before n.
+    size_t inside = si + BUCKET_SCAN_WINDOW - 1;
+    size_t step = 1;
+    size_t probe = inside + 1;
+    while (probe < n && bucketContains(timestamps[probe], bound, descending)) {
+        inside = probe;
+        step *= 2;
+        probe = inside + step;
+    }
+    size_t lo = inside + 1;
+    size_t hi = probe < n ? probe : n - 1;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (bucketContains(timestamps[mid], bound, descending)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+void initTimestampFilterFunctions() {
+    const X86Features *features = getArchitectureOptimization();
+    countBelow = CountBelowVec;
+
+#if defined(__x86_64__)
+    if (!features) {
+        return;
+    } else if (features->avx512f) {
+        countBelow = CountBelowAVX512F;
+        return;
+    } else if (features->avx2) {
+        countBelow = CountBelowAVX2;
+        return;
+    }
+#endif // __x86_64__
+    return;
+}
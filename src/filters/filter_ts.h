@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#ifndef FILTER_TS_H
+#define FILTER_TS_H
+
+#include "../gorilla.h"
+
+#include <stddef.h>
+
+// The number of timestamps which FindBucketEnd compares at once, before it gallops. The kernels of
+// an instruction set compare a whole window.
+#define BUCKET_SCAN_WINDOW 8
+
+// Returns the index of the first timestamp in the sorted [lo, hi) which is >= value, or hi when
+// there is none. The search gallops from lo, so it's logarithmic in the distance to the result.
+size_t GallopLowerBound(const timestamp_t *timestamps, size_t lo, size_t hi, timestamp_t value);
+
+// The same as GallopLowerBound, galloping from hi
+size_t GallopLowerBoundReverse(const timestamp_t *timestamps,
+                               size_t lo,
+                               size_t hi,
+                               timestamp_t value);
+
+// Moves the samples of [0, n) whose timestamp is in filter[*filterIndex, filterEnd) to the front of
+// dstTimestamps and dstValues and returns their count. The samples and the filter must be sorted
+// and unique, the destination may be the source itself. *filterIndex is advanced past the filter
+// timestamps up to the last sample, so a following chunk continues from there. Both sides gallop
+// over the timestamps which have no match, the cost is logarithmic in the length of the gaps.
+size_t FilterByTimestamps(timestamp_t *dstTimestamps,
+                          double *dstValues,
+                          const timestamp_t *timestamps,
+                          const double *values,
+                          size_t n,
+                          const timestamp_t *filter,
+                          size_t *filterIndex,
+                          size_t filterEnd);
+
+// Returns the index of the first timestamp in [si, n) which is past the end of the bucket, or n.
+// Ascending timestamps are in the bucket while they're < bound, descending ones while they're
+// >= bound. The window at si is compared at once, so a short bucket costs a single vector compare,
+// then the search gallops and a long one costs a logarithm of its length.
+size_t FindBucketEnd(const timestamp_t *timestamps,
+                     size_t si,
+                     size_t n,
+                     timestamp_t bound,
+                     bool descending);
+
+// Returns how many of the BUCKET_SCAN_WINDOW timestamps are < bound, the portable kernel of
+// FindBucketEnd
+size_t CountBelowVec(const timestamp_t *timestamps, timestamp_t bound);
+
+void initTimestampFilterFunctions();
+
+#endif // FILTER_TS_H
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filter_ts_avx2.h"
+
+#include <immintrin.h>
+
+// There is no unsigned 64 bit compare, flipping the sign bits of both sides keeps their order in
+// a signed one
+size_t CountBelowAVX2(const timestamp_t *timestamps, timestamp_t bound) {
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i bound_avx = _mm256_xor_si256(_mm256_set1_epi64x((int64_t)bound), sign);
+    const __m256i lo = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)timestamps), sign);
+    const __m256i hi = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)&timestamps[4]), sign);
+    const int below_lo = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(bound_avx, lo)));
+    const int below_hi = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(bound_avx, hi)));
+    return __builtin_popcount(below_lo | (below_hi << 4));
+}
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filter_ts_avx512f.h"
+
+#include <immintrin.h>
+
+size_t CountBelowAVX512F(const timestamp_t *timestamps, timestamp_t bound) {
+    const __mmask8 below = _mm512_cmplt_epu64_mask(_mm512_loadu_si512(timestamps),
+                                                   _mm512_set1_epi64((int64_t)bound));
+    return __builtin_popcount(below);
+}
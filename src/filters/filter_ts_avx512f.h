@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#ifndef FILTER_TS_AVX512F_H
+#define FILTER_TS_AVX512F_H
+
+#include "filter_ts.h"
+
+size_t CountBelowAVX512F(const timestamp_t *timestamps, timestamp_t bound);
+
+#endif // FILTER_TS_AVX512F_H
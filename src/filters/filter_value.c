@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filter_value.h"
+
+#include "filter_value_avx2.h"
+#include "filter_value_avx512f.h"
+#include "../utils/arch_features.h"
+
+static size_t (*filterByValue)(timestamp_t *dstTimestamps,
+                               double *dstValues,
+                               const timestamp_t *timestamps,
+                               const double *values,
+                               size_t n,
+                               double min,
+                               double max) = FilterByValueVec;
+
+// Every sample is written to the next free slot, which only advances past a matching one. The
+// slot never passes the sample which is read, so the samples can be moved in place.
+size_t FilterByValueVec(timestamp_t *dstTimestamps,
+                        double *dstValues,
+                        const timestamp_t *timestamps,
+                        const double *values,
+                        size_t n,
+                        double min,
+                        double max) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const timestamp_t timestamp = timestamps[i];
+        const double value = values[i];
+        dstTimestamps[count] = timestamp;
+        dstValues[count] = value;
+        count += (value >= min) & (value <= max);
+    }
+    return count;
+}
+
+size_t FilterByValue(timestamp_t *dstTimestamps,
+                     double *dstValues,
+                     const timestamp_t *timestamps,
+                     const double *values,
+                     size_t n,
+                     double min,
+                     double max) {
+    return filterByValue(dstTimestamps, dstValues, timestamps, values, n, min, max);
+}
+
+void initGlobalFilterFunctions() {
+    const X86Features *features = getArchitectureOptimization();
+    filterByValue = FilterByValueVec;
+
+#if defined(__x86_64__)
+    if (!features) {
+        return;
+    } else if (features->avx512f) {
+        filterByValue = FilterByValueAVX512F;
+        return;
+    } else if (features->avx2) {
+        filterByValue = FilterByValueAVX2;
+        return;
+    }
+#endif // __x86_64__
+    return;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#ifndef FILTER_VALUE_H
+#define FILTER_VALUE_H
+
+#include "../gorilla.h"
+
+#include <stddef.h>
+
+// Moves the samples of [0, n) whose value is in [min, max] to the front of dstTimestamps and
+// dstValues, keeping their order, and returns their count. The destination may be the source
+// itself. A NaN value never matches.
+size_t FilterByValue(timestamp_t *dstTimestamps,
+                     double *dstValues,
+                     const timestamp_t *timestamps,
+                     const double *values,
+                     size_t n,
+                     double min,
+                     double max);
+
+// The portable kernel of FilterByValue, the kernels of an instruction set use it for the tail
+size_t FilterByValueVec(timestamp_t *dstTimestamps,
+                        double *dstValues,
+                        const timestamp_t *timestamps,
+                        const double *values,
+                        size_t n,
+                        double min,
+                        double max);
+
+void initGlobalFilterFunctions();
+
+#endif // FILTER_VALUE_H
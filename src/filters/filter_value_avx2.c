@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filter_value_avx2.h"
+
+#include <immintrin.h>
+
+#define FILTER_VECTOR_SIZE_AVX2 4
+
+// The 32 bit lanes which move the doubles selected by a mask to the front of the vector
+static const int32_t compressLanes[1 << FILTER_VECTOR_SIZE_AVX2][8] = {
+    { 0, 0, 0, 0, 0, 0, 0, 0 },
+    { 0, 1, 0, 0, 0, 0, 0, 0 },
+    { 2, 3, 0, 0, 0, 0, 0, 0 },
+    { 0, 1, 2, 3, 0, 0, 0, 0 },
+    { 4, 5, 0, 0, 0, 0, 0, 0 },
+    { 0, 1, 4, 5, 0, 0, 0, 0 },
+    { 2, 3, 4, 5, 0, 0, 0, 0 },
+    { 0, 1, 2, 3, 4, 5, 0, 0 },
+    { 6, 7, 0, 0, 0, 0, 0, 0 },
+    { 0, 1, 6, 7, 0, 0, 0, 0 },
+    { 2, 3, 6, 7, 0, 0, 0, 0 },
+    { 0, 1, 2, 3, 6, 7, 0, 0 },
+    { 4, 5, 6, 7, 0, 0, 0, 0 },
+    { 0, 1, 4, 5, 6, 7, 0, 0 },
+    { 2, 3, 4, 5, 6, 7, 0, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7 },
+};
+
+// AVX2 has no compress instruction: the matching lanes are gathered to the front of the vector by
+// a permutation looked up by the comparison mask, and the whole vector is stored at the next free
+// slot. The slots after the matching lanes are overwritten by the next store.
+size_t FilterByValueAVX2(timestamp_t *dstTimestamps,
+                         double *dstValues,
+                         const timestamp_t *timestamps,
+                         const double *values,
+                         size_t n,
+                         double min,
+                         double max) {
+    const __m256d min_avx = _mm256_set1_pd(min);
+    const __m256d max_avx = _mm256_set1_pd(max);
+    size_t count = 0, i = 0;
+    for (; i + FILTER_VECTOR_SIZE_AVX2 <= n; i += FILTER_VECTOR_SIZE_AVX2) {
+        const __m256d values_avx = _mm256_loadu_pd(&values[i]);
+        const __m256i timestamps_avx = _mm256_loadu_si256((const __m256i *)&timestamps[i]);
+        // ordered comparisons are false for NaN
+        const int mask = _mm256_movemask_pd(
+            _mm256_and_pd(_mm256_cmp_pd(values_avx, min_avx, _CMP_GE_OQ),
+                          _mm256_cmp_pd(values_avx, max_avx, _CMP_LE_OQ)));
+        const __m256i lanes = _mm256_loadu_si256((const __m256i *)compressLanes[mask]);
+        _mm256_storeu_pd(&dstValues[count],
+                         _mm256_castsi256_pd(_mm256_permutevar8x32_epi32(
+                             _mm256_castpd_si256(values_avx), lanes)));
+        _mm256_storeu_si256((__m256i *)&dstTimestamps[count],
+                            _mm256_permutevar8x32_epi32(timestamps_avx, lanes));
+        count += __builtin_popcount(mask);
+    }
+    return count + FilterByValueVec(&dstTimestamps[count],
+                                    &dstValues[count],
+                                    &timestamps[i],
+                                    &values[i],
+                                    n - i,
+                                    min,
+                                    max);
+}
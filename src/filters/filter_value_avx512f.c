@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filter_value_avx512f.h"
+
+#include <immintrin.h>
+
+#define FILTER_VECTOR_SIZE_AVX512F 8
+
+// The matching lanes are compressed to the front of a register which is stored whole at the next
+// free slot, the slots after them are overwritten by the next store. It's faster than a masked
+// compress store to memory on some CPUs.
+size_t FilterByValueAVX512F(timestamp_t *dstTimestamps,
+                            double *dstValues,
+                            const timestamp_t *timestamps,
+                            const double *values,
+                            size_t n,
+                            double min,
+                            double max) {
+    const __m512d min_avx = _mm512_set1_pd(min);
+    const __m512d max_avx = _mm512_set1_pd(max);
+    size_t count = 0, i = 0;
+    for (; i + FILTER_VECTOR_SIZE_AVX512F <= n; i += FILTER_VECTOR_SIZE_AVX512F) {
+        const __m512d values_avx = _mm512_loadu_pd(&values[i]);
+        const __m512i timestamps_avx = _mm512_loadu_si512(&timestamps[i]);
+        // ordered comparisons are false for NaN
+        const __mmask8 mask = _mm512_mask_cmp_pd_mask(
+            _mm512_cmp_pd_mask(values_avx, min_avx, _CMP_GE_OQ), values_avx, max_avx, _CMP_LE_OQ);
+        _mm512_storeu_pd(&dstValues[count], _mm512_maskz_compress_pd(mask, values_avx));
+        _mm512_storeu_si512(&dstTimestamps[count],
+                            _mm512_maskz_compress_epi64(mask, timestamps_avx));
+        count += __builtin_popcount(mask);
+    }
+    return count + FilterByValueVec(&dstTimestamps[count],
+                                    &dstValues[count],
+                                    &timestamps[i],
+                                    &values[i],
+                                    n - i,
+                                    min,
+                                    max);
+}
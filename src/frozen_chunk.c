@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "frozen_chunk.h"
+
+#include <string.h>
+#include "rmutil/alloc.h"
+
+#define WORD_BITS 64
+
+static inline uint8_t bitWidth(uint64_t x) {
+    return x ? WORD_BITS - __builtin_clzll(x) : 0;
+}
+
+static inline size_t packedWords(size_t n, uint8_t bits) {
+    return (n * bits + WORD_BITS - 1) / WORD_BITS;
+}
+
+static inline size_t blockSamples(const FrozenChunk *chunk, uint32_t block) {
+    const size_t first = (size_t)block * FROZEN_BLOCK_SAMPLES;
+    return min(chunk->count - first, FROZEN_BLOCK_SAMPLES);
+}
+
+static inline uint64_t *tsStream(const FrozenChunk *chunk) {
+    return (uint64_t *)&chunk->blocks[chunk->numBlocks];
+}
+
+static inline uint64_t *valuesStream(const FrozenChunk *chunk) {
+    return tsStream(chunk) + chunk->tsWords;
+}
+
+static void packBits(uint64_t *words, uint8_t bits, const uint64_t *in, size_t n) {
+    if (bits == 0) {
+        return;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t pos = i * bits;
+        const uint64_t w = pos / WORD_BITS, s = pos % WORD_BITS;
+        words[w] |= in[i] << s;
+        if (s + bits > WORD_BITS) {
+            words[w + 1] |= in[i] >> (WORD_BITS - s);
+        }
+    }
+}
+
+// Branch free so the compiler can vectorize it. The high part of a value spanning two words is
+// shifted in two steps, a shift by 64 is undefined, and the streams are padded with an extra word
+// so `words[w + 1]` is always readable.
+static inline void unpackBits(const uint64_t *words, uint8_t bits, uint64_t *out, size_t n) {
+    if (bits == 0) {
+        memset(out, 0, n * sizeof(*out));
+        return;
+    }
+    const uint64_t mask = bits == WORD_BITS ? UINT64_MAX : (1ULL << bits) - 1;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t pos = i * bits;
+        const uint64_t w = pos / WORD_BITS, s = pos % WORD_BITS;
+        out[i] = ((words[w] >> s) | ((words[w + 1] << 1) << (WORD_BITS - 1 - s))) & mask;
+    }
+}
+
+// Picks the encoding of the block timestamps and fills `residuals`
+static void encodeTimestamps(FrozenBlock *block,
+                             const timestamp_t *timestamps,
+                             size_t n,
+                             uint64_t *residuals) {
+    uint64_t stride = n > 1 ? timestamps[1] - timestamps[0] : 0;
+    for (size_t i = 2; i < n; ++i) {
+        stride = min(stride, timestamps[i] - timestamps[i - 1]);
+    }
+    block->baseTimestamp = timestamps[0];
+    block->stride = stride;
+
+    uint64_t maxDelta = 0;
+    for (size_t i = 1; i < n; ++i) {
+        maxDelta = max(maxDelta, timestamps[i] - timestamps[i - 1] - stride);
+    }
+    const uint8_t deltaBits = bitWidth(maxDelta);
+    // the linear residuals never decrease, the last one is the largest
+    const uint8_t linearBits = bitWidth(timestamps[n - 1] - timestamps[0] - (n - 1) * stride);
+
+    residuals[0] = 0;
+    if (linearBits <= deltaBits) {
+        block->tsEncoding = FROZEN_TIMESTAMPS_LINEAR;
+        block->tsBits = linearBits;
+        for (size_t i = 1; i < n; ++i) {
+            residuals[i] = timestamps[i] - timestamps[0] - i * stride;
+        }
+    } else {
+        block->tsEncoding = FROZEN_TIMESTAMPS_DELTA;
+        block->tsBits = deltaBits;
+        for (size_t i = 1; i < n; ++i) {
+            residuals[i] = timestamps[i] - timestamps[i - 1] - stride;
+        }
+    }
+}
+
+// Returns false if the block values don't fit a single decimal scale
+static bool encodeDecimalValues(FrozenBlock *block,
+                                const double *values,
+                                size_t n,
+                                uint64_t *residuals) {
+    int scale = Decimal_ScaleOf(values[0]);
+    if (scale < 0) {
+        return false;
+    }
+    for (size_t i = 1; i < n; ++i) {
+        if (!Decimal_Fits(values[i], scale)) {
+            const int valueScale = Decimal_ScaleOf(values[i]);
+            if (valueScale < 0) {
+                return false;
+            }
+            scale = max(scale, valueScale);
+        }
+    }
+    int64_t minScaled = INT64_MAX, maxScaled = INT64_MIN;
+    for (size_t i = 0; i < n; ++i) {
+        // a value which fits a smaller scale may not fit the largest one
+        if (!Decimal_Fits(values[i], scale)) {
+            return false;
+        }
+        const int64_t scaled = Decimal_ToScaled(values[i], scale);
+        residuals[i] = scaled;
+        minScaled = min(minScaled, scaled);
+        maxScaled = max(maxScaled, scaled);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        residuals[i] -= minScaled;
+    }
+    block->valuesEncoding = FROZEN_VALUES_DECIMAL;
+    block->baseValue.i = minScaled;
+    block->valueShift = scale;
+    block->valueBits = bitWidth(maxScaled - minScaled);
+    return true;
+}
+
+static void encodeXorValues(FrozenBlock *block,
+                            const double *values,
+                            size_t n,
+                            uint64_t *residuals) {
+    union64bits base, val;
+    base.d = values[0];
+    uint64_t setBits = 0;
+    for (size_t i = 0; i < n; ++i) {
+        val.d = values[i];
+        residuals[i] = val.u ^ base.u;
+        setBits |= residuals[i];
+    }
+    const uint8_t shift = setBits ? __builtin_ctzll(setBits) : 0;
+    for (size_t i = 0; i < n; ++i) {
+        residuals[i] >>= shift;
+    }
+    block->valuesEncoding = FROZEN_VALUES_XOR;
+    block->baseValue = base;
+    block->valueShift = shift;
+    block->valueBits = bitWidth(setBits >> shift);
+}
+
+FrozenChunk *Frozen_Encode(const timestamp_t *timestamps, const double *values, size_t count) {
+    const uint32_t numBlocks = (count + FROZEN_BLOCK_SAMPLES - 1) / FROZEN_BLOCK_SAMPLES;
+    FrozenBlock *blocks = malloc(numBlocks * sizeof(FrozenBlock));
+    uint64_t *tsResiduals = malloc(count * sizeof(uint64_t));
+    uint64_t *valueResiduals = malloc(count * sizeof(uint64_t));
+    uint64_t decimalResiduals[FROZEN_BLOCK_SAMPLES];
+
+    // the encoding of every block is picked first to know the size of the streams
+    size_t tsWords = 0, valueWords = 0;
+    for (uint32_t b = 0; b < numBlocks; ++b) {
+        const size_t first = (size_t)b * FROZEN_BLOCK_SAMPLES;
+        const size_t n = min(count - first, FROZEN_BLOCK_SAMPLES);
+        FrozenBlock *block = &blocks[b];
+        encodeTimestamps(block, timestamps + first, n, tsResiduals + first);
+        encodeXorValues(block, values + first, n, valueResiduals + first);
+
+        FrozenBlock decimal = *block;
+        if (encodeDecimalValues(&decimal, values + first, n, decimalResiduals) &&
+            decimal.valueBits < block->valueBits) {
+            *block = decimal;
+            memcpy(valueResiduals + first, decimalResiduals, n * sizeof(uint64_t));
+        }
+        block->tsOffset = tsWords;
+        block->valuesOffset = valueWords;
+        tsWords += packedWords(n, block->tsBits);
+        valueWords += packedWords(n, block->valueBits);
+    }
+    // padding for unpackBits
+    tsWords++;
+    valueWords++;
+
+    const size_t size = sizeof(FrozenChunk) + numBlocks * sizeof(FrozenBlock) +
+                        (tsWords + valueWords) * sizeof(uint64_t);
+    FrozenChunk *chunk = calloc(1, size);
+    chunk->count = count;
+    chunk->numBlocks = numBlocks;
+    chunk->tsWords = tsWords;
+    chunk->valueWords = valueWords;
+    memcpy(chunk->blocks, blocks, numBlocks * sizeof(FrozenBlock));
+    for (uint32_t b = 0; b < numBlocks; ++b) {
+        const FrozenBlock *block = &blocks[b];
+        const size_t first = (size_t)b * FROZEN_BLOCK_SAMPLES;
+        const size_t n = blockSamples(chunk, b);
+        packBits(tsStream(chunk) + block->tsOffset, block->tsBits, tsResiduals + first, n);
+        packBits(valuesStream(chunk) + block->valuesOffset,
+                 block->valueBits,
+                 valueResiduals + first,
+                 n);
+    }
+
+    free(blocks);
+    free(tsResiduals);
+    free(valueResiduals);
+    return chunk;
+}
+
+size_t Frozen_Size(const FrozenChunk *chunk) {
+    return sizeof(FrozenChunk) + chunk->numBlocks * sizeof(FrozenBlock) +
+           (chunk->tsWords + chunk->valueWords) * sizeof(uint64_t);
+}
+
+FrozenChunk *Frozen_Clone(const FrozenChunk *chunk) {
+    const size_t size = Frozen_Size(chunk);
+    FrozenChunk *clone = malloc(size);
+    memcpy(clone, chunk, size);
+    return clone;
+}
+
+uint32_t Frozen_SeekBlock(const FrozenChunk *chunk, timestamp_t ts) {
+    size_t l = 0, h = chunk->numBlocks;
+    while (l < h) {
+        const size_t m = l + (h - l) / 2;
+        if (chunk->blocks[m].baseTimestamp <= ts) {
+            l = m + 1;
+        } else {
+            h = m;
+        }
+    }
+    return l > 0 ? l - 1 : 0;
+}
+
+size_t Frozen_DecodeBlock(const FrozenChunk *chunk,
+                          uint32_t block,
+                          timestamp_t *timestamps,
+                          double *values) {
+    const FrozenBlock *header = &chunk->blocks[block];
+    const size_t n = blockSamples(chunk, block);
+
+    unpackBits(tsStream(chunk) + header->tsOffset, header->tsBits, timestamps, n);
+    const timestamp_t baseTimestamp = header->baseTimestamp;
+    const uint64_t stride = header->stride;
+    if (header->tsEncoding == FROZEN_TIMESTAMPS_LINEAR) {
+        for (size_t i = 0; i < n; ++i) {
+            timestamps[i] += baseTimestamp + i * stride;
+        }
+    } else {
+        timestamp_t ts = baseTimestamp - stride; // the first residual is 0
+        for (size_t i = 0; i < n; ++i) {
+            ts += stride + timestamps[i];
+            timestamps[i] = ts;
+        }
+    }
+
+    uint64_t residuals[FROZEN_BLOCK_SAMPLES];
+    unpackBits(valuesStream(chunk) + header->valuesOffset, header->valueBits, residuals, n);
+    if (header->valuesEncoding == FROZEN_VALUES_DECIMAL) {
+        const int64_t base = header->baseValue.i;
+        const double scale = Decimal_ScaleFactor(header->valueShift);
+        for (size_t i = 0; i < n; ++i) {
+            values[i] = (double)(base + (int64_t)residuals[i]) / scale;
+        }
+    } else {
+        const uint64_t base = header->baseValue.u;
+        const uint8_t shift = header->valueShift;
+        union64bits val;
+        for (size_t i = 0; i < n; ++i) {
+            val.u = base ^ (residuals[i] << shift);
+            values[i] = val.d;
+        }
+    }
+    return n;
+}
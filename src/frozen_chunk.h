@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#ifndef FROZEN_CHUNK_H
+#define FROZEN_CHUNK_H
+
+#include "gorilla.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Read optimized layout of a sealed compressed chunk. The samples are split into blocks of
+// FROZEN_BLOCK_SAMPLES, every block packs its timestamps and its values with a fixed bit width so
+// a block is decoded with straight loops instead of the bit by bit Gorilla decoding.
+#define FROZEN_BLOCK_SAMPLES 128
+
+typedef enum FrozenValuesEncoding
+{
+    // XOR with the block base value, shifted right by the trailing zeros common to the block
+    FROZEN_VALUES_XOR = 0,
+    // values scaled to integers by 10^scale, minus the block base value (its smallest)
+    FROZEN_VALUES_DECIMAL,
+} FrozenValuesEncoding;
+
+typedef enum FrozenTimestampsEncoding
+{
+    // `ts[i] - (baseTimestamp + i * stride)`, decoded without any dependency between samples
+    FROZEN_TIMESTAMPS_LINEAR = 0,
+    // `ts[i] - ts[i - 1] - stride`, smaller when the intervals jitter
+    FROZEN_TIMESTAMPS_DELTA,
+} FrozenTimestampsEncoding;
+
+// The stride is the smallest delta of the block, so the timestamps of a fixed interval block take
+// 0 bits.
+typedef struct FrozenBlock
+{
+    timestamp_t baseTimestamp;
+    uint64_t stride;
+    union64bits baseValue; // a double or a scaled integer, according to `valuesEncoding`
+    uint32_t tsOffset;     // first word of the block in the timestamps stream
+    uint32_t valuesOffset; // first word of the block in the values stream
+    uint8_t tsBits;
+    uint8_t valueBits;
+    uint8_t valueShift; // the XOR shift, or the decimal scale
+    uint8_t valuesEncoding;
+    uint8_t tsEncoding;
+} FrozenBlock;
+
+// A single allocation: the block headers, then the timestamps stream and the values stream
+typedef struct FrozenChunk
+{
+    uint32_t count;
+    uint32_t numBlocks;
+    uint32_t tsWords;
+    uint32_t valueWords;
+    FrozenBlock blocks[];
+} FrozenChunk;
+
+FrozenChunk *Frozen_Encode(const timestamp_t *timestamps, const double *values, size_t count);
+FrozenChunk *Frozen_Clone(const FrozenChunk *chunk);
+// Size of the allocation in bytes
+size_t Frozen_Size(const FrozenChunk *chunk);
+
+// Returns the last block which base timestamp is <= ts, or 0 if there is none. Samples with a
+// timestamp >= ts are never found before this block.
+uint32_t Frozen_SeekBlock(const FrozenChunk *chunk, timestamp_t ts);
+// Decodes a block into the arrays, which must have room for FROZEN_BLOCK_SAMPLES samples, and
+// returns the number of decoded samples
+size_t Frozen_DecodeBlock(const FrozenChunk *chunk,
+                          uint32_t block,
+                          timestamp_t *timestamps,
+                          double *values);
+
+#endif // FROZEN_CHUNK_H
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "fused_range.h"
+
+#include "config.h"
+#include "consts.h"
+#include "filter_iterator.h"
+#include "reply.h"
+#include "series_iterator.h"
+
+#include <limits.h>
+
+typedef struct FusedRange
+{
+    RedisModuleCtx *ctx;
+    long long count;   // the samples, or buckets, to reply at most
+    long long replied; // the samples, or buckets, replied so far
+    double min;        // FILTER_BY_VALUE
+    double max;
+    AggregationClass *aggregation;
+    void *aggregationContext;
+    int64_t timeDelta;
+    timestamp_t timestampAlignment;
+    BucketTimestamp bucketTS;
+    bool hasBucket;          // the current bucket has samples which weren't replied yet
+    timestamp_t bucketStart; // normalized
+    timestamp_t bucketEnd;   // exclusive
+} FusedRange;
+
+static inline void openBucket(FusedRange *fr, timestamp_t ts) {
+    const timestamp_t bucketStart = CalcBucketStart(ts, fr->timeDelta, fr->timestampAlignment);
+    fr->bucketEnd = bucketStart + fr->timeDelta;
+    fr->bucketStart = BucketStartNormalize(bucketStart);
+    fr->hasBucket = true;
+}
+
+// Returns false once COUNT buckets were replied
+static inline bool replyBucket(FusedRange *fr) {
+    double value;
+    fr->aggregation->finalize(fr->aggregationContext, &value);
+    fr->aggregation->resetContext(fr->aggregationContext);
+    ReplyWithSample(fr->ctx, calc_bucket_ts(fr->bucketTS, fr->bucketStart, fr->timeDelta), value);
+    fr->hasBucket = false;
+    return ++fr->replied < fr->count;
+}
+
+// Makes the bucket of ts the current one, the samples of a chunk are ascending, or descending when
+// reversed. Returns false once COUNT buckets were replied.
+static really_inline bool enterBucket(FusedRange *fr, timestamp_t ts, const bool reverse) {
+    if (likely(fr->hasBucket)) {
+        if (reverse ? ts >= fr->bucketStart : ts < fr->bucketEnd) {
+            return true;
+        }
+        if (!replyBucket(fr)) {
+            return false;
+        }
+    }
+    openBucket(fr, ts);
+    return true;
+}
+
+// The loop of all the shapes, every shape instantiates it with constant flags so the stages it
+// doesn't have are compiled out. Returns false once COUNT was replied.
+static really_inline bool fusedRangeChunk(FusedRange *fr,
+                                          const EnrichedChunk *chunk,
+                                          const bool filterByValue,
+                                          const bool aggregate,
+                                          const bool reverse) {
+    const timestamp_t *timestamps = chunk->samples.timestamps;
+    double *values = chunk->samples.values;
+    const int64_t n = chunk->samples.num_samples;
+    if (aggregate && !filterByValue && !reverse && unlikely(chunk->summary)) {
+        // the summary of a chunk within a bucket comes with the first sample of the chunk
+        if (!enterBucket(fr, timestamps[0], reverse)) {
+            return false;
+        }
+        fr->aggregation->appendSummary(fr->aggregationContext, chunk->summary);
+        return true;
+    }
+
+    for (int64_t i = 0; i < n; ++i) {
+        const double value = values[i];
+        if (filterByValue && !(value >= fr->min && value <= fr->max)) {
+            continue;
+        }
+        const timestamp_t ts = timestamps[i];
+        if (!aggregate) {
+            ReplyWithSample(fr->ctx, ts, value);
+            if (++fr->replied == fr->count) {
+                return false;
+            }
+            continue;
+        }
+
+        if (!enterBucket(fr, ts, reverse)) {
+            return false;
+        }
+        if (!filterByValue && fr->aggregation->appendValueVec) {
+            // the rest of the bucket in the chunk is appended at once
+            const int64_t ei =
+                findLastIndexInBucket(chunk, fr->bucketStart, fr->bucketEnd, i, reverse);
+            fr->aggregation->appendValueVec(fr->aggregationContext, values, i, ei);
+            i = ei;
+        } else {
+            fr->aggregation->appendValue(fr->aggregationContext, value, ts);
+        }
+    }
+    return true;
+}
+
+typedef bool (*FusedRangeShape)(FusedRange *fr, const EnrichedChunk *chunk);
+
+#define FUSED_RANGE_SHAPE(name, filterByValue, aggregate, reverse)                                 \
+    static bool name(FusedRange *fr, const EnrichedChunk *chunk) {                                 \
+        return fusedRangeChunk(fr, chunk, filterByValue, aggregate, reverse);                      \
+    }
+
+FUSED_RANGE_SHAPE(fusedRange, false, false, false)
+FUSED_RANGE_SHAPE(fusedRangeFilter, true, false, false)
+FUSED_RANGE_SHAPE(fusedRangeAgg, false, true, false)
+FUSED_RANGE_SHAPE(fusedRangeFilterAgg, true, true, false)
+FUSED_RANGE_SHAPE(fusedRevRange, false, false, true)
+FUSED_RANGE_SHAPE(fusedRevRangeFilter, true, false, true)
+FUSED_RANGE_SHAPE(fusedRevRangeAgg, false, true, true)
+FUSED_RANGE_SHAPE(fusedRevRangeFilterAgg, true, true, true)
+
+// indexed by filterByValue | aggregate << 1 | reverse << 2
+static const FusedRangeShape fusedRangeShapes[] = {
+    fusedRange,    fusedRangeFilter,    fusedRangeAgg,    fusedRangeFilterAgg,
+    fusedRevRange, fusedRevRangeFilter, fusedRevRangeAgg, fusedRevRangeFilterAgg,
+};
+
+bool ReplySeriesRangeFused(RedisModuleCtx *ctx,
+                           Series *series,
+                           const RangeArgs *args,
+                           bool reverse) {
+    AggregationClass *aggregation = args->aggregationArgs.aggregationClass;
+    if (!TSGlobalConfig.fusedRange || args->filterByTSArgs.hasValue ||
+        (aggregation && (args->aggregationArgs.empty || aggregation->type == TS_AGG_TWA))) {
+        return false;
+    }
+
+    const bool filterByValue = args->filterByValueArgs.hasValue;
+    FusedRange fr = {
+        .ctx = ctx,
+        .count = args->count != -1 ? args->count : LLONG_MAX,
+        .replied = 0,
+        .min = args->filterByValueArgs.min,
+        .max = args->filterByValueArgs.max,
+        .aggregation = aggregation,
+        .aggregationContext = aggregation ? aggregation->createContext(reverse) : NULL,
+        .timeDelta = args->aggregationArgs.timeDelta,
+        .timestampAlignment = SeriesQueryAlignment(args),
+        .bucketTS = args->aggregationArgs.bucketTS,
+        .hasBucket = false,
+    };
+    const FusedRangeShape shape =
+        fusedRangeShapes[filterByValue | (aggregation != NULL) << 1 | reverse << 2];
+
+    AbstractIterator *iter = SeriesQueryChunks(series, args, reverse, reverse, true);
+    if (aggregation && aggregation->appendSummary && !reverse && !filterByValue) {
+        SeriesIterator_UseChunkSummaries(iter, fr.timeDelta, fr.timestampAlignment);
+    }
+
+    RedisModule_ReplyWithArray(ctx, REDISMODULE_POSTPONED_ARRAY_LEN);
+    bool more = fr.replied < fr.count;
+    EnrichedChunk *enrichedChunk;
+    while (more && (enrichedChunk = iter->GetNext(iter))) {
+        more = shape(&fr, enrichedChunk);
+    }
+    if (more && fr.hasBucket) {
+        replyBucket(&fr);
+    }
+    iter->Close(iter);
+    if (aggregation) {
+        aggregation->freeContext(fr.aggregationContext);
+    }
+
+    RedisModule_ReplySetArrayLength(ctx, fr.replied);
+    return true;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#ifndef FUSED_RANGE_H
+#define FUSED_RANGE_H
+
+#include "query_language.h"
+#include "tsdb.h"
+#include "RedisModulesSDK/redismodule.h"
+
+#include <stdbool.h>
+
+// Replies the samples of a range query in a single loop per chunk, which filters, aggregates and
+// replies each decoded sample without passing the chunk through the iterator chain. There is a
+// loop specialized for each shape: plain, FILTER_BY_VALUE, AGGREGATION or both, forward or
+// reverse. Returns false without replying for the other queries (FILTER_BY_TS, EMPTY, twa), or
+// when ts-fused-range is disabled, they are replied by the iterator chain of SeriesQuery.
+bool ReplySeriesRangeFused(RedisModuleCtx *ctx,
+                           Series *series,
+                           const RangeArgs *args,
+                           bool reverse);
+
+#endif // FUSED_RANGE_H
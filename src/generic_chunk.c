@@ -16,15 +16,18 @@ static const ChunkFuncs regChunk = {
 
     .AddSample = Uncompressed_AddSample,
     .UpsertSample = Uncompressed_UpsertSample,
+    .SealChunk = Uncompressed_SealChunk,
     .DelRange = Uncompressed_DelRange,
 
     .ProcessChunk = Uncompressed_ProcessChunk,
 
     .GetChunkSize = Uncompressed_GetChunkSize,
+    .GetCheckpointsSize = Uncompressed_GetCheckpointsSize,
     .GetNumOfSample = Uncompressed_NumOfSample,
     .GetLastTimestamp = Uncompressed_GetLastTimestamp,
     .GetLastValue = Uncompressed_GetLastValue,
     .GetFirstTimestamp = Uncompressed_GetFirstTimestamp,
+    .GetSummary = Uncompressed_GetSummary,
 
     .SaveToRDB = Uncompressed_SaveToRDB,
     .LoadFromRDB = Uncompressed_LoadFromRDB,
@@ -41,15 +44,18 @@ static const ChunkFuncs comprChunk = {
 
     .AddSample = Compressed_AddSample,
     .UpsertSample = Compressed_UpsertSample,
+    .SealChunk = Compressed_SealChunk,
     .DelRange = Compressed_DelRange,
 
     .ProcessChunk = Compressed_ProcessChunk,
 
     .GetChunkSize = Compressed_GetChunkSize,
+    .GetCheckpointsSize = Compressed_GetCheckpointsSize,
     .GetNumOfSample = Compressed_ChunkNumOfSample,
     .GetLastTimestamp = Compressed_GetLastTimestamp,
     .GetLastValue = Compressed_GetLastValue,
     .GetFirstTimestamp = Compressed_GetFirstTimestamp,
+    .GetSummary = Compressed_GetSummary,
 
     .SaveToRDB = Compressed_SaveToRDB,
     .LoadFromRDB = Compressed_LoadFromRDB,
@@ -57,6 +63,100 @@ static const ChunkFuncs comprChunk = {
     .MRDeserialize = Compressed_MRDeserialize,
 };
 
+static const ChunkFuncs decimalChunk = {
+    .NewChunk = Decimal_NewChunk,
+    .FreeChunk = Compressed_FreeChunk,
+    .CloneChunk = Compressed_CloneChunk,
+    .SplitChunk = Compressed_SplitChunk,
+    .DefragChunk = Compressed_DefragChunk,
+
+    .AddSample = Compressed_AddSample,
+    .UpsertSample = Compressed_UpsertSample,
+    .SealChunk = Compressed_SealChunk,
+    .DelRange = Compressed_DelRange,
+
+    .ProcessChunk = Compressed_ProcessChunk,
+
+    .GetChunkSize = Compressed_GetChunkSize,
+    .GetCheckpointsSize = Compressed_GetCheckpointsSize,
+    .GetNumOfSample = Compressed_ChunkNumOfSample,
+    .GetLastTimestamp = Compressed_GetLastTimestamp,
+    .GetLastValue = Compressed_GetLastValue,
+    .GetFirstTimestamp = Compressed_GetFirstTimestamp,
+    .GetSummary = Compressed_GetSummary,
+
+    .SaveToRDB = Decimal_SaveToRDB,
+    .LoadFromRDB = Decimal_LoadFromRDB,
+    .MRSerialize = Decimal_MRSerialize,
+    .MRDeserialize = Decimal_MRDeserialize,
+};
+
+static const ChunkFuncs chimpChunk = {
+    .NewChunk = Chimp_NewChunk,
+    .FreeChunk = Compressed_FreeChunk,
+    .CloneChunk = Compressed_CloneChunk,
+    .SplitChunk = Compressed_SplitChunk,
+    .DefragChunk = Compressed_DefragChunk,
+
+    .AddSample = Compressed_AddSample,
+    .UpsertSample = Compressed_UpsertSample,
+    .SealChunk = Compressed_SealChunk,
+    .DelRange = Compressed_DelRange,
+
+    .ProcessChunk = Compressed_ProcessChunk,
+
+    .GetChunkSize = Compressed_GetChunkSize,
+    .GetCheckpointsSize = Compressed_GetCheckpointsSize,
+    .GetNumOfSample = Compressed_ChunkNumOfSample,
+    .GetLastTimestamp = Compressed_GetLastTimestamp,
+    .GetLastValue = Compressed_GetLastValue,
+    .GetFirstTimestamp = Compressed_GetFirstTimestamp,
+    .GetSummary = Compressed_GetSummary,
+
+    .SaveToRDB = Chimp_SaveToRDB,
+    .LoadFromRDB = Chimp_LoadFromRDB,
+    .MRSerialize = Chimp_MRSerialize,
+    .MRDeserialize = Chimp_MRDeserialize,
+};
+
+void ChunkSummary_Reset(ChunkSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+}
+
+// Samples may be added out of order, first and last are picked by timestamp
+void ChunkSummary_Add(ChunkSummary *summary, const Sample *sample) {
+    const double value = sample->value;
+    if (summary->count == 0) {
+        summary->min = summary->max = value;
+        summary->first = summary->last = *sample;
+    } else {
+        if (value < summary->min) {
+            summary->min = value;
+        }
+        if (value > summary->max) {
+            summary->max = value;
+        }
+        if (sample->timestamp < summary->first.timestamp) {
+            summary->first = *sample;
+        }
+        if (sample->timestamp >= summary->last.timestamp) {
+            summary->last = *sample;
+        }
+    }
+    summary->count++;
+    summary->sum += value;
+    summary->sum_2 += value * value;
+}
+
+// A NaN or an infinite value (or a sum which overflowed) is left to the aggregations of the
+// samples, so a folded summary gives the same result
+const ChunkSummary *ChunkSummary_Get(const ChunkSummary *summary) {
+    if (summary->stale || summary->count == 0 || !isfinite(summary->sum)) {
+        return NULL;
+    }
+    return summary;
+}
+
 // This function will decide according to the policy how to handle duplicate sample, the `newSample`
 // will contain the data that will be kept in the database.
 ChunkResult handleDuplicateSample(DuplicatePolicy policy, Sample oldSample, Sample *newSample) {
@@ -99,6 +199,10 @@ const ChunkFuncs *GetChunkClass(CHUNK_TYPES_T chunkType) {
             return &regChunk;
         case CHUNK_COMPRESSED:
             return &comprChunk;
+        case CHUNK_DECIMAL:
+            return &decimalChunk;
+        case CHUNK_CHIMP:
+            return &chimpChunk;
     }
     return NULL;
 }
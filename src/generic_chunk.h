@@ -36,13 +36,34 @@ typedef void ChunkIter_t;
 typedef enum CHUNK_TYPES_T
 {
     CHUNK_REGULAR,
-    CHUNK_COMPRESSED
+    CHUNK_COMPRESSED,
+    CHUNK_DECIMAL,
+    CHUNK_CHIMP
 } CHUNK_TYPES_T;
 
+// Aggregates of all the samples of a chunk. A range aggregation folds the summary of a chunk
+// which falls inside a single bucket instead of reading its samples.
+typedef struct ChunkSummary
+{
+    uint64_t count;
+    double min;
+    double max;
+    double sum;
+    double sum_2; // sum of (values^2)
+    Sample first;
+    Sample last;
+    // an overridden value can't be taken out of min and max, the summary is rebuilt when the chunk
+    // is encoded again
+    bool stale;
+} ChunkSummary;
+
 typedef struct UpsertCtx
 {
     Sample sample;
-    Chunk_t *inChunk; // original chunk
+    Chunk_t *inChunk;       // original chunk
+    bool overridden;        // set by UpsertSample when the sample replaced one of the chunk
+    double overriddenValue; // the value of the replaced sample
+    bool overriddenUnknown; // set instead when the chunk didn't decode the sample it may replace
 } UpsertCtx;
 
 typedef struct ChunkFuncs
@@ -56,6 +77,8 @@ typedef struct ChunkFuncs
     size_t (*DelRange)(Chunk_t *chunk, timestamp_t startTs, timestamp_t endTs);
     ChunkResult (*AddSample)(Chunk_t *chunk, Sample *sample);
     ChunkResult (*UpsertSample)(UpsertCtx *uCtx, int *size, DuplicatePolicy duplicatePolicy);
+    // Called once a chunk is full and another chunk takes the appends
+    void (*SealChunk)(Chunk_t *chunk);
 
     void (*ProcessChunk)(const Chunk_t *chunk,
                          uint64_t start,
@@ -64,10 +87,13 @@ typedef struct ChunkFuncs
                          bool reverse);
 
     size_t (*GetChunkSize)(const Chunk_t *chunk, bool includeStruct);
+    size_t (*GetCheckpointsSize)(const Chunk_t *chunk);
     uint64_t (*GetNumOfSample)(Chunk_t *chunk);
     uint64_t (*GetLastTimestamp)(Chunk_t *chunk);
     double (*GetLastValue)(Chunk_t *chunk);
     uint64_t (*GetFirstTimestamp)(Chunk_t *chunk);
+    // NULL when the summary can't be used and the samples must be read
+    const ChunkSummary *(*GetSummary)(const Chunk_t *chunk);
 
     void (*SaveToRDB)(Chunk_t *chunk, struct RedisModuleIO *io);
     int (*LoadFromRDB)(Chunk_t **chunk, struct RedisModuleIO *io);
@@ -75,6 +101,10 @@ typedef struct ChunkFuncs
     int (*MRDeserialize)(Chunk_t **chunk, ReaderSerializationCtx *sctx);
 } ChunkFuncs;
 
+void ChunkSummary_Reset(ChunkSummary *summary);
+void ChunkSummary_Add(ChunkSummary *summary, const Sample *sample);
+const ChunkSummary *ChunkSummary_Get(const ChunkSummary *summary);
+
 ChunkResult handleDuplicateSample(DuplicatePolicy policy, Sample oldSample, Sample *newSample);
 const char *DuplicatePolicyToString(DuplicatePolicy policy);
 int RMStringLenDuplicationPolicyToEnum(RedisModuleString *aggTypeStr);
@@ -90,11 +90,42 @@
 * 0x0024b33333333333 01011 * 0x0024b33333333333 *  0 * 10 * 1 * 1 *  18.7 * 5.5 *
 *********************************************************************************
 * t=trailing, l=leading, p=use of previous params, 0=xor equal zero
+*********************************************************************************
+* Compression of decimal values
+*
+* Counters and gauges usually have a fixed number of digits after the decimal
+* point, their XOR compresses poorly. A decimal chunk picks the smallest scale
+* (number of digits after the decimal point) its values fit in, and stores the
+* values as integers scaled by 10^scale. A value fits a scale only if it is
+* restored exactly by dividing the scaled integer by 10^scale.
+*
+* The scaled integers are compressed like the timestamps, with delta of deltas,
+* but the DoubleDelta is zigzag encoded ((dd << 1) ^ (dd >> 63)) so the buckets
+* hold unsigned values of 4, 8, 12, 20 and 32 bits. The control bits are the
+* same as the timestamps control bits.
+*********************************************************************************
+* Compression of doubles with Chimp
+*
+* Based on "Chimp: Efficient Lossless Floating Point Compression for Time
+* Series Databases" (Liakos et al., VLDB 2022).
+* Like Gorilla, the XOR with the previous value is stored, but most XORs have
+* few trailing zeros, so instead of the block size Chimp stores the number of
+* leading zeros, rounded down to one of 8 values, and the rest of the XOR.
+* Two control bits select one of:
+* * 00 - the value is identical to the previous value.
+* * 01 - the XOR has more than 6 trailing zeros: 3 bits leading zeros index,
+*        6 bits length of the meaningful bits and the meaningful bits.
+* * 10 - same leading zeros as the previous value: the XOR after its leading
+*        zeros.
+* * 11 - 3 bits leading zeros index and the XOR after its leading zeros.
+* The previous leading zeros are reset by 01, so 10 always follows 11 or 10.
 */
 
 #include "gorilla.h"
 
 #include <assert.h>
+#include <math.h>   // llrint
+#include <string.h> // memcpy
 
 #define BIN_NUM_VALUES 64
 #define BINW BIN_NUM_VALUES
@@ -118,6 +149,45 @@
 #define CMPR_L4 15
 #define CMPR_L5 32
 
+// Define compression steps for the zigzag encoded decimal double deltas
+#define DECIMAL_L1 4
+#define DECIMAL_L2 8
+#define DECIMAL_L3 12
+#define DECIMAL_L4 20
+#define DECIMAL_L5 32
+
+// scaled values must be exactly representable as doubles
+#define DECIMAL_MAX_SCALED_VALUE 9007199254740992.0 // 2^53
+
+static const double decimalScales[DECIMAL_MAX_SCALE + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+#define CHIMP_FLAG 2
+#define CHIMP_LEADING 3
+#define CHIMP_SIGNIFICANT 6
+#define CHIMP_TRAILING_THRESHOLD 6
+// never a rounded number of leading zeros, `10` isn't used after it
+#define CHIMP_NO_LEADING 0xff
+
+enum
+{
+    CHIMP_SAME = 0,
+    CHIMP_TRAILING = 1,
+    CHIMP_PREV_LEADING = 2,
+    CHIMP_NEW_LEADING = 3,
+};
+
+// The rounded number of leading zeros of each leading zeros index
+static const uint8_t chimpLeading[1 << CHIMP_LEADING] = { 0, 8, 12, 16, 18, 20, 22, 24 };
+
+// The leading zeros index of each number of leading zeros, rounded down
+static const uint8_t chimpLeadingIndex[BIN_NUM_VALUES + 1] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 4, 4, 5, 5,
+    6, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7
+};
+
 // The powers of 2 from 0 to 63
 static uint64_t bittt[] = {
     1ULL << 0,  1ULL << 1,  1ULL << 2,  1ULL << 3,  1ULL << 4,  1ULL << 5,  1ULL << 6,  1ULL << 7,
@@ -260,6 +330,30 @@ static inline binary_t readBits(const binary_t *bins,
     }
 }
 
+// Read 64 bits from `bins` at position `start_pos` without reading past the end of the data.
+// Bits past the last bin are returned as zeros. Branch free, the double shift avoids shifting by 64
+// when `start_pos` is aligned to a bin.
+static inline binary_t peekBits64(const binary_t *bins, globalbit_t start_pos, uint64_t nbins) {
+    const uint64_t bin = start_pos / BINW;
+    const localbit_t lbit = localbit(start_pos);
+    const binary_t next = (bin + 1 < nbins) ? bins[bin + 1] : 0;
+    return (bins[bin] >> lbit) | ((next << 1) << (BINW - 1 - lbit));
+}
+
+// Peek at least 57 bits from `bins` at position `start_pos` using a single unaligned load.
+// Bits past the end of the data are returned as zeros.
+static inline binary_t peekBits(const binary_t *bins, globalbit_t start_pos, uint64_t nbins) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const uint64_t byte = start_pos / 8;
+    if (likely(byte + sizeof(binary_t) <= nbins * sizeof(binary_t))) {
+        binary_t bits;
+        memcpy(&bits, (const char *)bins + byte, sizeof(bits));
+        return bits >> (start_pos % 8);
+    }
+#endif
+    return peekBits64(bins, start_pos, nbins);
+}
+
 static inline bool isSpaceAvailable(CompressedChunk *chunk, uint8_t size) {
     uint64_t available = (chunk->size * 8) - chunk->idx;
     return size <= available;
@@ -324,6 +418,27 @@ static ChunkResult appendInteger(CompressedChunk *chunk, timestamp_t timestamp)
     return CR_OK;
 }
 
+// Returns true if the timestamp keeps the chunk on its fixed interval, the second sample sets the
+// interval
+static inline bool onInterval(const CompressedChunk *chunk, timestamp_t timestamp) {
+    if (chunk->timestampEncoding != TIMESTAMP_ENCODING_INTERVAL ||
+        chunk->intervalCount != chunk->count) {
+        return false;
+    }
+    if (chunk->count <= 1) {
+        return chunk->count == 0 || timestamp > chunk->prevTimestamp;
+    }
+    return timestamp - chunk->prevTimestamp == chunk->interval;
+}
+
+// A timestamp on the interval is implied by the sample index, nothing is encoded
+static ChunkResult appendIntervalTimestamp(CompressedChunk *chunk, timestamp_t timestamp) {
+    CHECKSPACE(chunk, 1); // the minimum for the value
+    chunk->interval = chunk->prevTimestampDelta = timestamp - chunk->prevTimestamp;
+    chunk->prevTimestamp = timestamp;
+    return CR_OK;
+}
+
 static ChunkResult appendFloat(CompressedChunk *chunk, double value) {
     union64bits val;
     val.d = value;
@@ -385,6 +500,130 @@ static ChunkResult appendFloat(CompressedChunk *chunk, double value) {
     return CR_OK;
 }
 
+int64_t Decimal_ToScaled(double value, uint8_t scale) {
+    return llrint(value * decimalScales[scale]);
+}
+
+double Decimal_ScaleFactor(uint8_t scale) {
+    return decimalScales[scale];
+}
+
+static inline double fromScaled(int64_t scaled, uint8_t scale) {
+    return (double)scaled / decimalScales[scale];
+}
+
+bool Decimal_Fits(double value, uint8_t scale) {
+    const double scaled = value * decimalScales[scale];
+    // also false for NaN and infinity
+    if (!(fabs(scaled) < DECIMAL_MAX_SCALED_VALUE)) {
+        return false;
+    }
+    union64bits val, restored;
+    val.d = value;
+    restored.d = fromScaled(llrint(scaled), scale);
+    return val.u == restored.u; // -0.0 doesn't fit, it is restored as 0.0
+}
+
+int Decimal_ScaleOf(double value) {
+    for (int scale = 0; scale <= DECIMAL_MAX_SCALE; ++scale) {
+        if (Decimal_Fits(value, scale)) {
+            return scale;
+        }
+    }
+    return -1;
+}
+
+static inline uint64_t zigzagEncode(int64_t x) {
+    return ((uint64_t)x << 1) ^ (uint64_t)(x >> 63);
+}
+
+static inline int64_t zigzagDecode(uint64_t x) {
+    return (int64_t)(x >> 1) ^ -(int64_t)(x & 1);
+}
+
+static ChunkResult appendChimp(CompressedChunk *chunk, double value) {
+    union64bits val;
+    val.d = value;
+    const uint64_t xorWithPrevious = val.u ^ chunk->prevValue.u;
+
+    binary_t *bins = chunk->data;
+    globalbit_t *bit = &chunk->idx;
+
+    if (xorWithPrevious == 0) {
+        CHECKSPACE(chunk, CHIMP_FLAG);
+        appendBits(bins, bit, CHIMP_SAME, CHIMP_FLAG);
+        return CR_OK;
+    }
+
+    const uint8_t leadingIndex = chimpLeadingIndex[LeadingZeros64(xorWithPrevious)];
+    const uint8_t leading = chimpLeading[leadingIndex];
+    const uint8_t trailing = TrailingZeros64(xorWithPrevious);
+    if (trailing > CHIMP_TRAILING_THRESHOLD) {
+        const uint8_t significant = BINW - leading - trailing;
+        CHECKSPACE(chunk, CHIMP_FLAG + CHIMP_LEADING + CHIMP_SIGNIFICANT + significant);
+        appendBits(bins, bit, CHIMP_TRAILING, CHIMP_FLAG);
+        appendBits(bins, bit, leadingIndex, CHIMP_LEADING);
+        appendBits(bins, bit, significant, CHIMP_SIGNIFICANT);
+        appendBits(bins, bit, xorWithPrevious >> trailing, significant);
+        chunk->prevLeading = CHIMP_NO_LEADING;
+    } else if (leading == chunk->prevLeading) {
+        CHECKSPACE(chunk, CHIMP_FLAG + BINW - leading);
+        appendBits(bins, bit, CHIMP_PREV_LEADING, CHIMP_FLAG);
+        appendBits(bins, bit, xorWithPrevious, BINW - leading);
+    } else {
+        CHECKSPACE(chunk, CHIMP_FLAG + CHIMP_LEADING + BINW - leading);
+        appendBits(bins, bit, CHIMP_NEW_LEADING, CHIMP_FLAG);
+        appendBits(bins, bit, leadingIndex, CHIMP_LEADING);
+        appendBits(bins, bit, xorWithPrevious, BINW - leading);
+        chunk->prevLeading = leading;
+    }
+    chunk->prevValue.d = value;
+    return CR_OK;
+}
+
+// The value must fit the decimal scale of the chunk
+static ChunkResult appendDecimal(CompressedChunk *chunk, double value) {
+    const int64_t scaled = Decimal_ToScaled(value, chunk->decimalScale);
+    const int64_t delta = scaled - chunk->prevScaledValue;
+    const uint64_t doubleDelta = zigzagEncode(delta - chunk->prevScaledDelta);
+
+    binary_t *bins = chunk->data;
+    globalbit_t *bit = &chunk->idx;
+
+    // CHECKSPACE already checked for 1 extra bit availability in appendInteger.
+    if (doubleDelta == 0) {
+        appendBits(bins, bit, 0x00, 1);
+    } else if (doubleDelta < BIT(DECIMAL_L1)) {
+        CHECKSPACE(chunk, 2 + DECIMAL_L1);
+        appendBits(bins, bit, 0x01, 2);
+        appendBits(bins, bit, doubleDelta, DECIMAL_L1);
+    } else if (doubleDelta < BIT(DECIMAL_L2)) {
+        CHECKSPACE(chunk, 3 + DECIMAL_L2);
+        appendBits(bins, bit, 0x03, 3);
+        appendBits(bins, bit, doubleDelta, DECIMAL_L2);
+    } else if (doubleDelta < BIT(DECIMAL_L3)) {
+        CHECKSPACE(chunk, 4 + DECIMAL_L3);
+        appendBits(bins, bit, 0x07, 4);
+        appendBits(bins, bit, doubleDelta, DECIMAL_L3);
+    } else if (doubleDelta < BIT(DECIMAL_L4)) {
+        CHECKSPACE(chunk, 5 + DECIMAL_L4);
+        appendBits(bins, bit, 0x0f, 5);
+        appendBits(bins, bit, doubleDelta, DECIMAL_L4);
+    } else if (doubleDelta < BIT(DECIMAL_L5)) {
+        CHECKSPACE(chunk, 6 + DECIMAL_L5);
+        appendBits(bins, bit, 0x1f, 6);
+        appendBits(bins, bit, doubleDelta, DECIMAL_L5);
+    } else {
+        CHECKSPACE(chunk, 6 + 64);
+        appendBits(bins, bit, 0x3f, 6);
+        appendBits(bins, bit, doubleDelta, 64);
+    }
+    chunk->prevScaledDelta = delta;
+    chunk->prevScaledValue = scaled;
+    chunk->prevValue.d = value;
+    return CR_OK;
+}
+
 static void zero_bits(uint64_t *data, size_t data_size, globalbit_t start, globalbit_t end) {
 #ifdef DEBUG
     assert(start <= end);
@@ -414,15 +653,34 @@ ChunkResult Compressed_Append(CompressedChunk *chunk, timestamp_t timestamp, dou
     assert(chunk);
 #endif
 
+    const bool decimal = chunk->valueEncoding == VALUE_ENCODING_DECIMAL;
+    const bool interval = onInterval(chunk, timestamp);
     if (chunk->count == 0) {
         chunk->baseValue.d = chunk->prevValue.d = value;
         chunk->baseTimestamp = chunk->prevTimestamp = timestamp;
         chunk->prevTimestampDelta = 0;
+        chunk->prevScaledValue = decimal ? Decimal_ToScaled(value, chunk->decimalScale) : 0;
+        chunk->prevScaledDelta = 0;
     } else {
         uint64_t idx = chunk->idx;
         uint64_t prevTimestamp = chunk->prevTimestamp;
         int64_t prevTimestampDelta = chunk->prevTimestampDelta;
-        if (appendInteger(chunk, timestamp) != CR_OK || appendFloat(chunk, value) != CR_OK) {
+        ChunkResult res = interval ? appendIntervalTimestamp(chunk, timestamp)
+                                   : appendInteger(chunk, timestamp);
+        if (res == CR_OK) {
+            switch (chunk->valueEncoding) {
+                case VALUE_ENCODING_DECIMAL:
+                    res = appendDecimal(chunk, value);
+                    break;
+                case VALUE_ENCODING_CHIMP:
+                    res = appendChimp(chunk, value);
+                    break;
+                default:
+                    res = appendFloat(chunk, value);
+                    break;
+            }
+        }
+        if (res != CR_OK) {
             zero_bits(chunk->data, chunk->size, idx, chunk->idx);
             chunk->idx = idx;
             chunk->prevTimestamp = prevTimestamp;
@@ -431,6 +689,7 @@ ChunkResult Compressed_Append(CompressedChunk *chunk, timestamp_t timestamp, dou
         }
     }
     chunk->count++;
+    chunk->intervalCount += interval;
     return CR_OK;
 }
 
@@ -511,6 +770,73 @@ static inline double readFloat(Compressed_Iterator *iter, const uint64_t *data)
     return iter->prevValue.d = rv.d;
 }
 
+/*
+ * This function decodes values inserted by appendDecimal.
+ *
+ * The control bits are read like in readInteger, the double delta is then zigzag decoded and
+ * the scaled value is divided by the scale of the chunk.
+ */
+static inline double readDecimal(Compressed_Iterator *iter, const uint64_t *bins) {
+    uint64_t doubleDelta = 0;
+    if (Bins_bitoff(bins, iter->idx++)) {
+        // the delta hasn't changed
+    } else if (Bins_bitoff(bins, iter->idx++)) {
+        doubleDelta = readBits(bins, iter->idx, DECIMAL_L1);
+        iter->idx += DECIMAL_L1;
+    } else if (Bins_bitoff(bins, iter->idx++)) {
+        doubleDelta = readBits(bins, iter->idx, DECIMAL_L2);
+        iter->idx += DECIMAL_L2;
+    } else if (Bins_bitoff(bins, iter->idx++)) {
+        doubleDelta = readBits(bins, iter->idx, DECIMAL_L3);
+        iter->idx += DECIMAL_L3;
+    } else if (Bins_bitoff(bins, iter->idx++)) {
+        doubleDelta = readBits(bins, iter->idx, DECIMAL_L4);
+        iter->idx += DECIMAL_L4;
+    } else if (Bins_bitoff(bins, iter->idx++)) {
+        doubleDelta = readBits(bins, iter->idx, DECIMAL_L5);
+        iter->idx += DECIMAL_L5;
+    } else {
+        doubleDelta = readBits(bins, iter->idx, 64);
+        iter->idx += 64;
+    }
+    iter->prevScaledDelta += zigzagDecode(doubleDelta);
+    iter->prevScaledValue += iter->prevScaledDelta;
+    return iter->prevValue.d = fromScaled(iter->prevScaledValue, iter->chunk->decimalScale);
+}
+
+/*
+ * This function decodes values inserted by appendChimp.
+ * The iterator `leading` holds the previous number of leading zeros.
+ */
+static inline double readChimp(Compressed_Iterator *iter, const uint64_t *bins) {
+    const uint8_t flag = readBits(bins, iter->idx, CHIMP_FLAG);
+    iter->idx += CHIMP_FLAG;
+    binary_t xorValue;
+    switch (flag) {
+        case CHIMP_SAME:
+            return iter->prevValue.d;
+        case CHIMP_TRAILING: {
+            const uint8_t leading = chimpLeading[readBits(bins, iter->idx, CHIMP_LEADING)];
+            iter->idx += CHIMP_LEADING;
+            const uint8_t significant = readBits(bins, iter->idx, CHIMP_SIGNIFICANT);
+            iter->idx += CHIMP_SIGNIFICANT;
+            xorValue = readBits(bins, iter->idx, significant) << (BINW - leading - significant);
+            iter->idx += significant;
+            break;
+        }
+        case CHIMP_NEW_LEADING:
+            iter->leading = chimpLeading[readBits(bins, iter->idx, CHIMP_LEADING)];
+            iter->idx += CHIMP_LEADING;
+            // fall through
+        default:
+            xorValue = readBits(bins, iter->idx, BINW - iter->leading);
+            iter->idx += BINW - iter->leading;
+            break;
+    }
+    iter->prevValue.u ^= xorValue;
+    return iter->prevValue.d;
+}
+
 ChunkResult Compressed_ChunkIteratorGetNext(ChunkIter_t *abstractIter, Sample *sample) {
     Compressed_Iterator *iter = (Compressed_Iterator *)abstractIter;
 #ifdef DEBUG
@@ -527,16 +853,352 @@ ChunkResult Compressed_ChunkIteratorGetNext(ChunkIter_t *abstractIter, Sample *s
         return CR_OK;
     }
     const uint64_t *bins = iter->chunk->data;
-    // We're fast checking the control bits for the cases in which the delta is 0
-    // This avoids the call to expensive readInteger and readFloat functions
-    //
-    // control bit ‘0’
-    // Read stored double delta value
-    sample->timestamp = iter->prevTS +=
-        Bins_bitoff(bins, iter->idx++) ? iter->prevDelta : readInteger(iter, bins);
-    // Check if value was changed
-    // control bit ‘0’ (case a)
-    sample->value = Bins_bitoff(bins, iter->idx++) ? iter->prevValue.d : readFloat(iter, bins);
+    if (iter->count < iter->chunk->intervalCount) {
+        // on the interval, only the value is encoded
+        iter->prevDelta = iter->chunk->interval;
+        sample->timestamp = iter->prevTS += iter->prevDelta;
+    } else {
+        // We're fast checking the control bits for the cases in which the delta is 0
+        // This avoids the call to expensive readInteger and readFloat functions
+        //
+        // control bit ‘0’
+        // Read stored double delta value
+        sample->timestamp = iter->prevTS +=
+            Bins_bitoff(bins, iter->idx++) ? iter->prevDelta : readInteger(iter, bins);
+    }
+    if (iter->chunk->valueEncoding == VALUE_ENCODING_DECIMAL) {
+        sample->value = readDecimal(iter, bins);
+    } else if (iter->chunk->valueEncoding == VALUE_ENCODING_CHIMP) {
+        sample->value = readChimp(iter, bins);
+    } else {
+        // Check if value was changed
+        // control bit ‘0’ (case a)
+        sample->value = Bins_bitoff(bins, iter->idx++) ? iter->prevValue.d : readFloat(iter, bins);
+    }
     iter->count++;
     return CR_OK;
 }
+
+// The double delta bucket lengths, one byte per number of consecutive '1' control bits (0 to 5)
+#define DD_LENGTHS                                                                                 \
+    (((uint64_t)CMPR_L1 << 8) | ((uint64_t)CMPR_L2 << 16) | ((uint64_t)CMPR_L3 << 24) |            \
+     ((uint64_t)CMPR_L4 << 32) | ((uint64_t)CMPR_L5 << 40))
+
+// The decimal double delta bucket lengths, laid out like DD_LENGTHS
+#define DECIMAL_LENGTHS                                                                            \
+    (((uint64_t)DECIMAL_L1 << 8) | ((uint64_t)DECIMAL_L2 << 16) | ((uint64_t)DECIMAL_L3 << 24) |   \
+     ((uint64_t)DECIMAL_L4 << 32) | ((uint64_t)DECIMAL_L5 << 40))
+
+// Reads a bucketed double delta from the bits peeked at `*idx` and advances `*idx`.
+// `*len` is set to the bucket length, 0 for the 64 bits bucket.
+static inline binary_t readBucket(const binary_t *bins,
+                                  binary_t bits,
+                                  globalbit_t *idx,
+                                  uint64_t lengths,
+                                  uint8_t *len) {
+    const unsigned int ones = TrailingZeros64(~bits);
+    if (likely(ones < 6)) {
+        *len = (lengths >> (ones * 8)) & 0xff;
+        *idx += ones + 1 + *len;
+        return (bits >> (ones + 1)) & ((BIT(0) << *len) - 1);
+    }
+    *len = 0;
+    const binary_t doubleDelta = readBits(bins, *idx + 6, 64);
+    *idx += 6 + 64;
+    return doubleDelta;
+}
+
+/*
+ * Decodes up to `n` samples of a decimal chunk, see Compressed_ChunkIteratorGetNextBlock.
+ * Both the timestamp and the value are bucketed double deltas, each one is read from its own
+ * peek so the bucket selection is branch free for all but the 64 bits buckets.
+ */
+static really_inline size_t decimalGetNextBlock(Compressed_Iterator *iter,
+                                                timestamp_t *timestamps,
+                                                double *values,
+                                                size_t n,
+                                                const bool intervalTimestamps) {
+    const CompressedChunk *chunk = iter->chunk;
+    size_t i = 0;
+    // First sample
+    if (unlikely(iter->count == 0)) {
+        timestamps[0] = chunk->baseTimestamp;
+        values[0] = chunk->baseValue.d;
+        i = 1;
+    }
+
+    const binary_t *bins = chunk->data;
+    const uint64_t nbins = chunk->size / sizeof(binary_t);
+    const double scale = decimalScales[chunk->decimalScale];
+    globalbit_t idx = iter->idx;
+    timestamp_t prevTS = iter->prevTS;
+    int64_t prevDelta = iter->prevDelta;
+    int64_t prevScaledValue = iter->prevScaledValue;
+    int64_t prevScaledDelta = iter->prevScaledDelta;
+
+    uint8_t len;
+    for (; i < n; ++i) {
+        if (intervalTimestamps) {
+            prevDelta = chunk->interval;
+        } else {
+            const binary_t doubleDelta =
+                readBucket(bins, peekBits(bins, idx, nbins), &idx, DD_LENGTHS, &len);
+            // sign extend the bucket, the 64 bits bucket doesn't need it and its length is 0
+            const binary_t sign = BIT(0) << len >> 1;
+            prevDelta += (int64_t)(doubleDelta ^ sign) - (int64_t)sign;
+        }
+        prevTS += prevDelta;
+        timestamps[i] = prevTS;
+
+        const binary_t zigzag =
+            readBucket(bins, peekBits(bins, idx, nbins), &idx, DECIMAL_LENGTHS, &len);
+        prevScaledDelta += zigzagDecode(zigzag);
+        prevScaledValue += prevScaledDelta;
+        values[i] = (double)prevScaledValue / scale;
+    }
+
+    iter->idx = idx;
+    iter->prevTS = prevTS;
+    iter->prevDelta = prevDelta;
+    iter->prevScaledValue = prevScaledValue;
+    iter->prevScaledDelta = prevScaledDelta;
+    iter->prevValue.d = values[n - 1];
+    iter->count += n;
+    return n;
+}
+
+/*
+ * Decodes up to `n` samples of a Chimp chunk, see Compressed_ChunkIteratorGetNextBlock.
+ * The Chimp header (flag, leading zeros index and length) is at most 11 bits, it is decoded from
+ * the same peek and the XOR is read from a second one.
+ */
+static really_inline size_t chimpGetNextBlock(Compressed_Iterator *iter,
+                                              timestamp_t *timestamps,
+                                              double *values,
+                                              size_t n,
+                                              const bool intervalTimestamps) {
+    const CompressedChunk *chunk = iter->chunk;
+    size_t i = 0;
+    // First sample
+    if (unlikely(iter->count == 0)) {
+        timestamps[0] = chunk->baseTimestamp;
+        values[0] = chunk->baseValue.d;
+        i = 1;
+    }
+
+    const binary_t *bins = chunk->data;
+    const uint64_t nbins = chunk->size / sizeof(binary_t);
+    globalbit_t idx = iter->idx;
+    timestamp_t prevTS = iter->prevTS;
+    int64_t prevDelta = iter->prevDelta;
+    union64bits prevValue = iter->prevValue;
+    uint64_t leading = iter->leading;
+
+    uint8_t len;
+    for (; i < n; ++i) {
+        if (intervalTimestamps) {
+            prevDelta = chunk->interval;
+        } else {
+            const binary_t doubleDelta =
+                readBucket(bins, peekBits(bins, idx, nbins), &idx, DD_LENGTHS, &len);
+            const binary_t sign = BIT(0) << len >> 1;
+            prevDelta += (int64_t)(doubleDelta ^ sign) - (int64_t)sign;
+        }
+        prevTS += prevDelta;
+        timestamps[i] = prevTS;
+
+        const binary_t bits = peekBits(bins, idx, nbins);
+        const uint64_t flag = LSB(bits, CHIMP_FLAG);
+        if (flag == CHIMP_SAME) {
+            idx += CHIMP_FLAG;
+        } else {
+            uint64_t header = CHIMP_FLAG, length, trailing = 0;
+            if (flag == CHIMP_TRAILING) {
+                const uint64_t blockLeading = chimpLeading[LSB(bits >> CHIMP_FLAG, CHIMP_LEADING)];
+                length = LSB(bits >> (CHIMP_FLAG + CHIMP_LEADING), CHIMP_SIGNIFICANT);
+                trailing = BINW - blockLeading - length;
+                header += CHIMP_LEADING + CHIMP_SIGNIFICANT;
+            } else {
+                if (flag == CHIMP_NEW_LEADING) {
+                    leading = chimpLeading[LSB(bits >> CHIMP_FLAG, CHIMP_LEADING)];
+                    header += CHIMP_LEADING;
+                }
+                length = BINW - leading;
+            }
+            prevValue.u ^= LSB(peekBits64(bins, idx + header, nbins), length) << trailing;
+            idx += header + length;
+        }
+        values[i] = prevValue.d;
+    }
+
+    iter->idx = idx;
+    iter->prevTS = prevTS;
+    iter->prevDelta = prevDelta;
+    iter->prevValue = prevValue;
+    iter->leading = leading;
+    iter->count += n;
+    return n;
+}
+
+/*
+ * Decodes up to `n` samples of a Gorilla chunk, see Compressed_ChunkIteratorGetNextBlock.
+ *
+ * Unlike Compressed_ChunkIteratorGetNext, the decoder state is kept in local variables for the
+ * whole block and is written back to the iterator only once at the end.
+ * The control bits are data dependent and mispredict often on real data, so the per sample work
+ * is (mostly) branch free and keeps the dependency chain on the bit position short:
+ * * A single peek holds the timestamp control bits, its double delta and the value control bits.
+ *   The double delta bucket is selected from the count of '1' control bits, only the rare 64 bits
+ *   bucket takes a branch.
+ * * The XOR block info is always extracted and conditionally selected, the XOR block itself is
+ *   read off the bit position chain and masked to zero when the value is unchanged.
+ */
+static really_inline size_t gorillaGetNextBlock(Compressed_Iterator *iter,
+                                                timestamp_t *timestamps,
+                                                double *values,
+                                                size_t n,
+                                                const bool intervalTimestamps) {
+    const CompressedChunk *chunk = iter->chunk;
+    size_t i = 0;
+    // First sample
+    if (unlikely(iter->count == 0)) {
+        timestamps[0] = chunk->baseTimestamp;
+        values[0] = chunk->baseValue.d;
+        i = 1;
+    }
+
+    const binary_t *bins = chunk->data;
+    const uint64_t nbins = chunk->size / sizeof(binary_t);
+    globalbit_t idx = iter->idx;
+    timestamp_t prevTS = iter->prevTS;
+    int64_t prevDelta = iter->prevDelta;
+    union64bits prevValue = iter->prevValue;
+    uint64_t leading = iter->leading;
+    uint64_t trailing = iter->trailing;
+    uint64_t blocksize = iter->blocksize;
+
+    for (; i < n; ++i) {
+        // timestamp: '0', or up to 5 '1's, a '0' and the bucket, or six '1's and 64 bits
+        binary_t bits = peekBits(bins, idx, nbins);
+        const unsigned int ones = TrailingZeros64(~bits);
+        if (intervalTimestamps) {
+            prevDelta = chunk->interval;
+        } else if (likely(ones < 6)) {
+            // at most 38 bits consumed, at least 19 bits are left for the value control bits
+            const uint8_t len = (DD_LENGTHS >> (ones * 8)) & 0xff;
+            const binary_t sign = BIT(0) << len >> 1;
+            const binary_t doubleDelta = (bits >> (ones + 1)) & ((BIT(0) << len) - 1);
+            prevDelta += (int64_t)(doubleDelta ^ sign) - (int64_t)sign;
+            bits >>= ones + 1 + len;
+            idx += ones + 1 + len;
+        } else {
+            prevDelta += readBits(bins, idx + 6, 64);
+            idx += 6 + 64;
+            bits = peekBits(bins, idx, nbins);
+        }
+        prevTS += prevDelta;
+        timestamps[i] = prevTS;
+
+        // value: '0' same value, '10' reuse the previous block, '11' new block info and block
+        // the selections are done with masks, compilers tend to turn ternaries into branches here
+        const uint64_t changed = bits & 1;
+        const uint64_t newBlock = (bits & 3) == 3;
+        const uint64_t newBlockMask = 0 - newBlock;
+        const uint64_t newLeading = LSB(bits >> 2, DOUBLE_LEADING);
+        const uint64_t newBlocksize =
+            LSB(bits >> (2 + DOUBLE_LEADING), DOUBLE_BLOCK_SIZE) + DOUBLE_BLOCK_ADJUST;
+        leading = (newLeading & newBlockMask) | (leading & ~newBlockMask);
+        blocksize = (newBlocksize & newBlockMask) | (blocksize & ~newBlockMask);
+#ifdef DEBUG
+        assert(!changed || leading + blocksize <= BINW);
+#endif
+        trailing = ((BINW - newLeading - newBlocksize) & newBlockMask) | (trailing & ~newBlockMask);
+        const uint64_t blockOffset = 2 + newBlock * (DOUBLE_LEADING + DOUBLE_BLOCK_SIZE);
+        const binary_t xorValue = LSB(peekBits64(bins, idx + blockOffset, nbins), blocksize)
+                                  << trailing;
+        prevValue.u ^= xorValue & (0 - changed);
+        idx += 1 + changed * (blockOffset + blocksize - 1);
+        values[i] = prevValue.d;
+    }
+
+    iter->idx = idx;
+    iter->prevTS = prevTS;
+    iter->prevDelta = prevDelta;
+    iter->prevValue = prevValue;
+    iter->leading = leading;
+    iter->trailing = trailing;
+    iter->blocksize = blocksize;
+    iter->count += n;
+    return n;
+}
+
+static really_inline size_t getNextBlock(Compressed_Iterator *iter,
+                                         timestamp_t *timestamps,
+                                         double *values,
+                                         size_t n,
+                                         const bool intervalTimestamps) {
+    switch (iter->chunk->valueEncoding) {
+        case VALUE_ENCODING_DECIMAL:
+            return decimalGetNextBlock(iter, timestamps, values, n, intervalTimestamps);
+        case VALUE_ENCODING_CHIMP:
+            return chimpGetNextBlock(iter, timestamps, values, n, intervalTimestamps);
+        default:
+            return gorillaGetNextBlock(iter, timestamps, values, n, intervalTimestamps);
+    }
+}
+
+/*
+ * Decodes up to `n` samples, starting at the iterator position, straight into `timestamps` and
+ * `values`.
+ * The samples on the chunk interval are decoded by a specialization of the decoders which reads
+ * only the values.
+ *
+ * Returns the number of decoded samples.
+ */
+size_t Compressed_ChunkIteratorGetNextBlock(ChunkIter_t *abstractIter,
+                                            timestamp_t *timestamps,
+                                            double *values,
+                                            size_t n) {
+    Compressed_Iterator *iter = (Compressed_Iterator *)abstractIter;
+    const CompressedChunk *chunk = iter->chunk;
+#ifdef DEBUG
+    assert(iter);
+    assert(chunk);
+#endif
+    n = min(n, chunk->count - iter->count);
+    if (unlikely(n == 0)) {
+        return 0;
+    }
+    size_t decoded = 0;
+    if (iter->count < chunk->intervalCount) {
+        decoded = getNextBlock(
+            iter, timestamps, values, min(n, chunk->intervalCount - iter->count), true);
+    }
+    if (decoded < n) {
+        decoded += getNextBlock(iter, timestamps + decoded, values + decoded, n - decoded, false);
+    }
+    return decoded;
+}
+
+/*
+ * Restores the decoder state saved in a checkpoint, `count` is the number of samples which
+ * precede the checkpoint. The block size isn't saved as it's implied by leading and trailing.
+ */
+void Compressed_ChunkIteratorSeek(ChunkIter_t *abstractIter,
+                                  const CompressedCheckpoint *checkpoint,
+                                  uint64_t count) {
+    Compressed_Iterator *iter = (Compressed_Iterator *)abstractIter;
+    iter->idx = checkpoint->idx;
+    iter->count = count;
+    iter->prevTS = checkpoint->prevTS;
+    iter->prevDelta = checkpoint->prevDelta;
+    iter->prevValue = checkpoint->prevValue;
+    iter->leading = checkpoint->leading;
+    iter->trailing = checkpoint->trailing;
+    iter->blocksize = BINW - checkpoint->leading - checkpoint->trailing;
+    if (iter->chunk->valueEncoding == VALUE_ENCODING_DECIMAL) {
+        iter->prevScaledValue =
+            Decimal_ToScaled(checkpoint->prevValue.d, iter->chunk->decimalScale);
+        iter->prevScaledDelta = checkpoint->prevScaledDelta;
+    }
+}
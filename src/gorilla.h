@@ -28,6 +28,42 @@ typedef union
     uint64_t u;
 } union64bits;
 
+// How the values of a compressed chunk are encoded
+typedef enum ValueEncoding
+{
+    VALUE_ENCODING_GORILLA = 0, // XOR of doubles
+    VALUE_ENCODING_DECIMAL,     // delta of deltas of the values scaled to integers
+    // a decimal chunk which values don't fit a decimal scale, encoded like VALUE_ENCODING_GORILLA
+    VALUE_ENCODING_DECIMAL_FALLBACK,
+    VALUE_ENCODING_CHIMP, // XOR of doubles with Chimp's leading zeros and trailing zeros flags
+} ValueEncoding;
+
+// How the timestamps of a compressed chunk are encoded
+typedef enum TimestampEncoding
+{
+    // the timestamps of the samples on a fixed interval take no bits, see `intervalCount`
+    TIMESTAMP_ENCODING_INTERVAL = 0,
+    TIMESTAMP_ENCODING_DELTA, // delta of deltas for all the samples
+} TimestampEncoding;
+
+// A value with up to DECIMAL_MAX_SCALE digits after the decimal point can be scaled to an integer
+#define DECIMAL_MAX_SCALE 15
+
+// Decoder state right after the last sample preceding a checkpoint. Decoding can resume from
+// `idx` with this state instead of starting from the chunk base.
+typedef struct CompressedCheckpoint
+{
+    uint64_t prevTS;
+    int64_t prevDelta;
+    union64bits prevValue;
+    int64_t prevScaledDelta; // decimal encoding only
+    uint32_t idx; // chunks are bounded by CHUNK_SIZE_BYTES_MAX, bit offsets fit in 32 bits
+    uint8_t leading;
+    uint8_t trailing;
+} CompressedCheckpoint;
+
+struct FrozenChunk;
+
 typedef struct CompressedChunk
 {
     uint64_t size;
@@ -42,9 +78,44 @@ typedef struct CompressedChunk
     uint64_t prevTimestamp;
     int64_t prevTimestampDelta;
 
+    // with TIMESTAMP_ENCODING_INTERVAL the timestamps of the first `intervalCount` samples are
+    // `baseTimestamp + i * interval` and only their values are encoded, the following samples are
+    // encoded with delta of deltas. A chunk stays on the interval until an irregular timestamp.
+    uint8_t timestampEncoding;
+    uint64_t interval;
+    uint64_t intervalCount;
+
     union64bits prevValue;
     uint8_t prevLeading;
     uint8_t prevTrailing;
+
+    // with VALUE_ENCODING_DECIMAL the values are stored as integers scaled by 10^decimalScale
+    uint8_t valueEncoding;
+    uint8_t decimalScale;
+    int64_t prevScaledValue;
+    int64_t prevScaledDelta;
+
+    // a checkpoint is taken every `checkpointInterval` samples, 0 means no checkpoints
+    uint32_t checkpointInterval;
+    uint32_t numCheckpoints;
+    CompressedCheckpoint *checkpoints;
+
+    // late samples which are not encoded yet, sorted by timestamp. An out of order sample
+    // overrides the encoded sample with the same timestamp, `numOOOOverrides` counts those.
+    // `numOOOPending` counts the samples which weren't looked up in the encoded samples, they
+    // are counted as new samples until the buffer is merged.
+    uint32_t numOOOSamples;
+    uint32_t numOOOOverrides;
+    uint32_t numOOOPending;
+    Sample *oooSamples;
+
+    // a sealed chunk is closed for appends. Its samples are kept in `frozen` instead of `data` if
+    // the frozen layout isn't larger, the metadata above (count, base and prev) stays valid.
+    bool sealed;
+    struct FrozenChunk *frozen;
+
+    // covers the encoded and the out of order samples
+    ChunkSummary summary;
 } CompressedChunk;
 
 typedef struct Compressed_Iterator
@@ -62,9 +133,27 @@ typedef struct Compressed_Iterator
     uint8_t leading;
     uint8_t trailing;
     uint8_t blocksize;
+
+    // decimal value vars
+    int64_t prevScaledValue;
+    int64_t prevScaledDelta;
 } Compressed_Iterator;
 
+// Returns the smallest decimal scale `value` fits in, or -1 if there is none
+int Decimal_ScaleOf(double value);
+bool Decimal_Fits(double value, uint8_t scale);
+int64_t Decimal_ToScaled(double value, uint8_t scale);
+// Returns 10^scale, a scaled value is restored by dividing it by this factor
+double Decimal_ScaleFactor(uint8_t scale);
+
 ChunkResult Compressed_Append(CompressedChunk *chunk, uint64_t timestamp, double value);
 ChunkResult Compressed_ChunkIteratorGetNext(ChunkIter_t *iter, Sample *sample);
+size_t Compressed_ChunkIteratorGetNextBlock(ChunkIter_t *iter,
+                                            timestamp_t *timestamps,
+                                            double *values,
+                                            size_t n);
+void Compressed_ChunkIteratorSeek(ChunkIter_t *iter,
+                                  const CompressedCheckpoint *checkpoint,
+                                  uint64_t count);
 
 #endif
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "ingest_batch.h"
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <rmutil/alloc.h>
+
+// A batch which grew to this many samples is flushed by the command which adds the next one
+#define INGEST_BATCH_MAX_SAMPLES 4096
+
+typedef struct PendingSample
+{
+    int db;
+    RedisModuleString *keyName;
+    RedisModuleString *timestampStr;
+    RedisModuleString *valueStr;
+} PendingSample;
+
+typedef struct PendingEvent
+{
+    int db;
+    int type;
+    const char *event;
+    RedisModuleString *keyName;
+    size_t pos; // keeps the order in which the keys were notified
+} PendingEvent;
+
+// The strings of the batch are retained until it's flushed. The arrays keep their capacity, so
+// the batches of a steady load don't allocate.
+static struct
+{
+    bool hooked; // the end of the event loop iteration flushes the batch
+    PendingSample *samples;
+    size_t samplesCount;
+    size_t samplesCapacity;
+    PendingEvent *events;
+    size_t eventsCount;
+    size_t eventsCapacity;
+    RedisModuleString **replArgv;
+    size_t replArgvCapacity;
+} batch = { 0 };
+
+IngestBatchStats ingestBatchStats = { 0 };
+
+// Commands which run while loading aren't propagated, and there's no event loop iteration which
+// would flush their batch. The commands of a transaction or a script are propagated together when
+// it ends, and a replica gets its commands from its master, so these aren't batched either.
+static inline bool batchingActive(RedisModuleCtx *ctx) {
+    return TSGlobalConfig.ingestBatching && batch.hooked &&
+           !(RedisModule_GetContextFlags(ctx) &
+             (REDISMODULE_CTX_FLAGS_LOADING | REDISMODULE_CTX_FLAGS_MULTI |
+              REDISMODULE_CTX_FLAGS_LUA | REDISMODULE_CTX_FLAGS_REPLICATED));
+}
+
+bool IngestBatch_AddSample(RedisModuleCtx *ctx,
+                           RedisModuleString *keyName,
+                           RedisModuleString *timestampStr,
+                           RedisModuleString *valueStr) {
+    if (!batchingActive(ctx)) {
+        return false;
+    }
+    if (batch.samplesCount == INGEST_BATCH_MAX_SAMPLES) {
+        IngestBatch_Flush(ctx);
+    }
+    if (batch.samplesCount == batch.samplesCapacity) {
+        batch.samplesCapacity = batch.samplesCapacity ? batch.samplesCapacity * 2 : 64;
+        batch.samples = realloc(batch.samples, batch.samplesCapacity * sizeof(*batch.samples));
+    }
+    RedisModule_RetainString(NULL, keyName);
+    RedisModule_RetainString(NULL, timestampStr);
+    RedisModule_RetainString(NULL, valueStr);
+    batch.samples[batch.samplesCount++] = (PendingSample){
+        .db = RedisModule_GetSelectedDb(ctx),
+        .keyName = keyName,
+        .timestampStr = timestampStr,
+        .valueStr = valueStr,
+    };
+    return true;
+}
+
+void IngestBatch_NotifyKeyspaceEvent(RedisModuleCtx *ctx,
+                                     int type,
+                                     const char *event,
+                                     RedisModuleString *keyName) {
+    if (!batchingActive(ctx)) {
+        RedisModule_NotifyKeyspaceEvent(ctx, type, event, keyName);
+        return;
+    }
+    if (batch.eventsCount == batch.eventsCapacity) {
+        batch.eventsCapacity = batch.eventsCapacity ? batch.eventsCapacity * 2 : 64;
+        batch.events = realloc(batch.events, batch.eventsCapacity * sizeof(*batch.events));
+    }
+    RedisModule_RetainString(NULL, keyName);
+    batch.events[batch.eventsCount] = (PendingEvent){
+        .db = RedisModule_GetSelectedDb(ctx),
+        .type = type,
+        .event = event,
+        .keyName = keyName,
+        .pos = batch.eventsCount,
+    };
+    batch.eventsCount++;
+}
+
+static int cmpPendingEventKey(const PendingEvent *ea, const PendingEvent *eb) {
+    if (ea->db != eb->db) {
+        return ea->db < eb->db ? -1 : 1;
+    }
+    const int cmp = strcmp(ea->event, eb->event);
+    return cmp != 0 ? cmp : RedisModule_StringCompare(ea->keyName, eb->keyName);
+}
+
+static int cmpPendingEvent(const void *a, const void *b) {
+    const PendingEvent *ea = a, *eb = b;
+    const int cmp = cmpPendingEventKey(ea, eb);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return ea->pos < eb->pos ? -1 : (ea->pos > eb->pos);
+}
+
+static int cmpPendingEventPos(const void *a, const void *b) {
+    const PendingEvent *ea = a, *eb = b;
+    return ea->pos < eb->pos ? -1 : (ea->pos > eb->pos);
+}
+
+// Replicates the samples as a TS.MADD per run of samples in the same database
+static void flushSamples(RedisModuleCtx *ctx) {
+    if (batch.samplesCount == 0) {
+        return;
+    }
+    if (batch.replArgvCapacity < batch.samplesCount * 3) {
+        batch.replArgvCapacity = batch.samplesCapacity * 3;
+        batch.replArgv =
+            realloc(batch.replArgv, batch.replArgvCapacity * sizeof(*batch.replArgv));
+    }
+    size_t i = 0;
+    while (i < batch.samplesCount) {
+        const int db = batch.samples[i].db;
+        size_t replArgc = 0;
+        for (; i < batch.samplesCount && batch.samples[i].db == db; ++i) {
+            batch.replArgv[replArgc++] = batch.samples[i].keyName;
+            batch.replArgv[replArgc++] = batch.samples[i].timestampStr;
+            batch.replArgv[replArgc++] = batch.samples[i].valueStr;
+        }
+        RedisModule_SelectDb(ctx, db);
+        RedisModule_Replicate(ctx, "TS.MADD", "v", batch.replArgv, replArgc);
+    }
+
+    for (i = 0; i < batch.samplesCount; ++i) {
+        RedisModule_FreeString(NULL, batch.samples[i].keyName);
+        RedisModule_FreeString(NULL, batch.samples[i].timestampStr);
+        RedisModule_FreeString(NULL, batch.samples[i].valueStr);
+    }
+    ingestBatchStats.samples += batch.samplesCount;
+    ingestBatchStats.flushes++;
+    batch.samplesCount = 0;
+}
+
+// Notifies every event of a key once, in the order the keys were first notified
+static void flushEvents(RedisModuleCtx *ctx) {
+    if (batch.eventsCount == 0) {
+        return;
+    }
+    qsort(batch.events, batch.eventsCount, sizeof(*batch.events), cmpPendingEvent);
+    size_t n_unique = 0;
+    for (size_t i = 0; i < batch.eventsCount; ++i) {
+        const PendingEvent *e = &batch.events[i];
+        if (n_unique > 0 && cmpPendingEventKey(&batch.events[n_unique - 1], e) == 0) {
+            // the same event of the key, notified later
+            RedisModule_FreeString(NULL, e->keyName);
+            continue;
+        }
+        batch.events[n_unique++] = *e;
+    }
+    qsort(batch.events, n_unique, sizeof(*batch.events), cmpPendingEventPos);
+
+    for (size_t i = 0; i < n_unique; ++i) {
+        const PendingEvent *e = &batch.events[i];
+        RedisModule_SelectDb(ctx, e->db);
+        RedisModule_NotifyKeyspaceEvent(ctx, e->type, e->event, e->keyName);
+        RedisModule_FreeString(NULL, e->keyName);
+    }
+    batch.eventsCount = 0;
+}
+
+void IngestBatch_Flush(RedisModuleCtx *ctx) {
+    if (batch.samplesCount == 0 && batch.eventsCount == 0) {
+        return;
+    }
+    const int db = RedisModule_GetSelectedDb(ctx);
+    flushSamples(ctx);
+    flushEvents(ctx);
+    RedisModule_SelectDb(ctx, db);
+}
+
+static void eventLoopCallback(RedisModuleCtx *ctx,
+                              RedisModuleEvent eid,
+                              uint64_t subevent,
+                              void *data) {
+    if (subevent == REDISMODULE_SUBEVENT_EVENTLOOP_BEFORE_SLEEP) {
+        IngestBatch_Flush(ctx);
+    }
+}
+
+void IngestBatch_Init(RedisModuleCtx *ctx) {
+    batch.hooked = RedisModule_SubscribeToServerEvent(
+                       ctx, RedisModuleEvent_EventLoop, eventLoopCallback) == REDISMODULE_OK;
+    if (!batch.hooked) {
+        RedisModule_Log(
+            ctx, "notice", "ts-ingest-batching isn't supported by this version of redis");
+    }
+}
+
+void IngestBatch_Free(void) {
+    for (size_t i = 0; i < batch.samplesCount; ++i) {
+        RedisModule_FreeString(NULL, batch.samples[i].keyName);
+        RedisModule_FreeString(NULL, batch.samples[i].timestampStr);
+        RedisModule_FreeString(NULL, batch.samples[i].valueStr);
+    }
+    for (size_t i = 0; i < batch.eventsCount; ++i) {
+        RedisModule_FreeString(NULL, batch.events[i].keyName);
+    }
+    free(batch.samples);
+    free(batch.events);
+    free(batch.replArgv);
+    memset(&batch, 0, sizeof(batch));
+}
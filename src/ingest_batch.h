@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#ifndef INGEST_BATCH_H
+#define INGEST_BATCH_H
+
+#include "RedisModulesSDK/redismodule.h"
+
+#include <stdbool.h>
+
+// When ts-ingest-batching is enabled, the samples of consecutive TS.ADD commands are replicated
+// together as a single TS.MADD, and their keyspace notifications are delivered once per key.
+// The batch is flushed at the end of the event loop iteration, and before anything else is
+// propagated which may depend on it: another write command of the module, a keyspace event of
+// another command, or the fork of a persistence. The commands of a transaction, a script or a
+// master aren't batched.
+void IngestBatch_Init(RedisModuleCtx *ctx);
+void IngestBatch_Free(void);
+
+// Returns false when the sample isn't batched, the caller replicates it
+bool IngestBatch_AddSample(RedisModuleCtx *ctx,
+                           RedisModuleString *keyName,
+                           RedisModuleString *timestampStr,
+                           RedisModuleString *valueStr);
+void IngestBatch_NotifyKeyspaceEvent(RedisModuleCtx *ctx,
+                                     int type,
+                                     const char *event,
+                                     RedisModuleString *keyName);
+void IngestBatch_Flush(RedisModuleCtx *ctx);
+
+typedef struct IngestBatchStats
+{
+    unsigned long long samples; // samples replicated through the batch
+    unsigned long long flushes; // batches which replicated samples
+} IngestBatchStats;
+
+extern IngestBatchStats ingestBatchStats;
+
+#endif
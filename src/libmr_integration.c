@@ -370,7 +370,10 @@ Record *ListWithSeriesLastDatapoint(const Series *series, bool latest, bool resp
         }
     }
 
-    if (SeriesGetNumSamples(series) == 0) {
+    if (series->accumulatorPos != 0) {
+        // the open window isn't written yet
+        return ListWithSample(series->accumulator.timestamp, series->accumulator.value, resp3);
+    } else if (SeriesGetNumSamples(series) == 0) {
         return ListRecord_Create(0);
     } else {
         return ListWithSample(series->lastTimestamp, series->lastValue, resp3);
@@ -922,6 +925,10 @@ Record *SeriesRecord_New(Series *series,
     out->keyName = RedisModule_CreateStringFromString(NULL, series->keyName);
     if (series->options & SERIES_OPT_UNCOMPRESSED) {
         out->chunkType = CHUNK_REGULAR;
+    } else if (series->options & SERIES_OPT_COMPRESSED_DECIMAL) {
+        out->chunkType = CHUNK_DECIMAL;
+    } else if (series->options & SERIES_OPT_COMPRESSED_CHIMP) {
+        out->chunkType = CHUNK_CHIMP;
     } else {
         out->chunkType = CHUNK_COMPRESSED;
     }
@@ -934,8 +941,8 @@ Record *SeriesRecord_New(Series *series,
     }
 
     // clone chunks
-    out->chunks = calloc(RedisModule_DictSize(series->chunks) + 1,
-                         sizeof(Chunk_t *)); // + 1 in case of latest flag
+    out->chunks = calloc(RedisModule_DictSize(series->chunks) + 2,
+                         sizeof(Chunk_t *)); // + 2 in case of an open window and latest flag
     RedisModuleDictIter *iter = RedisModule_DictIteratorStartC(series->chunks, "^", NULL, 0);
     Chunk_t *chunk = NULL;
     int index = 0;
@@ -957,6 +964,21 @@ Record *SeriesRecord_New(Series *series,
         }
     }
 
+    // the open ACCUMULATE window isn't written, it's read as the last sample
+    Sample window = series->accumulator;
+    if (series->accumulatorPos != 0 && window.timestamp >= startTimestamp &&
+        window.timestamp <= endTimestamp) {
+        if (index > 0 && out->funcs->GetLastTimestamp(out->chunks[index - 1]) == window.timestamp) {
+            UpsertCtx uCtx = { .inChunk = out->chunks[index - 1], .sample = window };
+            int size = 0;
+            out->funcs->UpsertSample(&uCtx, &size, DP_LAST);
+        } else {
+            out->chunks[index] = out->funcs->NewChunk(128);
+            out->funcs->AddSample(out->chunks[index], &window);
+            index++;
+        }
+    }
+
     if (should_finalize_last_bucket(predicates, series)) {
         Sample sample;
         Sample *sample_ptr = &sample;
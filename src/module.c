@@ -14,7 +14,11 @@
 #include "compaction.h"
 #include "common.h"
 #include "config.h"
+#include "endianconv.h"
+#include "filters/filter_ts.h"
+#include "filters/filter_value.h"
 #include "indexer.h"
+#include "ingest_batch.h"
 #include "libmr_commands.h"
 #include "libmr_integration.h"
 #include "query_language.h"
@@ -23,6 +27,7 @@
 #include "resultset.h"
 #include "short_read.h"
 #include "tsdb.h"
+#include "utils/scratch.h"
 #include "version.h"
 
 #include "fast_double_parser_c/fast_double_parser_c.h"
@@ -114,6 +119,24 @@ RedisModuleType *SeriesType;
 RedisModuleCtx *rts_staticCtx; // global redis ctx
 bool isTrimming = false;
 
+// Temporary buffers of the write commands, which run on the main thread
+static ScratchArena writeScratch = { 0 };
+
+// The heap allocations of the write commands against the samples they got, reported by INFO
+static struct
+{
+    unsigned long long samples;
+    unsigned long long strings; // strings created to replicate the samples
+} ingestStats = { 0 };
+
+// The buckets invalidated by a write command are recomputed when it ends, unless
+// ts-compaction-recompute-interval defers them
+static inline void recomputeCompactionsOnCommandEnd(void) {
+    if (TSGlobalConfig.compactionRecomputeInterval == 0) {
+        RecomputeDirtyCompactions();
+    }
+}
+
 int TSDB_info(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RedisModule_AutoMemory(ctx);
 
@@ -133,9 +156,9 @@ int TSDB_info(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
     int is_debug = RMUtil_ArgExists("DEBUG", argv, argc, 1);
     if (is_debug) {
-        RedisModule_ReplyWithMapOrArray(ctx, 16 * 2, true);
+        RedisModule_ReplyWithMapOrArray(ctx, 18 * 2, true);
     } else {
-        RedisModule_ReplyWithMapOrArray(ctx, 14 * 2, true);
+        RedisModule_ReplyWithMapOrArray(ctx, 16 * 2, true);
     }
 
     long long skippedSamples;
@@ -199,6 +222,11 @@ int TSDB_info(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     RedisModule_ReplyWithLongLong(ctx, series->ignoreMaxTimeDiff);
     RedisModule_ReplyWithSimpleString(ctx, "ignoreMaxValDiff");
     RedisModule_ReplyWithDouble(ctx, series->ignoreMaxValDiff);
+    // appended after the fields which existing clients read by position
+    RedisModule_ReplyWithSimpleString(ctx, "checkpointsMemoryUsage");
+    RedisModule_ReplyWithLongLong(ctx, SeriesCheckpointsSize(series));
+    RedisModule_ReplyWithSimpleString(ctx, "accumulateWindow");
+    RedisModule_ReplyWithLongLong(ctx, series->accumulateWindow);
 
     if (is_debug) {
         RedisModuleDictIter *iter = RedisModule_DictIteratorStartC(series->chunks, ">", "", 0);
@@ -569,6 +597,7 @@ int TSDB_generic_range(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
     }
 
     ReplySeriesRange(ctx, series, &rangeArgs, rev);
+    RangeArgs_Free(&rangeArgs);
 
 _out:
     RedisModule_CloseKey(key);
@@ -590,6 +619,24 @@ static int internalAdd(RedisModuleCtx *ctx,
                        DuplicatePolicy dp_override,
                        bool should_reply);
 
+// The outcome of adding a sample, replied by the caller
+typedef struct AddResult
+{
+    const char *error;         // set when the sample was rejected
+    api_timestamp_t timestamp; // replied when there is no error
+    bool added;                // false when the sample was rejected or ignored
+} AddResult;
+
+#define AddResult_Error(msg) ((AddResult){ .error = RTS_ERR " " msg })
+
+static void replyAddResult(RedisModuleCtx *ctx, const AddResult *result) {
+    if (result->error) {
+        RedisModule_ReplyWithError(ctx, result->error);
+    } else {
+        RedisModule_ReplyWithLongLong(ctx, result->timestamp);
+    }
+}
+
 static void handleCompaction(RedisModuleCtx *ctx,
                              Series *series,
                              CompactionRule *rule,
@@ -611,12 +658,10 @@ static void handleCompaction(RedisModuleCtx *ctx,
     }
 
     if (currentTimestampNormalized > rule->startCurrentTimeBucket) {
-        Series *destSeries;
+        // resolved by SeriesResolveRules
         RedisModuleKey *key;
-        const GetSeriesFlags flags = GetSeriesFlags_SilentOperation | GetSeriesFlags_CheckForAcls;
-        const GetSeriesResult status = GetSeries(
-            ctx, rule->destKey, &key, &destSeries, REDISMODULE_READ | REDISMODULE_WRITE, flags);
-        if (status != GetSeriesResult_Success) {
+        Series *destSeries = SeriesOpenRuleDest(ctx, rule, &key);
+        if (destSeries == NULL) {
             // key doesn't exist anymore or some other error occurred,
             // and we don't do anything
             return;
@@ -629,7 +674,7 @@ static void handleCompaction(RedisModuleCtx *ctx,
         double aggVal;
         if (rule->aggClass->finalize(rule->aggContext, &aggVal) == TSDB_OK) {
             internalAdd(ctx, destSeries, rule->startCurrentTimeBucket, aggVal, DP_LAST, false);
-            RedisModule_NotifyKeyspaceEvent(
+            IngestBatch_NotifyKeyspaceEvent(
                 ctx, REDISMODULE_NOTIFY_MODULE, "ts.add:dest", rule->destKey);
         }
         Sample last_sample;
@@ -653,28 +698,47 @@ static void handleCompaction(RedisModuleCtx *ctx,
     rule->aggClass->appendValue(rule->aggContext, value, timestamp);
 }
 
+// Advances the compaction rules of a series over appended samples, each rule goes over all of them
+// before the next one
+void HandleCompactions(RedisModuleCtx *ctx,
+                       Series *series,
+                       const Sample *samples,
+                       size_t n_samples) {
+    if (!series->rules || n_samples == 0) {
+        return;
+    }
+    // the current buckets must be up to date before the samples close them
+    SeriesRecomputeDirtyRules(series);
+    SeriesResolveRules(ctx, series);
+
+    for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        for (size_t i = 0; i < n_samples; ++i) {
+            handleCompaction(ctx, series, rule, samples[i].timestamp, samples[i].value);
+        }
+    }
+}
+
+// last is NULL when the series is empty
 static inline bool filter_close_samples(DuplicatePolicy dp_policy,
                                         const Series *series,
+                                        const Sample *last,
                                         api_timestamp_t timestamp,
                                         double value) {
-    return dp_policy == DP_LAST && series->totalSamples != 0 &&
-           timestamp >= series->lastTimestamp &&
-           timestamp - series->lastTimestamp <= series->ignoreMaxTimeDiff &&
-           fabs(value - series->lastValue) <= series->ignoreMaxValDiff;
+    return dp_policy == DP_LAST && last != NULL && timestamp >= last->timestamp &&
+           timestamp - last->timestamp <= series->ignoreMaxTimeDiff &&
+           fabs(value - last->value) <= series->ignoreMaxValDiff;
 }
 
-static int internalAdd(RedisModuleCtx *ctx,
-                       Series *series,
-                       api_timestamp_t timestamp,
-                       double value,
-                       DuplicatePolicy dp_override,
-                       bool should_reply) {
+static AddResult seriesAdd(RedisModuleCtx *ctx,
+                           Series *series,
+                           api_timestamp_t timestamp,
+                           double value,
+                           DuplicatePolicy dp_override) {
     const timestamp_t lastTS = series->lastTimestamp;
     const uint64_t retention = series->retentionTime;
     // ensure inside retention period.
     if (retention && timestamp < lastTS && retention < lastTS - timestamp) {
-        RTS_ReplyGeneralError(ctx, "TSDB: Timestamp is older than retention");
-        return REDISMODULE_ERR;
+        return AddResult_Error("TSDB: Timestamp is older than retention");
     }
 
     // Use module level configuration if key level configuration doesn't exist
@@ -683,38 +747,79 @@ static int internalAdd(RedisModuleCtx *ctx,
 
     // Insert filter for close samples. If configured, it's used to ignore last measurement if its
     // value is negligible compared to the last sample.
-    if (filter_close_samples(dp_policy, series, timestamp, value)) {
-        RedisModule_ReplyWithLongLong(ctx, series->lastTimestamp);
-        return REDISMODULE_ERR;
+    const Sample last = { .timestamp = series->lastTimestamp, .value = series->lastValue };
+    if (filter_close_samples(
+            dp_policy, series, series->totalSamples != 0 ? &last : NULL, timestamp, value)) {
+        return (AddResult){ .timestamp = series->lastTimestamp };
     }
 
     if (timestamp <= series->lastTimestamp && series->totalSamples != 0) {
         if (SeriesUpsertSample(series, timestamp, value, dp_policy) != REDISMODULE_OK) {
-            RTS_ReplyGeneralError(ctx,
-                                  "TSDB: Error at upsert, update is not supported when "
-                                  "DUPLICATE_POLICY is set to BLOCK mode");
-            return REDISMODULE_ERR;
+            return AddResult_Error("TSDB: Error at upsert, update is not supported when "
+                                   "DUPLICATE_POLICY is set to BLOCK mode");
         }
     } else {
         if (SeriesAddSample(series, timestamp, value) != REDISMODULE_OK) {
-            RTS_ReplyGeneralError(ctx, "TSDB: Error at add");
-            return REDISMODULE_ERR;
+            return AddResult_Error("TSDB: Error at add");
         }
         // handle compaction rules
-        if (series->rules) {
-            const GetSeriesFlags flags =
-                GetSeriesFlags_SilentOperation | GetSeriesFlags_CheckForAcls;
-            deleteReferenceToDeletedSeries(ctx, series, flags);
-        }
+        const Sample sample = { .timestamp = timestamp, .value = value };
+        HandleCompactions(ctx, series, &sample, 1);
+    }
+    return (AddResult){ .timestamp = timestamp, .added = true };
+}
 
-        for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
-            handleCompaction(ctx, series, rule, timestamp, value);
-        }
+static int internalAdd(RedisModuleCtx *ctx,
+                       Series *series,
+                       api_timestamp_t timestamp,
+                       double value,
+                       DuplicatePolicy dp_override,
+                       bool should_reply) {
+    const AddResult result = seriesAdd(ctx, series, timestamp, value, dp_override);
+    // rejected and ignored samples are always replied
+    if (should_reply || !result.added) {
+        replyAddResult(ctx, &result);
     }
-    if (should_reply) {
-        RedisModule_ReplyWithLongLong(ctx, timestamp);
+    return result.added ? REDISMODULE_OK : REDISMODULE_ERR;
+}
+
+// Adds samples to a series in their order. Samples newer than the last one are gathered into runs,
+// a run is appended to the chunks and to the compaction rules at once.
+static void seriesAddBatch(RedisModuleCtx *ctx,
+                           Series *series,
+                           const Sample *samples,
+                           size_t n_samples,
+                           AddResult *results) {
+    const DuplicatePolicy dp_policy = series->duplicatePolicy ?: TSGlobalConfig.duplicatePolicy;
+    SeriesFlushAccumulator(ctx, series);
+    const size_t mark = Scratch_Begin(&writeScratch);
+    Sample *run = Scratch_Alloc(&writeScratch, n_samples * sizeof(*run));
+    size_t n_run = 0;
+    for (size_t i = 0; i < n_samples; ++i) {
+        const Sample *sample = &samples[i];
+        const Sample seriesLast = { .timestamp = series->lastTimestamp,
+                                    .value = series->lastValue };
+        const Sample *last =
+            n_run > 0 ? &run[n_run - 1] : (series->totalSamples != 0 ? &seriesLast : NULL);
+        if (!last || sample->timestamp > last->timestamp) {
+            if (filter_close_samples(dp_policy, series, last, sample->timestamp, sample->value)) {
+                results[i] = (AddResult){ .timestamp = last->timestamp };
+                continue;
+            }
+            run[n_run++] = *sample;
+            results[i] = (AddResult){ .timestamp = sample->timestamp, .added = true };
+            continue;
+        }
+
+        // an update or a late sample, the compaction rules must be up to date before it
+        SeriesAddSamples(series, run, n_run);
+        HandleCompactions(ctx, series, run, n_run);
+        n_run = 0;
+        results[i] = seriesAdd(ctx, series, sample->timestamp, sample->value, DP_NONE);
     }
-    return REDISMODULE_OK;
+    SeriesAddSamples(series, run, n_run);
+    HandleCompactions(ctx, series, run, n_run);
+    Scratch_End(&writeScratch, mark);
 }
 
 static inline double parse_double(const RedisModuleString *valueStr) {
@@ -725,14 +830,15 @@ static inline double parse_double(const RedisModuleString *valueStr) {
     return endptr && endptr - valueCStr == len ? value : NAN;
 }
 
+// batchable is set when the sample may be replicated within a TS.MADD of the ingest batch: the
+// series existed and the command has no arguments other than the sample
 static inline int add(RedisModuleCtx *ctx,
                       RedisModuleString *keyName,
                       const RedisModuleString *timestampStr,
                       const RedisModuleString *valueStr,
                       RedisModuleString **argv,
-                      int argc) {
-    RedisModuleKey *key = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ | REDISMODULE_WRITE);
-
+                      int argc,
+                      bool *batchable) {
     const double value = parse_double(valueStr);
     if (isnan(value)) {
         RTS_ReplyGeneralError(ctx, "TSDB: invalid value");
@@ -752,17 +858,22 @@ static inline int add(RedisModuleCtx *ctx,
 
     Series *series = NULL;
     DuplicatePolicy dp = DP_NONE;
+    RedisModuleKey *key = RedisModule_OpenKey(ctx, keyName, REDISMODULE_READ | REDISMODULE_WRITE);
 
     if (argv != NULL && RedisModule_KeyType(key) == REDISMODULE_KEYTYPE_EMPTY) {
-        // the key doesn't exist, lets check we have enough information to create one
+        // the key doesn't exist, lets check we have enough information to create one. Creating
+        // the series and its rules isn't the steady state, it releases its objects automatically.
+        RedisModule_AutoMemory(ctx);
         CreateCtx cCtx = { 0 };
         if (parseCreateArgs(ctx, argv, argc, &cCtx) != REDISMODULE_OK) {
+            RedisModule_CloseKey(key);
             return REDISMODULE_ERR;
         }
 
         CreateTsKey(ctx, keyName, &cCtx, &series, &key);
         SeriesCreateRulesFromGlobalConfig(ctx, keyName, series, cCtx.labels, cCtx.labelsCount);
     } else if (RedisModule_ModuleTypeGetType(key) != SeriesType) {
+        RedisModule_CloseKey(key);
         RTS_ReplyGeneralError(ctx, "TSDB: the key is not a TSDB key");
         return REDISMODULE_ERR;
     } else {
@@ -771,47 +882,342 @@ static inline int add(RedisModuleCtx *ctx,
         if (argv != NULL &&
             ParseDuplicatePolicy(ctx, argv, argc, TS_ADD_DUPLICATE_POLICY_ARG, &dp, NULL) !=
                 TSDB_OK) {
+            RedisModule_CloseKey(key);
             return REDISMODULE_ERR;
         }
+        *batchable = argc == 4;
     }
+    SeriesFlushAccumulator(ctx, series);
     const int rv = internalAdd(ctx, series, timestamp, value, dp, true);
     RedisModule_CloseKey(key);
     return rv;
 }
 
-static inline RedisModuleString *getCurrentTime(RedisModuleCtx *ctx) {
-    return RedisModule_CreateStringPrintf(ctx, "%llu", RedisModule_Milliseconds());
+// The current time replaces "*" timestamps. Its string, which replicates them, is kept for the
+// rest of the millisecond, so it's valid until the next call.
+static RedisModuleString *getCurrentTime(void) {
+    static RedisModuleString *currentTimeStr = NULL;
+    static long long currentTime = -1;
+    const long long now = RedisModule_Milliseconds();
+    if (now != currentTime) {
+        if (currentTimeStr) {
+            RedisModule_FreeString(NULL, currentTimeStr);
+        }
+        currentTimeStr = RedisModule_CreateStringFromLongLong(NULL, now);
+        currentTime = now;
+        ingestStats.strings++;
+    }
+    return currentTimeStr;
 }
 
-int TSDB_madd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-    RedisModule_AutoMemory(ctx);
+static bool parseSample(const RedisModuleString *timestampStr,
+                        const RedisModuleString *valueStr,
+                        Sample *sample,
+                        AddResult *result) {
+    sample->value = parse_double(valueStr);
+    if (isnan(sample->value)) {
+        *result = AddResult_Error("TSDB: invalid value");
+        return false;
+    }
+
+    long long timestampValue;
+    if (RedisModule_StringToLongLong(timestampStr, &timestampValue) != REDISMODULE_OK) {
+        *result = AddResult_Error("TSDB: invalid timestamp");
+        return false;
+    }
+    if (timestampValue < 0) {
+        *result = AddResult_Error("TSDB: invalid timestamp, must be a nonnegative integer");
+        return false;
+    }
+    sample->timestamp = (api_timestamp_t)timestampValue;
+    return true;
+}
+
+// A packed payload holds little endian (int64 timestamp, float64 value) pairs
+#define PACKED_SAMPLE_SIZE (sizeof(int64_t) + sizeof(double))
+
+typedef enum PackedFormat
+{
+    PackedFormat_None = 0,
+    PackedFormat_Absolute,
+    // each timestamp but the first is the difference from the previous one
+    PackedFormat_Delta,
+} PackedFormat;
+
+// A packed payload is given in place of a timestamp by the PACKED or PACKED_DELTA token
+static PackedFormat parsePackedFormat(const RedisModuleString *tokenStr) {
+    size_t len;
+    const char *token = RedisModule_StringPtrLen(tokenStr, &len);
+    if (len == strlen(PACKED_ARG_STR) && strncasecmp(token, PACKED_ARG_STR, len) == 0) {
+        return PackedFormat_Absolute;
+    }
+    if (len == strlen(PACKED_DELTA_ARG_STR) && strncasecmp(token, PACKED_DELTA_ARG_STR, len) == 0) {
+        return PackedFormat_Delta;
+    }
+    return PackedFormat_None;
+}
+
+// Returns the number of samples of a payload, 0 if it is malformed
+static size_t packedSamplesCount(const RedisModuleString *payloadStr) {
+    size_t len;
+    RedisModule_StringPtrLen(payloadStr, &len);
+    return len % PACKED_SAMPLE_SIZE == 0 ? len / PACKED_SAMPLE_SIZE : 0;
+}
 
+// Decodes the samples of a packed payload with packedSamplesCount samples
+static bool parsePackedSamples(const RedisModuleString *payloadStr,
+                               PackedFormat format,
+                               Sample *samples,
+                               AddResult *result) {
+    size_t len;
+    const char *payload = RedisModule_StringPtrLen(payloadStr, &len);
+    const size_t n_samples = len / PACKED_SAMPLE_SIZE;
+    if (n_samples == 0 || len % PACKED_SAMPLE_SIZE != 0) {
+        *result = AddResult_Error("TSDB: invalid packed samples");
+        return false;
+    }
+    int64_t timestamp = 0;
+    for (size_t i = 0; i < n_samples; ++i, payload += PACKED_SAMPLE_SIZE) {
+        int64_t ts;
+        memcpy(&ts, payload, sizeof(ts));
+        memrev64ifbe(&ts);
+        memcpy(&samples[i].value, payload + sizeof(ts), sizeof(samples[i].value));
+        memrev64ifbe(&samples[i].value);
+        if (format == PackedFormat_Delta && i > 0) {
+            if (__builtin_add_overflow(timestamp, ts, &ts)) {
+                *result = AddResult_Error("TSDB: invalid timestamp");
+                return false;
+            }
+        }
+        if (ts < 0) {
+            *result = AddResult_Error("TSDB: invalid timestamp, must be a nonnegative integer");
+            return false;
+        }
+        if (isnan(samples[i].value)) {
+            *result = AddResult_Error("TSDB: invalid value");
+            return false;
+        }
+        timestamp = ts;
+        samples[i].timestamp = (timestamp_t)ts;
+    }
+    return true;
+}
+
+// Encodes samples as an absolute packed payload, the caller frees the string
+static RedisModuleString *packSamples(const Sample *samples, size_t n_samples) {
+    const size_t mark = Scratch_Begin(&writeScratch);
+    char *payload = Scratch_Alloc(&writeScratch, n_samples * PACKED_SAMPLE_SIZE);
+    char *offset = payload;
+    for (size_t i = 0; i < n_samples; ++i, offset += PACKED_SAMPLE_SIZE) {
+        int64_t ts = (int64_t)samples[i].timestamp;
+        double value = samples[i].value;
+        memrev64ifbe(&ts);
+        memrev64ifbe(&value);
+        memcpy(offset, &ts, sizeof(ts));
+        memcpy(offset + sizeof(ts), &value, sizeof(value));
+    }
+    RedisModuleString *payloadStr =
+        RedisModule_CreateString(NULL, payload, n_samples * PACKED_SAMPLE_SIZE);
+    Scratch_End(&writeScratch, mark);
+    ingestStats.strings++;
+    return payloadStr;
+}
+
+#define MADD_NO_KEY SIZE_MAX
+
+typedef struct MAddKeyRef
+{
+    RedisModuleString *keyName;
+    size_t triple;
+} MAddKeyRef;
+
+static int cmpMAddKeyRef(const void *a, const void *b) {
+    const MAddKeyRef *x = a, *y = b;
+    const int rv = RedisModule_StringCompare(x->keyName, y->keyName);
+    return rv != 0 ? rv : (x->triple > y->triple) - (x->triple < y->triple);
+}
+
+// Numbers the distinct keys of the triples by their first appearance
+static size_t groupMAddKeys(RedisModuleString **argv,
+                            size_t n_triples,
+                            size_t *keyOfTriple,
+                            RedisModuleString **keyNames) {
+    MAddKeyRef *refs = Scratch_Alloc(&writeScratch, n_triples * sizeof(*refs));
+    size_t *leader = Scratch_Alloc(&writeScratch, n_triples * sizeof(*leader));
+    for (size_t t = 0; t < n_triples; ++t) {
+        refs[t] = (MAddKeyRef){ .keyName = argv[1 + t * 3], .triple = t };
+    }
+    qsort(refs, n_triples, sizeof(*refs), cmpMAddKeyRef);
+    for (size_t i = 0; i < n_triples; ++i) {
+        const bool first = i == 0 || RedisModule_StringCompare(refs[i - 1].keyName,
+                                                                refs[i].keyName) != 0;
+        leader[refs[i].triple] = first ? refs[i].triple : leader[refs[i - 1].triple];
+    }
+    size_t n_keys = 0;
+    for (size_t t = 0; t < n_triples; ++t) {
+        if (leader[t] == t) {
+            keyNames[n_keys] = argv[1 + t * 3];
+            keyOfTriple[t] = n_keys++;
+        } else {
+            keyOfTriple[t] = keyOfTriple[leader[t]];
+        }
+    }
+    return n_keys;
+}
+
+// The string of the PACKED token which replicates packed payloads
+static RedisModuleString *packedTokenStr(void) {
+    static RedisModuleString *packedStr = NULL;
+    if (!packedStr) {
+        packedStr = RedisModule_CreateString(NULL, PACKED_ARG_STR, strlen(PACKED_ARG_STR));
+    }
+    return packedStr;
+}
+
+// The samples are grouped by key, so each key is opened once and its in order samples are appended
+// as runs. The samples of a key keep their order since the outcome of a sample (retention,
+// duplicate policy, ignore filter) depends on the samples before it. A triple whose timestamp is
+// PACKED or PACKED_DELTA carries a packed payload in place of its value, each of its samples gets
+// its own reply.
+// The buffers of the command come from the write scratch arena, so steady ingestion doesn't
+// allocate. Each triple is notified in the order of the arguments, like a TS.ADD would be.
+int TSDB_madd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     if (argc < 4 || (argc - 1) % 3 != 0) {
         return RedisModule_WrongArity(ctx);
     }
 
+    const size_t mark = Scratch_Begin(&writeScratch);
+    // the string is valid until the next command
     RedisModuleString *curTimeStr = NULL;
+    const size_t n_triples = (argc - 1) / 3;
+    // a malformed packed payload gets a single error reply
+    size_t max_samples = 0;
+    for (size_t t = 0; t < n_triples; ++t) {
+        const bool packed = parsePackedFormat(argv[2 + t * 3]) != PackedFormat_None;
+        max_samples += (packed ? packedSamplesCount(argv[3 + t * 3]) : 1) ?: 1;
+    }
+    RedisModuleString **timestampStrs =
+        Scratch_Alloc(&writeScratch, n_triples * sizeof *timestampStrs);
+    size_t *tripleStart = Scratch_Alloc(&writeScratch, (n_triples + 1) * sizeof *tripleStart);
+    Sample *samples = Scratch_Alloc(&writeScratch, max_samples * sizeof *samples);
+    AddResult *results = Scratch_Alloc(&writeScratch, max_samples * sizeof *results);
+    size_t *keyOf = Scratch_Alloc(&writeScratch, max_samples * sizeof *keyOf);
+    size_t *keyOfTriple = Scratch_Alloc(&writeScratch, n_triples * sizeof *keyOfTriple);
+    RedisModuleString **keyNames = Scratch_Alloc(&writeScratch, n_triples * sizeof *keyNames);
+    const size_t n_keys = groupMAddKeys(argv, n_triples, keyOfTriple, keyNames);
+    size_t n_samples = 0;
+    for (size_t t = 0; t < n_triples; ++t) {
+        RedisModuleString *timestampStr = argv[2 + t * 3];
+        const RedisModuleString *valueStr = argv[3 + t * 3];
+        tripleStart[t] = n_samples;
+
+        const PackedFormat format = parsePackedFormat(timestampStr);
+        size_t n_triple_samples = 1;
+        bool parsed;
+        if (format != PackedFormat_None) {
+            parsed =
+                parsePackedSamples(valueStr, format, &samples[n_samples], &results[n_samples]);
+            if (parsed) {
+                n_triple_samples = packedSamplesCount(valueStr);
+            }
+        } else {
+            if (stringEqualsC(timestampStr, "*")) {
+                // if timestamp is "*", take current time (automatic timestamp)
+                if (!curTimeStr) {
+                    curTimeStr = getCurrentTime();
+                }
+                timestampStr = curTimeStr;
+            }
+            parsed = parseSample(timestampStr, valueStr, &samples[n_samples], &results[n_samples]);
+        }
+        timestampStrs[t] = timestampStr;
 
-    RedisModule_ReplyWithArray(ctx, (argc - 1) / 3);
-    const RedisModuleString **replArgv = malloc((argc - 1) * sizeof *replArgv);
-    const RedisModuleString **offset = replArgv;
-    for (int i = 1; i < argc; i += 3) {
-        RedisModuleString *keyName = argv[i];
-        const RedisModuleString *timestampStr = argv[i + 1];
-        const RedisModuleString *valueStr = argv[i + 2];
-
-        if (stringEqualsC(timestampStr, "*")) {
-            // if timestamp is "*", take current time (automatic timestamp)
-            if (!curTimeStr) {
-                curTimeStr = getCurrentTime(ctx);
+        const size_t keyIndex = parsed ? keyOfTriple[t] : MADD_NO_KEY;
+        for (size_t j = 0; j < n_triple_samples; ++j) {
+            keyOf[n_samples++] = keyIndex;
+        }
+    }
+    tripleStart[n_triples] = n_samples;
+    ingestStats.samples += n_samples;
+
+    // order the samples by key, keeping the order of the samples of each key
+    size_t *keyStart = Scratch_Alloc(&writeScratch, (n_keys + 1) * sizeof *keyStart);
+    memset(keyStart, 0, (n_keys + 1) * sizeof(*keyStart));
+    for (size_t i = 0; i < n_samples; ++i) {
+        if (keyOf[i] != MADD_NO_KEY) {
+            keyStart[keyOf[i] + 1]++;
+        }
+    }
+    for (size_t k = 0; k < n_keys; ++k) {
+        keyStart[k + 1] += keyStart[k];
+    }
+    size_t *order = Scratch_Alloc(&writeScratch, n_samples * sizeof *order);
+    size_t *keyEnd = Scratch_Alloc(&writeScratch, (n_keys + 1) * sizeof *keyEnd);
+    memcpy(keyEnd, keyStart, (n_keys + 1) * sizeof *keyEnd);
+    for (size_t i = 0; i < n_samples; ++i) {
+        if (keyOf[i] != MADD_NO_KEY) {
+            order[keyEnd[keyOf[i]]++] = i;
+        }
+    }
+
+    Sample *keySamples = Scratch_Alloc(&writeScratch, n_samples * sizeof *keySamples);
+    AddResult *keyResults = Scratch_Alloc(&writeScratch, n_samples * sizeof *keyResults);
+    for (size_t k = 0; k < n_keys; ++k) {
+        const size_t *keyOrder = &order[keyStart[k]];
+        const size_t n_key_samples = keyStart[k + 1] - keyStart[k];
+        if (n_key_samples == 0) {
+            continue; // none of the samples of the key were parsed
+        }
+        RedisModuleKey *key =
+            RedisModule_OpenKey(ctx, keyNames[k], REDISMODULE_READ | REDISMODULE_WRITE);
+        if (RedisModule_ModuleTypeGetType(key) != SeriesType) {
+            for (size_t j = 0; j < n_key_samples; ++j) {
+                results[keyOrder[j]] = AddResult_Error("TSDB: the key is not a TSDB key");
             }
-            timestampStr = curTimeStr;
+            RedisModule_CloseKey(key);
+            continue;
+        }
+        Series *series = RedisModule_ModuleTypeGetValue(key);
+        for (size_t j = 0; j < n_key_samples; ++j) {
+            keySamples[j] = samples[keyOrder[j]];
         }
+        seriesAddBatch(ctx, series, keySamples, n_key_samples, keyResults);
+        for (size_t j = 0; j < n_key_samples; ++j) {
+            results[keyOrder[j]] = keyResults[j];
+        }
+        RedisModule_CloseKey(key);
+    }
+
+    RedisModule_ReplyWithArray(ctx, n_samples);
+    for (size_t i = 0; i < n_samples; ++i) {
+        replyAddResult(ctx, &results[i]);
+    }
 
-        if (add(ctx, keyName, timestampStr, valueStr, NULL, -1) == REDISMODULE_OK) {
-            *offset++ = keyName;
-            *offset++ = timestampStr;
-            *offset++ = valueStr;
+    RedisModuleString **replArgv = Scratch_Alloc(&writeScratch, (argc - 1) * sizeof *replArgv);
+    RedisModuleString **offset = replArgv;
+    RedisModuleString **packedStrs = Scratch_Alloc(&writeScratch, n_triples * sizeof *packedStrs);
+    size_t n_packed = 0;
+    for (size_t t = 0; t < n_triples; ++t) {
+        if (parsePackedFormat(argv[2 + t * 3]) == PackedFormat_None) {
+            if (results[tripleStart[t]].added) {
+                *offset++ = argv[1 + t * 3];
+                *offset++ = timestampStrs[t];
+                *offset++ = argv[3 + t * 3];
+            }
+            continue;
+        }
+        // the added samples of a packed payload are replicated with absolute timestamps
+        size_t n_added = 0;
+        for (size_t i = tripleStart[t]; i < tripleStart[t + 1]; ++i) {
+            if (results[i].added) {
+                keySamples[n_added++] = samples[i];
+            }
+        }
+        if (n_added > 0) {
+            packedStrs[n_packed] = packSamples(keySamples, n_added);
+            *offset++ = argv[1 + t * 3];
+            *offset++ = packedTokenStr();
+            *offset++ = packedStrs[n_packed++];
         }
     }
     const size_t replArgc = offset - replArgv;
@@ -820,50 +1226,202 @@ int TSDB_madd(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         // we want to replicate only successful sample inserts to avoid errors on the replica, when
         // this errors occurs, redis will CRITICAL error to its log and potentially fill up the disk
         // depending on the actual traffic.
+        IngestBatch_Flush(ctx);
         RedisModule_Replicate(ctx, "TS.MADD", "v", replArgv, replArgc);
     }
-    free(replArgv);
+    for (size_t i = 0; i < n_packed; ++i) {
+        RedisModule_FreeString(NULL, packedStrs[i]);
+    }
 
     for (int i = 1; i < argc; i += 3) {
-        RedisModule_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.add", argv[i]);
+        IngestBatch_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.add", argv[i]);
     }
+    Scratch_End(&writeScratch, mark);
 
+    recomputeCompactionsOnCommandEnd();
     return REDISMODULE_OK;
 }
 
+// Doesn't use automatic memory management, an existing series is added to without allocations
 int TSDB_add(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
-    RedisModule_AutoMemory(ctx);
-
     if (argc < 4) {
         return RedisModule_WrongArity(ctx);
     }
 
     RedisModuleString *keyName = argv[1];
-    const RedisModuleString *timestampStr = argv[2];
+    RedisModuleString *timestampStr = argv[2];
     const RedisModuleString *valueStr = argv[3];
 
     if (stringEqualsC(timestampStr, "*")) {
         // if timestamp is "*", take current time (automatic timestamp)
-        timestampStr = getCurrentTime(ctx);
+        timestampStr = getCurrentTime();
     }
+    ingestStats.samples++;
 
-    const int result = add(ctx, keyName, timestampStr, valueStr, argv, argc);
-    if (result == REDISMODULE_OK) {
-        const size_t replArgc = argc - 1;
-        const RedisModuleString **replArgv = malloc(replArgc * sizeof *replArgv);
-        for (int i = 0; i < replArgc; i++) { // skip the command name
-            replArgv[i] = argv[i + 1];
-        }
-        replArgv[1] = timestampStr; // In case the timestamp was "*"
-        RedisModule_Replicate(ctx, "TS.ADD", "v", replArgv, replArgc);
-        free(replArgv);
+    bool batchable = false;
+    const int result = add(ctx, keyName, timestampStr, valueStr, argv, argc, &batchable);
+    if (result == REDISMODULE_OK &&
+        !(batchable && IngestBatch_AddSample(ctx, keyName, timestampStr, argv[3]))) {
+        IngestBatch_Flush(ctx);
+        // the timestamp replaces "*"
+        RedisModule_Replicate(
+            ctx, "TS.ADD", "ssv", keyName, timestampStr, &argv[3], (size_t)(argc - 3));
     }
 
-    RedisModule_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.add", keyName);
+    IngestBatch_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.add", keyName);
 
+    recomputeCompactionsOnCommandEnd();
     return result;
 }
 
+typedef struct BulkSample
+{
+    Sample sample;
+    size_t pos; // keeps the order of samples with the same timestamp
+} BulkSample;
+
+static int cmpBulkSample(const void *a, const void *b) {
+    const BulkSample *sa = a, *sb = b;
+    if (sa->sample.timestamp != sb->sample.timestamp) {
+        return sa->sample.timestamp < sb->sample.timestamp ? -1 : 1;
+    }
+    return sa->pos < sb->pos ? -1 : (sa->pos > sb->pos);
+}
+
+// Sorts the samples by timestamp, samples with the same timestamp keep their order
+static void sortBulkSamples(Sample *samples, size_t n_samples) {
+    size_t i = 1;
+    while (i < n_samples && samples[i - 1].timestamp <= samples[i].timestamp) {
+        ++i;
+    }
+    if (i >= n_samples) {
+        return;
+    }
+    const size_t mark = Scratch_Begin(&writeScratch);
+    BulkSample *sorted = Scratch_Alloc(&writeScratch, n_samples * sizeof(*sorted));
+    for (size_t j = 0; j < n_samples; ++j) {
+        sorted[j] = (BulkSample){ .sample = samples[j], .pos = j };
+    }
+    qsort(sorted, n_samples, sizeof(*sorted), cmpBulkSample);
+    for (size_t j = 0; j < n_samples; ++j) {
+        samples[j] = sorted[j].sample;
+    }
+    Scratch_End(&writeScratch, mark);
+}
+
+// Resolves the duplicate timestamps of sorted samples in place, returns the number of samples left
+// and counts the samples which were added or updated.
+static size_t dedupBulkSamples(Sample *samples,
+                               size_t n_samples,
+                               DuplicatePolicy dp_policy,
+                               size_t *accepted) {
+    size_t n_out = 0;
+    for (size_t i = 0; i < n_samples; ++i) {
+        Sample sample = samples[i];
+        if (n_out > 0 && samples[n_out - 1].timestamp == sample.timestamp) {
+            if (handleDuplicateSample(dp_policy, samples[n_out - 1], &sample) != CR_OK) {
+                continue;
+            }
+            samples[n_out - 1].value = sample.value;
+        } else {
+            samples[n_out++] = sample;
+        }
+        ++(*accepted);
+    }
+    return n_out;
+}
+
+/*
+TS.ADDBULK key timestamp value [timestamp value ...]
+TS.ADDBULK key PACKED|PACKED_DELTA payload
+
+The samples are sorted by timestamp. Samples newer than the last sample of the series are appended
+at once, the older ones are merged into the chunks they overlap and the affected compaction buckets
+are recalculated once. Replies with the number of samples which were added or updated.
+*/
+int TSDB_addbulk(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
+    if (argc < 4 || (argc - 2) % 2 != 0) {
+        return RedisModule_WrongArity(ctx);
+    }
+
+    Series *series;
+    RedisModuleKey *key;
+    const GetSeriesResult status = GetSeries(ctx,
+                                             argv[1],
+                                             &key,
+                                             &series,
+                                             REDISMODULE_READ | REDISMODULE_WRITE,
+                                             GetSeriesFlags_DeleteReferences);
+    if (status != GetSeriesResult_Success) {
+        return REDISMODULE_ERR;
+    }
+
+    const PackedFormat format = argc == 4 ? parsePackedFormat(argv[2]) : PackedFormat_None;
+    const size_t n_samples =
+        format != PackedFormat_None ? packedSamplesCount(argv[3]) : (argc - 2) / 2;
+    const size_t mark = Scratch_Begin(&writeScratch);
+    Sample *samples = Scratch_Alloc(&writeScratch, n_samples * sizeof(*samples));
+    AddResult result;
+    bool parsed = true;
+    if (format != PackedFormat_None) {
+        parsed = parsePackedSamples(argv[3], format, samples, &result);
+    } else {
+        for (size_t i = 0; i < n_samples && parsed; ++i) {
+            parsed = parseSample(argv[2 + i * 2], argv[3 + i * 2], &samples[i], &result);
+        }
+    }
+    if (!parsed) {
+        Scratch_End(&writeScratch, mark);
+        RedisModule_CloseKey(key);
+        return RedisModule_ReplyWithError(ctx, result.error);
+    }
+    ingestStats.samples += n_samples;
+    sortBulkSamples(samples, n_samples);
+    SeriesFlushAccumulator(ctx, series);
+
+    // ensure inside retention period, relative to the newest sample after the insertion
+    const bool empty = series->totalSamples == 0;
+    timestamp_t newest = samples[n_samples - 1].timestamp;
+    if (!empty && series->lastTimestamp > newest) {
+        newest = series->lastTimestamp;
+    }
+    size_t first = 0;
+    if (series->retentionTime) {
+        while (first < n_samples && series->retentionTime < newest - samples[first].timestamp) {
+            ++first;
+        }
+    }
+
+    const DuplicatePolicy dp_policy = series->duplicatePolicy ?: TSGlobalConfig.duplicatePolicy;
+    size_t n_old = 0;
+    if (!empty) {
+        while (first + n_old < n_samples &&
+               samples[first + n_old].timestamp <= series->lastTimestamp) {
+            ++n_old;
+        }
+    }
+    size_t accepted = SeriesMergeSamples(series, &samples[first], n_old, dp_policy);
+
+    Sample *newSamples = &samples[first + n_old];
+    const size_t n_new =
+        dedupBulkSamples(newSamples, n_samples - first - n_old, dp_policy, &accepted);
+    SeriesAddSamples(series, newSamples, n_new);
+    HandleCompactions(ctx, series, newSamples, n_new);
+    Scratch_End(&writeScratch, mark);
+
+    RedisModule_ReplyWithLongLong(ctx, accepted);
+    if (accepted > 0) {
+        IngestBatch_Flush(ctx);
+        RedisModule_ReplicateVerbatim(ctx);
+    }
+    RedisModule_CloseKey(key);
+
+    IngestBatch_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.add", argv[1]);
+
+    recomputeCompactionsOnCommandEnd();
+    return REDISMODULE_OK;
+}
+
 int CreateTsKey(RedisModuleCtx *ctx,
                 RedisModuleString *keyName,
                 const CreateCtx *cCtx,
@@ -875,6 +1433,7 @@ int CreateTsKey(RedisModuleCtx *ctx,
 
     RedisModule_RetainString(ctx, keyName);
     *series = NewSeries(keyName, cCtx);
+    (*series)->db = RedisModule_GetSelectedDb(ctx);
     if (RedisModule_ModuleTypeSetValue(*key, SeriesType, *series) == REDISMODULE_ERR) {
         return TSDB_ERROR;
     }
@@ -913,6 +1472,7 @@ int TSDB_create(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 
     RedisModule_Log(ctx, "verbose", "created new series");
     RedisModule_ReplyWithSimpleString(ctx, "OK");
+    IngestBatch_Flush(ctx);
     RedisModule_ReplicateVerbatim(ctx);
 
     RedisModule_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.create", keyName);
@@ -968,7 +1528,13 @@ int TSDB_alter(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         series->ignoreMaxValDiff = cCtx.ignoreMaxValDiff;
     }
 
+    if (RMUtil_ArgIndex("ACCUMULATE", argv, argc) > 0) {
+        SeriesFlushAccumulator(ctx, series);
+        series->accumulateWindow = cCtx.accumulateWindow;
+    }
+
     RedisModule_ReplyWithSimpleString(ctx, "OK");
+    IngestBatch_Flush(ctx);
     RedisModule_ReplicateVerbatim(ctx);
     RedisModule_CloseKey(key);
 
@@ -1003,6 +1569,8 @@ int TSDB_deleteRule(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     }
 
     RedisModuleString *destKeyName = argv[2];
+    // the destination keeps the buckets which were invalidated before the rule is deleted
+    SeriesRecomputeDirtyRules(srcSeries);
     if (!SeriesDeleteRule(srcSeries, destKeyName)) {
         RedisModule_CloseKey(srcKey);
         return RTS_ReplyGeneralError(ctx, "TSDB: compaction rule does not exist");
@@ -1024,6 +1592,7 @@ int TSDB_deleteRule(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     SeriesDeleteSrcRule(destSeries, srcKeyName);
 
     RedisModule_ReplyWithSimpleString(ctx, "OK");
+    IngestBatch_Flush(ctx);
     RedisModule_ReplicateVerbatim(ctx);
     RedisModule_CloseKey(srcKey);
     RedisModule_CloseKey(destKey);
@@ -1036,6 +1605,51 @@ int TSDB_deleteRule(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
     return REDISMODULE_OK;
 }
 
+// A rule can be fed by the buckets of the compaction it's created on, when aggregating those
+// buckets yields exactly the aggregation of the raw samples behind them. An avg tier can't be
+// cascaded, its coarse tiers are computed from cascaded sum and count tiers instead.
+static bool isCascadableAggregation(TS_AGG_TYPES_T srcAggType, int aggType) {
+    switch (srcAggType) {
+        case TS_AGG_SUM:
+        case TS_AGG_COUNT:
+            return aggType == TS_AGG_SUM;
+        case TS_AGG_MIN:
+        case TS_AGG_MAX:
+        case TS_AGG_FIRST:
+        case TS_AGG_LAST:
+            return aggType == srcAggType;
+        default:
+            return false;
+    }
+}
+
+// The buckets of the rule must be made of whole buckets of the source rule
+static bool isCascadableRule(RedisModuleCtx *ctx,
+                             const Series *srcSeries,
+                             int aggType,
+                             timestamp_t bucketDuration,
+                             timestamp_t alignmentTS) {
+    RedisModuleKey *upstreamKey;
+    Series *upstreamSeries;
+    const GetSeriesResult status = GetSeries(ctx,
+                                             srcSeries->srcKey,
+                                             &upstreamKey,
+                                             &upstreamSeries,
+                                             REDISMODULE_READ,
+                                             GetSeriesFlags_SilentOperation);
+    if (status != GetSeriesResult_Success) {
+        return false;
+    }
+
+    const CompactionRule *srcRule = GetRule(upstreamSeries->rules, srcSeries->keyName);
+    const bool cascadable = srcRule && isCascadableAggregation(srcRule->aggType, aggType) &&
+                            bucketDuration % srcRule->bucketDuration == 0 &&
+                            alignmentTS % srcRule->bucketDuration ==
+                                srcRule->timestampAlignment % srcRule->bucketDuration;
+    RedisModule_CloseKey(upstreamKey);
+    return cascadable;
+}
+
 /*
 TS.CREATERULE sourceKey destKey AGGREGATION aggregationType bucketDuration
 */
@@ -1075,10 +1689,12 @@ int TSDB_createRule(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         return REDISMODULE_ERR;
     }
 
-    // 1. Verify the source is not a destination
-    if (srcSeries->srcKey) {
+    // 1. Verify a source which is a destination can feed the rule from its buckets
+    if (srcSeries->srcKey &&
+        !isCascadableRule(ctx, srcSeries, aggType, bucketDuration, alignmentTS)) {
         RedisModule_CloseKey(srcKey);
-        return RTS_ReplyGeneralError(ctx, "TSDB: the source key already has a source rule");
+        return RTS_ReplyGeneralError(
+            ctx, "TSDB: the source key already has a source rule which can't be cascaded");
     }
 
     Series *destSeries;
@@ -1116,6 +1732,7 @@ int TSDB_createRule(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         return REDISMODULE_ERR;
     }
     RedisModule_ReplyWithSimpleString(ctx, "OK");
+    IngestBatch_Flush(ctx);
     RedisModule_ReplicateVerbatim(ctx);
 
     RedisModule_CloseKey(srcKey);
@@ -1172,27 +1789,48 @@ int TSDB_incrby(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         return RTS_ReplyGeneralError(ctx, "TSDB: invalid timestamp");
     }
 
-    if (currentUpdatedTime < series->lastTimestamp && series->lastTimestamp != 0) {
-        return RedisModule_ReplyWithError(
-            ctx, "TSDB: timestamp must be equal to or higher than the maximum existing timestamp");
-    }
-
-    double result = series->lastValue;
     RMUtil_StringToLower(argv[0]);
     bool isIncr = RMUtil_StringEqualsC(argv[0], "ts.incrby");
-    if (isIncr) {
-        result += incrby;
+
+    int rv;
+    if (series->accumulateWindow) {
+        // the increments of a window are written as one sample, at the start of the window
+        timestamp_t windowStart;
+        if (SeriesAccumulate(ctx,
+                             series,
+                             currentUpdatedTime,
+                             isIncr ? incrby : -incrby,
+                             &windowStart) != TSDB_OK) {
+            return RedisModule_ReplyWithError(
+                ctx,
+                "TSDB: timestamp must be equal to or higher than the maximum existing timestamp");
+        }
+        RedisModule_ReplyWithLongLong(ctx, windowStart);
+        rv = REDISMODULE_OK;
     } else {
-        result -= incrby;
-    }
+        if (currentUpdatedTime < series->lastTimestamp && series->lastTimestamp != 0) {
+            return RedisModule_ReplyWithError(
+                ctx,
+                "TSDB: timestamp must be equal to or higher than the maximum existing timestamp");
+        }
 
-    int rv = internalAdd(ctx, series, currentUpdatedTime, result, DP_LAST, true);
+        double result = series->lastValue;
+        if (isIncr) {
+            result += incrby;
+        } else {
+            result -= incrby;
+        }
+
+        rv = internalAdd(ctx, series, currentUpdatedTime, result, DP_LAST, true);
+    }
+    IngestBatch_Flush(ctx);
     RedisModule_ReplicateVerbatim(ctx);
     RedisModule_CloseKey(key);
 
     RedisModule_NotifyKeyspaceEvent(
         ctx, REDISMODULE_NOTIFY_GENERIC, isIncr ? "ts.incrby" : "ts.decrby", argv[1]);
 
+    recomputeCompactionsOnCommandEnd();
     return rv;
 }
 
@@ -1450,9 +2088,11 @@ int TSDB_delete(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
         return REDISMODULE_ERR;
     }
 
+    SeriesFlushAccumulator(ctx, series);
     size_t deleted = SeriesDelRange(series, args.startTimestamp, args.endTimestamp);
 
     RedisModule_ReplyWithLongLong(ctx, deleted);
+    IngestBatch_Flush(ctx);
     RedisModule_ReplicateVerbatim(ctx);
     RedisModule_NotifyKeyspaceEvent(ctx, REDISMODULE_NOTIFY_MODULE, "ts.del", argv[1]);
 
@@ -1461,6 +2101,14 @@ int TSDB_delete(RedisModuleCtx *ctx, RedisModuleString **argv, int argc) {
 }
 
 void FlushEventCallback(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subevent, void *data) {
+    if ((!memcmp(&eid, &RedisModuleEvent_FlushDB, sizeof(eid))) &&
+        subevent == REDISMODULE_SUBEVENT_FLUSHDB_START) {
+        // an async flush frees the series on another thread, they must leave the dirty list and
+        // the list of open accumulators first
+        IngestBatch_Flush(ctx);
+        FlushAccumulators();
+        RecomputeDirtyCompactions();
+    }
     if ((!memcmp(&eid, &RedisModuleEvent_FlushDB, sizeof(eid))) &&
         subevent == REDISMODULE_SUBEVENT_FLUSHDB_END) {
         RemoveAllIndexedMetrics();
@@ -1468,6 +2116,7 @@ void FlushEventCallback(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t sube
 }
 
 void swapDbEventCallback(RedisModuleCtx *ctx, RedisModuleEvent e, uint64_t sub, void *data) {
+    IngestBatch_Flush(ctx);
     RedisModule_Log(ctx, "warning", "swapdb isn't supported by redis timeseries");
     if ((!memcmp(&e, &RedisModuleEvent_FlushDB, sizeof(e)))) {
         RedisModuleSwapDbInfo *ei = data;
@@ -1490,8 +2139,10 @@ int keyRemovedFromDbDict(RedisModuleCtx *ctx,
                          int writing_to_swap) {
     Series *series = (Series *)value;
     if (!!writing_to_swap) {
+        SeriesRecomputeDirtyRules(series);
         series->in_ram = false;
     }
+    SeriesUnlinkRules(series);
     return 0;
 }
 
@@ -1506,6 +2157,11 @@ void persistCallback(RedisModuleCtx *ctx, RedisModuleEvent eid, uint64_t subeven
         subevent == REDISMODULE_SUBEVENT_PERSISTENCE_AOF_START ||
         subevent == REDISMODULE_SUBEVENT_PERSISTENCE_SYNC_RDB_START ||
         subevent == REDISMODULE_SUBEVENT_PERSISTENCE_SYNC_AOF_START) {
+        // the batched samples are propagated before the fork, so a full sync which loads the
+        // snapshot doesn't get them again in the replication stream
+        IngestBatch_Flush(ctx);
+        // the dirty buckets aren't persisted
+        RecomputeDirtyCompactions();
         persistence_in_progress++;
     } else if (subevent == REDISMODULE_SUBEVENT_PERSISTENCE_ENDED ||
                subevent == REDISMODULE_SUBEVENT_PERSISTENCE_FAILED) {
@@ -1612,9 +2268,23 @@ __attribute__((weak)) int (*RedisModule_SetDataTypeExtensions)(
     RedisModuleType *mt,
     RedisModuleTypeExtMethods *typemethods) REDISMODULE_ATTR = NULL;
 
+// INFO timeseries_ingest: the heap allocations which the write commands made for their own
+// buffers and strings, they should stay flat while the ingested samples grow
+static void moduleInfoFunc(RedisModuleInfoCtx *ctx, int for_crash_report) {
+    RedisModule_InfoAddSection(ctx, "ingest");
+    RedisModule_InfoAddFieldULongLong(ctx, "ingested_samples", ingestStats.samples);
+    RedisModule_InfoAddFieldULongLong(
+        ctx, "ingest_allocations", writeScratch.allocations + ingestStats.strings);
+    RedisModule_InfoAddFieldULongLong(ctx, "ingest_scratch_bytes", writeScratch.capacity);
+    RedisModule_InfoAddFieldULongLong(ctx, "ingest_batched_samples", ingestBatchStats.samples);
+    RedisModule_InfoAddFieldULongLong(ctx, "ingest_batches", ingestBatchStats.flushes);
+}
+
 int RedisModule_OnUnload(RedisModuleCtx *ctx) {
     if (rts_staticCtx) {
         FreeConfig();
+        Scratch_Free(&writeScratch);
+        IngestBatch_Free();
 
         RedisModule_FreeThreadSafeContext(rts_staticCtx);
         rts_staticCtx = NULL;
@@ -1686,6 +2356,8 @@ int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     }
 
     initGlobalCompactionFunctions();
+    initGlobalFilterFunctions();
+    initTimestampFilterFunctions();
 
     if (register_rg(ctx, TSGlobalConfig.numThreads) != REDISMODULE_OK) {
         FreeConfig();
@@ -1757,6 +2429,7 @@ int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     RegisterCommandWithModesAndAcls(ctx, "ts.createrule", TSDB_createRule, "write fast", "write");
     RegisterCommandWithModesAndAcls(ctx, "ts.deleterule", TSDB_deleteRule, "write", "write fast");
     RegisterCommandWithModesAndAcls(ctx, "ts.add", TSDB_add, "write deny-oom", "write");
+    RegisterCommandWithModesAndAcls(ctx, "ts.addbulk", TSDB_addbulk, "write deny-oom", "write");
     RegisterCommandWithModesAndAcls(ctx, "ts.incrby", TSDB_incrby, "write deny-oom", "write");
     RegisterCommandWithModesAndAcls(ctx, "ts.decrby", TSDB_incrby, "write deny-oom", "write");
     RegisterCommandWithModesAndAcls(ctx, "ts.range", TSDB_range, "readonly", "read");
@@ -1830,6 +2503,11 @@ int RedisModule_OnLoad(RedisModuleCtx *ctx, RedisModuleString **argv, int argc)
     RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_FlushDB, FlushEventCallback);
     RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_SwapDB, swapDbEventCallback);
     RedisModule_SubscribeToServerEvent(ctx, RedisModuleEvent_Persistence, persistCallback);
+    IngestBatch_Init(ctx);
+
+    if (RedisModule_RegisterInfoFunc) {
+        RedisModule_RegisterInfoFunc(ctx, moduleInfoFunc);
+    }
 
     Initialize_RdbNotifications(ctx);
 
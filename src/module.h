@@ -101,6 +101,15 @@ static inline bool CheckKeyIsAllowedToReadWriteC(RedisModuleCtx *ctx,
         ctx, keyName, keyNameLength, REDISMODULE_CMD_KEY_ACCESS | REDISMODULE_CMD_KEY_UPDATE);
 }
 
+// The module contexts update the compactions which were deferred, they have no user whose ACLs
+// apply
+static inline bool CheckCompactionDestIsAllowed(RedisModuleCtx *ctx, RedisModuleString *destKey) {
+    extern RedisModuleCtx *rts_staticCtx;
+    extern RedisModuleCtx *rts_deferredCtx;
+    return ctx == rts_staticCtx || ctx == rts_deferredCtx ||
+           CheckKeyIsAllowedToReadWrite(ctx, destKey);
+}
+
 // Returns true if the user is allowed to read all the keys.
 static inline bool IsUserAllowedToReadAllTheKeys(struct RedisModuleCtx *ctx,
                                                  struct RedisModuleUser *user) {
@@ -145,6 +154,12 @@ int CreateTsKey(RedisModuleCtx *ctx,
 
 bool CheckVersionForBlockedClientMeasureTime();
 
+// Advances the compaction rules of a series over samples appended to it
+void HandleCompactions(RedisModuleCtx *ctx,
+                       Series *series,
+                       const Sample *samples,
+                       size_t n_samples);
+
 extern int persistence_in_progress;
 
 #endif // MODULE_H
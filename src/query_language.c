@@ -180,6 +180,26 @@ int parseIgnoreArgs(RedisModuleCtx *ctx,
     return TSDB_OK;
 }
 
+int parseAccumulateArg(RedisModuleCtx *ctx,
+                       RedisModuleString **argv,
+                       int argc,
+                       long long *accumulateWindow) {
+    if (RMUtil_ArgIndex("ACCUMULATE", argv, argc) > 0) {
+        if (RMUtil_ParseArgsAfter("ACCUMULATE", argv, argc, "l", accumulateWindow) !=
+            REDISMODULE_OK) {
+            RTS_ReplyGeneralError(ctx, "TSDB: Couldn't parse ACCUMULATE");
+            return TSDB_ERROR;
+        }
+
+        if (*accumulateWindow < 0) {
+            RTS_ReplyGeneralError(ctx, "TSDB: ACCUMULATE cannot be negative");
+            return TSDB_ERROR;
+        }
+    }
+
+    return TSDB_OK;
+}
+
 int parseCreateArgs(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, CreateCtx *cCtx) {
     cCtx->retentionTime = TSGlobalConfig.retentionPolicy;
     cCtx->chunkSizeBytes = TSGlobalConfig.chunkSizeBytes;
@@ -223,6 +243,11 @@ int parseCreateArgs(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, Cre
         goto err_exit;
     }
 
+    cCtx->accumulateWindow = 0;
+    if (parseAccumulateArg(ctx, argv, argc, &cCtx->accumulateWindow) != TSDB_OK) {
+        goto err_exit;
+    }
+
     return REDISMODULE_OK;
 err_exit:
     if (cCtx->labelsCount > 0 && cCtx->labels != NULL) {
@@ -241,13 +266,21 @@ int parseEncodingArgs(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, i
 
         const char *encoding = RedisModule_StringPtrLen(argv[encoding_location + 1], NULL);
         if (strcasecmp(encoding, UNCOMPRESSED_ARG_STR) == 0) {
-            *options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+            *options &= ~SERIES_OPT_ENCODING_MASK;
             *options |= SERIES_OPT_UNCOMPRESSED;
             return TSDB_OK;
         } else if (strcasecmp(encoding, COMPRESSED_GORILLA_ARG_STR) == 0) {
-            *options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+            *options &= ~SERIES_OPT_ENCODING_MASK;
             *options |= SERIES_OPT_COMPRESSED_GORILLA;
             return TSDB_OK;
+        } else if (strcasecmp(encoding, COMPRESSED_DECIMAL_ARG_STR) == 0) {
+            *options &= ~SERIES_OPT_ENCODING_MASK;
+            *options |= SERIES_OPT_COMPRESSED_DECIMAL;
+            return TSDB_OK;
+        } else if (strcasecmp(encoding, COMPRESSED_CHIMP_ARG_STR) == 0) {
+            *options &= ~SERIES_OPT_ENCODING_MASK;
+            *options |= SERIES_OPT_COMPRESSED_CHIMP;
+            return TSDB_OK;
         } else {
             RTS_ReplyGeneralError(ctx, "TSDB: unknown ENCODING parameter");
             return TSDB_ERROR;
@@ -255,11 +288,11 @@ int parseEncodingArgs(RedisModuleCtx *ctx, RedisModuleString **argv, int argc, i
     } else {
         // backwards compatible UNCOMPRESSED/COMPRESSED parsing
         if (RMUtil_ArgIndex(UNCOMPRESSED_ARG_STR, argv, argc) > 0) {
-            *options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+            *options &= ~SERIES_OPT_ENCODING_MASK;
             *options |= SERIES_OPT_UNCOMPRESSED;
         }
         if (RMUtil_ArgIndex(COMPRESSED_GORILLA_ARG_STR, argv, argc) > 0) {
-            *options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
+            *options &= ~SERIES_OPT_ENCODING_MASK;
             *options |= SERIES_OPT_COMPRESSED_GORILLA;
         }
     }
@@ -563,22 +596,22 @@ static int parseFilterByTimestamp(RedisModuleCtx *ctx,
             return TSDB_ERROR;
         }
 
-        while (offset + 1 < argc && index < MAX_TS_VALUES_FILTER) {
-            timestamp_t val;
-            if (parseTimestamp(argv[offset + 1], &val) == REDISMODULE_OK) {
-                args->values[index] = val;
-                index++;
-                offset++;
-            } else {
-                // TODO check if the token is a keywork in our query lang or raise an error
-                break;
-            }
+        // the timestamps run up to the next token which isn't a timestamp
+        int last = offset + 1;
+        timestamp_t val;
+        while (last < argc && parseTimestamp(argv[last], &val) == REDISMODULE_OK) {
+            last++;
         }
-        if (index == 0) {
+        if (last == offset + 1) {
             RTS_ReplyGeneralError(ctx, "TSDB: FILTER_BY_TS one or more arguments are missing");
             return TSDB_ERROR;
         }
 
+        args->values = malloc((last - offset - 1) * sizeof(*args->values));
+        for (int i = offset + 1; i < last; ++i) {
+            parseTimestamp(argv[i], &args->values[index++]);
+        }
+
         // We sort the provided timestamps in order to improve query time filtering
         qsort(args->values, index, sizeof(uint64_t), comp_uint64);
         index = values_remove_duplicates(args->values, index);
@@ -640,6 +673,7 @@ int parseRangeArguments(RedisModuleCtx *ctx,
     if (parseLatestArg(ctx, argv, argc, &args.latest) != REDISMODULE_OK) {
         return REDISMODULE_ERR;
     }
+    args.openWindow = true;
 
     args.count = -1;
     if (parseCountArgument(ctx, argv, argc, &args.count) != REDISMODULE_OK) {
@@ -896,12 +930,14 @@ int parseMRangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
     const int filter_location = RMUtil_ArgIndex("FILTER", argv, argc);
     if (filter_location == -1) {
         RTS_ReplyGeneralError(ctx, "TSDB: missing FILTER argument");
+        RangeArgs_Free(&args.rangeArgs);
         return REDISMODULE_ERR;
     }
 
     if (parseLabelQuery(
             ctx, argv, argc, &args.withLabels, args.limitLabels, &args.numLimitLabels) ==
         REDISMODULE_ERR) {
+        RangeArgs_Free(&args.rangeArgs);
         return REDISMODULE_ERR;
     }
 
@@ -909,6 +945,7 @@ int parseMRangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
 
     if (groupby_location > 0 && groupby_location < filter_location) {
         RTS_ReplyGeneralError(ctx, "TSDB: GROUPBY should always come after filter");
+        RangeArgs_Free(&args.rangeArgs);
         return REDISMODULE_ERR;
     }
 
@@ -919,11 +956,13 @@ int parseMRangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
 
     if (query_count == 0) {
         RTS_ReplyGeneralError(ctx, "TSDB: missing labels for filter argument");
+        RangeArgs_Free(&args.rangeArgs);
         return REDISMODULE_ERR;
     }
 
     QueryPredicateList *queries = NULL;
     if (parseFilter(ctx, argv, argc, filter_location, query_count, &queries) != REDISMODULE_OK) {
+        RangeArgs_Free(&args.rangeArgs);
         return REDISMODULE_ERR;
     }
     args.queryPredicates = queries;
@@ -933,6 +972,7 @@ int parseMRangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
             // GROUP BY without any argument
             RedisModule_WrongArity(ctx);
             QueryPredicateList_Free(queries);
+            RangeArgs_Free(&args.rangeArgs);
             return REDISMODULE_ERR;
         }
         args.groupByLabel = RedisModule_StringPtrLen(argv[groupby_location + 1], NULL);
@@ -943,11 +983,13 @@ int parseMRangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
         if (reduce_location < 0 || (argc - groupby_location != 4)) {
             RedisModule_WrongArity(ctx);
             QueryPredicateList_Free(queries);
+            RangeArgs_Free(&args.rangeArgs);
             return REDISMODULE_ERR;
         }
         if (parseMultiSeriesReduceArgs(ctx, argv[reduce_location + 1], &args.gropuByReducerArgs) !=
             TSDB_OK) {
             QueryPredicateList_Free(queries);
+            RangeArgs_Free(&args.rangeArgs);
             return REDISMODULE_ERR;
         }
     }
@@ -955,7 +997,13 @@ int parseMRangeCommand(RedisModuleCtx *ctx, RedisModuleString **argv, int argc,
     return REDISMODULE_OK;
 }
 
+void RangeArgs_Free(RangeArgs *args) {
+    free(args->filterByTSArgs.values);
+    args->filterByTSArgs.values = NULL;
+}
+
 void MRangeArgs_Free(MRangeArgs *args) {
+    RangeArgs_Free(&args->rangeArgs);
     QueryPredicateList_Free(args->queryPredicates);
 }
 
@@ -49,13 +49,11 @@ typedef struct FilterByValueArgs
     double max;
 } FilterByValueArgs;
 
-#define MAX_TS_VALUES_FILTER 128
-
 typedef struct FilterByTSArgs
 {
     bool hasValue;
     size_t count;
-    timestamp_t values[MAX_TS_VALUES_FILTER];
+    timestamp_t *values; // sorted and unique, owned by the RangeArgs
 } FilterByTSArgs;
 
 typedef enum RangeAlignment
@@ -71,6 +69,7 @@ typedef struct RangeArgs
     api_timestamp_t startTimestamp;
     api_timestamp_t endTimestamp;
     bool latest;     // get also the latest unfinalized bucket from the src series
+    bool openWindow; // get also the open ACCUMULATE window, which isn't written yet
     long long count; // AKA limit
     AggregationArgs aggregationArgs;
     FilterByValueArgs filterByValueArgs;
@@ -112,6 +111,7 @@ typedef struct CreateCtx
     bool skipChunkCreation;
     long long ignoreMaxTimeDiff;
     double ignoreMaxValDiff;
+    long long accumulateWindow;
 } CreateCtx;
 
 int parseLabelsFromArgs(RedisModuleString **argv, int argc, size_t *label_count, Label **labels);
@@ -160,6 +160,7 @@ int parseRangeArguments(RedisModuleCtx *ctx,
                         RedisModuleString **argv,
                         int argc,
                         RangeArgs *out);
+void RangeArgs_Free(RangeArgs *args);
 
 QueryPredicateList *parseLabelListFromArgs(RedisModuleCtx *ctx,
                                            RedisModuleString **argv,
@@ -8,6 +8,7 @@
  */
 #include "rdb.h"
 
+#include "config.h"
 #include "consts.h"
 #include "endianconv.h"
 #include "load_io_error_macros.h"
@@ -40,6 +41,13 @@ void *series_rdb_load(RedisModuleIO *io, int encver) {
     }
     cCtx.options = Load_IOError_OrDefault(
         io, err, NULL, encver >= TS_UNCOMPRESSED_VER, SERIES_OPT_UNCOMPRESSED);
+    // the decimal and chimp chunks save their value encoding state, which came with this version
+    if (encver < TS_DECIMAL_ENCODING_VER &&
+        (cCtx.options & (SERIES_OPT_COMPRESSED_DECIMAL | SERIES_OPT_COMPRESSED_CHIMP))) {
+        RedisModule_LogIOError(io, "error", "data is not in the correct encoding");
+        err = true;
+        return NULL;
+    }
 
     const timestamp_t lastTimestamp =
         Load_IOError_OrDefault(io, err, NULL, encver >= TS_SIZE_RDB_VER, 0);
@@ -58,6 +66,11 @@ void *series_rdb_load(RedisModuleIO *io, int encver) {
         Load_IOError_OrDefault(io, err, NULL, encver >= TS_CREATE_IGNORE_VER, 0);
     const double ignoreMaxValDiff =
         Load_IOError_OrDefault(io, err, NULL, encver >= TS_CREATE_IGNORE_VER, 0.0);
+    cCtx.accumulateWindow = Load_IOError_OrDefault(io, err, NULL, encver >= TS_ACCUMULATE_VER, 0);
+    const bool accumulating =
+        Load_IOError_OrDefault(io, err, NULL, encver >= TS_ACCUMULATE_VER, false);
+    const timestamp_t windowStart = Load_IOError_OrDefault(io, err, NULL, accumulating, 0);
+    const double windowValue = Load_IOError_OrDefault(io, err, NULL, accumulating, 0.0);
 
     cCtx.labelsCount = LoadUnsigned_IOError(io, err, NULL);
     cCtx.labels = calloc(cCtx.labelsCount, sizeof *cCtx.labels);
@@ -117,8 +130,14 @@ void *series_rdb_load(RedisModuleIO *io, int encver) {
             series->funcs->FreeChunk(chunk);
         }
         dictOperator(series->chunks, NULL, 0, DICT_OP_DEL);
+        chunk = NULL;
         const uint64_t numChunks = LoadUnsigned_IOError(io, err, NULL);
+        series->totalSamples = totalSamples;
         for (int i = 0; i < numChunks; ++i) {
+            if (chunk && TSGlobalConfig.chunkSealing == CHUNK_SEALING_INLINE) {
+                // all the chunks but the last one are full
+                SeriesSealChunk(series, chunk);
+            }
             if (series->funcs->LoadFromRDB(&chunk, io)) {
                 err = true;
                 return NULL;
@@ -126,7 +145,6 @@ void *series_rdb_load(RedisModuleIO *io, int encver) {
             dictOperator(
                 series->chunks, chunk, series->funcs->GetFirstTimestamp(chunk), DICT_OP_SET);
         }
-        series->totalSamples = totalSamples;
         series->duplicatePolicy = duplicatePolicy;
         series->srcKey = srcKey;
         series->lastTimestamp = lastTimestamp;
@@ -134,6 +152,13 @@ void *series_rdb_load(RedisModuleIO *io, int encver) {
         series->lastChunk = chunk;
         series->ignoreMaxTimeDiff = ignoreMaxTimeDiff;
         series->ignoreMaxValDiff = ignoreMaxValDiff;
+        if (numChunks > 1) {
+            SeriesDeferChunkSealing(series, 0);
+        }
+        if (accumulating) {
+            const Sample window = { .timestamp = windowStart, .value = windowValue };
+            SeriesOpenAccumulator(series, window);
+        }
     }
 
     return series;
@@ -172,6 +197,13 @@ void series_rdb_save(RedisModuleIO *io, void *value) {
 
     RedisModule_SaveUnsigned(io, series->ignoreMaxTimeDiff);
     RedisModule_SaveDouble(io, series->ignoreMaxValDiff);
+    RedisModule_SaveUnsigned(io, series->accumulateWindow);
+    // the open window is saved as is, saving doesn't write it to the series
+    RedisModule_SaveUnsigned(io, series->accumulatorPos != 0);
+    if (series->accumulatorPos != 0) {
+        RedisModule_SaveUnsigned(io, series->accumulator.timestamp);
+        RedisModule_SaveDouble(io, series->accumulator.value);
+    }
 
     RedisModule_SaveUnsigned(io, series->labelsCount);
     for (int i = 0; i < series->labelsCount; i++) {
@@ -23,9 +23,12 @@
 #define TS_ALIGNMENT_TS_VER 6
 #define TS_LAST_AGGREGATION_EMPTY 7
 #define TS_CREATE_IGNORE_VER 8
+#define TS_DECIMAL_ENCODING_VER 9
+#define TS_ACCUMULATE_VER 10
+#define TS_NATIVE_CHUNKS_VER 11
 
 // This flag should be updated whenever a new rdb version is introduced
-#define TS_LATEST_ENCVER TS_CREATE_IGNORE_VER
+#define TS_LATEST_ENCVER TS_NATIVE_CHUNKS_VER
 
 extern int last_rdb_load_version;
 
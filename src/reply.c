@@ -9,6 +9,7 @@
 
 #include "reply.h"
 
+#include "fused_range.h"
 #include "query_language.h"
 #include "series_iterator.h"
 #include "tsdb.h"
@@ -126,6 +127,10 @@ int ReplySeriesArrayPos(RedisModuleCtx *ctx,
 }
 
 int ReplySeriesRange(RedisModuleCtx *ctx, Series *series, const RangeArgs *args, bool reverse) {
+    if (ReplySeriesRangeFused(ctx, series, args, reverse)) {
+        return REDISMODULE_OK;
+    }
+
     long long arraylen = 0;
     long long _count = LLONG_MAX;
     unsigned int n;
@@ -210,7 +215,10 @@ void ReplyWithSample(RedisModuleCtx *ctx, uint64_t timestamp, double value) {
 }
 
 void ReplyWithSeriesLastDatapoint(RedisModuleCtx *ctx, const Series *series) {
-    if (SeriesGetNumSamples(series) == 0) {
+    if (series->accumulatorPos != 0) {
+        // the open ACCUMULATE window isn't written yet, it's the last sample of the series
+        ReplyWithSample(ctx, series->accumulator.timestamp, series->accumulator.value);
+    } else if (SeriesGetNumSamples(series) == 0) {
         RedisModule_ReplyWithArray(ctx, 0);
     } else {
         ReplyWithSample(ctx, series->lastTimestamp, series->lastValue);
@@ -12,6 +12,9 @@
 #include "filter_iterator.h"
 #include "tsdb.h"
 #include "enriched_chunk.h"
+#include "filters/filter_ts.h"
+
+#include <string.h>
 
 EnrichedChunk *SeriesIteratorGetNextChunk(AbstractIterator *iterator);
 
@@ -23,7 +26,8 @@ AbstractIterator *SeriesIterator_New(Series *series,
                                      timestamp_t end_ts,
                                      bool rev,
                                      bool rev_chunk,
-                                     bool latest) {
+                                     bool latest,
+                                     bool openWindow) {
     SeriesIterator *iter = malloc(sizeof(SeriesIterator));
     iter->base.Close = SeriesIteratorClose;
     iter->base.GetNext = SeriesIteratorGetNextChunk;
@@ -36,6 +40,15 @@ AbstractIterator *SeriesIterator_New(Series *series,
     iter->reverse = rev;
     iter->reverse_chunk = rev_chunk;
     iter->latest = latest;
+    iter->openWindow = openWindow && series->accumulatorPos != 0 &&
+                       series->accumulator.timestamp >= start_ts &&
+                       series->accumulator.timestamp <= end_ts;
+    iter->openWindowPassed = false;
+    iter->summaryBucketDuration = 0;
+    iter->summaryTimestampAlignment = 0;
+    iter->tsFilter = NULL;
+    iter->tsFilterStart = 0;
+    iter->tsFilterEnd = 0;
 
     timestamp_t rax_key;
 
@@ -58,6 +71,23 @@ AbstractIterator *SeriesIterator_New(Series *series,
     return (AbstractIterator *)iter;
 }
 
+void SeriesIterator_UseChunkSummaries(AbstractIterator *iterator,
+                                      timestamp_t bucketDuration,
+                                      timestamp_t timestampAlignment) {
+    SeriesIterator *self = (SeriesIterator *)iterator;
+    self->summaryBucketDuration = bucketDuration;
+    self->summaryTimestampAlignment = timestampAlignment;
+}
+
+void SeriesIterator_UseTimestampFilter(AbstractIterator *iterator,
+                                       const timestamp_t *filter,
+                                       size_t count) {
+    SeriesIterator *self = (SeriesIterator *)iterator;
+    self->tsFilter = filter;
+    self->tsFilterStart = 0;
+    self->tsFilterEnd = count;
+}
+
 void SeriesIteratorClose(AbstractIterator *iterator) {
     SeriesIterator *self = (SeriesIterator *)iterator;
     RedisModule_DictIteratorStop(self->dictIter);
@@ -72,6 +102,131 @@ extern RedisModuleCtx *rts_staticCtx; // global redis ctx
     ((iter)->latest && (iter)->series->srcKey &&                                                   \
      (iter)->maxTimestamp > (iter)->series->lastTimestamp)
 
+// The open window goes on from the last written sample when they have the same timestamp
+static bool openWindowReplacesSample(const SeriesIterator *iter, const Chunk_t *chunk) {
+    const Series *series = iter->series;
+    return iter->openWindow && chunk == series->lastChunk && series->totalSamples != 0 &&
+           series->accumulator.timestamp == series->lastTimestamp;
+}
+
+static void dropOpenWindowSample(SeriesIterator *iter) {
+    Samples *samples = &iter->enrichedChunk->samples;
+    const timestamp_t timestamp = iter->series->accumulator.timestamp;
+    if (samples->num_samples == 0) {
+        return;
+    }
+    if (!iter->reverse_chunk) {
+        if (samples->timestamps[samples->num_samples - 1] == timestamp) {
+            --samples->num_samples;
+        }
+    } else if (samples->timestamps[0] == timestamp) {
+        --samples->num_samples;
+        if (iter->enrichedChunk->borrowed) {
+            ++samples->timestamps;
+            ++samples->values;
+        } else {
+            memmove(samples->timestamps,
+                    samples->timestamps + 1,
+                    samples->num_samples * sizeof(timestamp_t));
+            memmove(samples->values, samples->values + 1, samples->num_samples * sizeof(double));
+        }
+    }
+}
+
+// The open window is read as a sample, it isn't written
+static EnrichedChunk *passOpenWindow(SeriesIterator *iter) {
+    if (iter->enrichedChunk->samples.size == 0) {
+        ReallocSamplesArray(&iter->enrichedChunk->samples, 1);
+    }
+    ResetEnrichedChunk(iter->enrichedChunk);
+    iter->enrichedChunk->rev = iter->reverse_chunk;
+    iter->enrichedChunk->samples.num_samples = 1;
+    *iter->enrichedChunk->samples.timestamps = iter->series->accumulator.timestamp;
+    *iter->enrichedChunk->samples.values = iter->series->accumulator.value;
+    iter->openWindowPassed = true;
+    return iter->enrichedChunk;
+}
+
+// Passes the chunk as its summary when all its samples are in the query range and in the same
+// bucket, the summary is followed by the first sample of the chunk so the bucket can be found.
+static bool setChunkSummary(SeriesIterator *iter, Chunk_t *chunk) {
+    if (openWindowReplacesSample(iter, chunk)) {
+        return false;
+    }
+    const ChunkSummary *summary = iter->series->funcs->GetSummary(chunk);
+    if (!summary || summary->first.timestamp < iter->minTimestamp ||
+        summary->last.timestamp > iter->maxTimestamp) {
+        return false;
+    }
+    const timestamp_t duration = iter->summaryBucketDuration;
+    const timestamp_t alignment = iter->summaryTimestampAlignment;
+    if (CalcBucketStart(summary->first.timestamp, duration, alignment) !=
+        CalcBucketStart(summary->last.timestamp, duration, alignment)) {
+        return false;
+    }
+
+    ResetEnrichedChunk(iter->enrichedChunk);
+    iter->enrichedChunk->summary = summary;
+    iter->enrichedChunk->samples.num_samples = 1;
+    iter->enrichedChunk->samples.timestamps[0] = summary->first.timestamp;
+    iter->enrichedChunk->samples.values[0] = summary->first.value;
+    return true;
+}
+
+// Moves to the first chunk, in the direction of the iterator, which may hold a timestamp of the
+// filter. The chunks before it are skipped by seeking the chunk of the next filter timestamp, so
+// they aren't decoded nor visited one by one.
+static Chunk_t *skipChunksOutsideTimestampFilter(SeriesIterator *iter) {
+    const timestamp_t *filter = iter->tsFilter;
+    Chunk_t *chunk = iter->currentChunk;
+    while (chunk && iter->series->funcs->GetNumOfSample(chunk) > 0) {
+        const timestamp_t first =
+            max(iter->series->funcs->GetFirstTimestamp(chunk), iter->minTimestamp);
+        const timestamp_t last =
+            min(iter->series->funcs->GetLastTimestamp(chunk), iter->maxTimestamp);
+        timestamp_t next; // the closest filter timestamp in the direction of the iterator
+        if (!iter->reverse) {
+            iter->tsFilterStart =
+                GallopLowerBound(filter, iter->tsFilterStart, iter->tsFilterEnd, first);
+            if (iter->tsFilterStart == iter->tsFilterEnd ||
+                filter[iter->tsFilterStart] > iter->maxTimestamp) {
+                chunk = NULL;
+                break;
+            }
+            next = filter[iter->tsFilterStart];
+            if (next <= last) {
+                break;
+            }
+        } else {
+            iter->tsFilterEnd =
+                GallopLowerBoundReverse(filter, iter->tsFilterStart, iter->tsFilterEnd, last + 1);
+            if (iter->tsFilterEnd == iter->tsFilterStart ||
+                filter[iter->tsFilterEnd - 1] < iter->minTimestamp) {
+                chunk = NULL;
+                break;
+            }
+            next = filter[iter->tsFilterEnd - 1];
+            if (next >= first) {
+                break;
+            }
+        }
+
+        // the last chunk which starts at or before the filter timestamp, it's the current chunk
+        // when the timestamp falls in the gap after it
+        timestamp_t rax_key;
+        seriesEncodeTimestamp(&rax_key, next);
+        RedisModule_DictIteratorReseekC(iter->dictIter, "<=", &rax_key, sizeof(rax_key));
+        Chunk_t *seeked;
+        if (!iter->DictGetNext(iter->dictIter, NULL, (void *)&seeked) ||
+            (seeked == chunk && !iter->DictGetNext(iter->dictIter, NULL, (void *)&seeked))) {
+            seeked = NULL;
+        }
+        chunk = seeked;
+    }
+    iter->currentChunk = chunk;
+    return chunk;
+}
+
 // Fills sample from chunk. If all samples were extracted from the chunk, we
 // move to the next chunk.
 EnrichedChunk *SeriesIteratorGetNextChunk(AbstractIterator *abstractIterator) {
@@ -83,14 +238,25 @@ EnrichedChunk *SeriesIteratorGetNextChunk(AbstractIterator *abstractIterator) {
     if (unlikely(iter->reverse && should_finalize_last_bucket(iter))) {
         goto _handle_latest;
     }
+    if (unlikely(iter->reverse && iter->openWindow && !iter->openWindowPassed)) {
+        return passOpenWindow(iter);
+    }
+
+    if (iter->tsFilter) {
+        curChunk = skipChunksOutsideTimestampFilter(iter);
+    }
 
     if (!curChunk || iter->series->funcs->GetNumOfSample(curChunk) == 0) {
         if (unlikely(curChunk && iter->series->funcs->GetNumOfSample(curChunk) > 0 &&
                      iter->series->totalSamples == 0)) { // empty chunks are being removed
             RedisModule_Log(rts_staticCtx, "error", "Empty chunk in a non empty series is invalid");
         }
+        if (iter->openWindow && !iter->openWindowPassed) {
+            return passOpenWindow(iter);
+        }
         if (should_finalize_last_bucket(iter)) {
             iter->enrichedChunk->samples.num_samples = 0;
+            iter->enrichedChunk->summary = NULL;
             goto _handle_latest;
         }
         return NULL;
@@ -100,6 +266,12 @@ EnrichedChunk *SeriesIteratorGetNextChunk(AbstractIterator *abstractIterator) {
     if (n_samples > iter->enrichedChunk->samples.size) {
         ReallocSamplesArray(&iter->enrichedChunk->samples, n_samples);
     }
+    if (iter->summaryBucketDuration > 0 && setChunkSummary(iter, curChunk)) {
+        if (!iter->DictGetNext(iter->dictIter, NULL, (void *)&iter->currentChunk)) {
+            iter->currentChunk = NULL;
+        }
+        goto _out;
+    }
     iter->series->funcs->ProcessChunk(
         curChunk, iter->minTimestamp, iter->maxTimestamp, iter->enrichedChunk, iter->reverse_chunk);
     if (!iter->DictGetNext(iter->dictIter, NULL, (void *)&iter->currentChunk)) {
@@ -114,6 +286,13 @@ EnrichedChunk *SeriesIteratorGetNextChunk(AbstractIterator *abstractIterator) {
         return SeriesIteratorGetNextChunk(abstractIterator);
     }
 
+    if (unlikely(openWindowReplacesSample(iter, curChunk))) {
+        dropOpenWindowSample(iter);
+        if (iter->enrichedChunk->samples.num_samples == 0) {
+            return SeriesIteratorGetNextChunk(abstractIterator);
+        }
+    }
+
     if (iter->enrichedChunk->samples.num_samples > 0 || (!should_finalize_last_bucket(iter))) {
         goto _out;
     }
@@ -27,6 +27,17 @@ typedef struct SeriesIterator
     bool reverse;
     bool reverse_chunk;
     bool latest;
+    // the open ACCUMULATE window of the series is in the range, it's passed after the written
+    // samples and replaces the written sample of its timestamp
+    bool openWindow;
+    bool openWindowPassed;
+    // when set, a chunk which falls inside one aggregation bucket is passed as its summary
+    timestamp_t summaryBucketDuration;
+    timestamp_t summaryTimestampAlignment;
+    // when set, the chunks which hold no timestamp of the sorted filter are skipped
+    const timestamp_t *tsFilter;
+    size_t tsFilterStart;
+    size_t tsFilterEnd;
     void *(*DictGetNext)(RedisModuleDictIter *di, size_t *keylen, void **dataptr);
 } SeriesIterator;
 
@@ -35,6 +46,17 @@ struct AbstractIterator *SeriesIterator_New(Series *series,
                                             timestamp_t end_ts,
                                             bool rev,
                                             bool rev_chunk,
-                                            bool latest);
+                                            bool latest,
+                                            bool openWindow);
+
+// Lets the aggregation which consumes the iterator fold chunk summaries, see ChunkSummary
+void SeriesIterator_UseChunkSummaries(struct AbstractIterator *iterator,
+                                      timestamp_t bucketDuration,
+                                      timestamp_t timestampAlignment);
+
+// Lets the FILTER_BY_TS which consumes the iterator skip the chunks without filtered timestamps
+void SeriesIterator_UseTimestampFilter(struct AbstractIterator *iterator,
+                                       const timestamp_t *filter,
+                                       size_t count);
 
 #endif // REDIS_TIMESERIES_CLEAN_SERIES_ITERATOR_H
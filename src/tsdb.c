@@ -22,6 +22,7 @@
 #include "libmr_integration.h"
 
 #include <inttypes.h>
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 #include <assert.h> // assert
@@ -31,6 +32,142 @@
 
 static RedisModuleString *renameFromKey = NULL;
 
+// A list of series with deferred work. A series knows its position in a list by a field of its own,
+// which holds its 1 based index, 0 if it isn't listed.
+typedef struct SeriesList
+{
+    Series **series;
+    size_t count;
+    size_t capacity;
+    size_t posOffset; // the offset of the position field in Series
+} SeriesList;
+
+#define SERIES_LIST(posField) { .posOffset = offsetof(Series, posField) }
+
+static inline size_t *seriesListPos(const SeriesList *list, Series *series) {
+    return (size_t *)((char *)series + list->posOffset);
+}
+
+// Returns false if the series was already listed
+static bool seriesListAdd(SeriesList *list, Series *series) {
+    size_t *pos = seriesListPos(list, series);
+    if (*pos != 0) {
+        return false;
+    }
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->series = realloc(list->series, list->capacity * sizeof(*list->series));
+    }
+    list->series[list->count++] = series;
+    *pos = list->count;
+    return true;
+}
+
+static void seriesListRemove(SeriesList *list, Series *series) {
+    size_t *pos = seriesListPos(list, series);
+    if (*pos == 0) {
+        return;
+    }
+    Series *last = list->series[--list->count];
+    list->series[*pos - 1] = last;
+    *seriesListPos(list, last) = *pos;
+    *pos = 0;
+}
+
+// The series was moved in memory, as it's listed at the same position
+static void seriesListMoved(SeriesList *list, Series *moved) {
+    const size_t pos = *seriesListPos(list, moved);
+    if (pos != 0) {
+        list->series[pos - 1] = moved;
+    }
+}
+
+// Series whose compaction rules have dirty buckets
+static SeriesList dirtySeries = SERIES_LIST(dirtyPos);
+static RedisModuleTimerID recomputeTimer;
+static bool recomputeTimerPending = false;
+
+static void recomputeTimerCallback(RedisModuleCtx *ctx, void *data) {
+    recomputeTimerPending = false;
+    RecomputeDirtyCompactions();
+}
+
+static void armRecomputeTimer(void) {
+    recomputeTimer = RedisModule_CreateTimer(
+        rts_staticCtx, TSGlobalConfig.compactionRecomputeInterval, recomputeTimerCallback, NULL);
+    recomputeTimerPending = true;
+}
+
+static void addDirtySeries(Series *series) {
+    if (!seriesListAdd(&dirtySeries, series)) {
+        return;
+    }
+    if (TSGlobalConfig.compactionRecomputeInterval > 0 && !recomputeTimerPending) {
+        armRecomputeTimer();
+    }
+}
+
+// ts-compaction-recompute-interval changed, the dirty buckets wait for the new interval
+void RescheduleDirtyCompactions(void) {
+    if (recomputeTimerPending) {
+        RedisModule_StopTimer(rts_staticCtx, recomputeTimer, NULL);
+        recomputeTimerPending = false;
+    }
+    if (dirtySeries.count > 0) {
+        armRecomputeTimer();
+    }
+}
+
+// Accumulating series with an open window
+static SeriesList accumulatingSeries = SERIES_LIST(accumulatorPos);
+
+// Series with full chunks which the deferred sealing didn't seal yet
+static SeriesList sealingSeries = SERIES_LIST(sealPos);
+static bool sealTimerPending = false;
+
+// Sealing merges the out of order samples of a chunk, which tells which of the ones buffered
+// without a lookup replaced a sample
+void SeriesSealChunk(Series *series, Chunk_t *chunk) {
+    const uint64_t numSamples = series->funcs->GetNumOfSample(chunk);
+    series->funcs->SealChunk(chunk);
+    series->totalSamples -= numSamples - series->funcs->GetNumOfSample(chunk);
+}
+
+// Seals the chunks of each series from the first unsealed one, all but the last chunk are full
+static void sealTimerCallback(RedisModuleCtx *ctx, void *data) {
+    sealTimerPending = false;
+    while (sealingSeries.count > 0) {
+        Series *series = sealingSeries.series[sealingSeries.count - 1];
+        seriesListRemove(&sealingSeries, series);
+        timestamp_t rax_key = htonu64(series->unsealedFrom);
+        RedisModuleDictIter *iter =
+            RedisModule_DictIteratorStartC(series->chunks, ">=", &rax_key, sizeof(rax_key));
+        Chunk_t *chunk;
+        while (RedisModule_DictNextC(iter, NULL, (void *)&chunk) != NULL &&
+               chunk != series->lastChunk) {
+            SeriesSealChunk(series, chunk);
+        }
+        RedisModule_DictIteratorStop(iter);
+    }
+}
+
+// With deferred sealing the full chunks from the one which starts at from are sealed by a timer,
+// once the command which filled them returned
+void SeriesDeferChunkSealing(Series *series, timestamp_t from) {
+    if (TSGlobalConfig.chunkSealing != CHUNK_SEALING_DEFERRED) {
+        return;
+    }
+    if (seriesListAdd(&sealingSeries, series)) {
+        series->unsealedFrom = from;
+    } else {
+        series->unsealedFrom = min(series->unsealedFrom, from);
+    }
+    if (!sealTimerPending) {
+        RedisModule_CreateTimer(rts_staticCtx, 0, sealTimerCallback, NULL);
+        sealTimerPending = true;
+    }
+}
+
 void deleteReferenceToDeletedSeries(RedisModuleCtx *ctx,
                                     Series *series,
                                     const GetSeriesFlags flags) {
@@ -63,6 +200,93 @@ void deleteReferenceToDeletedSeries(RedisModuleCtx *ctx,
     }
 }
 
+static void unlinkRuleDest(CompactionRule *rule) {
+    if (rule->destSeries != NULL) {
+        rule->destSeries->srcRule = NULL;
+        rule->destSeries = NULL;
+    }
+}
+
+static void linkRuleDest(CompactionRule *rule, Series *destSeries) {
+    unlinkRuleDest(rule);
+    if (destSeries->srcRule != NULL) {
+        unlinkRuleDest(destSeries->srcRule);
+    }
+    rule->destSeries = destSeries;
+    destSeries->srcRule = rule;
+}
+
+// Drops the references between the series and the rules which it resolved or which resolved it.
+// They're resolved again on the next append.
+void SeriesUnlinkRules(Series *series) {
+    if (series->srcRule != NULL) {
+        unlinkRuleDest(series->srcRule);
+    }
+    for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        unlinkRuleDest(rule);
+    }
+}
+
+static bool rulesResolved(const Series *series) {
+    if (series->srcKey != NULL && series->srcRule == NULL) {
+        return false;
+    }
+    for (const CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        if (rule->destSeries == NULL) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Drops the rules of deleted series and resolves the destination series of the others. A rule and
+// its destination keep referencing each other until either series is freed or moved, so appends
+// don't look up the destination keys.
+void SeriesResolveRules(RedisModuleCtx *ctx, Series *series) {
+    if (likely(rulesResolved(series))) {
+        return;
+    }
+    const GetSeriesFlags flags = GetSeriesFlags_SilentOperation;
+    deleteReferenceToDeletedSeries(ctx, series, flags);
+    Series *other;
+    RedisModuleKey *key;
+    if (series->srcKey != NULL && series->srcRule == NULL &&
+        GetSeries(ctx, series->srcKey, &key, &other, REDISMODULE_READ, flags) ==
+            GetSeriesResult_Success) {
+        CompactionRule *srcRule = GetRule(other->rules, series->keyName);
+        if (srcRule != NULL) {
+            linkRuleDest(srcRule, series);
+        }
+        RedisModule_CloseKey(key);
+    }
+    for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        if (rule->destSeries == NULL &&
+            GetSeries(ctx, rule->destKey, &key, &other, REDISMODULE_READ, flags) ==
+                GetSeriesResult_Success) {
+            linkRuleDest(rule, other);
+            RedisModule_CloseKey(key);
+        }
+    }
+}
+
+// Opens the destination key of a rule for write. The resolved destination series is only a hint,
+// it's written when the key still holds it. Returns NULL if it doesn't or the destination isn't
+// allowed, the key is then closed.
+Series *SeriesOpenRuleDest(RedisModuleCtx *ctx, CompactionRule *rule, RedisModuleKey **key) {
+    if (rule->destSeries == NULL || !CheckCompactionDestIsAllowed(ctx, rule->destKey)) {
+        return NULL;
+    }
+    *key = RedisModule_OpenKey(ctx, rule->destKey, REDISMODULE_READ | REDISMODULE_WRITE);
+    if (RedisModule_ModuleTypeGetType(*key) == SeriesType &&
+        RedisModule_ModuleTypeGetValue(*key) == rule->destSeries) {
+        return rule->destSeries;
+    }
+    RedisModule_CloseKey(*key);
+    // the key was replaced, the rule is resolved again on the next append
+    unlinkRuleDest(rule);
+    return NULL;
+}
+
 CompactionRule *GetRule(CompactionRule *rules, RedisModuleString *keyName) {
     CompactionRule *rule = rules;
     while (rule != NULL) {
@@ -132,6 +356,7 @@ GetSeriesResult GetSeries(RedisModuleCtx *ctx,
 
     *series = RedisModule_ModuleTypeGetValue(new_key);
     *key = new_key;
+    (*series)->db = RedisModule_GetSelectedDb(ctx);
 
     if (shouldDeleteRefs) {
         // deleteReferenceToDeletedSeries calls GetSeries with the flags it was provided. avoid
@@ -177,11 +402,16 @@ Series *NewSeries(RedisModuleString *keyName, const CreateCtx *cCtx) {
     newSeries->duplicatePolicy = cCtx->duplicatePolicy;
     newSeries->ignoreMaxTimeDiff = cCtx->ignoreMaxTimeDiff;
     newSeries->ignoreMaxValDiff = cCtx->ignoreMaxValDiff;
+    newSeries->accumulateWindow = cCtx->accumulateWindow;
     newSeries->in_ram = true;
 
     if (newSeries->options & SERIES_OPT_UNCOMPRESSED) {
         newSeries->options |= SERIES_OPT_UNCOMPRESSED;
         newSeries->funcs = GetChunkClass(CHUNK_REGULAR);
+    } else if (newSeries->options & SERIES_OPT_COMPRESSED_DECIMAL) {
+        newSeries->funcs = GetChunkClass(CHUNK_DECIMAL);
+    } else if (newSeries->options & SERIES_OPT_COMPRESSED_CHIMP) {
+        newSeries->funcs = GetChunkClass(CHUNK_CHIMP);
     } else {
         newSeries->options |= SERIES_OPT_COMPRESSED_GORILLA;
         newSeries->funcs = GetChunkClass(CHUNK_COMPRESSED);
@@ -395,6 +625,18 @@ cleanup:
     renameFromKey = NULL;
 }
 
+// A series moved or copied to another database does its deferred work there, opening it records
+// the database. The rules which resolved it are left in the other database.
+void SeriesMovedTo(RedisModuleCtx *ctx, RedisModuleString *keyname) {
+    Series *series;
+    RedisModuleKey *key = NULL;
+    if (GetSeries(ctx, keyname, &key, &series, REDISMODULE_READ, GetSeriesFlags_SilentOperation) ==
+        GetSeriesResult_Success) {
+        SeriesUnlinkRules(series);
+        RedisModule_CloseKey(key);
+    }
+}
+
 void *CopySeries(RedisModuleString *fromkey, RedisModuleString *tokey, const void *value) {
     Series *src = (Series *)value;
     Series *dst = (Series *)calloc(1, sizeof(Series));
@@ -429,6 +671,18 @@ void *CopySeries(RedisModuleString *fromkey, RedisModuleString *tokey, const voi
 
     dst->srcKey = NULL;
     dst->rules = NULL;
+    dst->srcRule = NULL;
+    dst->dirtyPos = 0;
+    // the copy goes on summing the open window of the source
+    dst->accumulatorPos = 0;
+    if (src->accumulatorPos != 0) {
+        seriesListAdd(&accumulatingSeries, dst);
+    }
+    // the clones of the chunks which the source didn't seal yet aren't sealed either
+    dst->sealPos = 0;
+    if (src->sealPos != 0) {
+        SeriesDeferChunkSealing(dst, src->unsealedFrom);
+    }
 
     RemoveIndexedMetric(tokey); // in case of replace
     if (dst->labelsCount > 0) {
@@ -447,6 +701,13 @@ void *CopySeries(RedisModuleString *fromkey, RedisModuleString *tokey, const voi
 // notification.
 void FreeSeries(void *value) {
     Series *series = (Series *)value;
+    // the rules of other series may have resolved it
+    if (series->srcRule != NULL) {
+        unlinkRuleDest(series->srcRule);
+    }
+    seriesListRemove(&dirtySeries, series);
+    seriesListRemove(&accumulatingSeries, series);
+    seriesListRemove(&sealingSeries, series);
     RedisModuleDictIter *iter = RedisModule_DictIteratorStartC(series->chunks, "^", NULL, 0);
     Chunk_t *currentChunk;
     while (RedisModule_DictNextC(iter, NULL, (void *)&currentChunk) != NULL) {
@@ -480,10 +741,23 @@ int DefragSeries(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value
 
     // first defrag of this key
     if (seekTo == NULL) {
-        series = defragPtr(ctx, series);
+        Series *moved = defragPtr(ctx, series);
+        if (moved != series) {
+            // the rule which resolved the series and the dirty series list point to it
+            if (moved->srcRule != NULL) {
+                moved->srcRule->destSeries = moved;
+            }
+            seriesListMoved(&dirtySeries, moved);
+            seriesListMoved(&accumulatingSeries, moved);
+            seriesListMoved(&sealingSeries, moved);
+            series = moved;
+        }
 
-        for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
-            rule = defragPtr(ctx, rule);
+        for (CompactionRule **rule = &series->rules; *rule != NULL; rule = &(*rule)->nextRule) {
+            *rule = defragPtr(ctx, *rule);
+            if ((*rule)->destSeries != NULL) {
+                (*rule)->destSeries->srcRule = *rule;
+            }
         }
 
         series->labels = defragPtr(ctx, series->labels);
@@ -512,8 +786,11 @@ int DefragSeries(RedisModuleDefragCtx *ctx, RedisModuleString *key, void **value
 
 void FreeCompactionRule(void *value) {
     CompactionRule *rule = (CompactionRule *)value;
+    unlinkRuleDest(rule);
     RedisModule_FreeString(NULL, rule->destKey);
     ((AggregationClass *)rule->aggClass)->freeContext(rule->aggContext);
+    free(rule->dirtyBuckets);
+    free(rule->bucketUpdates);
     free(rule);
 }
 
@@ -527,6 +804,16 @@ size_t SeriesChunksSize(const Series *series) {
     return chunksSize;
 }
 
+size_t SeriesCheckpointsSize(const Series *series) {
+    size_t checkpointsSize = 0;
+    RedisModuleDictIter *iter = RedisModule_DictIteratorStartC(series->chunks, "^", NULL, 0);
+    for (const Chunk_t *currentChunk; RedisModule_DictNextC(iter, NULL, (void *)&currentChunk);) {
+        checkpointsSize += series->funcs->GetCheckpointsSize(currentChunk);
+    }
+    RedisModule_DictIteratorStop(iter);
+    return checkpointsSize;
+}
+
 size_t SeriesLabelsSize(const Series *series) {
     size_t labelsSize = series->labels ? RedisModule_MallocSize(series->labels) : 0;
     for (size_t i = 0; i < series->labelsCount; ++i) {
@@ -591,19 +878,18 @@ static bool RuleSeriesUpsertSample(RedisModuleCtx *ctx,
                                    timestamp_t start,
                                    double val) {
     RedisModuleKey *key;
-    Series *destSeries;
-    if (GetSeries(ctx,
-                  rule->destKey,
-                  &key,
-                  &destSeries,
-                  REDISMODULE_READ | REDISMODULE_WRITE,
-                  GetSeriesFlags_CheckForAcls) != GetSeriesResult_Success) {
+    Series *destSeries = SeriesOpenRuleDest(ctx, rule, &key);
+    if (destSeries == NULL) {
         RedisModule_Log(ctx, "verbose", "%s", "Failed to retrieve downsample series");
         return false;
     }
 
-    if (destSeries->totalSamples == 0) {
+    if (destSeries->totalSamples == 0 || start > destSeries->lastTimestamp) {
+        // a new bucket of the destination, it feeds the destination's own rules like any
+        // appended sample
         SeriesAddSample(destSeries, start, val);
+        const Sample sample = { .timestamp = start, .value = val };
+        HandleCompactions(ctx, destSeries, &sample, 1);
     } else {
         SeriesUpsertSample(destSeries, start, val, DP_LAST);
     }
@@ -612,52 +898,362 @@ static bool RuleSeriesUpsertSample(RedisModuleCtx *ctx,
     return true;
 }
 
-static void upsertCompaction(Series *series, UpsertCtx *uCtx) {
-    if (series->rules == NULL) {
+// Marks the bucket which holds an updated timestamp for recomputation
+static void markRuleBucketDirty(Series *series, CompactionRule *rule, timestamp_t upsertTimestamp) {
+    const timestamp_t ruleTimebucket = rule->bucketDuration;
+    const timestamp_t curAggWindowStart =
+        CalcBucketStart(series->lastTimestamp, ruleTimebucket, rule->timestampAlignment);
+    if (upsertTimestamp >= BucketStartNormalize(curAggWindowStart)) {
+        // upsert in latest timebucket
+        rule->dirtyCurrentBucket = true;
+        rule->dirtyCurrentBucketStart = curAggWindowStart;
+    } else {
+        const timestamp_t start =
+            CalcBucketStart(upsertTimestamp, ruleTimebucket, rule->timestampAlignment);
+        if (rule->dirtyBucketsCount > 0 &&
+            rule->dirtyBuckets[rule->dirtyBucketsCount - 1] == start) {
+            return;
+        }
+        if (rule->dirtyBucketsCount == rule->dirtyBucketsCapacity) {
+            rule->dirtyBucketsCapacity =
+                rule->dirtyBucketsCapacity ? rule->dirtyBucketsCapacity * 2 : 8;
+            rule->dirtyBuckets = realloc(rule->dirtyBuckets,
+                                         rule->dirtyBucketsCapacity * sizeof(timestamp_t));
+        }
+        rule->dirtyBuckets[rule->dirtyBucketsCount++] = start;
+    }
+    addDirtySeries(series);
+}
+
+// A bucket start is negative when the bucket begins before the alignment of the first bucket
+static int cmpBucketStart(const void *a, const void *b) {
+    const int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmpBucketUpdate(const void *a, const void *b) {
+    const BucketUpdate *x = a, *y = b;
+    const int rv = cmpBucketStart(&x->start, &y->start);
+    return rv != 0 ? rv : (x->pos > y->pos) - (x->pos < y->pos);
+}
+
+static bool isDirtyBucket(const CompactionRule *rule, timestamp_t start) {
+    return bsearch(&start,
+                   rule->dirtyBuckets,
+                   rule->dirtyBucketsCount,
+                   sizeof(timestamp_t),
+                   cmpBucketStart) != NULL;
+}
+
+// Merges the upserted samples of a bucket into the bucket's value in the destination
+static bool mergeBucketUpdates(const CompactionRule *rule,
+                               const BucketUpdate *updates,
+                               size_t n_updates,
+                               double *value) {
+    const timestamp_t startNormalized = BucketStartNormalize(updates[0].start);
+    if (rule->destSeries == NULL) {
+        return false;
+    }
+    const RangeArgs args = {
+        .startTimestamp = startNormalized,
+        .endTimestamp = startNormalized,
+        .aggregationArgs = { 0 },
+        .filterByValueArgs = { 0 },
+        .filterByTSArgs = { 0 },
+    };
+    Sample sample;
+    AbstractSampleIterator *iterator =
+        SeriesCreateSampleIterator(rule->destSeries, &args, false, false);
+    const bool found = iterator->GetNext(iterator, &sample) == CR_OK;
+    iterator->Close(iterator);
+    if (!found) {
+        return false;
+    }
+
+    const AggregationClass *aggClass = rule->aggClass;
+    *value = sample.value;
+    for (size_t i = 0; i < n_updates; ++i) {
+        const BucketUpdate *update = &updates[i];
+        if (update->overridden && !aggClass->retractFinalized(value, update->overriddenValue)) {
+            return false;
+        }
+        if (!aggClass->mergeFinalized(value, update->value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Applies the merged updates of the buckets which weren't recalculated, a bucket which can't be
+// merged is recalculated
+static void applyBucketUpdates(RedisModuleCtx *ctx, Series *series, CompactionRule *rule) {
+    BucketUpdate *updates = rule->bucketUpdates;
+    const size_t n_updates = rule->bucketUpdatesCount;
+    if (n_updates == 0) {
         return;
     }
-    const GetSeriesFlags flags = GetSeriesFlags_SilentOperation | GetSeriesFlags_CheckForAcls;
-    deleteReferenceToDeletedSeries(rts_staticCtx, series, flags);
-    CompactionRule *rule = series->rules;
-    const timestamp_t upsertTimestamp = uCtx->sample.timestamp;
-    const timestamp_t seriesLastTimestamp = series->lastTimestamp;
-    while (rule != NULL) {
-        const timestamp_t ruleTimebucket = rule->bucketDuration;
-        const timestamp_t curAggWindowStart =
-            CalcBucketStart(seriesLastTimestamp, ruleTimebucket, rule->timestampAlignment);
-        const timestamp_t curAggWindowStartNormalized = BucketStartNormalize(curAggWindowStart);
-        if (upsertTimestamp >= curAggWindowStartNormalized) {
-            // upsert in latest timebucket
-            const int rv = SeriesCalcRange(series,
-                                           curAggWindowStartNormalized,
-                                           curAggWindowStart + ruleTimebucket - 1,
-                                           rule,
-                                           NULL,
-                                           NULL);
-            if (rv == TSDB_ERROR) {
-                RedisModule_Log(
-                    rts_staticCtx, "verbose", "%s", "Failed to calculate range for downsample");
-                continue;
-            }
+    qsort(updates, n_updates, sizeof(BucketUpdate), cmpBucketUpdate);
+    for (size_t i = 0, j; i < n_updates; i = j) {
+        const timestamp_t start = updates[i].start;
+        for (j = i + 1; j < n_updates && updates[j].start == start; ++j) {
+        }
+        if (isDirtyBucket(rule, start)) {
+            continue;
+        }
+        const timestamp_t startNormalized = BucketStartNormalize(start);
+        double val = 0;
+        if (!mergeBucketUpdates(rule, &updates[i], j - i, &val) &&
+            SeriesCalcRange(series,
+                            startNormalized,
+                            start + rule->bucketDuration - 1,
+                            rule,
+                            &val,
+                            NULL) == TSDB_ERROR) {
+            RedisModule_Log(
+                ctx, "verbose", "%s", "Failed to calculate range for downsample");
+            continue;
+        }
+        RuleSeriesUpsertSample(ctx, series, rule, startNormalized, val);
+    }
+    rule->bucketUpdatesCount = 0;
+}
+
+// Recalculates the dirty buckets of a rule, each one once, then merges the updates of the others
+static void recomputeRuleBuckets(RedisModuleCtx *ctx, Series *series, CompactionRule *rule) {
+    const timestamp_t ruleTimebucket = rule->bucketDuration;
+    if (rule->dirtyCurrentBucket) {
+        rule->dirtyCurrentBucket = false;
+        const timestamp_t start = rule->dirtyCurrentBucketStart;
+        const int rv = SeriesCalcRange(
+            series, BucketStartNormalize(start), start + ruleTimebucket - 1, rule, NULL, NULL);
+        if (rv == TSDB_ERROR) {
+            RedisModule_Log(
+                ctx, "verbose", "%s", "Failed to calculate range for downsample");
+        }
+    }
+
+    qsort(rule->dirtyBuckets, rule->dirtyBucketsCount, sizeof(timestamp_t), cmpBucketStart);
+    for (size_t i = 0; i < rule->dirtyBucketsCount; ++i) {
+        const timestamp_t start = rule->dirtyBuckets[i];
+        if (i > 0 && start == rule->dirtyBuckets[i - 1]) {
+            continue;
+        }
+        const timestamp_t startNormalized = BucketStartNormalize(start);
+        // ensure last include/exclude
+        double val = 0;
+        const int rv =
+            SeriesCalcRange(series, startNormalized, start + ruleTimebucket - 1, rule, &val, NULL);
+        if (rv == TSDB_ERROR) {
+            RedisModule_Log(
+                ctx, "verbose", "%s", "Failed to calculate range for downsample");
+            continue;
+        }
+        RuleSeriesUpsertSample(ctx, series, rule, startNormalized, val);
+    }
+    applyBucketUpdates(ctx, series, rule);
+    rule->dirtyBucketsCount = 0;
+}
+
+// The deferred work of a series runs in a detached context of its own, in the database of the
+// series. The module context is shared with the LibMR threads, its database is left alone.
+RedisModuleCtx *rts_deferredCtx = NULL;
+
+static RedisModuleCtx *seriesDeferredCtx(const Series *series) {
+    if (rts_deferredCtx == NULL) {
+        rts_deferredCtx = RedisModule_GetDetachedThreadSafeContext(rts_staticCtx);
+    }
+    RedisModule_SelectDb(rts_deferredCtx, series->db);
+    return rts_deferredCtx;
+}
+
+void SeriesRecomputeDirtyRules(Series *series) {
+    if (series->dirtyPos == 0) {
+        return;
+    }
+    seriesListRemove(&dirtySeries, series);
+    RedisModuleCtx *ctx = seriesDeferredCtx(series);
+    SeriesResolveRules(ctx, series);
+    for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        recomputeRuleBuckets(ctx, series, rule);
+    }
+}
+
+// Recomputing a bucket upserts it to the destination, which may mark the buckets of a cascaded
+// rule dirty in turn
+void RecomputeDirtyCompactions(void) {
+    while (dirtySeries.count > 0) {
+        SeriesRecomputeDirtyRules(dirtySeries.series[dirtySeries.count - 1]);
+    }
+}
+
+// An increment opens the window which holds its timestamp, from the last value of the series
+int SeriesAccumulate(RedisModuleCtx *ctx,
+                     Series *series,
+                     timestamp_t timestamp,
+                     double delta,
+                     timestamp_t *windowStart) {
+    const timestamp_t start = CalcBucketStart(timestamp, series->accumulateWindow, 0);
+    if (series->accumulatorPos != 0) {
+        if (start == series->accumulator.timestamp) {
+            series->accumulator.value += delta;
+            *windowStart = start;
+            return TSDB_OK;
+        }
+        if (start < series->accumulator.timestamp) {
+            return TSDB_ERROR;
+        }
+        SeriesFlushAccumulator(ctx, series);
+    }
+    if (series->totalSamples != 0 && start < series->lastTimestamp) {
+        return TSDB_ERROR;
+    }
+
+    const Sample window = { .timestamp = start, .value = series->lastValue + delta };
+    SeriesOpenAccumulator(series, window);
+    *windowStart = start;
+    return TSDB_OK;
+}
+
+// The timer waits for the earliest deadline of the open windows, 0 if it isn't pending. A far
+// deadline is waited for in steps, a timer's period can't be arbitrarily long.
+#define ACCUMULATOR_TIMER_MAX_DELAY (24 * 3600 * 1000)
+static RedisModuleTimerID accumulatorTimer;
+static mstime_t accumulatorTimerDue = 0;
+
+static void accumulatorTimerCallback(RedisModuleCtx *ctx, void *data);
+
+static void armAccumulatorTimer(mstime_t deadline) {
+    if (accumulatorTimerDue != 0) {
+        if (accumulatorTimerDue <= deadline) {
+            return;
+        }
+        RedisModule_StopTimer(rts_staticCtx, accumulatorTimer, NULL);
+    }
+    const mstime_t now = RedisModule_Milliseconds();
+    const mstime_t delay = min(deadline > now ? deadline - now : 0, ACCUMULATOR_TIMER_MAX_DELAY);
+    accumulatorTimer =
+        RedisModule_CreateTimer(rts_staticCtx, delay, accumulatorTimerCallback, NULL);
+    accumulatorTimerDue = now + delay;
+}
+
+// The windows are written in the module context, in the database of their series, the writes
+// don't depend on the client which happens to run when they're due
+static void accumulatorTimerCallback(RedisModuleCtx *ctx, void *data) {
+    accumulatorTimerDue = 0;
+    const mstime_t now = RedisModule_Milliseconds();
+    mstime_t nextDeadline = LLONG_MAX;
+    // a written window is replaced by the last one, which was already visited
+    for (size_t i = accumulatingSeries.count; i > 0; --i) {
+        Series *series = accumulatingSeries.series[i - 1];
+        if (series->accumulatorDeadline <= now) {
+            SeriesFlushAccumulator(seriesDeferredCtx(series), series);
         } else {
-            const timestamp_t start =
-                CalcBucketStart(upsertTimestamp, ruleTimebucket, rule->timestampAlignment);
-            const timestamp_t startNormalized = BucketStartNormalize(start);
-            // ensure last include/exclude
-            double val = 0;
-            const int rv = SeriesCalcRange(
-                series, startNormalized, start + ruleTimebucket - 1, rule, &val, NULL);
-            if (rv == TSDB_ERROR) {
-                RedisModule_Log(
-                    rts_staticCtx, "verbose", "%s", "Failed to calculate range for downsample");
-                continue;
-            }
+            nextDeadline = min(nextDeadline, series->accumulatorDeadline);
+        }
+    }
+    if (accumulatingSeries.count > 0) {
+        armAccumulatorTimer(nextDeadline);
+    }
+    if (TSGlobalConfig.compactionRecomputeInterval == 0) {
+        RecomputeDirtyCompactions();
+    }
+}
 
-            if (!RuleSeriesUpsertSample(rts_staticCtx, series, rule, startNormalized, val)) {
-                continue;
-            }
+// Opens a window of an accumulating series, or restores one which was saved open
+void SeriesOpenAccumulator(Series *series, Sample window) {
+    const mstime_t now = RedisModule_Milliseconds();
+    series->accumulator = window;
+    series->accumulatorDeadline = (mstime_t)series->accumulateWindow > LLONG_MAX - now
+                                      ? LLONG_MAX
+                                      : now + (mstime_t)series->accumulateWindow;
+    seriesListAdd(&accumulatingSeries, series);
+    armAccumulatorTimer(series->accumulatorDeadline);
+}
+
+void SeriesFlushAccumulator(RedisModuleCtx *ctx, Series *series) {
+    if (series->accumulatorPos == 0) {
+        return;
+    }
+    seriesListRemove(&accumulatingSeries, series);
+    const Sample sample = series->accumulator;
+    if (series->totalSamples != 0 && sample.timestamp <= series->lastTimestamp) {
+        SeriesUpsertSample(series, sample.timestamp, sample.value, DP_LAST);
+    } else {
+        SeriesAddSample(series, sample.timestamp, sample.value);
+        HandleCompactions(ctx, series, &sample, 1);
+    }
+}
+
+void FlushAccumulators(void) {
+    while (accumulatingSeries.count > 0) {
+        Series *series = accumulatingSeries.series[accumulatingSeries.count - 1];
+        SeriesFlushAccumulator(seriesDeferredCtx(series), series);
+    }
+}
+
+static void addBucketUpdate(CompactionRule *rule, timestamp_t start, const UpsertCtx *uCtx) {
+    if (rule->bucketUpdatesCount == rule->bucketUpdatesCapacity) {
+        rule->bucketUpdatesCapacity =
+            rule->bucketUpdatesCapacity ? rule->bucketUpdatesCapacity * 2 : 8;
+        rule->bucketUpdates =
+            realloc(rule->bucketUpdates, rule->bucketUpdatesCapacity * sizeof(BucketUpdate));
+    }
+    rule->bucketUpdates[rule->bucketUpdatesCount] = (BucketUpdate){
+        .start = start,
+        .value = uCtx->sample.value,
+        .overriddenValue = uCtx->overriddenValue,
+        .overridden = uCtx->overridden,
+        .pos = rule->bucketUpdatesCount,
+    };
+    rule->bucketUpdatesCount++;
+}
+
+// Updates the aggregation of the bucket which holds an upserted sample from the sample itself
+// (and the sample it replaced) when the aggregation supports it, otherwise marks the bucket for
+// recalculation
+static void upsertRuleSample(Series *series, CompactionRule *rule, const UpsertCtx *uCtx) {
+    const AggregationClass *aggClass = rule->aggClass;
+    const timestamp_t ts = uCtx->sample.timestamp;
+    const timestamp_t curAggWindowStart =
+        CalcBucketStart(series->lastTimestamp, rule->bucketDuration, rule->timestampAlignment);
+    if (uCtx->overriddenUnknown) {
+        // the sample it replaced, if any, isn't known
+        markRuleBucketDirty(series, rule, ts);
+        return;
+    }
+    if (ts >= BucketStartNormalize(curAggWindowStart)) {
+        // the context holds the samples of the current bucket unless it's recalculated anyway
+        if (!rule->dirtyCurrentBucket && aggClass->retractValue &&
+            rule->startCurrentTimeBucket == BucketStartNormalize(curAggWindowStart) &&
+            (!uCtx->overridden ||
+             aggClass->retractValue(rule->aggContext, uCtx->overriddenValue))) {
+            aggClass->appendValue(rule->aggContext, uCtx->sample.value, ts);
+            return;
+        }
+    } else if (aggClass->mergeFinalized) {
+        addBucketUpdate(
+            rule, CalcBucketStart(ts, rule->bucketDuration, rule->timestampAlignment), uCtx);
+        addDirtySeries(series);
+        return;
+    }
+    markRuleBucketDirty(series, rule, ts);
+}
+
+static void upsertCompaction(Series *series, UpsertCtx *uCtx) {
+    if (uCtx->overridden && uCtx->overriddenValue == uCtx->sample.value) {
+        return; // nothing changed
+    }
+    for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        upsertRuleSample(series, rule, uCtx);
+    }
+}
+
+// Marks the buckets which hold the updated timestamps, which are sorted
+static void upsertCompactionBuckets(Series *series, const Sample *samples, size_t n_samples) {
+    for (CompactionRule *rule = series->rules; rule != NULL; rule = rule->nextRule) {
+        for (size_t i = 0; i < n_samples; ++i) {
+            markRuleBucketDirty(series, rule, samples[i].timestamp);
         }
-        rule = rule->nextRule;
     }
 }
 
@@ -703,10 +1299,14 @@ int SeriesUpsertSample(Series *series,
 
     // Split chunks
     if (funcs->GetChunkSize(chunk, false) > series->chunkSizeBytes * SPLIT_FACTOR) {
+        const uint64_t numSamples = funcs->GetNumOfSample(chunk);
         Chunk_t *newChunk = funcs->SplitChunk(chunk);
         if (newChunk == NULL) {
             return REDISMODULE_ERR;
         }
+        // the split merges the out of order samples
+        series->totalSamples -=
+            numSamples - funcs->GetNumOfSample(chunk) - funcs->GetNumOfSample(newChunk);
         timestamp_t newChunkFirstTS = funcs->GetFirstTimestamp(newChunk);
         dictOperator(series->chunks, newChunk, newChunkFirstTS, DICT_OP_SET);
         if (timestamp >= newChunkFirstTS) {
@@ -742,28 +1342,196 @@ int SeriesUpsertSample(Series *series,
 }
 
 int SeriesAddSample(Series *series, api_timestamp_t timestamp, double value) {
-    // backfilling or update
     Sample sample = {
         .timestamp = timestamp,
         .value = value,
     };
-    ChunkResult ret = series->funcs->AddSample(series->lastChunk, &sample);
+    return SeriesAddSamples(series, &sample, 1);
+}
+
+// Appends a run of samples with increasing timestamps, all newer than the last sample of the series
+int SeriesAddSamples(Series *series, Sample *samples, size_t n_samples) {
+    if (n_samples == 0) {
+        return TSDB_OK;
+    }
+    ChunkResult (*AddSample)(Chunk_t *, Sample *) = series->funcs->AddSample;
+    for (size_t i = 0; i < n_samples; ++i) {
+        Sample *sample = &samples[i];
+        ChunkResult ret = AddSample(series->lastChunk, sample);
 
-    if (ret == CR_END) {
-        // When a new chunk is created trim the series
-        SeriesTrim(series, 0, 0);
+        if (unlikely(ret == CR_END)) {
+            // When a new chunk is created trim the series
+            SeriesTrim(series, 0, 0);
 
-        Chunk_t *newChunk = series->funcs->NewChunk(series->chunkSizeBytes);
-        dictOperator(series->chunks, newChunk, timestamp, DICT_OP_SET);
-        ret = series->funcs->AddSample(newChunk, &sample);
-        series->lastChunk = newChunk;
+            if (TSGlobalConfig.chunkSealing == CHUNK_SEALING_INLINE) {
+                SeriesSealChunk(series, series->lastChunk);
+            } else {
+                Chunk_t *fullChunk = series->lastChunk;
+                SeriesDeferChunkSealing(series, series->funcs->GetFirstTimestamp(fullChunk));
+            }
+
+            Chunk_t *newChunk = series->funcs->NewChunk(series->chunkSizeBytes);
+            dictOperator(series->chunks, newChunk, sample->timestamp, DICT_OP_SET);
+            ret = AddSample(newChunk, sample);
+            series->lastChunk = newChunk;
+        }
+        // the trimming of the next chunk depends on the last timestamp and the count
+        series->lastTimestamp = sample->timestamp;
+        series->totalSamples++;
     }
-    series->lastTimestamp = timestamp;
-    series->lastValue = value;
-    series->totalSamples++;
+    series->lastValue = samples[n_samples - 1].value;
     return TSDB_OK;
 }
 
+// Merges the samples of a chunk with sorted new samples, a duplicate timestamp is resolved by the
+// duplicate policy. Returns the number of merged samples, *accepted counts the new samples which
+// were added or updated.
+static size_t mergeChunkSamples(const Samples *old,
+                                const Sample *samples,
+                                size_t n_samples,
+                                DuplicatePolicy dp_policy,
+                                Sample *out,
+                                size_t *accepted) {
+    size_t i = 0, j = 0, n_out = 0;
+    while (i < old->num_samples || j < n_samples) {
+        if (j == n_samples ||
+            (i < old->num_samples && old->timestamps[i] < samples[j].timestamp)) {
+            out[n_out++] = (Sample){ .timestamp = old->timestamps[i], .value = old->values[i] };
+            ++i;
+            continue;
+        }
+        if (i < old->num_samples && old->timestamps[i] == samples[j].timestamp) {
+            out[n_out++] = (Sample){ .timestamp = old->timestamps[i], .value = old->values[i] };
+            ++i;
+        }
+        Sample sample = samples[j++];
+        if (n_out > 0 && out[n_out - 1].timestamp == sample.timestamp) {
+            if (handleDuplicateSample(dp_policy, out[n_out - 1], &sample) != CR_OK) {
+                continue;
+            }
+            out[n_out - 1].value = sample.value;
+        } else {
+            out[n_out++] = sample;
+        }
+        ++(*accepted);
+    }
+    return n_out;
+}
+
+// Inserts merged samples as new chunks in place of a chunk, returns the last new chunk
+static Chunk_t *replaceChunk(Series *series,
+                             const timestamp_t *chunkKey,
+                             Chunk_t *chunk,
+                             Sample *samples,
+                             size_t n_samples) {
+    const ChunkFuncs *funcs = series->funcs;
+    RedisModule_DictDelC(series->chunks, (void *)chunkKey, sizeof(*chunkKey), NULL);
+    funcs->FreeChunk(chunk);
+
+    Chunk_t *newChunk = funcs->NewChunk(series->chunkSizeBytes);
+    dictOperator(series->chunks, newChunk, samples[0].timestamp, DICT_OP_SET);
+    for (size_t i = 0; i < n_samples; ++i) {
+        if (unlikely(funcs->AddSample(newChunk, &samples[i]) == CR_END)) {
+            if (TSGlobalConfig.chunkSealing == CHUNK_SEALING_INLINE) {
+                funcs->SealChunk(newChunk);
+            } else {
+                SeriesDeferChunkSealing(series, funcs->GetFirstTimestamp(newChunk));
+            }
+            newChunk = funcs->NewChunk(series->chunkSizeBytes);
+            dictOperator(series->chunks, newChunk, samples[i].timestamp, DICT_OP_SET);
+            funcs->AddSample(newChunk, &samples[i]);
+        }
+    }
+    return newChunk;
+}
+
+// Merges sorted samples which are not newer than the last sample of the series. Each chunk which
+// overlaps the samples is decoded once and re-encoded with them, and each affected compaction
+// bucket is recalculated once. Returns the number of samples which were added or updated.
+size_t SeriesMergeSamples(Series *series,
+                          const Sample *samples,
+                          size_t n_samples,
+                          DuplicatePolicy dp_policy) {
+    if (n_samples == 0 || series->totalSamples == 0) {
+        return 0;
+    }
+    const ChunkFuncs *funcs = series->funcs;
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    Sample *merged = NULL;
+    size_t mergedSize = 0;
+    size_t accepted = 0;
+
+    size_t i = 0;
+    while (i < n_samples) {
+        // find the chunk of the sample and where the next chunk starts
+        timestamp_t rax_key;
+        seriesEncodeTimestamp(&rax_key, samples[i].timestamp);
+        RedisModuleDictIter *dictIter =
+            RedisModule_DictIteratorStartC(series->chunks, "<=", &rax_key, sizeof(rax_key));
+        Chunk_t *chunk = NULL;
+        size_t keyLen;
+        void *key = RedisModule_DictNextC(dictIter, &keyLen, (void *)&chunk);
+        if (key == NULL) {
+            RedisModule_DictIteratorReseekC(dictIter, "^", NULL, 0);
+            key = RedisModule_DictNextC(dictIter, &keyLen, (void *)&chunk);
+        }
+        if (key == NULL) {
+            RedisModule_DictIteratorStop(dictIter);
+            break;
+        }
+        timestamp_t chunkKey;
+        memcpy(&chunkKey, key, sizeof(chunkKey));
+        timestamp_t nextChunkStart = UINT64_MAX;
+        void *nextKey = RedisModule_DictNextC(dictIter, NULL, NULL);
+        if (nextKey != NULL) {
+            memcpy(&nextChunkStart, nextKey, sizeof(nextChunkStart));
+            nextChunkStart = ntohu64(nextChunkStart);
+        }
+        RedisModule_DictIteratorStop(dictIter);
+
+        size_t end = i;
+        while (end < n_samples && samples[end].timestamp < nextChunkStart) {
+            ++end;
+        }
+
+        const uint64_t chunkSamples = funcs->GetNumOfSample(chunk);
+        if (chunkSamples > enrichedChunk->samples.size) {
+            ReallocSamplesArray(&enrichedChunk->samples, chunkSamples);
+        }
+        ResetEnrichedChunk(enrichedChunk);
+        if (chunkSamples > 0) {
+            funcs->ProcessChunk(chunk, 0, UINT64_MAX, enrichedChunk, false);
+        }
+        if (chunkSamples + (end - i) > mergedSize) {
+            mergedSize = chunkSamples + (end - i);
+            merged = realloc(merged, mergedSize * sizeof(*merged));
+        }
+        const size_t acceptedBefore = accepted;
+        const size_t n_merged = mergeChunkSamples(
+            &enrichedChunk->samples, &samples[i], end - i, dp_policy, merged, &accepted);
+        if (accepted == acceptedBefore) {
+            // all the samples were blocked, the chunk is left as is
+            i = end;
+            continue;
+        }
+
+        const bool lastChunk = chunk == series->lastChunk;
+        Chunk_t *newChunk = replaceChunk(series, &chunkKey, chunk, merged, n_merged);
+        series->totalSamples += n_merged - chunkSamples;
+        if (lastChunk) {
+            series->lastChunk = newChunk;
+            series->lastValue = merged[n_merged - 1].value;
+        }
+        i = end;
+    }
+
+    free(merged);
+    FreeEnrichedChunk(enrichedChunk);
+
+    upsertCompactionBuckets(series, samples, n_samples);
+    return accepted;
+}
+
 static int ContinuousDeletion(RedisModuleCtx *ctx,
                               Series *series,
                               CompactionRule *rule,
@@ -989,6 +1757,8 @@ static void CompactionDelRange(Series *series,
 }
 
 size_t SeriesDelRange(Series *series, timestamp_t start_ts, timestamp_t end_ts) {
+    // the current bucket of the dirty rules may be moved by the deletion
+    SeriesRecomputeDirtyRules(series);
     // start iterator from smallest key
     RedisModuleDictIter *iter = RedisModule_DictIteratorStartC(series->chunks, "^", NULL, 0);
 
@@ -996,6 +1766,8 @@ size_t SeriesDelRange(Series *series, timestamp_t start_ts, timestamp_t end_ts)
     void *currentKey;
     size_t keyLen;
     size_t deletedSamples = 0;
+    // the chunk counts removed from the series, a deletion merges the out of order samples
+    size_t removedSamples = 0;
     const ChunkFuncs *funcs = series->funcs;
     while ((currentKey = RedisModule_DictNextC(iter, &keyLen, (void *)&currentChunk))) {
         // We deleted the latest samples, no more chunks/samples to delete or cur chunk start_ts is
@@ -1011,7 +1783,7 @@ size_t SeriesDelRange(Series *series, timestamp_t start_ts, timestamp_t end_ts)
         }
 
         bool is_only_chunk =
-            ((funcs->GetNumOfSample(currentChunk) + deletedSamples) == series->totalSamples);
+            ((funcs->GetNumOfSample(currentChunk) + removedSamples) == series->totalSamples);
         // Should we delete the all chunk?
         bool ts_delCondition =
             (funcs->GetFirstTimestamp(currentChunk) >= start_ts &&
@@ -1020,7 +1792,9 @@ size_t SeriesDelRange(Series *series, timestamp_t start_ts, timestamp_t end_ts)
 
         if (!ts_delCondition) {
             timestamp_t chunkFirstTS = funcs->GetFirstTimestamp(currentChunk);
+            const uint64_t numSamples = funcs->GetNumOfSample(currentChunk);
             deletedSamples += funcs->DelRange(currentChunk, start_ts, end_ts);
+            removedSamples += numSamples - funcs->GetNumOfSample(currentChunk);
             timestamp_t chunkFirstTSAfterOp = funcs->GetFirstTimestamp(currentChunk);
             if (chunkFirstTSAfterOp != chunkFirstTS) {
                 update_chunk_in_dict(
@@ -1037,6 +1811,7 @@ size_t SeriesDelRange(Series *series, timestamp_t start_ts, timestamp_t end_ts)
         bool isLastChunkDeleted = (currentChunk == series->lastChunk);
         RedisModule_DictDelC(series->chunks, currentKey, keyLen, NULL);
         deletedSamples += funcs->GetNumOfSample(currentChunk);
+        removedSamples += funcs->GetNumOfSample(currentChunk);
         funcs->FreeChunk(currentChunk);
 
         if (isLastChunkDeleted) {
@@ -1052,7 +1827,7 @@ size_t SeriesDelRange(Series *series, timestamp_t start_ts, timestamp_t end_ts)
         // go to first element that is bigger than current key
         RedisModule_DictIteratorReseekC(iter, ">", currentKey, keyLen);
     }
-    series->totalSamples -= deletedSamples;
+    series->totalSamples -= removedSamples;
 
     RedisModule_DictIteratorStop(iter);
 
@@ -1171,7 +1946,8 @@ int SeriesCreateRulesFromGlobalConfig(RedisModuleCtx *ctx,
 
         int rules_options = TSGlobalConfig.options;
         rules_options &= ~SERIES_OPT_DEFAULT_COMPRESSION;
-        rules_options &= SERIES_OPT_UNCOMPRESSED;
+        rules_options &=
+            SERIES_OPT_UNCOMPRESSED | SERIES_OPT_COMPRESSED_DECIMAL | SERIES_OPT_COMPRESSED_CHIMP;
 
         CreateCtx cCtx = {
             .retentionTime = rule->retentionSizeMillisec,
@@ -1210,6 +1986,15 @@ CompactionRule *NewRule(RedisModuleString *destKey,
     rule->destKey = destKey;
     rule->startCurrentTimeBucket = -1LL;
     rule->nextRule = NULL;
+    rule->destSeries = NULL;
+    rule->dirtyBuckets = NULL;
+    rule->dirtyBucketsCount = 0;
+    rule->dirtyBucketsCapacity = 0;
+    rule->dirtyCurrentBucket = false;
+    rule->dirtyCurrentBucketStart = 0;
+    rule->bucketUpdates = NULL;
+    rule->bucketUpdatesCount = 0;
+    rule->bucketUpdatesCapacity = 0;
 
     return rule;
 }
@@ -1245,6 +2030,9 @@ bool SeriesDeleteSrcRule(Series *series, RedisModuleString *srctKey) {
     if (RMUtil_StringEquals(series->srcKey, srctKey)) {
         RedisModule_FreeString(NULL, series->srcKey);
         series->srcKey = NULL;
+        if (series->srcRule != NULL) {
+            unlinkRuleDest(series->srcRule);
+        }
         return true;
     }
     return false;
@@ -1359,10 +2147,11 @@ timestamp_t getFirstValidTimestamp(Series *series, long long *skipped) {
     return sample.timestamp;
 }
 
-AbstractIterator *SeriesQuery(Series *series,
-                              const RangeArgs *args,
-                              bool reverse,
-                              bool check_retention) {
+AbstractIterator *SeriesQueryChunks(Series *series,
+                                    const RangeArgs *args,
+                                    bool reverse,
+                                    bool reverse_chunk,
+                                    bool check_retention) {
     // In case a retention is set shouldn't return chunks older than the retention
     timestamp_t startTimestamp = args->startTimestamp;
     if (check_retention && series->retentionTime > 0) {
@@ -1371,15 +2160,43 @@ AbstractIterator *SeriesQuery(Series *series,
                 ? max(args->startTimestamp, series->lastTimestamp - series->retentionTime)
                 : args->startTimestamp;
     }
+    return SeriesIterator_New(series,
+                              startTimestamp,
+                              args->endTimestamp,
+                              reverse,
+                              reverse_chunk,
+                              args->latest,
+                              args->openWindow);
+}
 
+timestamp_t SeriesQueryAlignment(const RangeArgs *args) {
+    switch (args->alignment) {
+        case StartAlignment:
+            // args-startTimestamp can hold an older timestamp than what we currently have or just 0
+            return args->startTimestamp;
+        case EndAlignment:
+            return args->endTimestamp;
+        case TimestampAlignment:
+            return args->timestampAlignment;
+        default:
+            return 0;
+    }
+}
+
+AbstractIterator *SeriesQuery(Series *series,
+                              const RangeArgs *args,
+                              bool reverse,
+                              bool check_retention) {
     // When there is a TS filter because we wanted the logic to be one for both reverse and non
     // reverse chunk, if the requested range should be reverse, we reverse it after the filter, and
     // should_reverse_chunk point it out.
     bool should_reverse_chunk = reverse && (!args->filterByTSArgs.hasValue);
-    AbstractIterator *chain = SeriesIterator_New(
-        series, startTimestamp, args->endTimestamp, reverse, should_reverse_chunk, args->latest);
+    AbstractIterator *chain =
+        SeriesQueryChunks(series, args, reverse, should_reverse_chunk, check_retention);
 
     if (args->filterByTSArgs.hasValue) {
+        SeriesIterator_UseTimestampFilter(
+            chain, args->filterByTSArgs.values, args->filterByTSArgs.count);
         chain =
             (AbstractIterator *)SeriesFilterTSIterator_New(chain, args->filterByTSArgs, reverse);
     }
@@ -1388,26 +2205,19 @@ AbstractIterator *SeriesQuery(Series *series,
         chain = (AbstractIterator *)SeriesFilterValIterator_New(chain, args->filterByValueArgs);
     }
 
-    timestamp_t timestampAlignment;
-    switch (args->alignment) {
-        case StartAlignment:
-            // args-startTimestamp can hold an older timestamp than what we currently have or just 0
-            timestampAlignment = args->startTimestamp;
-            break;
-        case EndAlignment:
-            timestampAlignment = args->endTimestamp;
-            break;
-        case TimestampAlignment:
-            timestampAlignment = args->timestampAlignment;
-            break;
-        default:
-            timestampAlignment = 0;
-            break;
+    const timestamp_t timestampAlignment = SeriesQueryAlignment(args);
+
+    AggregationClass *aggregation = args->aggregationArgs.aggregationClass;
+    if (aggregation != NULL && aggregation->appendSummary != NULL && !reverse &&
+        !args->filterByTSArgs.hasValue && !args->filterByValueArgs.hasValue) {
+        // the aggregation reads the chunks straight from the series iterator
+        SeriesIterator_UseChunkSummaries(
+            chain, args->aggregationArgs.timeDelta, timestampAlignment);
     }
 
-    if (args->aggregationArgs.aggregationClass != NULL) {
+    if (aggregation != NULL) {
         chain = (AbstractIterator *)AggregationIterator_New(chain,
-                                                            args->aggregationArgs.aggregationClass,
+                                                            aggregation,
                                                             args->aggregationArgs.timeDelta,
                                                             timestampAlignment,
                                                             reverse,
@@ -1482,6 +2292,21 @@ void calculate_latest_sample(Sample **sample, const Series *series) {
         }
         void *clonedContext = rule->aggClass->cloneContext(rule->aggContext);
 
+        // A cascaded rule is fed by the finished buckets of its source, the latest bucket of the
+        // source belongs to the current bucket too
+        Sample srcLatest;
+        Sample *srcLatestPtr = &srcLatest;
+        if (srcSeries->srcKey) {
+            calculate_latest_sample(&srcLatestPtr, srcSeries);
+        }
+        if (srcSeries->srcKey && srcLatestPtr) {
+            const timestamp_t srcLatestBucket = BucketStartNormalize(CalcBucketStart(
+                srcLatest.timestamp, rule->bucketDuration, rule->timestampAlignment));
+            if (srcLatestBucket == rule->startCurrentTimeBucket) {
+                rule->aggClass->appendValue(clonedContext, srcLatest.value, srcLatest.timestamp);
+            }
+        }
+
         double aggVal;
         rule->aggClass->finalize(clonedContext, &aggVal);
         (*sample)->timestamp = rule->startCurrentTimeBucket;
@@ -44,6 +44,17 @@ typedef enum GetSeriesResultFlags
                          GetSeriesFlags_CheckForAcls,
 } GetSeriesFlags;
 
+// An upserted sample of a finished bucket, merged into the bucket's value by
+// SeriesRecomputeDirtyRules
+typedef struct BucketUpdate
+{
+    timestamp_t start;
+    double value;
+    double overriddenValue;
+    bool overridden;
+    size_t pos; // keeps the order of the updates of a bucket
+} BucketUpdate;
+
 typedef struct CompactionRule
 {
     RedisModuleString *destKey;
@@ -55,6 +66,17 @@ typedef struct CompactionRule
     struct CompactionRule *nextRule;
     timestamp_t startCurrentTimeBucket; // Beware that the first bucket is alway starting in 0 no
                                         // matter the alignment
+    struct Series *destSeries; // destKey resolved by SeriesResolveRules, its srcRule is this rule
+    // Finished buckets whose samples were upserted, recomputed by SeriesRecomputeDirtyRules
+    timestamp_t *dirtyBuckets;
+    size_t dirtyBucketsCount;
+    size_t dirtyBucketsCapacity;
+    bool dirtyCurrentBucket; // the context is recomputed from the current bucket too
+    timestamp_t dirtyCurrentBucketStart;
+    // Finished buckets which are updated by merging the samples, when the aggregation supports it
+    BucketUpdate *bucketUpdates;
+    size_t bucketUpdatesCount;
+    size_t bucketUpdatesCapacity;
 } CompactionRule;
 
 typedef struct Series
@@ -77,6 +99,15 @@ typedef struct Series
     long long ignoreMaxTimeDiff;
     double ignoreMaxValDiff;
     bool in_ram; // false if the key is on flash (relevant only for RoF)
+    CompactionRule *srcRule; // the rule of srcKey which resolved this series, NULL if none
+    size_t dirtyPos;     // 1 based position in the list of series with dirty rules, 0 if clean
+    int db; // the database in which the key was last opened, its deferred work runs there
+    timestamp_t accumulateWindow; // TS.INCRBY/DECRBY write one sample per window, 0 if disabled
+    Sample accumulator;           // the start of the open window and the value summed into it
+    size_t accumulatorPos; // 1 based position in the list of open accumulators, 0 if closed
+    mstime_t accumulatorDeadline; // the time by which the module writes the open window
+    size_t sealPos; // 1 based position in the list of series with chunks to seal, 0 if none
+    timestamp_t unsealedFrom; // the first chunk which the deferred sealing didn't seal yet
 } Series;
 
 // process C's modulo result to translate from a negative modulo to a positive
@@ -105,11 +136,36 @@ void RenameSeriesFrom(RedisModuleCtx *ctx, RedisModuleString *key);
 void IndexMetricFromName(RedisModuleCtx *ctx, RedisModuleString *keyname);
 void RenameSeriesTo(RedisModuleCtx *ctx, RedisModuleString *key);
 void RestoreKey(RedisModuleCtx *ctx, RedisModuleString *keyname);
+void SeriesMovedTo(RedisModuleCtx *ctx, RedisModuleString *keyname);
 
 CompactionRule *GetRule(CompactionRule *rules, RedisModuleString *keyName);
 void deleteReferenceToDeletedSeries(RedisModuleCtx *ctx,
                                     Series *series,
                                     const GetSeriesFlags flags);
+void SeriesResolveRules(RedisModuleCtx *ctx, Series *series);
+void SeriesUnlinkRules(Series *series);
+Series *SeriesOpenRuleDest(RedisModuleCtx *ctx, CompactionRule *rule, RedisModuleKey **key);
+
+// Upserted samples mark the buckets of the compaction rules dirty. They're recomputed at the end of
+// the write command or after ts-compaction-recompute-interval, reads don't write them.
+void SeriesRecomputeDirtyRules(Series *series);
+void RecomputeDirtyCompactions(void);
+void RescheduleDirtyCompactions(void);
+
+// The increments of an accumulating series are summed in memory, its open window is written as a
+// single sample when a later window closes it, before other writes to the series, and at the
+// latest a window duration after it opened. Reads return the open window as the last sample of
+// the series without writing it.
+int SeriesAccumulate(RedisModuleCtx *ctx,
+                     Series *series,
+                     timestamp_t timestamp,
+                     double delta,
+                     timestamp_t *windowStart);
+void SeriesOpenAccumulator(Series *series, Sample window);
+void SeriesFlushAccumulator(RedisModuleCtx *ctx, Series *series);
+void SeriesSealChunk(Series *series, Chunk_t *chunk);
+void SeriesDeferChunkSealing(Series *series, timestamp_t from);
+void FlushAccumulators(void);
 
 // Deletes the reference if the series deleted, watch out of rules iterator invalidation
 GetSeriesResult GetSeries(RedisModuleCtx *ctx,
@@ -119,6 +175,14 @@ GetSeriesResult GetSeries(RedisModuleCtx *ctx,
                           int mode,
                           const GetSeriesFlags flags);
 
+// The iterator over the chunks of the query range, which the stages of SeriesQuery consume
+AbstractIterator *SeriesQueryChunks(Series *series,
+                                    const RangeArgs *args,
+                                    bool reverse,
+                                    bool reverse_chunk,
+                                    bool check_retention);
+// The timestamp the aggregation buckets of the query are aligned to
+timestamp_t SeriesQueryAlignment(const RangeArgs *args);
 AbstractIterator *SeriesQuery(Series *series,
                               const RangeArgs *args,
                               bool reserve,
@@ -143,12 +207,18 @@ AbstractSampleIterator *MultiSeriesCreateAggDupSampleIterator(Series **series,
 
 void FreeCompactionRule(void *value);
 size_t SeriesMemUsage(const void *value);
+size_t SeriesCheckpointsSize(const Series *series);
 
 int SeriesAddSample(Series *series, api_timestamp_t timestamp, double value);
+int SeriesAddSamples(Series *series, Sample *samples, size_t n_samples);
 int SeriesUpsertSample(Series *series,
                        api_timestamp_t timestamp,
                        double value,
                        DuplicatePolicy dp_override);
+size_t SeriesMergeSamples(Series *series,
+                          const Sample *samples,
+                          size_t n_samples,
+                          DuplicatePolicy dp_policy);
 
 bool SeriesDeleteRule(Series *series, RedisModuleString *destKey);
 void SeriesSetSrcRule(RedisModuleCtx *ctx, Series *series, RedisModuleString *srcKeyName);
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#include "scratch.h"
+
+#include "rmutil/alloc.h"
+
+#include <stdalign.h>
+#include <stdlib.h>
+
+#define SCRATCH_MIN_CAPACITY 4096
+
+struct ScratchOverflow
+{
+    ScratchOverflow *next;
+    alignas(max_align_t) char data[];
+};
+
+void *Scratch_Alloc(ScratchArena *arena, size_t size) {
+    size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+    if (size <= arena->capacity - arena->used) {
+        void *buf = arena->block + arena->used;
+        arena->used += size;
+        return buf;
+    }
+    ScratchOverflow *overflow = malloc(sizeof(ScratchOverflow) + size);
+    overflow->next = arena->overflow;
+    arena->overflow = overflow;
+    arena->overflowBytes += size;
+    arena->allocations++;
+    return overflow->data;
+}
+
+size_t Scratch_Begin(ScratchArena *arena) {
+    arena->depth++;
+    return arena->used;
+}
+
+static void freeOverflow(ScratchArena *arena) {
+    while (arena->overflow) {
+        ScratchOverflow *next = arena->overflow->next;
+        free(arena->overflow);
+        arena->overflow = next;
+    }
+    arena->overflowBytes = 0;
+}
+
+// The buffers which didn't fit the block are kept until the outermost scope is closed, then the
+// block grows to hold all of them
+void Scratch_End(ScratchArena *arena, size_t mark) {
+    arena->used = mark;
+    if (--arena->depth > 0 || !arena->overflow) {
+        return;
+    }
+    const size_t needed = arena->capacity + arena->overflowBytes;
+    size_t capacity = arena->capacity ? arena->capacity : SCRATCH_MIN_CAPACITY;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    freeOverflow(arena);
+    free(arena->block);
+    arena->block = malloc(capacity);
+    arena->capacity = capacity;
+    arena->allocations++;
+}
+
+void Scratch_Free(ScratchArena *arena) {
+    freeOverflow(arena);
+    free(arena->block);
+    *arena = (ScratchArena){ 0 };
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stddef.h>
+
+typedef struct ScratchOverflow ScratchOverflow;
+
+// A bump allocator for the temporary buffers of a command. The buffers are carved from a block
+// which is kept for the next commands. When a command needs more than the block, the extra
+// buffers get their own allocations and the block grows to fit the command once it's released,
+// so a steady stream of similar commands doesn't allocate.
+typedef struct ScratchArena
+{
+    char *block;
+    size_t capacity;
+    size_t used;
+    unsigned depth; // number of open scopes
+    ScratchOverflow *overflow;
+    size_t overflowBytes;
+    unsigned long long allocations; // heap allocations made by the arena
+} ScratchArena;
+
+// Opens a scope, the buffers allocated in it are valid until it's closed. Scopes nest.
+size_t Scratch_Begin(ScratchArena *arena);
+void Scratch_End(ScratchArena *arena, size_t mark);
+
+void *Scratch_Alloc(ScratchArena *arena, size_t size);
+
+void Scratch_Free(ScratchArena *arena);
+
+#endif
@@ -77,6 +77,21 @@ def test_encoding_compressed():
         r.execute_command('TS.ADD', 't1', '1', 1.0)
         assert TSInfo(r.execute_command('TS.INFO', 't1_MAX_1000')).chunk_type == b'compressed'
 
+def test_encoding_decimal():
+    Env().skipOnCluster()
+    skip_on_rlec()
+    env = Env(moduleArgs='ENCODING decimal; COMPACTION_POLICY max:1s:1m')
+    with env.getConnection() as r:
+        r.execute_command('FLUSHALL')
+        r.execute_command('TS.ADD', 't1', '1', 1.5)
+        assert TSInfo(r.execute_command('TS.INFO', 't1')).chunk_type == b'decimal'
+        assert TSInfo(r.execute_command('TS.INFO', 't1_MAX_1000')).chunk_type == b'decimal'
+        r.execute_command('CONFIG', 'SET', 'ts-encoding', 'compressed')
+        r.execute_command('TS.ADD', 't2', '1', 1.5)
+        assert TSInfo(r.execute_command('TS.INFO', 't2')).chunk_type == b'compressed'
+        r.execute_command('CONFIG', 'SET', 'ts-encoding', 'DECIMAL')
+        assert r.execute_command('CONFIG', 'GET', 'ts-encoding')[1] == b'decimal'
+
 def test_uncompressed():
     Env().skipOnCluster()
     skip_on_rlec()
@@ -287,6 +302,16 @@ def test_module_config_api_is_used_on_recent_redis_versions():
 
         conn.execute_command('CONFIG', 'GET', 'ts-encoding')
         conn.execute_command('CONFIG', 'SET', 'ts-encoding', 'compressed')
+        conn.execute_command('CONFIG', 'SET', 'ts-encoding', 'decimal')
+        conn.execute_command('CONFIG', 'SET', 'ts-encoding', 'chimp')
+        conn.execute_command('CONFIG', 'SET', 'ts-encoding', 'compressed')
+
+        conn.execute_command('CONFIG', 'GET', 'ts-chunk-sealing')
+        conn.execute_command('CONFIG', 'SET', 'ts-chunk-sealing', 'deferred')
+        conn.execute_command('CONFIG', 'SET', 'ts-chunk-sealing', 'none')
+        conn.execute_command('CONFIG', 'SET', 'ts-chunk-sealing', 'inline')
+        with pytest.raises(redis.exceptions.ResponseError):
+            conn.execute_command('CONFIG', 'SET', 'ts-chunk-sealing', 'always')
 
         conn.execute_command('CONFIG', 'GET', 'ts-ignore-max-val-diff')
         conn.execute_command('CONFIG', 'SET', 'ts-ignore-max-val-diff', '10')
@@ -308,6 +333,13 @@ def test_module_config_api_is_used_on_recent_redis_versions():
         conn.execute_command('CONFIG', 'GET', 'ts-ignore-max-time-diff')
         conn.execute_command('CONFIG', 'SET', 'ts-ignore-max-time-diff', '5')
 
+        conn.execute_command('CONFIG', 'GET', 'ts-chunk-checkpoint-interval')
+        conn.execute_command('CONFIG', 'SET', 'ts-chunk-checkpoint-interval', '256')
+
+        conn.execute_command('CONFIG', 'GET', 'ts-compaction-recompute-interval')
+        conn.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', '100')
+        conn.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', '0')
+
         assert not is_line_in_server_log(env, 'is deprecated, please use')
 
 def test_module_config_from_module_arguments_raises_deprecation_messages():
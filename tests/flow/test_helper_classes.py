@@ -175,6 +175,7 @@ class TSInfo(object):
     chunk_type = None
     chunks = None
     key_SelfName = None
+    accumulate_window = None
 
     def __init__(self, args):
         response = dict(zip(args[::2], args[1::2]))
@@ -193,6 +194,7 @@ class TSInfo(object):
         if b'chunkType' in response: self.chunk_type = response[b'chunkType']
         if b'Chunks' in response: self.chunks = response[b'Chunks']
         if b'keySelfName' in response: self.key_SelfName = response[b'keySelfName']
+        if b'accumulateWindow' in response: self.accumulate_window = response[b'accumulateWindow']
 
     def __eq__(self, other):
         if not isinstance(other, TSInfo):
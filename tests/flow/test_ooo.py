@@ -71,13 +71,15 @@ def test_ooo_split(self):
     with Env().getClusterConnectionIfNeeded() as r:
         quantity = 5000
 
-        type_list = ['', 'UNCOMPRESSED']
-        for chunk_type in type_list:
+        # a compressed chunk buffers its late samples and only grows, and splits, once they are
+        # encoded into it
+        chunk_counts = {'': 10, 'UNCOMPRESSED': 32}
+        for chunk_type, chunk_count in chunk_counts.items():
             r.execute_command('ts.create', 'split', chunk_type)
             r.execute_command('ts.add', 'split', quantity, 42)
             for i in range(quantity):
                 r.execute_command('ts.add', 'split', i, i * 1.01)
-            assert _get_ts_info(r, 'split').chunk_count in [13, 32]
+            assert _get_ts_info(r, 'split').chunk_count == chunk_count
             res = r.execute_command('ts.range', 'split', '-', '+')
             for i in range(quantity - 1):
                 assert res[i][0] + 1 == res[i + 1][0]
@@ -114,3 +116,39 @@ def test_rand_oom(self):
         for i in range(len(all_data)):
             assert all_data[i][0] == res[i][0]
             assert float(all_data[i][1]) == float(res[i][1])
+
+
+def test_ooo_buffered_samples(self):
+    with Env().getClusterConnectionIfNeeded() as r:
+        key = 'ooo_buffer{1}'
+        r.execute_command('ts.create', key, 'COMPRESSED', 'DUPLICATE_POLICY', 'BLOCK')
+        expected = {}
+        for i in range(1000):
+            r.execute_command('ts.add', key, i * 10, i)
+            expected[i * 10] = float(i)
+
+        for i in range(300):
+            ts = random.randint(0, 10000)
+            value = random.randint(0, 100)
+            if ts in expected:
+                with pytest.raises(redis.ResponseError):
+                    r.execute_command('ts.add', key, ts, value)
+                r.execute_command('ts.add', key, ts, value, 'ON_DUPLICATE', 'SUM')
+                expected[ts] += value
+            else:
+                r.execute_command('ts.add', key, ts, value)
+                expected[ts] = float(value)
+
+        def check():
+            res = r.execute_command('ts.range', key, '-', '+')
+            assert [[ts, float(v)] for ts, v in res] == sorted([[ts, v] for ts, v in expected.items()])
+            res = r.execute_command('ts.revrange', key, 2000, 3000)
+            assert [[ts, float(v)] for ts, v in res] == \
+                sorted([[ts, v] for ts, v in expected.items() if 2000 <= ts <= 3000], reverse=True)
+            assert _get_ts_info(r, key).total_samples == len(expected)
+
+        check()
+        dump = r.execute_command('dump', key)
+        r.execute_command('del', key)
+        r.execute_command('restore', key, 0, dump)
+        check()
@@ -306,3 +306,44 @@ def test_ts_add_fail(env):
         env.cmd('TS.ADD', 'k', 1, '1,0')
     with pytest.raises(redis.ResponseError):
         env.cmd('TS.ADD', 'k', 1, '0x1')
+
+
+def test_add_ingest_batching_replication():
+    env = Env()
+    if not env.useSlaves:
+        env.skip()
+    # getSlaveConnection is not supported in cluster mode
+    env.skipOnCluster()
+    env.skipOnVersionSmaller("7.0.0")
+    with env.getConnection() as r:
+        r.execute_command('config', 'set', 'ts-ingest-batching', 'yes')
+        try:
+            r.execute_command('ts.create', 'batched_last', 'DUPLICATE_POLICY', 'LAST')
+            r.execute_command('ts.create', 'batched_sum', 'DUPLICATE_POLICY', 'SUM')
+            r.execute_command('ts.create', 'batched_max')
+            r.execute_command('ts.createrule', 'batched_last', 'batched_max', 'AGGREGATION', 'max', 10)
+            pipe = r.pipeline(transaction=False)
+            for i in range(1000):
+                pipe.execute_command('ts.add', 'batched_last', i // 2, i)
+                pipe.execute_command('ts.add', 'batched_sum', i // 2, i)
+                if i == 500:
+                    # replicated after the samples which were batched before it
+                    pipe.execute_command('ts.del', 'batched_last', 0, 100)
+            # a key which TS.ADD creates isn't batched
+            pipe.execute_command('ts.add', 'batched_created', 1, 1, 'LABELS', 'name', 'batched')
+            pipe.execute()
+            info = r.execute_command('info', 'timeseries_ingest')
+            env.assertGreater(info['timeseries_ingest_batched_samples'], 0)
+            env.assertGreater(info['timeseries_ingest_batched_samples'], info['timeseries_ingest_batches'])
+
+            keys = ['batched_last', 'batched_sum', 'batched_max', 'batched_created']
+            expected = [r.execute_command('ts.range', key, '-', '+') for key in keys]
+            # the batch is propagated after the replies of its commands, poll the replica
+            with env.getSlaveConnection() as s:
+                for _ in range(50):
+                    if [s.execute_command('ts.range', key, '-', '+') for key in keys] == expected:
+                        break
+                    time.sleep(0.1)
+                env.assertEqual([s.execute_command('ts.range', key, '-', '+') for key in keys], expected)
+        finally:
+            r.execute_command('config', 'set', 'ts-ingest-batching', 'no')
@@ -0,0 +1,105 @@
+import random
+import struct
+
+from RLTest import Env
+from includes import *
+from test_helper_classes import _get_ts_info
+
+
+def test_addbulk_errors():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        r.execute_command('TS.CREATE', 'bulk')
+        r.execute_command('SET', 'not_a_series', 'value')
+        env.expect('TS.ADDBULK', 'bulk', 1).raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 1, 2, 3).raiseError()
+        env.expect('TS.ADDBULK', 'missing', 1, 2).raiseError()
+        env.expect('TS.ADDBULK', 'not_a_series', 1, 2).raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 1, 2, '*', 3).raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 1, 2, -1, 3).raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 1, 2, 3, 'bad').raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 'PACKED', struct.pack('<qd', 1, 2)[:15]).raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 'PACKED', struct.pack('<qdqd', 1, 2, -2, 3)).raiseError()
+        env.expect('TS.ADDBULK', 'bulk', 'PACKED_DELTA', struct.pack('<qdqd', 1, 2, -2, 3)).raiseError()
+        # a rejected command doesn't add any of its samples
+        env.assertEqual(r.execute_command('TS.RANGE', 'bulk', '-', '+'), [])
+
+
+def test_addbulk_retention():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        r.execute_command('TS.CREATE', 'bulk', 'RETENTION', 100)
+        r.execute_command('TS.ADD', 'bulk', 1000, 1)
+        # the retention is relative to the newest sample of the command
+        env.assertEqual(r.execute_command('TS.ADDBULK', 'bulk', 1200, 2, 950, 3, 1100, 4), 2)
+        env.assertEqual(r.execute_command('TS.RANGE', 'bulk', 1050, '+'),
+                        [[1100, b'4'], [1200, b'2']])
+
+
+def test_addbulk_matches_add():
+    env = Env()
+    env.skipOnCluster()
+    skip_on_rlec()
+    with env.getConnection() as r:
+        keys = [('lst', ['DUPLICATE_POLICY', 'LAST']),
+                ('sum', ['DUPLICATE_POLICY', 'SUM', 'CHUNK_SIZE', 128]),
+                ('blk', ['DUPLICATE_POLICY', 'BLOCK']),
+                ('unc', ['UNCOMPRESSED', 'CHUNK_SIZE', 128, 'DUPLICATE_POLICY', 'MIN'])]
+        for prefix in ['bulk_', 'add_']:
+            for key, args in keys:
+                r.execute_command('TS.CREATE', prefix + key, *args)
+                for agg in ['sum', 'max', 'twa']:
+                    r.execute_command('TS.CREATE', prefix + key + '_' + agg)
+                    r.execute_command('TS.CREATERULE', prefix + key, prefix + key + '_' + agg,
+                                      'AGGREGATION', agg, 100)
+
+        last = 1000
+        for batch in range(20):
+            samples = []
+            for _ in range(300):
+                if random.random() < 0.7:
+                    t = last + random.randint(0, 10)
+                else:
+                    t = random.randint(1000, last + 10)  # overlaps the existing chunks
+                samples.append((t, random.randint(0, 20) / 4))
+            last = max(last, max(t for t, _ in samples))
+
+            for key, _ in keys:
+                added = r.execute_command('TS.ADDBULK', 'bulk_' + key, *[a for s in samples for a in s])
+                expected = 0
+                for t, v in sorted(samples, key=lambda s: s[0]):
+                    try:
+                        r.execute_command('TS.ADD', 'add_' + key, t, v)
+                        expected += 1
+                    except Exception:
+                        pass
+                env.assertEqual(added, expected)
+
+        for key, _ in keys:
+            for suffix in ['', '_sum', '_max', '_twa']:
+                env.assertEqual(r.execute_command('TS.RANGE', 'bulk_' + key + suffix, '-', '+'),
+                                r.execute_command('TS.RANGE', 'add_' + key + suffix, '-', '+'))
+            env.assertEqual(_get_ts_info(r, 'bulk_' + key).total_samples,
+                            _get_ts_info(r, 'add_' + key).total_samples)
+
+
+def test_addbulk_packed():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        samples = [(random.randint(1000, 5000), random.randint(0, 20) / 4) for _ in range(500)]
+        ordered = sorted(samples, key=lambda s: s[0])
+        deltas = [ordered[0]] + [(b[0] - a[0], b[1]) for a, b in zip(ordered, ordered[1:])]
+        for key in ['text{1}', 'packed{1}', 'delta{1}']:
+            r.execute_command('TS.CREATE', key, 'DUPLICATE_POLICY', 'SUM')
+
+        text = r.execute_command('TS.ADDBULK', 'text{1}', *[a for s in samples for a in s])
+        packed = r.execute_command('TS.ADDBULK', 'packed{1}', 'packed',
+                                   b''.join(struct.pack('<qd', t, v) for t, v in samples))
+        delta = r.execute_command('TS.ADDBULK', 'delta{1}', 'PACKED_DELTA',
+                                  b''.join(struct.pack('<qd', d, v) for d, v in deltas))
+        env.assertEqual(text, 500)
+        env.assertEqual(packed, 500)
+        env.assertEqual(delta, 500)
+        expected = r.execute_command('TS.RANGE', 'text{1}', '-', '+')
+        env.assertEqual(r.execute_command('TS.RANGE', 'packed{1}', '-', '+'), expected)
+        env.assertEqual(r.execute_command('TS.RANGE', 'delta{1}', '-', '+'), expected)
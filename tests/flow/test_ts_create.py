@@ -1,4 +1,5 @@
 import math
+import random
 import time
 
 import pytest
@@ -197,3 +198,80 @@ def test_ts_create_encoding():
             # backwards compatible check
             r.execute_command('ts.create', 't1_bc', ENCODING)
             e.assertEqual(TSInfo(r.execute_command('TS.INFO', 't1_bc')).chunk_type, ENCODING.encode())
+
+
+def test_ts_create_decimal_encoding():
+    e = Env()
+    e.flush()
+    with e.getClusterConnectionIfNeeded() as r:
+        r.execute_command('TS.CREATE', 'counter{1}', 'ENCODING', 'COMPRESSED', 'LABELS', 'name', 'counter')
+        r.execute_command('TS.CREATE', 'counter_decimal{1}', 'ENCODING', 'DECIMAL', 'LABELS', 'name', 'counter')
+        e.assertEqual(TSInfo(r.execute_command('TS.INFO', 'counter_decimal{1}')).chunk_type, b'decimal')
+
+        # a counter with 2 digits after the decimal point, and a few values which don't fit
+        cents = 100000
+        samples = []
+        for i in range(10000):
+            cents += random.randint(0, 500)
+            samples.append([1000 + i * 1000, str(cents / 100)])
+        samples[5000][1] = str(1 / 3)
+        samples[7000][1] = '-0.0005'
+        for key in ['counter{1}', 'counter_decimal{1}']:
+            for i in range(0, len(samples), 1000):
+                r.execute_command('TS.MADD', *[arg for ts, val in samples[i:i + 1000] for arg in (key, ts, val)])
+        # late samples
+        r.execute_command('TS.ADD', 'counter{1}', 1500, 12.5)
+        r.execute_command('TS.ADD', 'counter_decimal{1}', 1500, 12.5)
+
+        gorilla = TSInfo(r.execute_command('TS.INFO', 'counter{1}'))
+        decimal = TSInfo(r.execute_command('TS.INFO', 'counter_decimal{1}'))
+        e.assertEqual(gorilla.total_samples, decimal.total_samples)
+        e.assertTrue(decimal.chunk_count * 2 <= gorilla.chunk_count)
+
+        def check_ranges():
+            expected = r.execute_command('TS.RANGE', 'counter{1}', '-', '+')
+            e.assertEqual(len(expected), len(samples) + 1)
+            e.assertEqual(r.execute_command('TS.RANGE', 'counter_decimal{1}', '-', '+'), expected)
+            e.assertEqual(r.execute_command('TS.REVRANGE', 'counter_decimal{1}', 4000000, 8000000),
+                          r.execute_command('TS.REVRANGE', 'counter{1}', 4000000, 8000000))
+            res = r.execute_command('TS.MRANGE', '-', '+', 'FILTER', 'name=counter')
+            e.assertEqual(res[0][2], res[1][2])
+
+        check_ranges()
+        dump = r.execute_command('DUMP', 'counter_decimal{1}')
+        r.execute_command('DEL', 'counter_decimal{1}')
+        r.execute_command('RESTORE', 'counter_decimal{1}', 0, dump)
+        e.assertEqual(TSInfo(r.execute_command('TS.INFO', 'counter_decimal{1}')).chunk_type, b'decimal')
+        check_ranges()
+
+
+def test_ts_create_chimp_encoding():
+    e = Env()
+    e.flush()
+    with e.getClusterConnectionIfNeeded() as r:
+        r.execute_command('TS.CREATE', 'sensor{1}', 'ENCODING', 'COMPRESSED', 'LABELS', 'name', 'sensor')
+        r.execute_command('TS.CREATE', 'sensor_chimp{1}', 'ENCODING', 'CHIMP', 'LABELS', 'name', 'sensor')
+        e.assertEqual(TSInfo(r.execute_command('TS.INFO', 'sensor_chimp{1}')).chunk_type, b'chimp')
+
+        samples = [[1000 + i * 1000, str(random.choice([random.random() * 100, random.randint(0, 10), 42]))]
+                   for i in range(10000)]
+        for key in ['sensor{1}', 'sensor_chimp{1}']:
+            for i in range(0, len(samples), 1000):
+                r.execute_command('TS.MADD', *[arg for ts, val in samples[i:i + 1000] for arg in (key, ts, val)])
+            r.execute_command('TS.ADD', key, 1500, 12.5)
+            r.execute_command('TS.DEL', key, 3000000, 3100000)
+
+        def check_ranges():
+            expected = r.execute_command('TS.RANGE', 'sensor{1}', '-', '+')
+            e.assertEqual(r.execute_command('TS.RANGE', 'sensor_chimp{1}', '-', '+'), expected)
+            e.assertEqual(r.execute_command('TS.REVRANGE', 'sensor_chimp{1}', 4000000, 8000000),
+                          r.execute_command('TS.REVRANGE', 'sensor{1}', 4000000, 8000000))
+            res = r.execute_command('TS.MRANGE', '-', '+', 'FILTER', 'name=sensor')
+            e.assertEqual(res[0][2], res[1][2])
+
+        check_ranges()
+        dump = r.execute_command('DUMP', 'sensor_chimp{1}')
+        r.execute_command('DEL', 'sensor_chimp{1}')
+        r.execute_command('RESTORE', 'sensor_chimp{1}', 0, dump)
+        e.assertEqual(TSInfo(r.execute_command('TS.INFO', 'sensor_chimp{1}')).chunk_type, b'chimp')
+        check_ranges()
@@ -1,12 +1,13 @@
 import math
 import random
 import statistics
+import time
 
 import pytest
 import redis
 from RLTest import Env
 from test_helper_classes import _get_series_value, calc_rule, ALLOWED_ERROR, _insert_data, \
-    _get_ts_info, _insert_agg_data
+    _get_ts_info, _insert_agg_data, TSInfo
 from includes import *
 
 
@@ -80,8 +81,13 @@ def test_create_compaction_rule_from_target():
         assert r.execute_command('TS.CREATE', 'tester2')
         assert r.execute_command('TS.CREATE', agg_key_name)
         assert r.execute_command('TS.CREATERULE', key_name, agg_key_name, 'AGGREGATION', 'MAX', 10)
+        # only exact aggregations of whole source buckets can be cascaded
         with pytest.raises(redis.ResponseError) as excinfo:
-            assert r.execute_command('TS.CREATERULE', agg_key_name, 'tester2', 'AGGREGATION', 'MAX', 10)
+            assert r.execute_command('TS.CREATERULE', agg_key_name, 'tester2', 'AGGREGATION', 'MIN', 10)
+        with pytest.raises(redis.ResponseError) as excinfo:
+            assert r.execute_command('TS.CREATERULE', agg_key_name, 'tester2', 'AGGREGATION', 'MAX', 15)
+        with pytest.raises(redis.ResponseError) as excinfo:
+            assert r.execute_command('TS.CREATERULE', agg_key_name, 'tester2', 'AGGREGATION', 'MAX', 20, 5)
 
 
 def test_create_compaction_rule_own():
@@ -393,3 +399,215 @@ def test_create_rule_non_empty_src_series(self):
         r.execute_command("ts.createrule", t1, t3, "AGGREGATION", "avg", 10, 5)
         res = r.execute_command("ts.range", t3, "-", "+", "LATEST")
         assert res == []
+
+
+def test_compaction_dest_replaced():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        src, dest, renamed = 'src{dest}', 'dest{dest}', 'renamed{dest}'
+        r.execute_command('TS.CREATE', src)
+        r.execute_command('TS.CREATE', dest)
+        r.execute_command('TS.CREATERULE', src, dest, 'AGGREGATION', 'sum', 10)
+        for ts in range(15):
+            r.execute_command('TS.ADD', src, ts, 1)
+        env.assertEqual(r.execute_command('TS.RANGE', dest, '-', '+'), [[0, b'10']])
+
+        # the renamed destination keeps receiving the buckets
+        r.execute_command('RENAME', dest, renamed)
+        for ts in range(15, 25):
+            r.execute_command('TS.ADD', src, ts, 1)
+        env.assertEqual(r.execute_command('TS.RANGE', renamed, '-', '+'), [[0, b'10'], [10, b'10']])
+
+        # a destination which was replaced by another type is dropped
+        r.execute_command('DEL', renamed)
+        r.execute_command('SET', renamed, 'value')
+        for ts in range(25, 35):
+            r.execute_command('TS.ADD', src, ts, 1)
+        env.assertEqual(r.execute_command('GET', renamed), b'value')
+        env.assertEqual(_get_ts_info(r, src).rules, [])
+
+        # a new destination with the same name
+        r.execute_command('DEL', renamed)
+        r.execute_command('TS.CREATE', renamed)
+        r.execute_command('TS.CREATERULE', src, renamed, 'AGGREGATION', 'count', 10)
+        for ts in range(35, 55):
+            r.execute_command('TS.ADD', src, ts, 1)
+        env.assertEqual(r.execute_command('TS.RANGE', renamed, '-', '+'), [[30, b'5'], [40, b'10']])
+
+        # a destination which is overwritten by a command of another type, there's no del event
+        r.execute_command('SADD', 'set{dest}', 'member')
+        r.execute_command('SUNIONSTORE', renamed, 'set{dest}')
+        for ts in range(55, 65):
+            r.execute_command('TS.ADD', src, ts, 1)
+        env.assertEqual(r.execute_command('TYPE', renamed), b'set')
+        env.assertEqual(_get_ts_info(r, src).rules, [])
+
+        r.execute_command('FLUSHALL')
+        r.execute_command('TS.CREATE', src)
+        r.execute_command('TS.CREATE', dest)
+        r.execute_command('TS.CREATERULE', src, dest, 'AGGREGATION', 'max', 10)
+        for ts in range(15):
+            r.execute_command('TS.ADD', src, ts, ts)
+        env.assertEqual(r.execute_command('TS.RANGE', dest, '-', '+'), [[0, b'9']])
+
+
+def test_cascaded_compaction():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        cascades = [('sum', 'sum'), ('count', 'sum'), ('min', 'min'), ('max', 'max'),
+                    ('first', 'first'), ('last', 'last')]
+        r.execute_command('TS.CREATE', 'raw{5}', 'DUPLICATE_POLICY', 'LAST')
+        for fine, coarse in cascades:
+            r.execute_command('TS.CREATE', 'fine_{}{{5}}'.format(fine))
+            r.execute_command('TS.CREATE', 'coarse_{}{{5}}'.format(fine))
+            r.execute_command('TS.CREATERULE', 'raw{5}', 'fine_{}{{5}}'.format(fine), 'AGGREGATION', fine, 10)
+            r.execute_command('TS.CREATERULE', 'fine_{}{{5}}'.format(fine), 'coarse_{}{{5}}'.format(fine),
+                              'AGGREGATION', coarse, 100)
+        r.execute_command('TS.CREATE', 'coarse_avg{5}')
+        with pytest.raises(redis.ResponseError):
+            r.execute_command('TS.CREATERULE', 'fine_sum{5}', 'coarse_avg{5}', 'AGGREGATION', 'avg', 100)
+
+        samples = [(t, random.randint(0, 100)) for t in random.sample(range(1000), 400)]
+        for t, v in samples:
+            r.execute_command('TS.ADD', 'raw{5}', t, v)
+        # backfill into finished buckets of both tiers
+        for t in random.sample(range(600), 50):
+            r.execute_command('TS.ADD', 'raw{5}', t, random.randint(0, 100))
+        r.execute_command('TS.ADD', 'raw{5}', 1055, 1)
+
+        for fine, _ in cascades:
+            coarse_key = 'coarse_{}{{5}}'.format(fine)
+            expected = r.execute_command('TS.RANGE', 'raw{5}', '-', '+', 'AGGREGATION', fine, 100)
+            env.assertEqual(r.execute_command('TS.RANGE', coarse_key, '-', '+'), expected[:-1])
+            # the latest bucket includes the open bucket of the finer tier
+            env.assertEqual(r.execute_command('TS.RANGE', coarse_key, '-', '+', 'LATEST'), expected)
+            env.assertEqual(r.execute_command('TS.GET', coarse_key, 'LATEST'), expected[-1])
+
+
+def test_deferred_backfill_recompute():
+    env = Env()
+    if is_redis_version_lower_than(env, '7.0') or env.isCluster():
+        env.skip()
+    skip_on_rlec()
+    with env.getConnection() as r:
+        aggs = ['sum', 'avg', 'max', 'twa']
+        r.execute_command('TS.CREATE', 'raw', 'DUPLICATE_POLICY', 'LAST')
+        for agg in aggs:
+            r.execute_command('TS.CREATE', 'raw_' + agg)
+            r.execute_command('TS.CREATERULE', 'raw', 'raw_' + agg, 'AGGREGATION', agg, 100)
+        for t in range(0, 1000, 5):
+            r.execute_command('TS.ADD', 'raw', t, t % 7)
+
+        def check():
+            for agg in aggs:
+                expected = r.execute_command('TS.RANGE', 'raw', '-', '+', 'AGGREGATION', agg, 100)
+                env.assertEqual(r.execute_command('TS.RANGE', 'raw_' + agg, '-', '+'), expected[:-1])
+                env.assertEqual(r.execute_command('TS.RANGE', 'raw_' + agg, '-', '+', 'LATEST'), expected)
+                env.assertEqual(r.execute_command('TS.GET', 'raw_' + agg, 'LATEST'), expected[-1])
+
+        # recomputed at the end of each command
+        r.execute_command('TS.MADD', *[a for t in range(1, 1000, 3) for a in ('raw', t, t % 11)])
+        check()
+
+        # reads and DUMP don't recompute, they see the buckets from before the adds
+        r.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', 3600000)
+        stale = {agg: r.execute_command('TS.RANGE', 'raw_' + agg, '-', '+') for agg in aggs}
+        for t in range(2, 1000, 7):
+            r.execute_command('TS.ADD', 'raw', t, t % 13)
+        for agg in aggs:
+            env.assertEqual(r.execute_command('TS.RANGE', 'raw_' + agg, '-', '+'), stale[agg])
+        r.execute_command('RESTORE', 'dumped_sum', 0, r.execute_command('DUMP', 'raw_sum'))
+        env.assertEqual(r.execute_command('TS.RANGE', 'dumped_sum', '-', '+'), stale['sum'])
+        env.assertEqual(r.execute_command('TS.RANGE', 'raw_sum', '-', '+'), stale['sum'])
+
+        # lowering the interval reschedules the pending recompute
+        r.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', 10)
+        time.sleep(0.2)
+        check()
+
+        # recomputed by the interval
+        r.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', 10)
+        for t in range(4, 1000, 9):
+            r.execute_command('TS.ADD', 'raw', t, t % 5)
+        time.sleep(0.2)
+        # a restored copy isn't a compaction, reading it doesn't recompute
+        r.execute_command('RESTORE', 'copy_sum', 0, r.execute_command('DUMP', 'raw_sum'))
+        sums = r.execute_command('TS.RANGE', 'raw', '-', '+', 'AGGREGATION', 'sum', 100)
+        env.assertEqual(r.execute_command('TS.RANGE', 'copy_sum', '-', '+'), sums[:-1])
+        check()
+
+        # the interval recomputes the series of every database in its own database
+        pipe = r.pipeline(transaction=False)
+        pipe.execute_command('SELECT', 1)
+        pipe.execute_command('TS.CREATE', 'raw', 'DUPLICATE_POLICY', 'LAST')
+        pipe.execute_command('TS.CREATE', 'raw_sum')
+        pipe.execute_command('TS.CREATERULE', 'raw', 'raw_sum', 'AGGREGATION', 'sum', 100)
+        for t in range(0, 1000, 5):
+            pipe.execute_command('TS.ADD', 'raw', t, 1)
+        for t in range(1, 1000, 50):
+            pipe.execute_command('TS.ADD', 'raw', t, 1)
+        pipe.execute_command('SELECT', 0)
+        pipe.execute()
+        time.sleep(0.2)
+        pipe = r.pipeline(transaction=False)
+        pipe.execute_command('SELECT', 1)
+        pipe.execute_command('TS.RANGE', 'raw_sum', '-', '+')
+        pipe.execute_command('TS.INFO', 'raw')
+        pipe.execute_command('SELECT', 0)
+        res = pipe.execute()
+        env.assertEqual(res[1], [[t, b'22'] for t in range(0, 900, 100)])
+        env.assertEqual(len(TSInfo(res[2]).rules), 1)
+
+        # a series moved with dirty buckets is recomputed in the database it was moved to
+        r.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', 3600000)
+        pipe = r.pipeline(transaction=False)
+        pipe.execute_command('SELECT', 1)
+        for t in range(2, 1000, 50):
+            pipe.execute_command('TS.ADD', 'raw', t, 1)
+        pipe.execute_command('MOVE', 'raw', 2)
+        pipe.execute_command('MOVE', 'raw_sum', 2)
+        pipe.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', 10)
+        pipe.execute()
+        time.sleep(0.2)
+        pipe = r.pipeline(transaction=False)
+        pipe.execute_command('SELECT', 2)
+        pipe.execute_command('TS.RANGE', 'raw_sum', '-', '+')
+        pipe.execute_command('TS.INFO', 'raw')
+        pipe.execute_command('SELECT', 0)
+        res = pipe.execute()
+        env.assertEqual(res[-3], [[t, b'24'] for t in range(0, 900, 100)])
+        env.assertEqual(len(TSInfo(res[-2]).rules), 1)
+        r.execute_command('CONFIG', 'SET', 'ts-compaction-recompute-interval', 0)
+
+
+def test_incremental_backfill_compaction():
+    env = Env()
+    if env.isCluster():
+        env.skip()
+    skip_on_rlec()
+    with env.getConnection() as r:
+        aggs = ['sum', 'count', 'min', 'max', 'range', 'avg', 'std.p', 'var.s', 'first']
+        for policy in ['LAST', 'SUM', 'MIN']:
+            raw = 'raw_' + policy
+            r.execute_command('TS.CREATE', raw, 'DUPLICATE_POLICY', policy)
+            for agg in aggs:
+                r.execute_command('TS.CREATE', raw + agg)
+                r.execute_command('TS.CREATERULE', raw, raw + agg, 'AGGREGATION', agg, 100)
+            # a cascaded rule is updated from the upserted buckets of its source
+            r.execute_command('TS.CREATE', raw + 'sum_1000')
+            r.execute_command('TS.CREATERULE', raw + 'sum', raw + 'sum_1000', 'AGGREGATION', 'sum', 1000)
+
+            for t in range(0, 5000, 10):
+                r.execute_command('TS.ADD', raw, t, t % 17)
+            # new samples and overrides of finished buckets and of the current bucket
+            for _ in range(500):
+                t = random.choice([random.randint(0, 5000), random.randrange(0, 5000, 10),
+                                   random.randint(4900, 5000)])
+                r.execute_command('TS.ADD', raw, t, random.randint(-20, 20))
+
+            for agg in aggs:
+                expected = r.execute_command('TS.RANGE', raw, '-', '+', 'AGGREGATION', agg, 100)
+                env.assertEqual(r.execute_command('TS.RANGE', raw + agg, '-', '+', 'LATEST'), expected)
+            expected = r.execute_command('TS.RANGE', raw, '-', '+', 'AGGREGATION', 'sum', 1000)
+            env.assertEqual(r.execute_command('TS.RANGE', raw + 'sum_1000', '-', '+', 'LATEST'),
+                            expected)
@@ -5,6 +5,7 @@ import time
 # import redis
 # from utils import Env
 from includes import *
+from test_helper_classes import _get_ts_info
 
 
 def test_incrby():
@@ -66,3 +67,87 @@ def test_incrby_with_update_latest():
         result = r.execute_command('TS.RANGE', 'tester', 0, 20)
         assert len(result) == 20
         assert result[19] == [20, b'95']
+
+
+def test_incrby_accumulate():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        r.execute_command('ts.create', 'counter{1}', 'ACCUMULATE', 100)
+        r.execute_command('ts.create', 'counter_sum{1}')
+        r.execute_command('ts.createrule', 'counter{1}', 'counter_sum{1}', 'AGGREGATION', 'sum', 1000)
+        assert _get_ts_info(r, 'counter{1}').accumulate_window == 100
+
+        # the increments of a window are one sample at the start of the window
+        for t in range(1000, 1100, 10):
+            assert r.execute_command('ts.incrby', 'counter{1}', 2, 'TIMESTAMP', t) == 1000
+        assert r.execute_command('ts.decrby', 'counter{1}', 1, 'TIMESTAMP', 1099) == 1000
+        # the open window is written at the latest a window duration after it opened
+        time.sleep(0.3)
+        assert r.execute_command('ts.get', 'counter{1}') == [1000, b'19']
+
+        # a written window goes on from its sample
+        r.execute_command('ts.incrby', 'counter{1}', 1, 'TIMESTAMP', 1050)
+        for t in range(1100, 2100, 50):
+            r.execute_command('ts.incrby', 'counter{1}', 1, 'TIMESTAMP', t)
+        time.sleep(0.3)
+        assert r.execute_command('ts.range', 'counter{1}', '-', '+') == \
+            [[t, str(20 + (t - 1000) // 100 * 2).encode()] for t in range(1000, 2100, 100)]
+        assert r.execute_command('ts.range', 'counter{1}', '-', '+', 'AGGREGATION', 'count', 1000) == \
+            [[1000, b'10'], [2000, b'1']]
+        # the compaction sees the windows which closed it
+        assert r.execute_command('ts.range', 'counter_sum{1}', '-', '+') == \
+            [[1000, str(sum(20 + i * 2 for i in range(10))).encode()]]
+
+        with pytest.raises(redis.ResponseError):
+            r.execute_command('ts.incrby', 'counter{1}', 1, 'TIMESTAMP', 1999)
+        with pytest.raises(redis.ResponseError):
+            r.execute_command('ts.create', 'bad{1}', 'ACCUMULATE', -1)
+
+        # disabling the mode writes the open window
+        r.execute_command('ts.incrby', 'counter{1}', 1, 'TIMESTAMP', 2150)
+        r.execute_command('ts.alter', 'counter{1}', 'ACCUMULATE', 0)
+        assert r.execute_command('ts.incrby', 'counter{1}', 1, 'TIMESTAMP', 2160) == 2160
+        assert r.execute_command('ts.range', 'counter{1}', 2000, '+') == \
+            [[2000, b'40'], [2100, b'41'], [2160, b'42']]
+
+
+def test_incrby_accumulate_reads():
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        r.execute_command('ts.create', 'slow{1}', 'ACCUMULATE', 3600000, 'LABELS', 'reads', 'open')
+        r.execute_command('ts.create', 'slow_sum{1}')
+        r.execute_command('ts.createrule', 'slow{1}', 'slow_sum{1}', 'AGGREGATION', 'sum', 10)
+        r.execute_command('ts.incrby', 'slow{1}', 5, 'TIMESTAMP', 100)
+
+        # reads return the open window without writing it
+        assert r.execute_command('ts.get', 'slow{1}') == [0, b'5']
+        assert r.execute_command('ts.range', 'slow{1}', '-', '+') == [[0, b'5']]
+        assert r.execute_command('ts.revrange', 'slow{1}', '-', '+') == [[0, b'5']]
+        assert r.execute_command('ts.range', 'slow{1}', 1, '+') == []
+        assert r.execute_command('ts.mget', 'FILTER', 'reads=open') == [[b'slow{1}', [], [0, b'5']]]
+        assert r.execute_command('ts.mrange', '-', '+', 'FILTER', 'reads=open') == \
+            [[b'slow{1}', [], [[0, b'5']]]]
+        assert r.execute_command('ts.range', 'slow_sum{1}', '-', '+') == []
+        assert _get_ts_info(r, 'slow{1}').total_samples == 0
+        # a DUMP saves the open window as it is
+        r.execute_command('restore', 'restored{1}', 0, r.execute_command('dump', 'slow{1}'))
+        assert _get_ts_info(r, 'slow{1}').total_samples == 0
+        assert r.execute_command('ts.incrby', 'restored{1}', 1, 'TIMESTAMP', 200) == 0
+
+        # a write to the series writes the open window first
+        r.execute_command('ts.add', 'slow{1}', 3600000, 1)
+        assert r.execute_command('ts.range', 'slow{1}', '-', '+') == [[0, b'5'], [3600000, b'1']]
+        assert r.execute_command('ts.range', 'slow_sum{1}', '-', '+') == [[0, b'5']]
+        r.execute_command('ts.add', 'restored{1}', 3600000, 1)
+        assert r.execute_command('ts.range', 'restored{1}', '-', '+') == [[0, b'6'], [3600000, b'1']]
+
+        # a window which starts at the last written sample goes on from it, reads see it once
+        r.execute_command('ts.incrby', 'slow{1}', 2, 'TIMESTAMP', 3600001)
+        assert r.execute_command('ts.get', 'slow{1}') == [3600000, b'3']
+        assert r.execute_command('ts.range', 'slow{1}', '-', '+') == [[0, b'5'], [3600000, b'3']]
+        assert r.execute_command('ts.revrange', 'slow{1}', '-', '+') == [[3600000, b'3'], [0, b'5']]
+        assert r.execute_command('ts.range', 'slow{1}', '-', '+',
+                                 'AGGREGATION', 'sum', 7200000) == [[0, b'8']]
+        assert r.execute_command('ts.mrange', '-', '+', 'FILTER', 'reads=open') == \
+            [[b'restored{1}', [], [[0, b'6'], [3600000, b'1']]],
+             [b'slow{1}', [], [[0, b'5'], [3600000, b'3']]]]
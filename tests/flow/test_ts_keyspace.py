@@ -39,6 +39,15 @@ def test_keyspace():
         assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add')
         assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'test_key2{2}')
 
+        # MADD notifies each sample in the order of the arguments
+        r.execute_command("ts.madd", 'tester{2}', 3000, 1, 'test_key2{2}', 3000, 2, 'tester{2}', 3001, 3)
+        assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add')
+        assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'tester{2}')
+        assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add')
+        assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'test_key2{2}')
+        assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add')
+        assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'tester{2}')
+
         # Test INCRBY generate event on key
         r.execute_command("ts.INCRBY", 'tester{2}', "100")
         assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.incrby')
@@ -148,3 +157,48 @@ def test_keyspace_rules_send():
 
         assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.incrby')
         assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'tester_src{2}')
+
+
+def test_keyspace_ingest_batching():
+    Env().skipOnCluster()
+    Env().skipOnVersionSmaller("7.0.0")
+    skip_on_rlec()
+    env = Env()
+    with env.getClusterConnectionIfNeeded() as r:
+        r.execute_command('config', 'set', 'notify-keyspace-events', 'KEA')
+        r.execute_command('config', 'set', 'ts-ingest-batching', 'yes')
+        try:
+            r.execute_command('ts.create', 'batched_src{2}')
+            r.execute_command('ts.create', 'batched_dest{2}')
+            r.execute_command('ts.createrule', 'batched_src{2}', 'batched_dest{2}', 'AGGREGATION', 'max', 10)
+            r.execute_command('ts.create', 'unbatched{2}')
+
+            pubsub = r.pubsub()
+            pubsub.psubscribe('__key*')
+            time.sleep(1)
+            env.assertEqual('psubscribe', pubsub.get_message(timeout=1)['type'])
+
+            # the commands of a pipeline run in the same event loop iteration, each key is
+            # notified once, in the order the keys were first notified
+            pipe = r.pipeline(transaction=False)
+            for t in range(100):
+                pipe.execute_command('ts.add', 'batched_src{2}', t, t)
+            pipe.execute()
+            assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add')
+            assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'batched_src{2}')
+            assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add:dest')
+            assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'batched_dest{2}')
+            env.assertEqual(pubsub.get_message(timeout=1), None)
+
+            # the commands of a transaction or a script aren't batched, each sample is notified
+            pipe = r.pipeline(transaction=True)
+            for t in range(3):
+                pipe.execute_command('ts.add', 'unbatched{2}', t, t)
+            pipe.execute()
+            r.eval("for t = 3, 5 do redis.call('ts.add', KEYS[1], t, t) end", 1, 'unbatched{2}')
+            for _ in range(6):
+                assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'ts.add')
+                assert_msg(env, pubsub.get_message(timeout=1), 'pmessage', b'unbatched{2}')
+            env.assertEqual(pubsub.get_message(timeout=1), None)
+        finally:
+            r.execute_command('config', 'set', 'ts-ingest-batching', 'no')
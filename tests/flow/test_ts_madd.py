@@ -1,4 +1,6 @@
 import os
+import random
+import struct
 import time
 import aof_parser
 
@@ -169,3 +171,124 @@ def test_madd_some_failed_replicas():
 
     # rollback the config change
     env.cmd('CONFIG', 'SET', 'appendfsync', res[1])
+
+
+def test_madd_grouped_by_key_matches_add():
+    env = Env()
+    env.skipOnCluster()
+    skip_on_rlec()
+    with env.getConnection() as r:
+        keys = ['grouped{1}_%d' % i for i in range(4)]
+        for prefix in ['madd_', 'add_']:
+            r.execute_command('TS.CREATE', prefix + keys[0])
+            r.execute_command('TS.CREATE', prefix + keys[1], 'RETENTION', 500, 'DUPLICATE_POLICY', 'BLOCK')
+            r.execute_command('TS.CREATE', prefix + keys[2], 'UNCOMPRESSED', 'CHUNK_SIZE', 128,
+                              'DUPLICATE_POLICY', 'LAST', 'IGNORE', 5, 0.5)
+            r.execute_command('TS.CREATE', prefix + keys[3], 'DUPLICATE_POLICY', 'SUM')
+            for agg in ['sum', 'max', 'twa']:
+                r.execute_command('TS.CREATE', prefix + keys[0] + '_' + agg)
+                r.execute_command('TS.CREATERULE', prefix + keys[0], prefix + keys[0] + '_' + agg,
+                                  'AGGREGATION', agg, 100)
+        r.execute_command('SET', 'madd_not_a_series', 'value')
+        r.execute_command('SET', 'add_not_a_series', 'value')
+
+        def result(f):
+            try:
+                return f()
+            except Exception as e:
+                return str(e)
+
+        ts = [1000] * len(keys)
+        for batch in range(20):
+            args = []
+            for _ in range(200):
+                k = random.randint(0, len(keys) - 1)
+                choice = random.random()
+                if choice < 0.8:
+                    ts[k] += random.randint(1, 10)
+                    t = ts[k]
+                elif choice < 0.95:
+                    t = ts[k] - random.randint(0, 800)  # late, duplicate or out of retention
+                else:
+                    t = 'bad'
+                args.append((keys[k], t, random.randint(0, 20) / 4))
+            args.append(('not_a_series', 5, 1))
+
+            madd_res = result(lambda: r.execute_command('TS.MADD', *[a for key, t, v in args for a in ('madd_' + key, t, v)]))
+            add_res = [result(lambda: r.execute_command('TS.ADD', 'add_' + key, t, v)) for key, t, v in args]
+            madd_res = [str(x) if isinstance(x, Exception) else x for x in madd_res]
+            env.assertEqual(len(madd_res), len(args))
+            for m, a in zip(madd_res, add_res):
+                if isinstance(m, int):
+                    env.assertEqual(m, a)
+                else:
+                    env.assertTrue(isinstance(a, str))
+
+        for key in keys + [keys[0] + '_sum', keys[0] + '_max', keys[0] + '_twa']:
+            env.assertEqual(r.execute_command('TS.RANGE', 'madd_' + key, '-', '+'),
+                            r.execute_command('TS.RANGE', 'add_' + key, '-', '+'))
+
+
+def test_madd_packed():
+    env = Env()
+    env.skipOnCluster()
+    skip_on_rlec()
+    with env.getConnection() as r:
+        r.execute_command('TS.CREATE', 'text{1}')
+        r.execute_command('TS.CREATE', 'packed{1}')
+        r.execute_command('TS.CREATE', 'other{1}', 'DUPLICATE_POLICY', 'BLOCK')
+
+        samples = [(1000 + i * 10, i / 4) for i in range(100)]
+        payload = b''.join(struct.pack('<qd', t, v) for t, v in samples[:50])
+        delta_payload = struct.pack('<qd', *samples[50]) + b''.join(
+            struct.pack('<qd', b[0] - a[0], b[1]) for a, b in zip(samples[50:], samples[51:]))
+
+        res = r.execute_command('TS.MADD', 'packed{1}', 'PACKED', payload,
+                                'other{1}', 1, 1,
+                                'packed{1}', 'packed_delta', delta_payload)
+        env.assertEqual(len(res), 101)
+        env.assertEqual(res[:50], [t for t, _ in samples[:50]])
+        env.assertEqual(res[50], 1)
+        for t, v in samples:
+            r.execute_command('TS.ADD', 'text{1}', t, v)
+        env.assertEqual(r.execute_command('TS.RANGE', 'packed{1}', '-', '+'),
+                        r.execute_command('TS.RANGE', 'text{1}', '-', '+'))
+
+        # the samples of a packed payload are replied one by one
+        res = r.execute_command('TS.MADD', 'other{1}', 'PACKED', struct.pack('<qdqd', 1, 2, 2, 3))
+        env.assertEqual(len(res), 2)
+        env.assertTrue(isinstance(res[0], redis.ResponseError))
+        env.assertEqual(res[1], 2)
+
+        for bad in [b'', payload[:15], struct.pack('<qd', -1, 1), struct.pack('<qd', 1, float('nan'))]:
+            res = r.execute_command('TS.MADD', 'other{1}', 'PACKED', bad, 'other{1}', 3, 3)
+            env.assertEqual(len(res), 2)
+            env.assertTrue(isinstance(res[0], redis.ResponseError))
+        env.assertEqual(r.execute_command('TS.RANGE', 'other{1}', '-', '+'), [[1, b'1'], [2, b'3'], [3, b'3']])
+
+
+def test_ingest_allocations():
+    env = Env()
+    env.skipOnCluster()
+    skip_on_rlec()
+    with env.getConnection() as r:
+        keys = ['alloc{1}', 'alloc{2}', 'alloc{3}']
+        for key in keys:
+            r.execute_command('TS.CREATE', key)
+
+        def ingest(batch):
+            base = 1000 + batch * 100
+            r.execute_command('TS.MADD', *[a for i in range(90) for a in (keys[i % 3], base + i, i)])
+            r.execute_command('TS.ADD', keys[0], base + 95, 1)
+            r.execute_command('TS.ADDBULK', keys[1], *[a for i in range(95, 100) for a in (base + i, i)])
+
+        def stats():
+            info = r.execute_command('INFO', 'timeseries_ingest')
+            return info['timeseries_ingested_samples'], info['timeseries_ingest_allocations']
+
+        ingest(0)
+        samples, allocations = stats()
+        for batch in range(1, 100):
+            ingest(batch)
+        # the buffers of the commands are reused once they're grown
+        env.assertEqual(stats(), (samples + 99 * 96, allocations))
@@ -1578,3 +1578,371 @@ def test_ts_range_count_validation():
     assert r.execute_command('TS.RANGE', key, '-', '+', 'COUNT', 2, 'AGGREGATION', 'sum', 5) == [[0, '10'], [5, '35']]
 
 
+
+
+def test_range_with_chunk_checkpoints():
+    key = 'checkpoints{1}'
+    samples_count = 20000
+    with Env().getClusterConnectionIfNeeded() as r:
+        r.execute_command('TS.CREATE', key, 'COMPRESSED', 'CHUNK_SIZE', 65536)
+        samples = [[1000 + i * 10 + random.randint(0, 5), str(random.randint(0, 1000) / 10)]
+                   for i in range(samples_count)]
+        for i in range(0, samples_count, 1000):
+            args = [arg for ts, value in samples[i:i + 1000] for arg in (key, ts, value)]
+            r.execute_command('TS.MADD', *args)
+
+        def check_ranges():
+            info = r.execute_command('TS.INFO', key)
+            assert dict(zip(info[::2], info[1::2]))[b'checkpointsMemoryUsage'] > 0
+            for start, end in [(0, 10), (1500, 1600), (10000, 19999), (samples_count - 3, samples_count - 1)]:
+                expected = [[ts, float(v)] for ts, v in samples[start:end + 1]]
+                for from_ts in [samples[start][0], samples[start][0] - 1]:
+                    res = r.execute_command('TS.RANGE', key, from_ts, samples[end][0])
+                    assert [[ts, float(v)] for ts, v in res] == expected
+                    res = r.execute_command('TS.REVRANGE', key, from_ts, samples[end][0])
+                    assert [[ts, float(v)] for ts, v in res] == expected[::-1]
+
+        check_ranges()
+        # the checkpoints are rebuilt on load
+        dump = r.execute_command('DUMP', key)
+        r.execute_command('DEL', key)
+        r.execute_command('RESTORE', key, 0, dump)
+        check_ranges()
+
+
+def test_range_with_sealed_chunks():
+    env = Env()
+    if is_redis_version_lower_than(env, '7.0') or env.isCluster():
+        env.skip()
+    samples_count = 5000
+    samples = [[1000 + i * 10, str(random.randint(0, 10000) / 100)] for i in range(samples_count)]
+    with env.getConnection() as r:
+        memory = {}
+        for sealing in ['none', 'deferred', 'inline']:
+            r.execute_command('CONFIG', 'SET', 'ts-chunk-sealing', sealing)
+            key = 'sealed_' + sealing
+            r.execute_command('TS.CREATE', key, 'COMPRESSED', 'CHUNK_SIZE', 256)
+            expected = {ts: float(v) for ts, v in samples}
+            for i in range(0, samples_count, 1000):
+                args = [arg for ts, value in samples[i:i + 1000] for arg in (key, ts, value)]
+                r.execute_command('TS.MADD', *args)
+
+            def check_ranges():
+                items = sorted(expected.items())
+                for start, end in [(0, 10), (1500, 1600), (100, 4000), (len(items) - 3, len(items) - 1)]:
+                    res = r.execute_command('TS.RANGE', key, items[start][0] - 1, items[end][0])
+                    assert [[ts, float(v)] for ts, v in res] == [list(s) for s in items[start:end + 1]]
+                    res = r.execute_command('TS.REVRANGE', key, items[start][0], items[end][0])
+                    assert [[ts, float(v)] for ts, v in res] == [list(s) for s in items[start:end + 1]][::-1]
+                res = r.execute_command('TS.RANGE', key, '-', '+', 'AGGREGATION', 'sum', 1000)
+                assert len(res) > 0
+
+            check_ranges()
+            if sealing == 'deferred':
+                # the full chunks are sealed by a timer once the commands returned, not by the reads
+                time.sleep(0.1)
+            memory[sealing] = _get_ts_info(r, key).memory_usage
+
+            # late samples and deletions in sealed chunks
+            for i in range(300):
+                ts = 1000 + random.randint(0, samples_count * 10)
+                r.execute_command('TS.ADD', key, ts, i, 'ON_DUPLICATE', 'LAST')
+                expected[ts] = float(i)
+            r.execute_command('TS.DEL', key, 5000, 9000)
+            for ts in [ts for ts in expected if 5000 <= ts <= 9000]:
+                del expected[ts]
+            check_ranges()
+
+            dump = r.execute_command('DUMP', key)
+            r.execute_command('DEL', key)
+            r.execute_command('RESTORE', key, 0, dump)
+            check_ranges()
+
+        # fixed interval samples with 2 decimal digits are smaller once sealed
+        assert memory['inline'] < memory['none']
+        assert memory['deferred'] < memory['none']
+
+
+def test_range_fixed_interval():
+    env = Env()
+    if is_redis_version_lower_than(env, '7.0') or env.isCluster():
+        env.skip()
+    with env.getConnection() as r:
+        r.execute_command('CONFIG', 'SET', 'ts-chunk-sealing', 'none')
+        key = 'fixed_interval'
+        r.execute_command('TS.CREATE', key, 'COMPRESSED', 'CHUNK_SIZE', 1024)
+        # a fixed interval, then irregular timestamps
+        samples = [[1000 + i * 15, i % 7] for i in range(3000)]
+        ts = samples[-1][0]
+        for i in range(500):
+            ts += random.randint(16, 30)
+            samples.append([ts, i])
+        for i in range(0, len(samples), 1000):
+            args = [arg for ts, value in samples[i:i + 1000] for arg in (key, ts, value)]
+            r.execute_command('TS.MADD', *args)
+
+        def check_ranges():
+            for start, end in [(0, 10), (1500, 1600), (100, 2999), (2990, 3100), (len(samples) - 3, len(samples) - 1)]:
+                # bounds between the samples
+                res = r.execute_command('TS.RANGE', key, samples[start][0] - 1, samples[end][0] + 1)
+                assert [[ts, float(v)] for ts, v in res] == [[ts, float(v)] for ts, v in samples[start:end + 1]]
+                res = r.execute_command('TS.REVRANGE', key, samples[start][0], samples[end][0])
+                assert [[ts, float(v)] for ts, v in res] == [[ts, float(v)] for ts, v in samples[start:end + 1]][::-1]
+            assert r.execute_command('TS.RANGE', key, 1001, 1014) == []
+
+        check_ranges()
+        r.execute_command('TS.ADD', key, samples[20][0], 100, 'ON_DUPLICATE', 'LAST')
+        samples[20][1] = 100
+        check_ranges()
+
+        dump = r.execute_command('DUMP', key)
+        r.execute_command('DEL', key)
+        r.execute_command('RESTORE', key, 0, dump)
+        check_ranges()
+        for i in range(100):
+            samples.append([samples[-1][0] + 15, i])
+            r.execute_command('TS.ADD', key, samples[-1][0], i)
+        check_ranges()
+
+
+def test_range_aggregation_chunk_summaries():
+    env = Env()
+    if env.isCluster():
+        env.skip()
+    with env.getConnection() as r:
+        samples = {}
+        for key in ['summaries_compressed', 'summaries_uncompressed']:
+            encoding = 'COMPRESSED' if key == 'summaries_compressed' else 'UNCOMPRESSED'
+            r.execute_command('TS.CREATE', key, encoding, 'CHUNK_SIZE', 256, 'DUPLICATE_POLICY', 'LAST')
+        for i in range(5000):
+            samples[1000 + i * 10] = random.randint(-1000, 1000) / 8
+        for key in ['summaries_compressed', 'summaries_uncompressed']:
+            args = [arg for ts, value in samples.items() for arg in (key, ts, value)]
+            r.execute_command('TS.MADD', *args)
+
+        def expected_aggregation(agg, values):
+            if agg == 'min':
+                return min(values)
+            if agg == 'max':
+                return max(values)
+            if agg == 'sum':
+                return sum(values)
+            if agg == 'avg':
+                return sum(values) / len(values)
+            if agg == 'count':
+                return len(values)
+            if agg == 'range':
+                return max(values) - min(values)
+            if agg == 'std.p':
+                mean = sum(values) / len(values)
+                return math.sqrt(sum((v - mean) ** 2 for v in values) / len(values))
+
+        def check_aggregations():
+            for key in ['summaries_compressed', 'summaries_uncompressed']:
+                for bucket in [1000, 20000, 100000]:
+                    for start, end in [(0, '+'), (12345, 40000)]:
+                        buckets = {}
+                        for ts in sorted(samples):
+                            if ts >= start and (end == '+' or ts <= end):
+                                buckets.setdefault(ts - ts % bucket, []).append((ts, samples[ts]))
+                        for agg in ['min', 'max', 'sum', 'avg', 'count', 'range', 'std.p', 'first', 'last']:
+                            res = r.execute_command('TS.RANGE', key, start, end, 'AGGREGATION', agg, bucket)
+                            assert [b for b, _ in res] == sorted(buckets)
+                            for b, value in res:
+                                bucket_samples = buckets[b]
+                                if agg == 'first':
+                                    expected = bucket_samples[0][1]
+                                elif agg == 'last':
+                                    expected = bucket_samples[-1][1]
+                                else:
+                                    expected = expected_aggregation(agg, [v for _, v in bucket_samples])
+                                assert abs(float(value) - expected) <= ALLOWED_ERROR * max(1, abs(expected))
+
+        check_aggregations()
+        # late samples and overrides
+        for i in range(300):
+            ts = 1000 + random.randint(0, 50000)
+            samples[ts] = random.randint(-1000, 1000) / 8
+            for key in ['summaries_compressed', 'summaries_uncompressed']:
+                r.execute_command('TS.ADD', key, ts, samples[ts])
+        check_aggregations()
+        for key in ['summaries_compressed', 'summaries_uncompressed']:
+            r.execute_command('TS.DEL', key, 20000, 25000)
+        samples = {ts: v for ts, v in samples.items() if ts < 20000 or ts > 25000}
+        check_aggregations()
+
+
+def test_range_uncompressed_borrowed_chunks():
+    with Env().getClusterConnectionIfNeeded() as r:
+        key = 'borrowed{1}'
+        r.execute_command('TS.CREATE', key, 'UNCOMPRESSED', 'CHUNK_SIZE', 128)
+        samples = [[1000 + i * 10, i % 13] for i in range(500)]
+        for ts, value in samples:
+            r.execute_command('TS.ADD', key, ts, value)
+
+        def as_floats(res):
+            return [[ts, float(v)] for ts, v in res]
+
+        for _ in range(2):  # the stages must not modify the chunks they read
+            assert as_floats(r.execute_command('TS.RANGE', key, 1995, 3005)) == \
+                [[ts, float(v)] for ts, v in samples if 1995 <= ts <= 3005]
+            assert as_floats(r.execute_command('TS.RANGE', key, '-', '+', 'FILTER_BY_VALUE', 3, 5)) == \
+                [[ts, float(v)] for ts, v in samples if 3 <= v <= 5]
+            filter_ts = [1000, 1010, 2500, 5990]
+            assert as_floats(r.execute_command('TS.RANGE', key, '-', '+', 'FILTER_BY_TS', *filter_ts)) == \
+                [[ts, float(v)] for ts, v in samples if ts in filter_ts]
+            res = r.execute_command('TS.RANGE', key, '-', '+', 'AGGREGATION', 'sum', 100)
+            assert as_floats(res) == [[b, float(sum(v for ts, v in samples if b <= ts < b + 100))]
+                                      for b in range(1000, 6000, 100)]
+            res = r.execute_command('TS.RANGE', key, '-', '+', 'FILTER_BY_VALUE', 0, 6, 'AGGREGATION', 'count', 1000)
+            assert as_floats(res) == [[b, float(len([v for ts, v in samples if b <= ts < b + 1000 and v <= 6]))]
+                                      for b in range(1000, 6000, 1000)]
+
+
+def test_vectorized_aggregations_reverse():
+    with Env(decodeResponses=True).getClusterConnectionIfNeeded() as r:
+        samples = {}
+        ts = 1000
+        for i in range(3000):
+            # gaps of a few buckets for EMPTY
+            ts += 7 if i % 500 else 3000
+            samples[ts] = random.randint(-1000, 1000) / 8
+        for key in ['vec_compressed{1}', 'vec_uncompressed{1}']:
+            r.execute_command('TS.CREATE', key, 'CHUNK_SIZE', 256,
+                              'UNCOMPRESSED' if 'uncompressed' in key else 'COMPRESSED')
+            for ts, value in samples.items():
+                r.execute_command('TS.ADD', key, ts, value)
+
+        def assert_same(res, expected):
+            assert [b for b, _ in res] == [b for b, _ in expected]
+            for (_, value), (_, expected_value) in zip(res, expected):
+                if expected_value == 'NaN':
+                    assert value == 'NaN'
+                else:
+                    assert abs(float(value) - float(expected_value)) <= \
+                        ALLOWED_ERROR * max(1, abs(float(expected_value)))
+
+        for key in ['vec_compressed{1}', 'vec_uncompressed{1}']:
+            for bucket in [10, 1000, 5000]:
+                for start, end in [('-', '+'), (2345, 15000)]:
+                    for agg in ['min', 'max', 'sum', 'avg', 'count', 'range', 'std.p', 'std.s', 'var.p',
+                                'var.s']:
+                        for empty in [[], ['EMPTY']]:
+                            args = [start, end, 'AGGREGATION', agg, bucket] + empty
+                            res = r.execute_command('TS.REVRANGE', key, *args)
+                            assert_same(res, r.execute_command('TS.RANGE', key, *args)[::-1])
+                    # a reversed bucket is appended from its latest sample
+                    args = [start, end, 'AGGREGATION']
+                    assert_same(r.execute_command('TS.REVRANGE', key, *args, 'first', bucket),
+                                r.execute_command('TS.RANGE', key, *args, 'last', bucket)[::-1])
+                    assert_same(r.execute_command('TS.REVRANGE', key, *args, 'last', bucket),
+                                r.execute_command('TS.RANGE', key, *args, 'first', bucket)[::-1])
+
+
+def test_filter_by_value_selectivity():
+    with Env(decodeResponses=True).getClusterConnectionIfNeeded() as r:
+        samples = [[1000 + i * 10, random.randint(0, 99)] for i in range(3000)]
+        for key in ['filter_compressed{1}', 'filter_uncompressed{1}']:
+            r.execute_command('TS.CREATE', key, 'CHUNK_SIZE', 256,
+                              'UNCOMPRESSED' if 'uncompressed' in key else 'COMPRESSED')
+            r.execute_command('TS.MADD', *[arg for ts, v in samples for arg in (key, ts, v)])
+            for min_value, max_value in [[0, 99], [0, 49], [10, 14], [42, 42], [100, 200]]:
+                expected = [[ts, float(v)] for ts, v in samples if min_value <= v <= max_value]
+                res = r.execute_command('TS.RANGE', key, '-', '+', 'FILTER_BY_VALUE', min_value, max_value)
+                assert [[ts, float(v)] for ts, v in res] == expected
+                res = r.execute_command('TS.REVRANGE', key, '-', '+', 'FILTER_BY_VALUE', min_value, max_value)
+                assert [[ts, float(v)] for ts, v in res] == expected[::-1]
+
+                counts = {}
+                for ts, _ in expected:
+                    if 5005 <= ts <= 25005:
+                        counts[ts - ts % 1000] = counts.get(ts - ts % 1000, 0) + 1
+                res = r.execute_command('TS.RANGE', key, 5005, 25005, 'FILTER_BY_VALUE', min_value, max_value,
+                                        'AGGREGATION', 'count', 1000)
+                assert [[ts, float(v)] for ts, v in res] == [[b, float(c)] for b, c in sorted(counts.items())]
+
+
+def test_filter_by_ts_unlimited():
+    env = Env(decodeResponses=True)
+    with env.getClusterConnectionIfNeeded() as r:
+        # runs of samples with gaps, so whole chunks hold no filter timestamp
+        samples = {}
+        ts = 1000
+        for i in range(6000):
+            ts += 10 if i % 1000 else 50000
+            samples[ts] = i % 97
+        timestamps = sorted(samples)
+        # thousands of timestamps, which fall on samples, in the gaps and out of the series
+        filter_ts = random.sample(timestamps, 2000) + [t + 5 for t in random.sample(timestamps, 500)] + \
+            [0, 1, timestamps[0] - 1, timestamps[-1] + 1, timestamps[-1] + 50000] + \
+            list(range(timestamps[2500], timestamps[2700], 10))
+        for key in ['filter_ts_compressed{1}', 'filter_ts_uncompressed{1}']:
+            r.execute_command('TS.CREATE', key, 'CHUNK_SIZE', 256, 'LABELS', 'filter_ts', 'yes',
+                              'UNCOMPRESSED' if 'uncompressed' in key else 'COMPRESSED')
+            r.execute_command('TS.MADD', *[arg for ts, v in samples.items() for arg in (key, ts, v)])
+            for start, end in [['-', '+'], [timestamps[100], timestamps[4321]],
+                               [timestamps[1000] - 1, timestamps[1999] + 1]]:
+                lo = 0 if start == '-' else start
+                hi = float('inf') if end == '+' else end
+                expected = [[t, float(samples[t])] for t in sorted(set(filter_ts)) if t in samples and lo <= t <= hi]
+                res = r.execute_command('TS.RANGE', key, start, end, 'FILTER_BY_TS', *filter_ts)
+                assert [[t, float(v)] for t, v in res] == expected
+                res = r.execute_command('TS.REVRANGE', key, start, end, 'FILTER_BY_TS', *filter_ts)
+                assert [[t, float(v)] for t, v in res] == expected[::-1]
+                res = r.execute_command('TS.RANGE', key, start, end, 'FILTER_BY_TS', *filter_ts,
+                                        'FILTER_BY_VALUE', 10, 50, 'COUNT', 100)
+                assert [[t, float(v)] for t, v in res] == [s for s in expected if 10 <= s[1] <= 50][:100]
+
+                counts = {}
+                for t, _ in expected:
+                    counts[t - t % 10000] = counts.get(t - t % 10000, 0) + 1
+                res = r.execute_command('TS.RANGE', key, start, end, 'FILTER_BY_TS', *filter_ts,
+                                        'AGGREGATION', 'count', 10000)
+                assert [[t, float(v)] for t, v in res] == [[b, float(c)] for b, c in sorted(counts.items())]
+
+        res = env.getConnection().execute_command('TS.MRANGE', '-', '+', 'FILTER_BY_TS', *filter_ts, 'FILTER', 'filter_ts=yes')
+        expected = [[t, float(samples[t])] for t in sorted(set(filter_ts)) if t in samples]
+        assert len(res) == 2
+        for _, _, series_samples in res:
+            assert [[t, float(v)] for t, v in series_samples] == expected
+
+
+def test_fused_range_shapes():
+    env = Env(decodeResponses=True)
+    env.skipOnCluster()
+    with env.getConnection() as r:
+        samples = {}
+        ts = 1000
+        for i in range(5000):
+            ts += random.randint(1, 30) if i % 800 else 20000
+            samples[ts] = random.randint(-50, 50) / 4
+        timestamps = sorted(samples)
+        for key in ['fused_compressed', 'fused_uncompressed']:
+            r.execute_command('TS.CREATE', key, 'CHUNK_SIZE', 256,
+                              'UNCOMPRESSED' if 'uncompressed' in key else 'COMPRESSED')
+            r.execute_command('TS.MADD', *[arg for ts, v in samples.items() for arg in (key, ts, v)])
+
+        queries = []
+        for start, end in [['-', '+'], [timestamps[321], timestamps[4321]], [timestamps[10], timestamps[12]]]:
+            for filter_args in [[], ['FILTER_BY_VALUE', -3, 5], ['FILTER_BY_VALUE', 100, 200]]:
+                for count_args in [[], ['COUNT', 1], ['COUNT', 77]]:
+                    queries.append([start, end] + filter_args + count_args)
+                    for agg in ['avg', 'sum', 'min', 'max', 'range', 'count', 'first', 'last',
+                                'std.p', 'var.s']:
+                        for bucket_args in [[1000], [37, 'ALIGN', 'start'], [5000, 'BUCKETTIMESTAMP', 'mid']]:
+                            queries.append([start, end] + filter_args + count_args + ['AGGREGATION', agg] + bucket_args)
+
+        try:
+            for key in ['fused_compressed', 'fused_uncompressed']:
+                for command in ['TS.RANGE', 'TS.REVRANGE']:
+                    for query in queries:
+                        r.execute_command('config', 'set', 'ts-fused-range', 'no')
+                        expected = r.execute_command(command, key, *query)
+                        r.execute_command('config', 'set', 'ts-fused-range', 'yes')
+                        res = r.execute_command(command, key, *query)
+                        env.assertEqual(len(res), len(expected), message=str([command] + query))
+                        for (ts, v), (expected_ts, expected_v) in zip(res, expected):
+                            assert ts == expected_ts
+                            assert math.isclose(float(v), float(expected_v), rel_tol=1e-9, abs_tol=1e-9)
+        finally:
+            r.execute_command('config', 'set', 'ts-fused-range', 'yes')
@@ -24,6 +24,7 @@ def test_resp3(env):
         assert res == [1000, 5.0]
         res = r.execute_command('ts.info', t1, 'DEBUG')
         res.pop(b'memoryUsage')
+        assert res.pop(b'checkpointsMemoryUsage') == 0
         default_duplicate_policy = env.cmd("config", "get", "ts-duplicate-policy")[b"ts-duplicate-policy"]
         assert res == {
             b'totalSamples': 1000,
@@ -52,7 +53,7 @@ def test_resp3(env):
                         b'bytesPerSample': 0.2612244784832001
                     }
                 ],
-            b'ignoreMaxTimeDiff': 0, b'ignoreMaxValDiff': 0.0,
+            b'ignoreMaxTimeDiff': 0, b'ignoreMaxValDiff': 0.0, b'accumulateWindow': 0,
         }
         res = r1.execute_command('ts.mget', 'FILTER', 'name=mush')
         assert res == {b't1{1}': [{}, [1000, 5.0]],
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+
+// Measures the kernels of the module per instruction set level, and the chunk decoders.
+// Usage: microbench [all|compaction|filter|chunk] [samples] [rounds]
+
+#include "utils/arch_features.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rmutil/alloc.h"
+
+enum
+{
+    ISA_SCALAR, // the code path before the kernels
+    ISA_PORTABLE,
+    ISA_AVX2,
+    ISA_AVX512F,
+    ISA_COUNT
+};
+
+static const char *isaNames[ISA_COUNT] = { "scalar", "portable", "avx2", "avx512f" };
+static bool isaSupported[ISA_COUNT] = { true, true, false, false };
+
+static double nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void printIsaHeader(const char *kernel, const char *param) {
+    printf("%-8s %8s", kernel, param);
+    for (int isa = 0; isa < ISA_COUNT; ++isa) {
+        printf(" %10s", isaNames[isa]);
+    }
+    printf("   (ns/sample)\n");
+}
+
+#include "microbench_chunk.c"
+#include "microbench_compaction.c"
+#include "microbench_filter.c"
+
+int main(int argc, char *argv[]) {
+    RMUTil_InitAlloc();
+    const char *suite = argc > 1 ? argv[1] : "all";
+    const size_t n = argc > 2 ? strtoul(argv[2], NULL, 10) : 1 << 16;
+    const int rounds = argc > 3 ? atoi(argv[3]) : 200;
+
+    const X86Features *features = getArchitectureOptimization();
+    isaSupported[ISA_AVX2] = features && features->avx2;
+    isaSupported[ISA_AVX512F] = features && features->avx512f;
+
+    if (!strcmp(suite, "all") || !strcmp(suite, "compaction")) {
+        benchAppendValuesVec(n, rounds);
+    }
+    if (!strcmp(suite, "all") || !strcmp(suite, "filter")) {
+        benchFilterByValue(n, rounds);
+    }
+    if (!strcmp(suite, "all") || !strcmp(suite, "chunk")) {
+        benchChunks(n, rounds);
+    }
+    return 0;
+}
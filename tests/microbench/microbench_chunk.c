@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "chunk.h"
+#include "compressed_chunk.h"
+#include "config.h"
+#include "enriched_chunk.h"
+#include "gorilla.h"
+
+// The block decoder against the per sample iterator, over a chunk of jittered timestamps and
+// random values, like the series of scaling-ts_range_90k_datapoints.
+// The decoding is a chain of dependent reads, the position of a sample is known only once the
+// control bits of the previous one are decoded. The block decoder saves the calls and most of the
+// mispredicted branches of the iterator, not the chain.
+static void benchDecodeBlock(size_t n, int rounds) {
+    CompressedChunk *chunk = Compressed_NewChunk(n * 16);
+    for (size_t i = 0; i < n; ++i) {
+        Sample sample = { .timestamp = 1000 + i * 10 + (rand() % 3),
+                          .value = (double)(rand() % 1000) / 10 };
+        Compressed_AddSample(chunk, &sample);
+    }
+    timestamp_t *timestamps = malloc(n * sizeof(*timestamps));
+    double *values = malloc(n * sizeof(*values));
+    timestamp_t checksum = 0;
+
+    double start = nowNs();
+    for (int round = 0; round < rounds; ++round) {
+        Sample sample;
+        Compressed_Iterator iter;
+        Compressed_ResetChunkIterator(&iter, chunk);
+        for (size_t i = 0; i < n; ++i) {
+            Compressed_ChunkIteratorGetNext(&iter, &sample);
+            timestamps[i] = sample.timestamp;
+            values[i] = sample.value;
+        }
+        checksum += timestamps[n - 1];
+    }
+    const double sampleTime = nowNs() - start;
+
+    start = nowNs();
+    for (int round = 0; round < rounds; ++round) {
+        Compressed_Iterator iter;
+        Compressed_ResetChunkIterator(&iter, chunk);
+        Compressed_ChunkIteratorGetNextBlock(&iter, timestamps, values, n);
+        checksum += timestamps[n - 1];
+    }
+    const double blockTime = nowNs() - start;
+
+    printf("%-12s %10s %10s %10s   (ns/sample)\n", "decode", "sample", "block", "speedup");
+    printf("%-12s %10.2f %10.2f %9.2fx\n",
+           "gorilla",
+           sampleTime / ((double)n * rounds),
+           blockTime / ((double)n * rounds),
+           sampleTime / blockTime);
+    // keeps the results alive
+    fprintf(stderr, "checksum %lu\n", checksum);
+    free(timestamps);
+    free(values);
+    Compressed_FreeChunk(chunk);
+}
+
+// Loads the samples of a flow tests dataset, either a value per line or TS.ADD commands
+static Sample *loadDataset(const char *name, size_t *n) {
+    // the microbenchmarks run either from the repository root or from tests/microbench
+    char path[256];
+    snprintf(path, sizeof(path), "tests/flow/%s", name);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        snprintf(path, sizeof(path), "../flow/%s", name);
+        file = fopen(path, "r");
+    }
+    if (!file) {
+        return NULL;
+    }
+    size_t capacity = 1024;
+    Sample *samples = malloc(capacity * sizeof(Sample));
+    char line[1024];
+    *n = 0;
+    while (fgets(line, sizeof(line), file)) {
+        Sample *sample = &samples[*n];
+        if (strncmp(line, "TS.ADD", 6) == 0) {
+            if (sscanf(line, "%*s %*s %lu %lf", &sample->timestamp, &sample->value) != 2) {
+                continue;
+            }
+        } else {
+            if (sscanf(line, "%lf", &sample->value) != 1) {
+                continue;
+            }
+            sample->timestamp = 1000 + *n * 10;
+        }
+        if (++*n == capacity) {
+            capacity *= 2;
+            samples = realloc(samples, capacity * sizeof(Sample));
+        }
+    }
+    fclose(file);
+    return samples;
+}
+
+// The size and the block decoding time of the value encodings over the datasets of the flow tests
+static void benchValueEncodings(int rounds) {
+    const char *datasets[] = { "lemire_canada.txt", "issue358.txt" };
+    Chunk_t *(*newChunk[])(size_t) = { Compressed_NewChunk, Chimp_NewChunk, Decimal_NewChunk };
+    const char *names[] = { "gorilla", "chimp", "decimal" };
+    timestamp_t checksum = 0;
+    printf("%-18s %-8s %12s %10s\n", "dataset", "encoding", "bytes/sample", "ns/sample");
+    for (size_t d = 0; d < sizeof(datasets) / sizeof(datasets[0]); ++d) {
+        size_t n;
+        Sample *dataset = loadDataset(datasets[d], &n);
+        if (!dataset) {
+            printf("%-18s wasn't found, skipping it\n", datasets[d]);
+            continue;
+        }
+        timestamp_t *timestamps = malloc(n * sizeof(*timestamps));
+        double *values = malloc(n * sizeof(*values));
+        for (size_t c = 0; c < sizeof(names) / sizeof(names[0]); ++c) {
+            CompressedChunk *chunk = newChunk[c](n * 16);
+            for (size_t i = 0; i < n; ++i) {
+                Compressed_AddSample(chunk, &dataset[i]);
+            }
+            const double start = nowNs();
+            for (int round = 0; round < rounds; ++round) {
+                Compressed_Iterator iter;
+                Compressed_ResetChunkIterator(&iter, chunk);
+                Compressed_ChunkIteratorGetNextBlock(&iter, timestamps, values, n);
+                checksum += timestamps[n - 1];
+            }
+            const double elapsed = nowNs() - start;
+            printf("%-18s %-8s %12.2f %10.2f\n",
+                   datasets[d],
+                   names[c],
+                   (double)chunk->idx / 8 / n,
+                   elapsed / ((double)n * rounds));
+            Compressed_FreeChunk(chunk);
+        }
+        free(timestamps);
+        free(values);
+        free(dataset);
+    }
+    fprintf(stderr, "checksum %lu\n", checksum);
+}
+
+// Decoding a whole sealed chunk against the Gorilla layout, a fixed interval series with two
+// decimal digits values
+static void benchSealedDecode(size_t n, int rounds) {
+    CompressedChunk *chunk = Compressed_NewChunk(n * 16);
+    for (size_t i = 0; i < n; ++i) {
+        Sample sample = { .timestamp = 1000 + i * 10, .value = (double)(rand() % 10000) / 100 };
+        Compressed_AddSample(chunk, &sample);
+    }
+    CompressedChunk *sealed = Compressed_CloneChunk(chunk);
+    Compressed_SealChunk(sealed);
+
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n);
+    CompressedChunk *chunks[] = { chunk, sealed };
+    const char *names[] = { "gorilla", "frozen" };
+    // the Gorilla chunk is allocated for the worst case, its size is the size of the encoding
+    const double sizes[] = { (double)chunk->idx / 8, Compressed_GetChunkSize(sealed, false) };
+    double times[2];
+    printf("%-12s %12s %10s   (sealed chunk decode)\n", "layout", "bytes/sample", "ns/sample");
+    for (int c = 0; c < 2; ++c) {
+        const double start = nowNs();
+        for (int round = 0; round < rounds; ++round) {
+            Compressed_ProcessChunk(chunks[c], 0, UINT64_MAX, enrichedChunk, false);
+        }
+        times[c] = nowNs() - start;
+        printf("%-12s %12.2f %10.2f\n",
+               names[c],
+               sizes[c] / n,
+               times[c] / ((double)n * rounds));
+    }
+    printf("%-12s %22.2fx\n", "speedup", times[0] / times[1]);
+
+    FreeEnrichedChunk(enrichedChunk);
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(sealed);
+}
+
+// Decoding a fixed interval chunk against the same samples with delta of deltas timestamps, for
+// the whole chunk and for narrow ranges
+static void benchIntervalDecode(size_t n, int rounds) {
+    const size_t n_ranges = 2000, range = 100;
+    TSGlobalConfig.chunkCheckpointInterval = 256;
+    CompressedChunk *chunks[] = { Compressed_NewChunk(n * 16), Compressed_NewChunk(n * 16) };
+    chunks[0]->timestampEncoding = TIMESTAMP_ENCODING_DELTA;
+    for (size_t i = 0; i < n; ++i) {
+        Sample sample = { .timestamp = 1000 + i * 10, .value = (double)(rand() % 1000) / 10 };
+        Compressed_AddSample(chunks[0], &sample);
+        Compressed_AddSample(chunks[1], &sample);
+    }
+
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n);
+    const char *names[] = { "delta", "interval" };
+    double times[2], rangeTimes[2];
+    printf("%-12s %12s %10s %10s   (timestamps decode)\n",
+           "timestamps",
+           "bits/sample",
+           "ns/sample",
+           "ns/range");
+    for (int c = 0; c < 2; ++c) {
+        double start = nowNs();
+        for (int round = 0; round < rounds; ++round) {
+            Compressed_ProcessChunk(chunks[c], 0, UINT64_MAX, enrichedChunk, false);
+        }
+        times[c] = nowNs() - start;
+
+        srand(42);
+        start = nowNs();
+        for (size_t r = 0; r < n_ranges; ++r) {
+            const timestamp_t first = 1000 + (rand() % (n - range)) * 10;
+            Compressed_ProcessChunk(
+                chunks[c], first, first + (range - 1) * 10, enrichedChunk, false);
+        }
+        rangeTimes[c] = nowNs() - start;
+        printf("%-12s %12.2f %10.2f %10.1f\n",
+               names[c],
+               (double)chunks[c]->idx / n,
+               times[c] / ((double)n * rounds),
+               rangeTimes[c] / n_ranges);
+    }
+    printf("%-12s %22.2fx %9.2fx\n", "speedup", times[0] / times[1], rangeTimes[0] / rangeTimes[1]);
+
+    TSGlobalConfig.chunkCheckpointInterval = 0;
+    FreeEnrichedChunk(enrichedChunk);
+    Compressed_FreeChunk(chunks[0]);
+    Compressed_FreeChunk(chunks[1]);
+}
+
+// Range reads from an uncompressed chunk, forward and reverse, of the whole chunk and of 100
+// samples
+static void benchUncompressedRanges(size_t n, int rounds) {
+    const size_t range = 100;
+    Chunk *chunk = Uncompressed_NewChunk(n * SAMPLE_SIZE);
+    for (size_t i = 0; i < n; ++i) {
+        Sample sample = { .timestamp = 1000 + i * 10, .value = i };
+        Uncompressed_AddSample(chunk, &sample);
+    }
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n);
+    printf("%-12s %10s %10s   (uncompressed ranges)\n", "direction", "ns/sample", "ns/range");
+    for (int reverse = 0; reverse < 2; ++reverse) {
+        double start = nowNs();
+        for (int round = 0; round < rounds; ++round) {
+            Uncompressed_ProcessChunk(chunk, 0, UINT64_MAX, enrichedChunk, reverse);
+        }
+        const double full = (nowNs() - start) / ((double)n * rounds);
+        start = nowNs();
+        for (int round = 0; round < rounds * 100; ++round) {
+            const timestamp_t from = 1000 + (round * 7919 % (n - range)) * 10;
+            Uncompressed_ProcessChunk(
+                chunk, from, from + (range - 1) * 10, enrichedChunk, reverse);
+        }
+        const double small = (nowNs() - start) / (rounds * 100);
+        printf("%-12s %10.2f %10.1f\n", reverse ? "reverse" : "forward", full, small);
+    }
+    FreeEnrichedChunk(enrichedChunk);
+    Uncompressed_FreeChunk(chunk);
+}
+
+static void benchChunks(size_t n, int rounds) {
+    benchDecodeBlock(n, rounds);
+    benchValueEncodings(rounds);
+    benchSealedDecode(n, rounds);
+    benchIntervalDecode(n, rounds);
+    benchUncompressedRanges(n, rounds);
+}
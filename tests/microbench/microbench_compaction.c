@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "compaction.h"
+#include "compactions/compaction_avx2.h"
+#include "compactions/compaction_avx512f.h"
+#include "compactions/compaction_common.h"
+
+typedef void (*AppendValuesVecFunc)(void *__restrict__ context,
+                                    double *__restrict__ values,
+                                    size_t si,
+                                    size_t ei);
+
+static void appendValues(void *context, double *values, size_t si, size_t ei);
+
+#if defined(__x86_64__)
+#define APPEND_VALUES_KERNELS(name)                                                                \
+    name##AppendValuesVec, name##AppendValuesAVX2, name##AppendValuesAVX512F
+#else
+#define APPEND_VALUES_KERNELS(name) name##AppendValuesVec, NULL, NULL
+#endif
+
+static const struct
+{
+    TS_AGG_TYPES_T type;
+    AppendValuesVecFunc kernels[ISA_COUNT];
+} aggregations[] = {
+    { TS_AGG_MAX, { appendValues, APPEND_VALUES_KERNELS(Max) } },
+    { TS_AGG_MIN, { appendValues, APPEND_VALUES_KERNELS(Min) } },
+    { TS_AGG_RANGE, { appendValues, APPEND_VALUES_KERNELS(MaxMin) } },
+    { TS_AGG_SUM, { appendValues, SumAppendValuesVec, NULL, NULL } },
+    { TS_AGG_AVG, { appendValues, AvgAppendValuesVec, NULL, NULL } },
+    { TS_AGG_VAR_S, { appendValues, StdAppendValuesVec, NULL, NULL } },
+    { TS_AGG_COUNT, { appendValues, CountAppendValuesVec, NULL, NULL } },
+    { TS_AGG_FIRST, { appendValues, FirstAppendValuesVec, NULL, NULL } },
+    { TS_AGG_LAST, { appendValues, LastAppendValuesVec, NULL, NULL } },
+};
+
+// the aggregation iterator without kernels, which appends the samples one by one
+static AggregationClass *scalarClass;
+
+static void appendValues(void *context, double *values, size_t si, size_t ei) {
+    for (size_t i = si; i <= ei; ++i) {
+        scalarClass->appendValue(context, values[i], i);
+    }
+}
+
+// Aggregates the values into buckets of bucketSize samples, as a range query does
+static double measure(AggregationClass *aggClass,
+                      AppendValuesVecFunc kernel,
+                      double *values,
+                      size_t n,
+                      size_t bucketSize,
+                      int rounds,
+                      double *checksum) {
+    void *context = aggClass->createContext(false);
+    scalarClass = aggClass;
+    double value;
+    const double start = nowNs();
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t si = 0; si < n; si += bucketSize) {
+            const size_t ei = (si + bucketSize < n ? si + bucketSize : n) - 1;
+            kernel(context, values, si, ei);
+            aggClass->finalize(context, &value);
+            aggClass->resetContext(context);
+            *checksum += value;
+        }
+    }
+    const double elapsed = nowNs() - start;
+    aggClass->freeContext(context);
+    return elapsed / ((double)n * rounds);
+}
+
+// Measures the ns/sample of the bucket kernels of the aggregations, per bucket size
+static void benchAppendValuesVec(size_t n, int rounds) {
+    const size_t bucketSizes[] = { 4, 32, 256, 4096 };
+    double *values = malloc(n * sizeof(*values));
+    for (size_t i = 0; i < n; ++i) {
+        values[i] = (rand() % 200000 - 100000) / 8.0;
+    }
+
+    double checksum = 0;
+    printIsaHeader("agg", "bucket");
+    for (size_t a = 0; a < sizeof(aggregations) / sizeof(aggregations[0]); ++a) {
+        AggregationClass *aggClass = GetAggClass(aggregations[a].type);
+        for (size_t b = 0; b < sizeof(bucketSizes) / sizeof(bucketSizes[0]); ++b) {
+            printf("%-8s %8zu", AggTypeEnumToStringLowerCase(aggClass->type), bucketSizes[b]);
+            for (int isa = 0; isa < ISA_COUNT; ++isa) {
+                const AppendValuesVecFunc kernel = aggregations[a].kernels[isa];
+                if (!kernel || !isaSupported[isa]) {
+                    printf(" %10s", "-");
+                    continue;
+                }
+                printf(" %10.3f",
+                       measure(aggClass, kernel, values, n, bucketSizes[b], rounds, &checksum));
+            }
+            printf("\n");
+        }
+    }
+    // keeps the results alive
+    fprintf(stderr, "checksum %g\n", checksum);
+    free(values);
+}
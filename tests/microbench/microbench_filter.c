@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "filters/filter_value.h"
+#include "filters/filter_value_avx2.h"
+#include "filters/filter_value_avx512f.h"
+
+typedef size_t (*FilterByValueFunc)(timestamp_t *dstTimestamps,
+                                    double *dstValues,
+                                    const timestamp_t *timestamps,
+                                    const double *values,
+                                    size_t n,
+                                    double min,
+                                    double max);
+
+// the filter stage before the kernels, with a branch on every sample
+static size_t filterByValueScalar(timestamp_t *dstTimestamps,
+                                  double *dstValues,
+                                  const timestamp_t *timestamps,
+                                  const double *values,
+                                  size_t n,
+                                  double min,
+                                  double max) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (values[i] >= min && values[i] <= max) {
+            dstTimestamps[count] = timestamps[i];
+            dstValues[count] = values[i];
+            ++count;
+        }
+    }
+    return count;
+}
+
+static const FilterByValueFunc filterKernels[ISA_COUNT] = {
+    filterByValueScalar,
+    FilterByValueVec,
+#if defined(__x86_64__)
+    FilterByValueAVX2,
+    FilterByValueAVX512F,
+#else
+    NULL,
+    NULL,
+#endif
+};
+
+// Measures the ns/sample of the FILTER_BY_VALUE kernels per selectivity, the share of the samples
+// which match. The values are random so the branch of the scalar filter is unpredictable.
+static void benchFilterByValue(size_t n, int rounds) {
+    const int selectivities[] = { 1, 5, 25, 50, 95 }; // percents
+    timestamp_t *timestamps = malloc(n * sizeof(*timestamps));
+    double *values = malloc(n * sizeof(*values));
+    timestamp_t *dstTimestamps = malloc(n * sizeof(*dstTimestamps));
+    double *dstValues = malloc(n * sizeof(*dstValues));
+    for (size_t i = 0; i < n; ++i) {
+        timestamps[i] = 1000 + i * 10;
+        values[i] = rand() % 100;
+    }
+
+    size_t checksum = 0;
+    printIsaHeader("filter", "match%");
+    for (size_t s = 0; s < sizeof(selectivities) / sizeof(selectivities[0]); ++s) {
+        printf("%-8s %8d", "value", selectivities[s]);
+        for (int isa = 0; isa < ISA_COUNT; ++isa) {
+            if (!filterKernels[isa] || !isaSupported[isa]) {
+                printf(" %10s", "-");
+                continue;
+            }
+            const double start = nowNs();
+            for (int round = 0; round < rounds; ++round) {
+                checksum += filterKernels[isa](
+                    dstTimestamps, dstValues, timestamps, values, n, 0, selectivities[s] - 1);
+            }
+            printf(" %10.3f", (nowNs() - start) / ((double)n * rounds));
+        }
+        printf("\n");
+    }
+    // keeps the results alive
+    fprintf(stderr, "checksum %zu\n", checksum);
+    free(timestamps);
+    free(values);
+    free(dstTimestamps);
+    free(dstValues);
+}
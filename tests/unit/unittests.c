@@ -12,9 +12,13 @@
 #include "minunit.h"
 
 #include "parse_policies.h"
+#include "unittests_compaction.c"
 #include "unittests_compressed_chunk.c"
+#include "unittests_filter_by_ts.c"
+#include "unittests_filter_by_value.c"
 #include "unittests_parse_duplicate_policy.c"
 #include "unittests_parse_policies.c"
+#include "unittests_scratch.c"
 #include "unittests_uncompressed_chunk.c"
 
 #include <stdio.h>
@@ -28,6 +32,10 @@ int main(int argc, char *argv[]) {
     MU_RUN_SUITE(uncompressed_chunk_test_suite);
     MU_RUN_SUITE(compressed_chunk_test_suite);
     MU_RUN_SUITE(parse_duplicate_policy_test_suite);
+    MU_RUN_SUITE(compaction_test_suite);
+    MU_RUN_SUITE(filter_by_ts_test_suite);
+    MU_RUN_SUITE(filter_by_value_test_suite);
+    MU_RUN_SUITE(scratch_test_suite);
     MU_REPORT();
     return minunit_fail;
 }
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "compaction.h"
+#include "consts.h"
+#include "minunit.h"
+#include "compactions/compaction_avx2.h"
+#include "compactions/compaction_avx512f.h"
+#include "compactions/compaction_common.h"
+#include "utils/arch_features.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+static double aggregate(AggregationClass *aggClass, const double *values, size_t n) {
+    void *context = aggClass->createContext(false);
+    for (size_t i = 0; i < n; ++i) {
+        aggClass->appendValue(context, values[i], i);
+    }
+    double value;
+    aggClass->finalize(context, &value);
+    aggClass->freeContext(context);
+    return value;
+}
+
+// Replacing a value of a bucket by retracting it must give the aggregation of the new bucket
+MU_TEST(test_retract_value) {
+    const TS_AGG_TYPES_T types[] = { TS_AGG_SUM,   TS_AGG_COUNT, TS_AGG_AVG,   TS_AGG_MIN,
+                                     TS_AGG_MAX,   TS_AGG_RANGE, TS_AGG_STD_P, TS_AGG_STD_S,
+                                     TS_AGG_VAR_P, TS_AGG_VAR_S };
+    double values[100];
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t) {
+        AggregationClass *aggClass = GetAggClass(types[t]);
+        mu_check(aggClass->retractValue != NULL);
+        for (int round = 0; round < 50; ++round) {
+            const size_t n = 1 + rand() % 100;
+            void *context = aggClass->createContext(false);
+            for (size_t i = 0; i < n; ++i) {
+                values[i] = rand() % 50;
+                aggClass->appendValue(context, values[i], i);
+            }
+            const size_t pos = rand() % n;
+            if (aggClass->retractValue(context, values[pos])) {
+                values[pos] = rand() % 50;
+                aggClass->appendValue(context, values[pos], pos);
+                double value;
+                aggClass->finalize(context, &value);
+                mu_assert_double_eq(aggregate(aggClass, values, n), value);
+            } else {
+                // only the extremes can't be retracted
+                const double min = aggregate(GetAggClass(TS_AGG_MIN), values, n);
+                const double max = aggregate(GetAggClass(TS_AGG_MAX), values, n);
+                mu_check(values[pos] == min || values[pos] == max);
+            }
+            aggClass->freeContext(context);
+        }
+    }
+
+    // order dependent aggregations can't retract
+    mu_check(GetAggClass(TS_AGG_FIRST)->retractValue == NULL);
+    mu_check(GetAggClass(TS_AGG_LAST)->retractValue == NULL);
+    mu_check(GetAggClass(TS_AGG_TWA)->retractValue == NULL);
+}
+
+// Merging samples into a finalized bucket must give the aggregation of the new bucket
+MU_TEST(test_merge_finalized) {
+    const TS_AGG_TYPES_T types[] = { TS_AGG_SUM, TS_AGG_COUNT, TS_AGG_MIN, TS_AGG_MAX };
+    double values[101];
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t) {
+        AggregationClass *aggClass = GetAggClass(types[t]);
+        for (int round = 0; round < 50; ++round) {
+            const size_t n = 1 + rand() % 100;
+            for (size_t i = 0; i < n; ++i) {
+                values[i] = rand() % 50;
+            }
+            double finalized = aggregate(aggClass, values, n);
+
+            // a new sample
+            values[n] = rand() % 50;
+            mu_check(aggClass->mergeFinalized(&finalized, values[n]));
+            mu_assert_double_eq(aggregate(aggClass, values, n + 1), finalized);
+
+            // an overridden sample
+            const size_t pos = rand() % (n + 1);
+            const double replaced = values[pos];
+            values[pos] = rand() % 50;
+            if (aggClass->retractFinalized(&finalized, replaced)) {
+                mu_check(aggClass->mergeFinalized(&finalized, values[pos]));
+                mu_assert_double_eq(aggregate(aggClass, values, n + 1), finalized);
+            } else {
+                mu_check(types[t] == TS_AGG_MIN || types[t] == TS_AGG_MAX);
+                mu_assert_double_eq(replaced, finalized);
+            }
+        }
+    }
+
+    // a non finite value can't be subtracted from a sum
+    double sum = INFINITY;
+    mu_check(!GetAggClass(TS_AGG_SUM)->retractFinalized(&sum, INFINITY));
+    mu_check(GetAggClass(TS_AGG_AVG)->mergeFinalized == NULL);
+}
+
+typedef void (*AppendValuesVecFunc)(void *__restrict__ context,
+                                    double *__restrict__ values,
+                                    size_t si,
+                                    size_t ei);
+
+// Appends [si, ei] in two calls of the kernel, so the context carries a partial result between them
+static double aggregateVec(AggregationClass *aggClass,
+                           AppendValuesVecFunc kernel,
+                           double *values,
+                           size_t si,
+                           size_t ei) {
+    void *context = aggClass->createContext(false);
+    const size_t mid = si + (ei - si) / 3;
+    kernel(context, values, si, mid);
+    if (mid < ei) {
+        kernel(context, values, mid + 1, ei);
+    }
+    double value;
+    aggClass->finalize(context, &value);
+    aggClass->freeContext(context);
+    return value;
+}
+
+// A kernel must give the aggregation of appending the values one by one, up to the rounding of the
+// AVG block sum. An exact kernel must give the same bits.
+static void checkAppendValuesVec(TS_AGG_TYPES_T type, AppendValuesVecFunc kernel, bool exact) {
+    AggregationClass *aggClass = GetAggClass(type);
+    double values[80];
+    for (int round = 0; round < 3; ++round) {
+        for (size_t i = 0; i < 80; ++i) {
+            values[i] = (rand() % 20000 - 10000) / 7.0;
+        }
+        if (round == 1) {
+            values[rand() % 80] = NAN;
+        } else if (round == 2) {
+            // the average of these overflows the double range
+            for (size_t i = 0; i < 80; i += 2) {
+                values[i] = DBL_MAX / 2;
+            }
+        }
+        for (size_t si = 0; si < 4; ++si) {
+            for (size_t ei = si; ei < 80; ++ei) {
+                const double expected = aggregate(aggClass, &values[si], ei - si + 1);
+                const double value = aggregateVec(aggClass, kernel, values, si, ei);
+                if (isnan(expected)) {
+                    mu_check(isnan(value));
+                } else if (exact || isinf(expected)) {
+                    mu_assert_double_eq(expected, value);
+                } else {
+                    mu_check(fabs(value - expected) <= 1e-9 * fmax(1, fabs(expected)));
+                }
+            }
+        }
+    }
+}
+
+// the kernels of each instruction set, only x86_64 builds have the vector ones
+#if defined(__x86_64__)
+#define APPEND_VALUES_KERNELS(name)                                                                \
+    name##AppendValuesVec, name##AppendValuesAVX2, name##AppendValuesAVX512F
+#else
+#define APPEND_VALUES_KERNELS(name) name##AppendValuesVec, NULL, NULL
+#endif
+
+MU_TEST(test_append_values_vec) {
+    initGlobalCompactionFunctions();
+    const TS_AGG_TYPES_T types[] = { TS_AGG_SUM,   TS_AGG_COUNT, TS_AGG_AVG,   TS_AGG_MIN,
+                                     TS_AGG_MAX,   TS_AGG_RANGE, TS_AGG_STD_P, TS_AGG_STD_S,
+                                     TS_AGG_VAR_P, TS_AGG_VAR_S, TS_AGG_FIRST, TS_AGG_LAST };
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); ++t) {
+        mu_check(GetAggClass(types[t])->appendValueVec != NULL);
+        checkAppendValuesVec(types[t], GetAggClass(types[t])->appendValueVec,
+                             types[t] != TS_AGG_AVG);
+    }
+    // the sums are added in sample order whatever the CPU
+    mu_check(GetAggClass(TS_AGG_SUM)->appendValueVec == SumAppendValuesVec);
+    mu_check(GetAggClass(TS_AGG_AVG)->appendValueVec == AvgAppendValuesVec);
+    mu_check(GetAggClass(TS_AGG_STD_P)->appendValueVec == StdAppendValuesVec);
+    mu_check(GetAggClass(TS_AGG_VAR_S)->appendValueVec == StdAppendValuesVec);
+    // the time weighted average needs the timestamps
+    mu_check(GetAggClass(TS_AGG_TWA)->appendValueVec == NULL);
+
+    const struct
+    {
+        TS_AGG_TYPES_T type;
+        AppendValuesVecFunc portable;
+        AppendValuesVecFunc avx2;
+        AppendValuesVecFunc avx512f;
+    } kernels[] = {
+        { TS_AGG_MAX, APPEND_VALUES_KERNELS(Max) },
+        { TS_AGG_MIN, APPEND_VALUES_KERNELS(Min) },
+        { TS_AGG_RANGE, APPEND_VALUES_KERNELS(MaxMin) },
+    };
+    const X86Features *features = getArchitectureOptimization();
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        checkAppendValuesVec(kernels[k].type, kernels[k].portable, true);
+        if (features && features->avx2 && kernels[k].avx2) {
+            checkAppendValuesVec(kernels[k].type, kernels[k].avx2, true);
+        }
+        if (features && features->avx512f && kernels[k].avx512f) {
+            checkAppendValuesVec(kernels[k].type, kernels[k].avx512f, true);
+        }
+    }
+}
+
+MU_TEST_SUITE(compaction_test_suite) {
+    MU_RUN_TEST(test_retract_value);
+    MU_RUN_TEST(test_merge_finalized);
+    MU_RUN_TEST(test_append_values_vec);
+}
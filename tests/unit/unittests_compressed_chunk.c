@@ -8,11 +8,15 @@
  */
 #include "compaction.h"
 #include "compressed_chunk.h"
+#include "config.h"
+#include "frozen_chunk.h"
 #include "gorilla.h"
 #include "minunit.h"
 #include "parse_policies.h"
 #include "tsdb.h"
 
+#include <float.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include "rmutil/alloc.h"
@@ -199,10 +203,925 @@ MU_TEST(test_Compressed_SplitChunk_force_realloc) {
     Compressed_FreeChunk(chunk);
 }
 
+// Fills a chunk with samples covering all the double delta buckets and XOR block cases
+static CompressedChunk *fillChunkForDecode(size_t chunk_size, size_t *n_samples) {
+    CompressedChunk *chunk = Compressed_NewChunk(chunk_size);
+    const int64_t deltas[] = { 0, 1, -30, 60, -500, 4000, -30000, 2000000, 1LL << 40 };
+    timestamp_t ts = 1000;
+    int64_t delta = 10;
+    double value = 1.5;
+    size_t i = 0;
+    while (true) {
+        if (i % 7 == 0) {
+            delta += deltas[rand() % (sizeof(deltas) / sizeof(deltas[0]))];
+            if (delta < 1) {
+                delta = 1;
+            }
+        }
+        ts += delta;
+        switch (rand() % 4) {
+            case 0: // unchanged value
+                break;
+            case 1:
+                value += 1;
+                break;
+            case 2:
+                value = (double)rand() / RAND_MAX;
+                break;
+            default:
+                value = -value * 1e17;
+                break;
+        }
+        Sample sample = { .timestamp = ts, .value = value };
+        if (Compressed_AddSample(chunk, &sample) != CR_OK) {
+            break;
+        }
+        ++i;
+    }
+    *n_samples = i;
+    return chunk;
+}
+
+MU_TEST(test_Compressed_decode_block) {
+    srand((unsigned int)time(NULL));
+    for (size_t chunk_size = 64; chunk_size <= 16384; chunk_size *= 2) {
+        size_t n_samples;
+        CompressedChunk *chunk = fillChunkForDecode(chunk_size, &n_samples);
+        mu_assert_int_eq(n_samples, Compressed_ChunkNumOfSample(chunk));
+
+        timestamp_t *timestamps = malloc(n_samples * sizeof(timestamp_t));
+        double *values = malloc(n_samples * sizeof(double));
+        ChunkIter_t *blockIter = Compressed_NewChunkIterator(chunk);
+        // decode in uneven blocks to exercise resuming from the iterator state
+        size_t decoded = 0, block = 1;
+        while (decoded < n_samples) {
+            size_t n = Compressed_ChunkIteratorGetNextBlock(
+                blockIter, timestamps + decoded, values + decoded, block);
+            mu_assert(n > 0, "decoded block");
+            decoded += n;
+            block = block * 3 + 1;
+        }
+        mu_assert_int_eq(0, Compressed_ChunkIteratorGetNextBlock(blockIter, timestamps, values, 1));
+
+        Sample sample;
+        ChunkIter_t *iter = Compressed_NewChunkIterator(chunk);
+        for (size_t i = 0; i < n_samples; ++i) {
+            mu_assert(Compressed_ChunkIteratorGetNext(iter, &sample) == CR_OK, "get next");
+            mu_assert_int_eq(sample.timestamp, timestamps[i]);
+            mu_assert(memcmp(&sample.value, &values[i], sizeof(double)) == 0, "same value");
+        }
+        mu_assert_int_eq(getIterIdx(iter), getIterIdx(blockIter));
+
+        Compressed_FreeChunkIterator(iter);
+        Compressed_FreeChunkIterator(blockIter);
+        free(timestamps);
+        free(values);
+        Compressed_FreeChunk(chunk);
+    }
+}
+
+MU_TEST(test_Compressed_ProcessChunk_range) {
+    size_t n_samples;
+    CompressedChunk *chunk = fillChunkForDecode(4096, &n_samples);
+    Sample *samples = malloc(n_samples * sizeof(Sample));
+    ChunkIter_t *iter = Compressed_NewChunkIterator(chunk);
+    for (size_t i = 0; i < n_samples; ++i) {
+        Compressed_ChunkIteratorGetNext(iter, &samples[i]);
+    }
+    Compressed_FreeChunkIterator(iter);
+
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n_samples);
+    for (int t = 0; t < 100; ++t) {
+        size_t a = rand() % n_samples, b = rand() % n_samples;
+        timestamp_t start = samples[min(a, b)].timestamp;
+        timestamp_t end = samples[max(a, b)].timestamp;
+        bool reverse = t % 2;
+        Compressed_ProcessChunk(chunk, start, end, enrichedChunk, reverse);
+        mu_assert_int_eq(max(a, b) - min(a, b) + 1, enrichedChunk->samples.num_samples);
+        mu_assert(enrichedChunk->rev == reverse, "reverse flag");
+        for (size_t i = 0; i < enrichedChunk->samples.num_samples; ++i) {
+            size_t j = reverse ? max(a, b) - i : min(a, b) + i;
+            mu_assert_int_eq(samples[j].timestamp, enrichedChunk->samples.timestamps[i]);
+        }
+    }
+    // nothing in range
+    if (samples[1].timestamp - samples[0].timestamp > 1) {
+        Compressed_ProcessChunk(
+            chunk, samples[0].timestamp + 1, samples[1].timestamp - 1, enrichedChunk, false);
+        mu_assert_int_eq(0, enrichedChunk->samples.num_samples);
+    }
+
+    FreeEnrichedChunk(enrichedChunk);
+    free(samples);
+    Compressed_FreeChunk(chunk);
+}
+
+MU_TEST(test_Compressed_checkpoints) {
+    const uint32_t interval = 64;
+    TSGlobalConfig.chunkCheckpointInterval = interval;
+    size_t n_samples;
+    CompressedChunk *chunk = fillChunkForDecode(16384, &n_samples);
+    mu_assert_int_eq(interval, chunk->checkpointInterval);
+    mu_assert_int_eq((n_samples - 1) / interval, chunk->numCheckpoints);
+    mu_assert(Compressed_GetCheckpointsSize(chunk) >=
+                  chunk->numCheckpoints * sizeof(CompressedCheckpoint),
+              "checkpoints size");
+
+    // checkpoints built while decoding are the same as the ones taken while appending
+    CompressedChunk *clone = Compressed_CloneChunk(chunk);
+    Compressed_RebuildCheckpoints(clone, interval);
+    mu_assert_int_eq(chunk->numCheckpoints, clone->numCheckpoints);
+    for (size_t i = 0; i < chunk->numCheckpoints; ++i) {
+        const CompressedCheckpoint *c1 = &chunk->checkpoints[i], *c2 = &clone->checkpoints[i];
+        mu_assert_int_eq(c1->prevTS, c2->prevTS);
+        mu_assert_int_eq(c1->prevDelta, c2->prevDelta);
+        mu_assert_int_eq(c1->prevValue.u, c2->prevValue.u);
+        mu_assert_int_eq(c1->idx, c2->idx);
+        mu_assert_int_eq(c1->leading, c2->leading);
+        mu_assert_int_eq(c1->trailing, c2->trailing);
+    }
+    Compressed_FreeChunk(clone);
+
+    Sample *samples = malloc(n_samples * sizeof(Sample));
+    ChunkIter_t *iter = Compressed_NewChunkIterator(chunk);
+    for (size_t i = 0; i < n_samples; ++i) {
+        Compressed_ChunkIteratorGetNext(iter, &samples[i]);
+    }
+    Compressed_FreeChunkIterator(iter);
+
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n_samples);
+    for (int t = 0; t < 200; ++t) {
+        size_t a = rand() % n_samples, b = rand() % n_samples;
+        size_t si = min(a, b), ei = max(a, b);
+        // starting between samples must seek to the same place as starting on a sample
+        timestamp_t start = samples[si].timestamp;
+        if (t % 2 && (si == 0 || samples[si - 1].timestamp < start - 1)) {
+            start--;
+        }
+        Compressed_ProcessChunk(chunk, start, samples[ei].timestamp, enrichedChunk, false);
+        mu_assert_int_eq(ei - si + 1, enrichedChunk->samples.num_samples);
+        for (size_t i = 0; i < enrichedChunk->samples.num_samples; ++i) {
+            mu_assert_int_eq(samples[si + i].timestamp, enrichedChunk->samples.timestamps[i]);
+            mu_assert_double_eq(samples[si + i].value, enrichedChunk->samples.values[i]);
+        }
+    }
+
+    // no checkpoints are kept when they are disabled
+    Compressed_RebuildCheckpoints(chunk, 0);
+    mu_assert_int_eq(0, chunk->numCheckpoints);
+    mu_assert_int_eq(0, Compressed_GetCheckpointsSize(chunk));
+
+    TSGlobalConfig.chunkCheckpointInterval = 0;
+    FreeEnrichedChunk(enrichedChunk);
+    free(samples);
+    Compressed_FreeChunk(chunk);
+}
+
+// Checks the chunk content against the expected samples, both through the iterator path used by
+// ranges and through the chunk accessors.
+static void assertChunkSamples(CompressedChunk *chunk, const Sample *expected, size_t n) {
+    // the samples buffered without a lookup are counted as new until they are merged
+    mu_assert(Compressed_ChunkNumOfSample(chunk) >= n &&
+                  Compressed_ChunkNumOfSample(chunk) - n <= chunk->numOOOPending,
+              "sample count");
+    mu_assert_int_eq(expected[0].timestamp, Compressed_GetFirstTimestamp(chunk));
+    mu_assert_int_eq(expected[n - 1].timestamp, Compressed_GetLastTimestamp(chunk));
+    mu_assert_double_eq(expected[n - 1].value, Compressed_GetLastValue(chunk));
+
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, Compressed_ChunkNumOfSample(chunk));
+    for (int t = 0; t < 20; ++t) {
+        size_t a = rand() % n, b = rand() % n;
+        size_t si = t ? min(a, b) : 0, ei = t ? max(a, b) : n - 1;
+        bool reverse = t % 2;
+        Compressed_ProcessChunk(
+            chunk, expected[si].timestamp, expected[ei].timestamp, enrichedChunk, reverse);
+        mu_assert_int_eq(ei - si + 1, enrichedChunk->samples.num_samples);
+        for (size_t i = 0; i < enrichedChunk->samples.num_samples; ++i) {
+            size_t j = reverse ? ei - i : si + i;
+            mu_assert_int_eq(expected[j].timestamp, enrichedChunk->samples.timestamps[i]);
+            mu_assert_double_eq(expected[j].value, enrichedChunk->samples.values[i]);
+        }
+    }
+    FreeEnrichedChunk(enrichedChunk);
+}
+
+MU_TEST(test_Compressed_upsert_ooo_buffer) {
+    const size_t n_samples = 2000;
+    Sample *expected = malloc(n_samples * 2 * sizeof(Sample));
+    size_t n = 0;
+    CompressedChunk *chunk = Compressed_NewChunk(4096);
+    for (size_t i = 0; i < n_samples; ++i) {
+        Sample sample = { .timestamp = 100 + i * 10, .value = i };
+        mu_assert(Compressed_AddSample(chunk, &sample) == CR_OK, "add sample");
+        expected[n++] = sample;
+    }
+
+    int size;
+    int64_t numSamples = n;
+    for (size_t i = 0; i < 1000; ++i) {
+        // late samples, either new timestamps or overriding existing ones
+        Sample sample = { .timestamp = 95 + rand() % (n_samples * 10), .value = rand() % 100 };
+        DuplicatePolicy policy = i % 3 == 0 ? DP_BLOCK : (i % 3 == 1 ? DP_LAST : DP_SUM);
+        UpsertCtx uCtx = { .inChunk = chunk, .sample = sample };
+        size_t pos = 0;
+        while (pos < n && expected[pos].timestamp < sample.timestamp) {
+            ++pos;
+        }
+        bool exists = pos < n && expected[pos].timestamp == sample.timestamp;
+        ChunkResult rv = Compressed_UpsertSample(&uCtx, &size, policy);
+        if (exists && policy == DP_BLOCK) {
+            mu_assert(rv == CR_ERR, "blocked duplicate");
+            continue;
+        }
+        mu_assert(rv == CR_OK, "upsert");
+        if (exists) {
+            mu_check(uCtx.overridden || (policy == DP_LAST && uCtx.overriddenUnknown));
+            expected[pos].value = policy == DP_SUM ? expected[pos].value + sample.value
+                                                   : sample.value;
+        } else {
+            mu_check(!uCtx.overridden);
+            memmove(&expected[pos + 1], &expected[pos], (n - pos) * sizeof(Sample));
+            expected[pos] = sample;
+            ++n;
+        }
+        // the size tracks the sample count of the chunk, also when the buffer is merged
+        numSamples += size;
+        mu_assert_int_eq(numSamples, Compressed_ChunkNumOfSample(chunk));
+        mu_assert_double_eq(expected[pos].value, uCtx.sample.value);
+        if (i % 100 == 0) {
+            assertChunkSamples(chunk, expected, n);
+        }
+    }
+    assertChunkSamples(chunk, expected, n);
+
+    // delete a range which covers buffered samples
+    timestamp_t startTs = expected[n / 4].timestamp, endTs = expected[n / 2].timestamp;
+    mu_assert_int_eq(n / 2 - n / 4 + 1, Compressed_DelRange(chunk, startTs, endTs));
+    memmove(&expected[n / 4], &expected[n / 2 + 1], (n - n / 2 - 1) * sizeof(Sample));
+    n -= n / 2 - n / 4 + 1;
+    mu_assert_int_eq(0, chunk->numOOOSamples);
+    mu_assert_int_eq(n, Compressed_ChunkNumOfSample(chunk));
+    assertChunkSamples(chunk, expected, n);
+
+    // split a chunk with buffered samples
+    size_t gap = 0;
+    while (expected[gap + 1].timestamp == expected[gap].timestamp + 1) {
+        ++gap;
+    }
+    Sample late = { .timestamp = expected[gap].timestamp + 1, .value = -1 };
+    UpsertCtx uCtx = { .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_assert_int_eq(1, chunk->numOOOSamples);
+    memmove(&expected[gap + 2], &expected[gap + 1], (n - gap - 1) * sizeof(Sample));
+    expected[gap + 1] = late;
+    ++n;
+    CompressedChunk *chunk2 = Compressed_SplitChunk(chunk);
+    size_t n1 = Compressed_ChunkNumOfSample(chunk);
+    mu_assert_int_eq(n, n1 + Compressed_ChunkNumOfSample(chunk2));
+    assertChunkSamples(chunk, expected, n1);
+    assertChunkSamples(chunk2, expected + n1, n - n1);
+
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(chunk2);
+    free(expected);
+}
+
+// A late sample which replaces a sample under DUPLICATE_POLICY LAST is buffered without decoding
+// the chunk, the merge finds that it replaced a sample
+MU_TEST(test_Compressed_upsert_pending) {
+    const size_t n_samples = 1000;
+    Sample *expected = malloc(n_samples * sizeof(Sample));
+    // irregular timestamps, the chunk isn't encoded on an interval
+    CompressedChunk *chunk = Compressed_NewChunk(16384);
+    timestamp_t ts = 100;
+    for (size_t i = 0; i < n_samples; ++i) {
+        ts += 10 + rand() % 5;
+        expected[i] = (Sample){ .timestamp = ts, .value = i };
+        mu_assert(Compressed_AddSample(chunk, &expected[i]) == CR_OK, "add sample");
+    }
+    mu_assert(chunk->intervalCount < 100, "irregular timestamps");
+
+    int size;
+    Sample late = { .timestamp = expected[100].timestamp, .value = -1 };
+    UpsertCtx uCtx = { .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_check(!uCtx.overridden && uCtx.overriddenUnknown);
+    mu_assert_int_eq(1, size);
+    mu_assert_int_eq(1, chunk->numOOOPending);
+    mu_assert_int_eq(n_samples + 1, Compressed_ChunkNumOfSample(chunk));
+    expected[100] = late;
+    assertChunkSamples(chunk, expected, n_samples);
+
+    // a NaN keeps the value it replaces, it's looked up
+    late = (Sample){ .timestamp = expected[200].timestamp, .value = NAN };
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_check(uCtx.overridden && !uCtx.overriddenUnknown);
+    mu_assert_double_eq(expected[200].value, uCtx.sample.value);
+    mu_assert_int_eq(0, size);
+
+    // the last sample is known without decoding
+    late = (Sample){ .timestamp = expected[n_samples - 1].timestamp, .value = -3 };
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_check(uCtx.overridden && !uCtx.overriddenUnknown);
+    mu_assert_double_eq(expected[n_samples - 1].value, uCtx.overriddenValue);
+    mu_assert_int_eq(0, size);
+    expected[n_samples - 1] = late;
+
+    // a deletion merges the pending sample
+    mu_assert_int_eq(1, Compressed_DelRange(chunk, expected[0].timestamp, expected[0].timestamp));
+    mu_assert_int_eq(0, chunk->numOOOPending);
+    mu_assert_int_eq(n_samples - 1, Compressed_ChunkNumOfSample(chunk));
+    assertChunkSamples(chunk, expected + 1, n_samples - 1);
+    // a sample before the first one is new
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = expected[0] };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_check(!uCtx.overridden && !uCtx.overriddenUnknown);
+    mu_assert_int_eq(1, size);
+
+    // a full buffer is merged, the size takes back the replaced samples
+    int64_t numSamples = n_samples;
+    for (size_t i = 0; i < 256; ++i) {
+        late = (Sample){ .timestamp = expected[i * 3].timestamp, .value = -(double)i };
+        uCtx = (UpsertCtx){ .inChunk = chunk, .sample = late };
+        mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+        expected[i * 3] = late;
+        numSamples += size;
+        mu_assert_int_eq(numSamples, Compressed_ChunkNumOfSample(chunk));
+    }
+    mu_assert_int_eq(0, chunk->numOOOSamples);
+    mu_assert_int_eq(n_samples, numSamples);
+    assertChunkSamples(chunk, expected, n_samples);
+
+    // sealing merges the pending samples
+    late = (Sample){ .timestamp = expected[500].timestamp, .value = -5 };
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    expected[500] = late;
+    CompressedChunk *clone = Compressed_CloneChunk(chunk);
+    Compressed_SealChunk(chunk);
+    mu_assert_int_eq(0, chunk->numOOOPending);
+    mu_assert_int_eq(n_samples, Compressed_ChunkNumOfSample(chunk));
+    assertChunkSamples(chunk, expected, n_samples);
+
+    // so does a split
+    CompressedChunk *chunk2 = Compressed_SplitChunk(clone);
+    const size_t n1 = Compressed_ChunkNumOfSample(clone);
+    mu_assert_int_eq(n_samples, n1 + Compressed_ChunkNumOfSample(chunk2));
+    assertChunkSamples(clone, expected, n1);
+    assertChunkSamples(chunk2, expected + n1, n_samples - n1);
+
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(chunk2);
+    Compressed_FreeChunk(clone);
+    free(expected);
+}
+
+// Checks the chunk summary against the expected samples
+static void assertChunkSummary(CompressedChunk *chunk, const Sample *expected, size_t n) {
+    const ChunkSummary *summary = Compressed_GetSummary(chunk);
+    mu_check(summary != NULL);
+    double min = expected[0].value, max = expected[0].value, sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        min = fmin(min, expected[i].value);
+        max = fmax(max, expected[i].value);
+        sum += expected[i].value;
+    }
+    mu_assert_int_eq(n, summary->count);
+    mu_assert_double_eq(min, summary->min);
+    mu_assert_double_eq(max, summary->max);
+    mu_assert_double_eq(sum, summary->sum);
+    mu_assert_int_eq(expected[0].timestamp, summary->first.timestamp);
+    mu_assert_double_eq(expected[0].value, summary->first.value);
+    mu_assert_int_eq(expected[n - 1].timestamp, summary->last.timestamp);
+    mu_assert_double_eq(expected[n - 1].value, summary->last.value);
+}
+
+MU_TEST(test_Compressed_summary) {
+    const size_t n_samples = 1000;
+    Sample *expected = malloc((n_samples + 1) * sizeof(Sample));
+    CompressedChunk *chunk = Compressed_NewChunk(4096);
+    mu_check(Compressed_GetSummary(chunk) == NULL);
+    for (size_t i = 0; i < n_samples; ++i) {
+        expected[i] = (Sample){ .timestamp = 100 + i * 10, .value = rand() % 1000 };
+        mu_assert(Compressed_AddSample(chunk, &expected[i]) == CR_OK, "add sample");
+    }
+    size_t n = n_samples;
+    assertChunkSummary(chunk, expected, n);
+
+    // a new out of order sample is added to the summary
+    int size;
+    Sample late = { .timestamp = 105, .value = 5000 };
+    UpsertCtx uCtx = { .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_check(!uCtx.overridden);
+    memmove(&expected[2], &expected[1], (n - 1) * sizeof(Sample));
+    expected[1] = late;
+    ++n;
+    assertChunkSummary(chunk, expected, n);
+
+    // an override can't be taken out of the summary until the chunk is encoded again
+    Sample override = { .timestamp = expected[n / 2].timestamp, .value = -1 };
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = override };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_MAX) == CR_OK, "upsert");
+    mu_check(uCtx.overridden);
+    mu_assert_double_eq(expected[n / 2].value, uCtx.overriddenValue);
+    mu_assert_double_eq(expected[n / 2].value, uCtx.sample.value);
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = override };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    expected[n / 2] = override;
+    // the override itself is found in the out of order buffer
+    override.value = -2;
+    uCtx = (UpsertCtx){ .inChunk = chunk, .sample = override };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_check(uCtx.overridden);
+    mu_assert_double_eq(-1, uCtx.overriddenValue);
+    expected[n / 2] = override;
+    mu_check(Compressed_GetSummary(chunk) == NULL);
+    mu_assert_int_eq(1, Compressed_DelRange(chunk, expected[0].timestamp, expected[0].timestamp));
+    memmove(&expected[0], &expected[1], (n - 1) * sizeof(Sample));
+    --n;
+    assertChunkSummary(chunk, expected, n);
+
+    Compressed_SealChunk(chunk);
+    assertChunkSummary(chunk, expected, n);
+
+    CompressedChunk *chunk2 = Compressed_SplitChunk(chunk);
+    size_t n1 = Compressed_ChunkNumOfSample(chunk);
+    assertChunkSummary(chunk, expected, n1);
+    assertChunkSummary(chunk2, expected + n1, n - n1);
+
+    // summaries of chunks with non finite values aren't used
+    CompressedChunk *chunk3 = Compressed_NewChunk(4096);
+    Sample nan = { .timestamp = expected[0].timestamp + 1, .value = NAN };
+    mu_assert(Compressed_AddSample(chunk3, &expected[0]) == CR_OK, "add sample");
+    mu_check(Compressed_GetSummary(chunk3) != NULL);
+    mu_assert(Compressed_AddSample(chunk3, &nan) == CR_OK, "add sample");
+    mu_check(Compressed_GetSummary(chunk3) == NULL);
+
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(chunk2);
+    Compressed_FreeChunk(chunk3);
+    free(expected);
+}
+
+MU_TEST(test_Decimal_counter_memory) {
+    const size_t n_samples = 5000;
+    Sample *expected = malloc(n_samples * sizeof(Sample));
+    CompressedChunk *gorillaChunk = Compressed_NewChunk(n_samples * 16);
+    CompressedChunk *decimalChunk = Decimal_NewChunk(n_samples * 16);
+    uint64_t cents = 100000;
+    for (size_t i = 0; i < n_samples; ++i) {
+        // a counter with 2 digits after the decimal point sampled every second
+        cents += rand() % 500;
+        expected[i] = (Sample){ .timestamp = 1000 + i * 1000, .value = cents / 100.0 };
+        mu_assert(Compressed_AddSample(gorillaChunk, &expected[i]) == CR_OK, "add sample");
+        mu_assert(Compressed_AddSample(decimalChunk, &expected[i]) == CR_OK, "add sample");
+    }
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL, decimalChunk->valueEncoding);
+    mu_assert_int_eq(2, decimalChunk->decimalScale);
+    assertChunkSamples(decimalChunk, expected, n_samples);
+
+    // a delta of up to 500 cents fits in 9 bits, with the timestamp and the control bits
+    mu_assert(decimalChunk->idx <= n_samples * 16, "decimal takes at most 16 bits/sample");
+    mu_assert(decimalChunk->idx * 2 <= gorillaChunk->idx, "decimal saves at least half");
+
+    // the decimal state is restored when decoding from a checkpoint
+    Compressed_RebuildCheckpoints(decimalChunk, 64);
+    mu_assert_int_eq((n_samples - 1) / 64, decimalChunk->numCheckpoints);
+    assertChunkSamples(decimalChunk, expected, n_samples);
+
+    Compressed_FreeChunk(gorillaChunk);
+    Compressed_FreeChunk(decimalChunk);
+    free(expected);
+}
+
+MU_TEST(test_Decimal_scale_fallback) {
+    const size_t n_samples = 300;
+    Sample *expected = malloc(n_samples * sizeof(Sample));
+    size_t n = 0;
+    CompressedChunk *chunk = Decimal_NewChunk(4096);
+    for (; n < 100; ++n) {
+        expected[n] = (Sample){ .timestamp = 100 + n * 10, .value = 50 + n % 7 };
+        mu_assert(Compressed_AddSample(chunk, &expected[n]) == CR_OK, "add sample");
+    }
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL, chunk->valueEncoding);
+    mu_assert_int_eq(0, chunk->decimalScale);
+
+    // a value with more digits re-encodes the chunk with a larger scale
+    for (; n < 200; ++n) {
+        expected[n] = (Sample){ .timestamp = 100 + n * 10, .value = -12.125 + n };
+        mu_assert(Compressed_AddSample(chunk, &expected[n]) == CR_OK, "add sample");
+    }
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL, chunk->valueEncoding);
+    mu_assert_int_eq(3, chunk->decimalScale);
+    assertChunkSamples(chunk, expected, n);
+
+    // late samples are kept aside and don't change the scale until they are encoded
+    int size;
+    Sample late = { .timestamp = expected[10].timestamp + 1, .value = 0.5 };
+    UpsertCtx uCtx = { .inChunk = chunk, .sample = late };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    memmove(&expected[12], &expected[11], (n - 11) * sizeof(Sample));
+    expected[11] = late;
+    ++n;
+
+    // a value which doesn't fit any scale falls back to Gorilla
+    for (; n < n_samples; ++n) {
+        expected[n] = (Sample){ .timestamp = 100 + n * 10, .value = 1.0 / n };
+        mu_assert(Compressed_AddSample(chunk, &expected[n]) == CR_OK, "add sample");
+    }
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL_FALLBACK, chunk->valueEncoding);
+    mu_assert_int_eq(1, chunk->numOOOSamples);
+    assertChunkSamples(chunk, expected, n);
+
+    // the split chunks detect their scale again
+    CompressedChunk *chunk2 = Compressed_SplitChunk(chunk);
+    size_t n1 = Compressed_ChunkNumOfSample(chunk);
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL, chunk->valueEncoding);
+    mu_assert_int_eq(3, chunk->decimalScale);
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL_FALLBACK, chunk2->valueEncoding);
+    assertChunkSamples(chunk, expected, n1);
+    assertChunkSamples(chunk2, expected + n1, n - n1);
+
+    // NaN and -0.0 aren't decimals
+    CompressedChunk *chunk3 = Decimal_NewChunk(64);
+    Sample sample = { .timestamp = 1, .value = -0.0 };
+    mu_assert(Compressed_AddSample(chunk3, &sample) == CR_OK, "add sample");
+    mu_assert_int_eq(VALUE_ENCODING_DECIMAL_FALLBACK, chunk3->valueEncoding);
+    mu_assert_int_eq(-1, Decimal_ScaleOf(NAN));
+    mu_assert_int_eq(-1, Decimal_ScaleOf(1e300));
+    mu_assert_int_eq(15, Decimal_ScaleOf(0.123456789012345));
+
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(chunk2);
+    Compressed_FreeChunk(chunk3);
+    free(expected);
+}
+
+MU_TEST(test_Chimp_chunk) {
+    const size_t n_samples = 3000;
+    Sample *expected = malloc(n_samples * 2 * sizeof(Sample));
+    size_t n = 0;
+    CompressedChunk *chunk = Chimp_NewChunk(4096);
+    for (; n < n_samples; ++n) {
+        // repeated values, values with many trailing zeros and noisy values
+        double value;
+        switch (n % 4) {
+            case 0:
+                value = n > 0 ? expected[n - 1].value : 0;
+                break;
+            case 1:
+                value = rand() % 1000;
+                break;
+            case 2:
+                value = (double)rand() / RAND_MAX * 1e6;
+                break;
+            default:
+                value = -(double)(rand() % 100000) / 100;
+                break;
+        }
+        expected[n] = (Sample){ .timestamp = 100 + n * 10, .value = value };
+        ChunkResult rv = Compressed_AddSample(chunk, &expected[n]);
+        if (rv == CR_END) {
+            break;
+        }
+        mu_assert(rv == CR_OK, "add sample");
+    }
+    mu_assert(n > 300, "chunk holds samples");
+    assertChunkSamples(chunk, expected, n);
+    Compressed_RebuildCheckpoints(chunk, 32);
+    assertChunkSamples(chunk, expected, n);
+
+    // late samples, each one right after the sample i * 3, and a split keep the Chimp encoding
+    int size;
+    for (size_t i = 0; i < 50; ++i) {
+        Sample late = { .timestamp = 100 + i * 30 + 1, .value = 1.0 / (i + 3) };
+        UpsertCtx uCtx = { .inChunk = chunk, .sample = late };
+        mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+        size_t pos = i * 3 + i + 1;
+        memmove(&expected[pos + 1], &expected[pos], (n - pos) * sizeof(Sample));
+        expected[pos] = late;
+        ++n;
+    }
+    assertChunkSamples(chunk, expected, n);
+    CompressedChunk *chunk2 = Compressed_SplitChunk(chunk);
+    size_t n1 = Compressed_ChunkNumOfSample(chunk);
+    mu_assert_int_eq(VALUE_ENCODING_CHIMP, chunk->valueEncoding);
+    mu_assert_int_eq(VALUE_ENCODING_CHIMP, chunk2->valueEncoding);
+    assertChunkSamples(chunk, expected, n1);
+    assertChunkSamples(chunk2, expected + n1, n - n1);
+
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(chunk2);
+    free(expected);
+}
+
+// Loads the samples of a flow tests dataset, either a value per line or TS.ADD commands
+static Sample *loadDataset(const char *name, size_t *n) {
+    // the unit tests run either from the repository root or from tests/unit
+    char path[256];
+    snprintf(path, sizeof(path), "tests/flow/%s", name);
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        snprintf(path, sizeof(path), "../flow/%s", name);
+        file = fopen(path, "r");
+    }
+    if (!file) {
+        return NULL;
+    }
+    size_t capacity = 1024;
+    Sample *samples = malloc(capacity * sizeof(Sample));
+    char line[1024];
+    *n = 0;
+    while (fgets(line, sizeof(line), file)) {
+        Sample *sample = &samples[*n];
+        if (strncmp(line, "TS.ADD", 6) == 0) {
+            if (sscanf(line, "%*s %*s %lu %lf", &sample->timestamp, &sample->value) != 2) {
+                continue;
+            }
+        } else {
+            if (sscanf(line, "%lf", &sample->value) != 1) {
+                continue;
+            }
+            sample->timestamp = 1000 + *n * 10;
+        }
+        if (++*n == capacity) {
+            capacity *= 2;
+            samples = realloc(samples, capacity * sizeof(Sample));
+        }
+    }
+    fclose(file);
+    return samples;
+}
+
+// The datasets of the flow tests round trip through every value encoding
+MU_TEST(test_Chimp_codec_datasets) {
+    const char *datasets[] = { "lemire_canada.txt", "issue358.txt" };
+    Chunk_t *(*newChunk[])(size_t) = { Compressed_NewChunk, Chimp_NewChunk, Decimal_NewChunk };
+    for (size_t d = 0; d < sizeof(datasets) / sizeof(datasets[0]); ++d) {
+        size_t n_samples;
+        Sample *dataset = loadDataset(datasets[d], &n_samples);
+        if (!dataset) {
+            continue;
+        }
+        timestamp_t *timestamps = malloc(n_samples * sizeof(timestamp_t));
+        double *values = malloc(n_samples * sizeof(double));
+        for (int c = 0; c < 3; ++c) {
+            CompressedChunk *chunk = newChunk[c](n_samples * 16);
+            for (size_t i = 0; i < n_samples; ++i) {
+                mu_assert(Compressed_AddSample(chunk, &dataset[i]) == CR_OK, "add sample");
+            }
+            Compressed_Iterator iter;
+            Compressed_ResetChunkIterator(&iter, chunk);
+            mu_assert_int_eq(
+                n_samples,
+                Compressed_ChunkIteratorGetNextBlock(&iter, timestamps, values, n_samples));
+            for (size_t i = 0; i < n_samples; ++i) {
+                mu_assert_int_eq(dataset[i].timestamp, timestamps[i]);
+                mu_assert_double_eq(dataset[i].value, values[i]);
+            }
+            Compressed_FreeChunk(chunk);
+        }
+        free(timestamps);
+        free(values);
+        free(dataset);
+    }
+}
+
+MU_TEST(test_Frozen_codec) {
+    const size_t n_samples = 1000;
+    timestamp_t *timestamps = malloc(n_samples * sizeof(timestamp_t));
+    double *values = malloc(n_samples * sizeof(double));
+    timestamp_t *decodedTS = malloc((n_samples + FROZEN_BLOCK_SAMPLES) * sizeof(timestamp_t));
+    double *decodedValues = malloc((n_samples + FROZEN_BLOCK_SAMPLES) * sizeof(double));
+    const double specials[] = { NAN, -0.0, 0.0, INFINITY, -INFINITY, DBL_MAX, 5e-324 };
+    for (int t = 0; t < 4; ++t) {
+        timestamp_t ts = t == 3 ? 1ULL << 62 : 0;
+        for (size_t i = 0; i < n_samples; ++i) {
+            switch (t) {
+                case 0: // fixed interval, decimal values
+                    ts += 1000;
+                    values[i] = (double)(rand() % 100000) / 100;
+                    break;
+                case 1: // jitter, slowly changing values
+                    ts += 1000 + rand() % 5;
+                    values[i] = 20.5 + (i / 50) * 0.25;
+                    break;
+                case 2: // random doubles with special values
+                    ts += 1 + rand() % 100000;
+                    values[i] = i % 10 == 0 ? specials[(i / 10) % 7] : (double)rand() / RAND_MAX;
+                    break;
+                default: // huge gaps
+                    ts += (timestamp_t)rand() << 20;
+                    values[i] = -(double)rand() * 1e300;
+                    break;
+            }
+            timestamps[i] = ts;
+        }
+        FrozenChunk *frozen = Frozen_Encode(timestamps, values, n_samples);
+        mu_assert_int_eq((n_samples + FROZEN_BLOCK_SAMPLES - 1) / FROZEN_BLOCK_SAMPLES,
+                         frozen->numBlocks);
+        size_t decoded = 0;
+        for (uint32_t b = 0; b < frozen->numBlocks; ++b) {
+            decoded += Frozen_DecodeBlock(frozen, b, decodedTS + decoded, decodedValues + decoded);
+        }
+        mu_assert_int_eq(n_samples, decoded);
+        for (size_t i = 0; i < n_samples; ++i) {
+            mu_assert_int_eq(timestamps[i], decodedTS[i]);
+            mu_assert(memcmp(&values[i], &decodedValues[i], sizeof(double)) == 0, "same value");
+        }
+        for (size_t i = 0; i < n_samples; i += 37) {
+            const uint32_t b = Frozen_SeekBlock(frozen, timestamps[i]);
+            mu_assert_int_eq(i / FROZEN_BLOCK_SAMPLES, b);
+        }
+        if (t == 0) {
+            // fixed interval timestamps take no bits
+            mu_assert_int_eq(0, frozen->blocks[0].tsBits);
+            mu_assert_int_eq(FROZEN_VALUES_DECIMAL, frozen->blocks[0].valuesEncoding);
+        }
+        FrozenChunk *clone = Frozen_Clone(frozen);
+        mu_assert(memcmp(clone, frozen, Frozen_Size(frozen)) == 0, "clone");
+        free(clone);
+        free(frozen);
+    }
+    free(timestamps);
+    free(values);
+    free(decodedTS);
+    free(decodedValues);
+}
+
+MU_TEST(test_Compressed_seal_chunk) {
+    const size_t n_samples = 2000;
+    Sample *expected = malloc(n_samples * 2 * sizeof(Sample));
+    size_t n = 0;
+    // the chunk has room to spare so the frozen layout is always smaller
+    CompressedChunk *chunk = Compressed_NewChunk(16384);
+    for (size_t i = 0; i < n_samples; ++i) {
+        Sample sample = { .timestamp = 100 + i * 10, .value = (double)(i % 300) / 4 };
+        mu_assert(Compressed_AddSample(chunk, &sample) == CR_OK, "add sample");
+        expected[n++] = sample;
+    }
+    const size_t gorillaSize = Compressed_GetChunkSize(chunk, false);
+    Compressed_SealChunk(chunk);
+    mu_assert(chunk->sealed && chunk->frozen, "frozen");
+    mu_assert(chunk->data == NULL, "gorilla data released");
+    mu_assert(Compressed_GetChunkSize(chunk, false) <= gorillaSize, "frozen isn't larger");
+    assertChunkSamples(chunk, expected, n);
+
+    CompressedChunk *clone = Compressed_CloneChunk(chunk);
+    assertChunkSamples(clone, expected, n);
+    Compressed_FreeChunk(clone);
+
+    // late samples are buffered, the chunk stays frozen
+    int size;
+    int64_t numSamples = n;
+    for (size_t i = 0; i < 300; ++i) {
+        Sample sample = { .timestamp = 95 + rand() % (n_samples * 10 + 20), .value = i };
+        UpsertCtx uCtx = { .inChunk = chunk, .sample = sample };
+        size_t pos = 0;
+        while (pos < n && expected[pos].timestamp < sample.timestamp) {
+            ++pos;
+        }
+        mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+        if (pos < n && expected[pos].timestamp == sample.timestamp) {
+            expected[pos].value = sample.value;
+        } else {
+            memmove(&expected[pos + 1], &expected[pos], (n - pos) * sizeof(Sample));
+            expected[pos] = sample;
+            ++n;
+        }
+        numSamples += size;
+        mu_assert_int_eq(numSamples, Compressed_ChunkNumOfSample(chunk));
+        mu_assert(chunk->sealed, "sealed");
+    }
+    // the buffer was folded once it filled up and the chunk was sealed again
+    mu_assert(chunk->frozen != NULL, "frozen");
+    assertChunkSamples(chunk, expected, n);
+
+    timestamp_t startTs = expected[n / 4].timestamp, endTs = expected[n / 2].timestamp;
+    mu_assert_int_eq(n / 2 - n / 4 + 1, Compressed_DelRange(chunk, startTs, endTs));
+    memmove(&expected[n / 4], &expected[n / 2 + 1], (n - n / 2 - 1) * sizeof(Sample));
+    n -= n / 2 - n / 4 + 1;
+    mu_assert(chunk->frozen != NULL, "frozen");
+    assertChunkSamples(chunk, expected, n);
+
+    // appending reopens a sealed chunk
+    clone = Compressed_CloneChunk(chunk);
+    Sample sample = { .timestamp = expected[n - 1].timestamp + 10, .value = 1 };
+    mu_assert(Compressed_AddSample(clone, &sample) == CR_OK, "add sample");
+    mu_assert(!clone->sealed && !clone->frozen, "reopened");
+    expected[n] = sample;
+    assertChunkSamples(clone, expected, n + 1);
+    Compressed_FreeChunk(clone);
+
+    CompressedChunk *chunk2 = Compressed_SplitChunk(chunk);
+    size_t n1 = Compressed_ChunkNumOfSample(chunk);
+    mu_assert(chunk->sealed && chunk2->sealed, "sealed");
+    assertChunkSamples(chunk, expected, n1);
+    assertChunkSamples(chunk2, expected + n1, n - n1);
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(chunk2);
+
+    // random doubles don't get smaller, the chunk keeps the Gorilla layout
+    size_t n_random;
+    chunk = fillChunkForDecode(4096, &n_random);
+    Compressed_SealChunk(chunk);
+    mu_assert(chunk->sealed, "sealed");
+    mu_assert(chunk->frozen == NULL || Compressed_GetChunkSize(chunk, false) <= chunk->size,
+              "frozen isn't larger");
+    Compressed_FreeChunk(chunk);
+    free(expected);
+}
+
+// A fixed interval series is encoded without timestamps until the first irregular timestamp, the
+// following samples are encoded with delta of deltas.
+MU_TEST(test_Compressed_interval_timestamps) {
+    TSGlobalConfig.chunkCheckpointInterval = 64;
+    const size_t n_samples = 3000, n_regular = 2000;
+    Sample *expected = malloc(n_samples * sizeof(Sample));
+    CompressedChunk *chunk = Compressed_NewChunk(16384);
+    CompressedChunk *delta = Compressed_NewChunk(16384);
+    delta->timestampEncoding = TIMESTAMP_ENCODING_DELTA;
+    timestamp_t ts = 1000;
+    for (size_t i = 0; i < n_samples; ++i) {
+        ts += i < n_regular ? 15 : 16 + rand() % 10;
+        expected[i] = (Sample){ .timestamp = ts, .value = rand() % 100 };
+        mu_assert(Compressed_AddSample(chunk, &expected[i]) == CR_OK, "add sample");
+        mu_assert(Compressed_AddSample(delta, &expected[i]) == CR_OK, "add sample");
+        if (i == n_regular - 1) {
+            mu_assert_int_eq(n_regular, chunk->intervalCount);
+            mu_assert_int_eq(15, chunk->interval);
+            // delta of deltas takes at least a bit per timestamp
+            mu_assert(delta->idx - chunk->idx >= n_regular - 1, "timestamps take no bits");
+        }
+    }
+    mu_assert_int_eq(n_regular, chunk->intervalCount);
+    mu_assert_int_eq(0, delta->intervalCount);
+    mu_assert_int_eq(chunk->numCheckpoints, delta->numCheckpoints);
+    assertChunkSamples(chunk, expected, n_samples);
+
+    // ranges which bounds fall between the samples on the interval
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n_samples);
+    for (int t = 0; t < 100; ++t) {
+        size_t a = rand() % n_regular, b = rand() % n_regular;
+        size_t si = min(a, b), ei = max(a, b);
+        timestamp_t start = expected[si].timestamp - (t % 2 ? 7 : 0);
+        timestamp_t end = expected[ei].timestamp + (t % 3 ? 3 : 0);
+        Compressed_ProcessChunk(chunk, start, end, enrichedChunk, false);
+        mu_assert_int_eq(ei - si + 1, enrichedChunk->samples.num_samples);
+        for (size_t i = 0; i < enrichedChunk->samples.num_samples; ++i) {
+            mu_assert_int_eq(expected[si + i].timestamp, enrichedChunk->samples.timestamps[i]);
+            mu_assert_double_eq(expected[si + i].value, enrichedChunk->samples.values[i]);
+        }
+    }
+    Compressed_ProcessChunk(
+        chunk, expected[5].timestamp + 1, expected[6].timestamp - 1, enrichedChunk, false);
+    mu_assert_int_eq(0, enrichedChunk->samples.num_samples);
+    Compressed_ProcessChunk(chunk, 0, expected[0].timestamp - 1, enrichedChunk, false);
+    mu_assert_int_eq(0, enrichedChunk->samples.num_samples);
+
+    // an upsert on the interval overrides the sample, off the interval it adds one
+    int size;
+    Sample sample = { .timestamp = expected[100].timestamp, .value = -1 };
+    UpsertCtx uCtx = { .inChunk = chunk, .sample = sample };
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_assert_int_eq(0, size);
+    uCtx.sample.timestamp = expected[100].timestamp + 1;
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_assert_int_eq(1, size);
+    uCtx.sample.timestamp = expected[0].timestamp;
+    mu_assert(Compressed_UpsertSample(&uCtx, &size, DP_BLOCK) == CR_ERR, "blocked duplicate");
+
+    TSGlobalConfig.chunkCheckpointInterval = 0;
+    FreeEnrichedChunk(enrichedChunk);
+    free(expected);
+    Compressed_FreeChunk(chunk);
+    Compressed_FreeChunk(delta);
+}
+
 MU_TEST_SUITE(compressed_chunk_test_suite) {
     MU_RUN_TEST(test_compressed_upsert);
     MU_RUN_TEST(test_compressed_fail_appendInteger);
     MU_RUN_TEST(test_Compressed_SplitChunk_empty);
     MU_RUN_TEST(test_Compressed_SplitChunk_odd);
     MU_RUN_TEST(test_Compressed_SplitChunk_force_realloc);
+    MU_RUN_TEST(test_Compressed_decode_block);
+    MU_RUN_TEST(test_Compressed_ProcessChunk_range);
+    MU_RUN_TEST(test_Compressed_checkpoints);
+    MU_RUN_TEST(test_Compressed_upsert_ooo_buffer);
+    MU_RUN_TEST(test_Compressed_upsert_pending);
+    MU_RUN_TEST(test_Compressed_summary);
+    MU_RUN_TEST(test_Decimal_counter_memory);
+    MU_RUN_TEST(test_Decimal_scale_fallback);
+    MU_RUN_TEST(test_Chimp_chunk);
+    MU_RUN_TEST(test_Chimp_codec_datasets);
+    MU_RUN_TEST(test_Frozen_codec);
+    MU_RUN_TEST(test_Compressed_seal_chunk);
+    MU_RUN_TEST(test_Compressed_interval_timestamps);
 }
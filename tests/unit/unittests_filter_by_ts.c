@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "minunit.h"
+#include "filters/filter_ts.h"
+#include "filters/filter_ts_avx2.h"
+#include "filters/filter_ts_avx512f.h"
+#include "utils/arch_features.h"
+
+#include <string.h>
+
+#define FILTER_TS_TEST_SAMPLES 300
+
+// Fills sorted unique timestamps, the gaps between them are random up to maxGap
+static size_t fillTimestamps(timestamp_t *timestamps, size_t n, timestamp_t start, int maxGap) {
+    timestamp_t ts = start;
+    for (size_t i = 0; i < n; ++i) {
+        ts += 1 + rand() % maxGap;
+        timestamps[i] = ts;
+    }
+    return n;
+}
+
+MU_TEST(test_gallop_lower_bound) {
+    timestamp_t timestamps[FILTER_TS_TEST_SAMPLES];
+    for (int round = 0; round < 20; ++round) {
+        fillTimestamps(timestamps, FILTER_TS_TEST_SAMPLES, 100, 1 + round);
+        for (int probe = 0; probe < 200; ++probe) {
+            const size_t lo = rand() % FILTER_TS_TEST_SAMPLES;
+            const size_t hi = lo + rand() % (FILTER_TS_TEST_SAMPLES - lo + 1);
+            const timestamp_t value = 90 + rand() % (FILTER_TS_TEST_SAMPLES * (round + 2));
+            size_t expected = lo;
+            while (expected < hi && timestamps[expected] < value) {
+                ++expected;
+            }
+            mu_assert_int_eq(expected, GallopLowerBound(timestamps, lo, hi, value));
+            mu_assert_int_eq(expected, GallopLowerBoundReverse(timestamps, lo, hi, value));
+        }
+    }
+}
+
+MU_TEST(test_filter_by_timestamps) {
+    timestamp_t timestamps[FILTER_TS_TEST_SAMPLES], filter[FILTER_TS_TEST_SAMPLES];
+    double values[FILTER_TS_TEST_SAMPLES];
+    timestamp_t dstTimestamps[FILTER_TS_TEST_SAMPLES], expectedTimestamps[FILTER_TS_TEST_SAMPLES];
+    double dstValues[FILTER_TS_TEST_SAMPLES], expectedValues[FILTER_TS_TEST_SAMPLES];
+    // sparse and dense filters, over sparse and dense samples
+    const int gaps[][2] = { { 1, 1 }, { 1, 20 }, { 20, 1 }, { 5, 5 }, { 50, 3 } };
+    for (int round = 0; round < 20; ++round) {
+        for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); ++g) {
+            const size_t n =
+                fillTimestamps(timestamps, rand() % FILTER_TS_TEST_SAMPLES, 0, gaps[g][0]);
+            const size_t m = fillTimestamps(filter, rand() % FILTER_TS_TEST_SAMPLES, 0, gaps[g][1]);
+            for (size_t i = 0; i < n; ++i) {
+                values[i] = rand() % 100;
+            }
+            const size_t filterStart = m ? rand() % m : 0;
+
+            size_t expected = 0;
+            size_t expectedFilterIndex = filterStart;
+            for (size_t i = 0; i < n; ++i) {
+                while (expectedFilterIndex < m && filter[expectedFilterIndex] < timestamps[i]) {
+                    ++expectedFilterIndex;
+                }
+                if (expectedFilterIndex < m && filter[expectedFilterIndex] == timestamps[i]) {
+                    expectedTimestamps[expected] = timestamps[i];
+                    expectedValues[expected] = values[i];
+                    ++expected;
+                    ++expectedFilterIndex;
+                }
+            }
+            // the cursor passes every filter timestamp up to the last sample
+            while (n > 0 && expectedFilterIndex < m &&
+                   filter[expectedFilterIndex] <= timestamps[n - 1]) {
+                ++expectedFilterIndex;
+            }
+
+            size_t filterIndex = filterStart;
+            size_t count = FilterByTimestamps(
+                dstTimestamps, dstValues, timestamps, values, n, filter, &filterIndex, m);
+            mu_assert_int_eq(expected, count);
+            mu_assert_int_eq(expectedFilterIndex, filterIndex);
+            mu_check(!memcmp(expectedTimestamps, dstTimestamps, count * sizeof(timestamp_t)));
+            mu_check(!memcmp(expectedValues, dstValues, count * sizeof(double)));
+
+            // in place
+            filterIndex = filterStart;
+            count = FilterByTimestamps(
+                timestamps, values, timestamps, values, n, filter, &filterIndex, m);
+            mu_assert_int_eq(expected, count);
+            mu_check(!memcmp(expectedTimestamps, timestamps, count * sizeof(timestamp_t)));
+            mu_check(!memcmp(expectedValues, values, count * sizeof(double)));
+        }
+    }
+}
+
+static void checkCountBelow(size_t (*countBelow)(const timestamp_t *, timestamp_t)) {
+    // around the sign bit too, which a signed compare would get wrong
+    const timestamp_t starts[] = { 0, 1000, (timestamp_t)INT64_MAX - 20, UINT64_MAX - 200 };
+    timestamp_t timestamps[BUCKET_SCAN_WINDOW];
+    for (size_t s = 0; s < sizeof(starts) / sizeof(starts[0]); ++s) {
+        fillTimestamps(timestamps, BUCKET_SCAN_WINDOW, starts[s], 5);
+        for (timestamp_t bound = timestamps[0] - 1; bound <= timestamps[BUCKET_SCAN_WINDOW - 1] + 1;
+             ++bound) {
+            size_t expected = 0;
+            while (expected < BUCKET_SCAN_WINDOW && timestamps[expected] < bound) {
+                ++expected;
+            }
+            mu_assert_int_eq(expected, countBelow(timestamps, bound));
+        }
+    }
+}
+
+MU_TEST(test_find_bucket_end) {
+    checkCountBelow(CountBelowVec);
+#if defined(__x86_64__)
+    const X86Features *features = getArchitectureOptimization();
+    if (features && features->avx2) {
+        checkCountBelow(CountBelowAVX2);
+    }
+    if (features && features->avx512f) {
+        checkCountBelow(CountBelowAVX512F);
+    }
+#endif // __x86_64__
+
+    initTimestampFilterFunctions();
+    timestamp_t timestamps[FILTER_TS_TEST_SAMPLES], descending[FILTER_TS_TEST_SAMPLES];
+    for (int round = 0; round < 20; ++round) {
+        fillTimestamps(timestamps, FILTER_TS_TEST_SAMPLES, 100, 1 + round % 5);
+        for (size_t i = 0; i < FILTER_TS_TEST_SAMPLES; ++i) {
+            descending[i] = timestamps[FILTER_TS_TEST_SAMPLES - 1 - i];
+        }
+        const timestamp_t last = timestamps[FILTER_TS_TEST_SAMPLES - 1];
+        for (int probe = 0; probe < 300; ++probe) {
+            // buckets of a few samples and of most of the chunk
+            const size_t n = 1 + rand() % FILTER_TS_TEST_SAMPLES;
+            const size_t si = rand() % n;
+            const timestamp_t span = probe % 2 ? 1 + rand() % 30 : rand() % (last + 10);
+
+            size_t expected = si;
+            const timestamp_t bound = timestamps[si] + span;
+            while (expected < n && timestamps[expected] < bound) {
+                ++expected;
+            }
+            mu_assert_int_eq(expected, FindBucketEnd(timestamps, si, n, bound, false));
+
+            expected = si;
+            const timestamp_t start = descending[si] > span ? descending[si] - span : 0;
+            while (expected < n && descending[expected] >= start) {
+                ++expected;
+            }
+            mu_assert_int_eq(expected, FindBucketEnd(descending, si, n, start, true));
+        }
+    }
+}
+
+MU_TEST_SUITE(filter_by_ts_test_suite) {
+    MU_RUN_TEST(test_gallop_lower_bound);
+    MU_RUN_TEST(test_filter_by_timestamps);
+    MU_RUN_TEST(test_find_bucket_end);
+}
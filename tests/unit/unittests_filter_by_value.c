@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "minunit.h"
+#include "filters/filter_value.h"
+#include "filters/filter_value_avx2.h"
+#include "filters/filter_value_avx512f.h"
+#include "utils/arch_features.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef size_t (*FilterByValueFunc)(timestamp_t *dstTimestamps,
+                                    double *dstValues,
+                                    const timestamp_t *timestamps,
+                                    const double *values,
+                                    size_t n,
+                                    double min,
+                                    double max);
+
+#define FILTER_TEST_SAMPLES 100
+
+// A kernel must keep the samples with a value in [min, max] in order, in place or not
+static void checkFilterByValue(FilterByValueFunc filter) {
+    timestamp_t timestamps[FILTER_TEST_SAMPLES], dstTimestamps[FILTER_TEST_SAMPLES];
+    double values[FILTER_TEST_SAMPLES], dstValues[FILTER_TEST_SAMPLES];
+    timestamp_t expectedTimestamps[FILTER_TEST_SAMPLES];
+    double expectedValues[FILTER_TEST_SAMPLES];
+    // ranges which keep all, most, a few and none of the samples
+    const double ranges[][2] = { { -1, 100 }, { 10, 90 }, { 45, 50 }, { 200, 300 } };
+    for (int round = 0; round < 20; ++round) {
+        for (size_t i = 0; i < FILTER_TEST_SAMPLES; ++i) {
+            timestamps[i] = 1000 + i * 10;
+            values[i] = rand() % 100;
+        }
+        values[rand() % FILTER_TEST_SAMPLES] = NAN;
+        for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); ++r) {
+            for (size_t n = 0; n <= FILTER_TEST_SAMPLES; n += 1 + rand() % 7) {
+                size_t expected = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    if (values[i] >= ranges[r][0] && values[i] <= ranges[r][1]) {
+                        expectedTimestamps[expected] = timestamps[i];
+                        expectedValues[expected] = values[i];
+                        ++expected;
+                    }
+                }
+                size_t count = filter(
+                    dstTimestamps, dstValues, timestamps, values, n, ranges[r][0], ranges[r][1]);
+                mu_assert_int_eq(expected, count);
+                mu_check(!memcmp(expectedTimestamps, dstTimestamps, count * sizeof(timestamp_t)));
+                mu_check(!memcmp(expectedValues, dstValues, count * sizeof(double)));
+
+                // in place
+                memcpy(dstTimestamps, timestamps, n * sizeof(timestamp_t));
+                memcpy(dstValues, values, n * sizeof(double));
+                count = filter(dstTimestamps,
+                               dstValues,
+                               dstTimestamps,
+                               dstValues,
+                               n,
+                               ranges[r][0],
+                               ranges[r][1]);
+                mu_assert_int_eq(expected, count);
+                mu_check(!memcmp(expectedTimestamps, dstTimestamps, count * sizeof(timestamp_t)));
+                mu_check(!memcmp(expectedValues, dstValues, count * sizeof(double)));
+            }
+        }
+    }
+}
+
+MU_TEST(test_filter_by_value) {
+    initGlobalFilterFunctions();
+    checkFilterByValue(FilterByValue);
+    checkFilterByValue(FilterByValueVec);
+#if defined(__x86_64__)
+    const X86Features *features = getArchitectureOptimization();
+    if (features && features->avx2) {
+        checkFilterByValue(FilterByValueAVX2);
+    }
+    if (features && features->avx512f) {
+        checkFilterByValue(FilterByValueAVX512F);
+    }
+#endif // __x86_64__
+}
+
+MU_TEST_SUITE(filter_by_value_test_suite) {
+    MU_RUN_TEST(test_filter_by_value);
+}
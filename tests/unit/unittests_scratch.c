@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2006-Present, Redis Ltd.
+ * All rights reserved.
+ *
+ * Licensed under your choice of (a) the Redis Source Available License 2.0
+ * (RSALv2); or (b) the Server Side Public License v1 (SSPLv1); or (c) the
+ * GNU Affero General Public License v3 (AGPLv3).
+ */
+#include "minunit.h"
+#include "utils/scratch.h"
+
+#include <stdint.h>
+#include <string.h>
+
+MU_TEST(test_scratch_reuse) {
+    ScratchArena arena = { 0 };
+    unsigned long long allocations = 0;
+    // the first command grows the arena, the ones like it don't allocate
+    for (int round = 0; round < 10; ++round) {
+        const size_t mark = Scratch_Begin(&arena);
+        for (size_t size = 1; size <= 2048; size *= 2) {
+            char *buf = Scratch_Alloc(&arena, size);
+            mu_check((uintptr_t)buf % sizeof(double) == 0);
+            memset(buf, round, size);
+        }
+        Scratch_End(&arena, mark);
+        if (round == 0) {
+            mu_check(arena.allocations > 0);
+            allocations = arena.allocations;
+        }
+    }
+    for (int round = 0; round < 10; ++round) {
+        const size_t mark = Scratch_Begin(&arena);
+        Scratch_Alloc(&arena, 4000);
+        Scratch_End(&arena, mark);
+    }
+    mu_assert_int_eq(allocations, arena.allocations);
+    Scratch_Free(&arena);
+}
+
+MU_TEST(test_scratch_nested) {
+    ScratchArena arena = { 0 };
+    size_t outer = Scratch_Begin(&arena);
+    int *a = Scratch_Alloc(&arena, 100 * sizeof(int));
+    for (int i = 0; i < 100; ++i) {
+        a[i] = i;
+    }
+    // the buffers of an outer scope outlive an inner scope, even one which overflows the block
+    const size_t inner = Scratch_Begin(&arena);
+    memset(Scratch_Alloc(&arena, 100000), 0xff, 100000);
+    Scratch_End(&arena, inner);
+    for (int i = 0; i < 100; ++i) {
+        mu_assert_int_eq(i, a[i]);
+    }
+    Scratch_End(&arena, outer);
+    mu_check(arena.capacity >= 100000);
+    mu_check(arena.overflow == NULL);
+
+    // the grown block serves the same nesting without allocations
+    const unsigned long long allocations = arena.allocations;
+    outer = Scratch_Begin(&arena);
+    Scratch_Alloc(&arena, 100 * sizeof(int));
+    Scratch_End(&arena, Scratch_Begin(&arena));
+    Scratch_Alloc(&arena, 100000);
+    Scratch_End(&arena, outer);
+    mu_assert_int_eq(allocations, arena.allocations);
+    Scratch_Free(&arena);
+}
+
+MU_TEST_SUITE(scratch_test_suite) {
+    MU_RUN_TEST(test_scratch_reuse);
+    MU_RUN_TEST(test_scratch_nested);
+}
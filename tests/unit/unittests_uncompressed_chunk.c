@@ -117,35 +117,126 @@ MU_TEST(test_Uncompressed_Uncompressed_UpsertSample_DuplicatePolicy) {
     mu_assert_int_eq(1, chunk->num_samples);
     const uint64_t firstTs = Uncompressed_GetFirstTimestamp(chunk);
     mu_assert_int_eq(1, firstTs);
-    mu_assert_double_eq(-0.5, chunk->samples[0].value);
+    mu_assert_double_eq(-0.5, chunk->values[0]);
     // DP_MAX should keep -0.5 given that -0.4 is smaller
     uCtx.sample.value = -0.4;
     rv = Uncompressed_UpsertSample(&uCtx, &size, DP_MIN);
     mu_assert(rv == CR_OK, "duplicate min not changing old value");
     mu_assert_int_eq(1, chunk->num_samples);
-    mu_assert_double_eq(-0.5, chunk->samples[0].value);
+    mu_assert_double_eq(-0.5, chunk->values[0]);
     // DP_MIN should replace -0.5 by -0.6
     uCtx.sample.value = -0.6;
     rv = Uncompressed_UpsertSample(&uCtx, &size, DP_MIN);
     mu_assert(rv == CR_OK, "duplicate min changing old value");
     mu_assert_int_eq(1, chunk->num_samples);
-    mu_assert_double_eq(-0.6, chunk->samples[0].value);
+    mu_assert_double_eq(-0.6, chunk->values[0]);
+    mu_check(uCtx.overridden);
+    mu_assert_double_eq(-0.5, uCtx.overriddenValue);
     // DP_MAX should keep -0.6 given that -1 is smaller
     uCtx.sample.value = -1.0;
     rv = Uncompressed_UpsertSample(&uCtx, &size, DP_MAX);
     mu_assert(rv == CR_OK, "duplicate max not changing old value");
-    mu_assert_double_eq(-0.6, chunk->samples[0].value);
+    mu_assert_double_eq(-0.6, chunk->values[0]);
     // DP_MAX should replace -0.6 by -0.2
     uCtx.sample.value = -0.2;
     rv = Uncompressed_UpsertSample(&uCtx, &size, DP_MAX);
     mu_assert(rv == CR_OK, "duplicate max changing old value");
-    mu_assert_double_eq(-0.2, chunk->samples[0].value);
+    mu_assert_double_eq(-0.2, chunk->values[0]);
     Uncompressed_FreeChunk(chunk);
 }
 
+MU_TEST(test_Uncompressed_summary) {
+    Chunk *chunk = Uncompressed_NewChunk(4096);
+    for (timestamp_t ts = 1; ts <= 100; ++ts) {
+        Sample sample = { .timestamp = ts, .value = ts };
+        mu_assert(Uncompressed_AddSample(chunk, &sample) == CR_OK, "add sample");
+    }
+    mu_assert_double_eq(100, Uncompressed_GetSummary(chunk)->max);
+
+    // an override marks the summary stale, the next read rebuilds it
+    UpsertCtx uCtx = { .inChunk = chunk, .sample = { .timestamp = 100, .value = 7 } };
+    int size;
+    mu_assert(Uncompressed_UpsertSample(&uCtx, &size, DP_LAST) == CR_OK, "upsert");
+    mu_assert(chunk->summary.stale, "stale after an override");
+    const ChunkSummary *summary = Uncompressed_GetSummary(chunk);
+    mu_assert_double_eq(99, summary->max);
+    mu_assert_double_eq(7, summary->last.value);
+    mu_assert(!chunk->summary.stale, "rebuilt");
+
+    mu_assert_int_eq(10, Uncompressed_DelRange(chunk, 1, 10));
+    mu_assert(chunk->summary.stale, "stale after a deletion");
+    summary = Uncompressed_GetSummary(chunk);
+    mu_assert_int_eq(90, summary->count);
+    mu_assert_double_eq(7, summary->min);
+    mu_assert_double_eq(11, summary->first.value);
+    Uncompressed_FreeChunk(chunk);
+}
+
+MU_TEST(test_Uncompressed_ProcessChunk) {
+    const size_t n_samples = 1000;
+    Chunk *chunk = Uncompressed_NewChunk(n_samples * SAMPLE_SIZE);
+    for (size_t i = 0; i < n_samples; ++i) {
+        Sample sample = { .timestamp = 100 + i * 10, .value = i };
+        mu_assert(Uncompressed_AddSample(chunk, &sample) == CR_OK, "add sample");
+    }
+    EnrichedChunk *enrichedChunk = NewEnrichedChunk();
+    ReallocSamplesArray(&enrichedChunk->samples, n_samples);
+    for (int t = 0; t < 100; ++t) {
+        // bounds on and between the samples
+        timestamp_t start = 95 + rand() % (n_samples * 10), end = start + rand() % 2000;
+        size_t si = start <= 100 ? 0 : (start - 100 + 9) / 10;
+        size_t ei = min(n_samples, (end - 100) / 10 + 1);
+        bool reverse = t % 2;
+        Uncompressed_ProcessChunk(chunk, start, end, enrichedChunk, reverse);
+        mu_assert_int_eq(ei > si ? ei - si : 0, enrichedChunk->samples.num_samples);
+        for (size_t i = 0; i < enrichedChunk->samples.num_samples; ++i) {
+            size_t j = reverse ? ei - 1 - i : si + i;
+            mu_assert_int_eq(100 + j * 10, enrichedChunk->samples.timestamps[i]);
+            mu_assert_double_eq(j, enrichedChunk->samples.values[i]);
+        }
+    }
+    Uncompressed_ProcessChunk(chunk, 0, UINT64_MAX, enrichedChunk, false);
+    mu_assert_int_eq(n_samples, enrichedChunk->samples.num_samples);
+
+    // a forward read borrows the chunk, it's copied before being modified
+    Uncompressed_ProcessChunk(chunk, 150, 300, enrichedChunk, false);
+    mu_check(enrichedChunk->borrowed);
+    mu_check(enrichedChunk->samples.values == chunk->values + 5);
+    MakeEnrichedChunkWritable(enrichedChunk);
+    mu_check(!enrichedChunk->borrowed);
+    mu_assert_int_eq(16, enrichedChunk->samples.num_samples);
+    mu_assert_int_eq(300, enrichedChunk->samples.timestamps[15]);
+    enrichedChunk->samples.values[0] = -1;
+    mu_assert_double_eq(5, chunk->values[5]);
+    Uncompressed_ProcessChunk(chunk, 150, 300, enrichedChunk, true);
+    mu_check(!enrichedChunk->borrowed);
+
+    // deleting a range closes the gap
+    mu_assert_int_eq(10, Uncompressed_DelRange(chunk, 195, 290));
+    mu_assert_int_eq(0, Uncompressed_DelRange(chunk, 195, 290));
+    Uncompressed_ProcessChunk(chunk, 180, 310, enrichedChunk, false);
+    mu_assert_int_eq(4, enrichedChunk->samples.num_samples);
+    mu_assert_int_eq(190, enrichedChunk->samples.timestamps[1]);
+    mu_assert_int_eq(300, enrichedChunk->samples.timestamps[2]);
+    mu_assert_double_eq(20, enrichedChunk->samples.values[2]);
+
+    Chunk *chunk2 = Uncompressed_SplitChunk(chunk);
+    mu_assert_int_eq(n_samples - 10, chunk->num_samples + chunk2->num_samples);
+    mu_assert_int_eq(Uncompressed_GetLastTimestamp(chunk) + 10,
+                     Uncompressed_GetFirstTimestamp(chunk2));
+    mu_assert_int_eq(100 + (n_samples - 1) * 10, Uncompressed_GetLastTimestamp(chunk2));
+    mu_assert_double_eq(n_samples - 1, Uncompressed_GetLastValue(chunk2));
+
+    FreeEnrichedChunk(enrichedChunk);
+    Uncompressed_FreeChunk(chunk);
+    Uncompressed_FreeChunk(chunk2);
+}
+
 MU_TEST_SUITE(uncompressed_chunk_test_suite) {
     MU_RUN_TEST(test_Uncompressed_NewChunk);
     MU_RUN_TEST(test_Uncompressed_Uncompressed_AddSample);
     MU_RUN_TEST(test_Uncompressed_Uncompressed_UpsertSample);
     MU_RUN_TEST(test_Uncompressed_Uncompressed_UpsertSample_DuplicatePolicy);
+    MU_RUN_TEST(test_Uncompressed_summary);
+    MU_RUN_TEST(test_Uncompressed_ProcessChunk);
 }
@@ -0,0 +1,49 @@
+import time
+
+import click
+import redis
+
+
+def run(redis_client, batching, keys, samples, pipeline_size, start_timestamp):
+    redis_client.config_set('ts-ingest-batching', 'yes' if batching else 'no')
+    redis_client.delete(*keys)
+    for key in keys:
+        redis_client.execute_command('TS.CREATE', key)
+    start = time.time()
+    for i in range(0, samples, pipeline_size):
+        pipe = redis_client.pipeline(transaction=False)
+        for j in range(i, min(i + pipeline_size, samples)):
+            pipe.execute_command('TS.ADD', keys[j % len(keys)], start_timestamp + j, j % 1000)
+        pipe.execute()
+    return time.time() - start
+
+
+@click.command()
+@click.option('--host', default="localhost", help='redis host.')
+@click.option('--port', type=click.INT, default=6379, help='redis port.')
+@click.option('--samples', type=click.INT, default=1000000, help='Number of samples per run.')
+@click.option('--pipeline-size', type=click.INT, default=100, help='Number of TS.ADD commands per pipeline.')
+@click.option('--keys', type=click.INT, default=10, help='Number of keys the samples are spread over.')
+@click.option('--start-timestamp', type=click.INT, default=1551347864000, help='Base timestamp for all samples')
+@click.option('--key-prefix', type=click.STRING, default="batching_benchmark", help='The prefix of the keys')
+def main(host, port, samples, pipeline_size, keys, start_timestamp, key_prefix):
+    """Compares the rate of pipelined TS.ADD with and without ts-ingest-batching. Attach a replica
+    and enable notify-keyspace-events to measure the propagation which the batching saves."""
+    redis_client = redis.Redis(host, port)
+    key_names = ['{}_{}'.format(key_prefix, i) for i in range(keys)]
+    original = redis_client.config_get('ts-ingest-batching')['ts-ingest-batching']
+    try:
+        rates = {}
+        for batching in [False, True]:
+            elapsed = run(redis_client, batching, key_names, samples, pipeline_size, start_timestamp)
+            rates[batching] = samples / elapsed
+            print("{:<12} {:>10.3f} sec {:>14,.0f} samples/sec".format(
+                'batched' if batching else 'unbatched', elapsed, rates[batching]))
+        print("{:<12} {:>+10.1%}".format('gain', rates[True] / rates[False] - 1))
+    finally:
+        redis_client.config_set('ts-ingest-batching', original)
+        redis_client.delete(*key_names)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,91 @@
+import struct
+import time
+
+import click
+import redis
+
+
+def text_args(samples):
+    return [a for sample in samples for a in sample]
+
+
+def packed_payload(samples):
+    return b''.join(struct.pack('<qd', t, v) for t, v in samples)
+
+
+def packed_delta_payload(samples):
+    prev = 0
+    deltas = []
+    for t, v in samples:
+        deltas.append(struct.pack('<qd', t - prev, v))
+        prev = t
+    return b''.join(deltas)
+
+
+# each encoding builds the commands which insert a batch of samples to a key
+ENCODINGS = {
+    'madd-text': lambda key, batch: ['TS.MADD'] + [a for t, v in batch for a in (key, t, v)],
+    'madd-packed': lambda key, batch: ['TS.MADD', key, 'PACKED', packed_payload(batch)],
+    'addbulk-text': lambda key, batch: ['TS.ADDBULK', key] + text_args(batch),
+    'addbulk-packed': lambda key, batch: ['TS.ADDBULK', key, 'PACKED', packed_payload(batch)],
+    'addbulk-packed-delta': lambda key, batch: ['TS.ADDBULK', key, 'PACKED_DELTA',
+                                                packed_delta_payload(batch)],
+}
+
+
+RULES = [('avg', 60000), ('max', 60000), ('sum', 3600000), ('min', 3600000), ('count', 86400000)]
+
+
+def create_series(redis_client, key, rules):
+    redis_client.delete(key, *['{}_{}'.format(key, i) for i in range(len(RULES))])
+    redis_client.execute_command('TS.CREATE', key)
+    for i in range(rules):
+        aggregation, bucket = RULES[i % len(RULES)]
+        dest = '{}_{}'.format(key, i)
+        redis_client.execute_command('TS.CREATE', dest)
+        redis_client.execute_command('TS.CREATERULE', key, dest, 'AGGREGATION', aggregation, bucket)
+
+
+def ingest_allocations(redis_client):
+    return redis_client.info('timeseries_ingest').get('timeseries_ingest_allocations', 0)
+
+
+def run(redis_client, encoding, key, samples, batch_size, pipeline_size, rules):
+    create_series(redis_client, key, rules)
+    allocations = ingest_allocations(redis_client)
+    cmds = [ENCODINGS[encoding](key, samples[i:i + batch_size])
+            for i in range(0, len(samples), batch_size)]
+    start = time.time()
+    for i in range(0, len(cmds), pipeline_size):
+        pipe = redis_client.pipeline(transaction=False)
+        for cmd in cmds[i:i + pipeline_size]:
+            pipe.execute_command(*cmd)
+        pipe.execute()
+    elapsed = time.time() - start
+    count = redis_client.execute_command('TS.INFO', key)[1]
+    assert count == len(samples), "{} inserted {} samples out of {}".format(encoding, count, len(samples))
+    return elapsed, ingest_allocations(redis_client) - allocations
+
+
+@click.command()
+@click.option('--host', default="localhost", help='redis host.')
+@click.option('--port', type=click.INT, default=6379, help='redis port.')
+@click.option('--samples', type=click.INT, default=1000000, help='Number of samples per run.')
+@click.option('--batch-size', type=click.INT, default=1000, help='Number of samples per command.')
+@click.option('--pipeline-size', type=click.INT, default=10, help='Number of commands per pipeline.')
+@click.option('--start-timestamp', type=click.INT, default=1551347864000, help='Base timestamp for all samples')
+@click.option('--key', type=click.STRING, default="ingest_benchmark", help='The key which the samples are inserted to')
+@click.option('--rules', type=click.IntRange(0, len(RULES)), default=0, help='Number of compaction rules of the key.')
+def main(host, port, samples, batch_size, pipeline_size, start_timestamp, key, rules):
+    """Compares the ingest rate of the text and the packed sample encodings"""
+    redis_client = redis.Redis(host, port)
+    series = [(start_timestamp + i * 10, float(i % 1000) / 8) for i in range(samples)]
+    for encoding in ENCODINGS:
+        elapsed, allocations = run(redis_client, encoding, key, series, batch_size, pipeline_size, rules)
+        print("{:<22} {:>10.3f} sec {:>14,.0f} samples/sec {:>10.6f} allocations/sample".format(
+            encoding, elapsed, samples / elapsed, allocations / samples))
+    redis_client.delete(key, *['{}_{}'.format(key, i) for i in range(len(RULES))])
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,54 @@
+import time
+
+import click
+import redis
+
+SHAPES = {
+    'plain': [],
+    'filter': ['FILTER_BY_VALUE', 200, 700],
+    'agg': ['AGGREGATION', 'avg', 1000],
+    'filter+agg': ['FILTER_BY_VALUE', 200, 700, 'AGGREGATION', 'max', 1000],
+}
+
+
+def run(redis_client, fused, key, command, args, queries):
+    redis_client.config_set('ts-fused-range', 'yes' if fused else 'no')
+    start = time.time()
+    for _ in range(queries):
+        redis_client.execute_command(command, key, '-', '+', *args)
+    return time.time() - start
+
+
+@click.command()
+@click.option('--host', default="localhost", help='redis host.')
+@click.option('--port', type=click.INT, default=6379, help='redis port.')
+@click.option('--samples', type=click.INT, default=100000, help='Number of samples in the series.')
+@click.option('--queries', type=click.INT, default=200, help='Number of queries per shape.')
+@click.option('--start-timestamp', type=click.INT, default=1551347864000, help='Base timestamp for all samples')
+@click.option('--key', type=click.STRING, default="fused_range_benchmark", help='The name of the key')
+def main(host, port, samples, queries, start_timestamp, key):
+    """Compares the rate of TS.RANGE and TS.REVRANGE of the common query shapes with and without
+    ts-fused-range."""
+    redis_client = redis.Redis(host, port)
+    original = redis_client.config_get('ts-fused-range')['ts-fused-range']
+    redis_client.delete(key)
+    redis_client.execute_command('TS.CREATE', key)
+    for i in range(0, samples, 1000):
+        redis_client.execute_command('TS.MADD', *[arg for j in range(i, min(i + 1000, samples))
+                                                   for arg in (key, start_timestamp + j * 10, j % 1000)])
+    try:
+        for command in ['TS.RANGE', 'TS.REVRANGE']:
+            for shape, args in SHAPES.items():
+                rates = {}
+                for fused in [False, True]:
+                    elapsed = run(redis_client, fused, key, command, args, queries)
+                    rates[fused] = queries / elapsed
+                print("{:<12} {:<12} {:>12,.1f} queries/sec chain {:>12,.1f} queries/sec fused {:>+8.1%}".format(
+                    command, shape, rates[False], rates[True], rates[True] / rates[False] - 1))
+    finally:
+        redis_client.config_set('ts-fused-range', original)
+        redis_client.delete(key)
+
+
+if __name__ == '__main__':
+    main()